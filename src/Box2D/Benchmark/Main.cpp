@@ -0,0 +1,332 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Profile.h"
+#include "Scene.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// Usage: box2d_bench [-t threads] [-w copies] [-o file] [scene ...]
+// Steps each scene a fixed number of times at 60Hz and writes JSON with the
+// step rate and the b2Profile mean and maximum over all steps. The default
+// runs every scene single threaded and writes to stdout.
+// With -w, copies of every selected scene are stepped together as separate
+// worlds of one b2WorldGroup on the thread pool, for the step count of the
+// longest scene, and the step time of each world is written instead.
+// -h or --help prints the usage and the scene names. Unknown options and
+// scene names print them too and exit with 1.
+
+static bool IsSelected(const char* name, int argc, char** argv, int first)
+{
+	if (first == argc)
+	{
+		return true;
+	}
+
+	for (int i = first; i < argc; ++i)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static float64 ComputeChecksum(b2World* world)
+{
+	float64 checksum = 0.0;
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		b2Vec2 p = b->GetPosition();
+		checksum += p.x + p.y + b->GetAngle();
+	}
+
+	return checksum;
+}
+
+static void RunScene(FILE* file, const SceneEntry& entry, b2ThreadPool* threadPool, bool first)
+{
+	b2World world(b2Vec2(0.0f, -10.0f));
+	world.SetThreadPool(threadPool);
+
+	Scene* scene = entry.createFcn();
+	scene->Build(&world);
+
+	ProfileStats stats;
+	float64 seconds = 0.0;
+	for (int32 i = 0; i < entry.stepCount; ++i)
+	{
+		scene->Step(&world, i);
+
+		b2Timer timer;
+		world.Step(1.0f / 60.0f, 8, 3);
+		seconds += 0.001 * timer.GetMilliseconds();
+
+		stats.Add(world.GetProfile());
+	}
+
+	// The checksum shows when a change alters the simulation.
+	float64 checksum = ComputeChecksum(&world);
+
+	fprintf(file, "%s\t\t{\n", first ? "" : ",\n");
+	fprintf(file, "\t\t\t\"name\": \"%s\",\n", entry.name);
+	fprintf(file, "\t\t\t\"steps\": %d,\n", entry.stepCount);
+	fprintf(file, "\t\t\t\"bodies\": %d,\n", world.GetBodyCount());
+	fprintf(file, "\t\t\t\"joints\": %d,\n", world.GetJointCount());
+	fprintf(file, "\t\t\t\"contacts\": %d,\n", world.GetContactCount());
+	fprintf(file, "\t\t\t\"seconds\": %.4f,\n", seconds);
+	fprintf(file, "\t\t\t\"stepsPerSecond\": %.2f,\n", seconds > 0.0 ? entry.stepCount / seconds : 0.0);
+	fprintf(file, "\t\t\t\"checksum\": %.6f", checksum);
+	scene->Report(file, &world);
+	fprintf(file, ",\n");
+	stats.Write(file, 3);
+	fprintf(file, "\n\t\t}");
+
+	delete scene;
+}
+
+struct GroupWorld
+{
+	const SceneEntry* entry;
+	Scene* scene;
+	b2World* world;
+	float64 totalTime;
+	float32 maxTime;
+};
+
+static void RunGroup(FILE* file, int32 copies, b2ThreadPool* threadPool, int argc, char** argv, int first)
+{
+	int32 sceneCount = 0;
+	for (int32 i = 0; g_sceneEntries[i].name != NULL; ++i)
+	{
+		if (IsSelected(g_sceneEntries[i].name, argc, argv, first))
+		{
+			++sceneCount;
+		}
+	}
+
+	int32 worldCount = copies * sceneCount;
+	GroupWorld* worlds = new GroupWorld[worldCount];
+	b2WorldGroup group(threadPool);
+
+	int32 stepCount = 0;
+	int32 worldIndex = 0;
+	for (int32 i = 0; g_sceneEntries[i].name != NULL; ++i)
+	{
+		if (IsSelected(g_sceneEntries[i].name, argc, argv, first) == false)
+		{
+			continue;
+		}
+
+		stepCount = b2Max(stepCount, g_sceneEntries[i].stepCount);
+
+		for (int32 j = 0; j < copies; ++j)
+		{
+			GroupWorld* w = worlds + worldIndex++;
+			w->entry = g_sceneEntries + i;
+			w->scene = w->entry->createFcn();
+			w->world = new b2World(b2Vec2(0.0f, -10.0f));
+			w->scene->Build(w->world);
+			w->totalTime = 0.0;
+			w->maxTime = 0.0f;
+			group.AddWorld(w->world);
+		}
+	}
+
+	float64 seconds = 0.0;
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		for (int32 j = 0; j < worldCount; ++j)
+		{
+			worlds[j].scene->Step(worlds[j].world, i);
+		}
+
+		b2Timer timer;
+		group.Step(1.0f / 60.0f, 8, 3);
+		seconds += 0.001 * timer.GetMilliseconds();
+
+		// Worlds keep the index they were added with.
+		for (int32 j = 0; j < worldCount; ++j)
+		{
+			float32 time = group.GetStepTime(j);
+			worlds[j].totalTime += time;
+			worlds[j].maxTime = b2Max(worlds[j].maxTime, time);
+		}
+	}
+
+	fprintf(file, "\t\"group\": {\n");
+	fprintf(file, "\t\t\"worlds\": %d,\n", worldCount);
+	fprintf(file, "\t\t\"steps\": %d,\n", stepCount);
+	fprintf(file, "\t\t\"seconds\": %.4f,\n", seconds);
+	fprintf(file, "\t\t\"stepsPerSecond\": %.2f,\n", seconds > 0.0 ? stepCount / seconds : 0.0);
+	fprintf(file, "\t\t\"lastSteals\": %d,\n", group.GetStealCount());
+	fprintf(file, "\t\t\"worldSteps\": [\n");
+
+	for (int32 j = 0; j < worldCount; ++j)
+	{
+		GroupWorld* w = worlds + j;
+		fprintf(file, "\t\t\t{\"name\": \"%s\", \"bodies\": %d, \"checksum\": %.6f, \"meanStep\": %.4f, \"maxStep\": %.4f}%s\n",
+			w->entry->name, w->world->GetBodyCount(), ComputeChecksum(w->world),
+			w->totalTime / stepCount, w->maxTime, j + 1 < worldCount ? "," : "");
+
+		delete w->world;
+		delete w->scene;
+	}
+
+	fprintf(file, "\t\t]\n\t}\n");
+
+	delete [] worlds;
+}
+
+static void PrintUsage(FILE* file)
+{
+	fprintf(file, "usage: box2d_bench [-t threads] [-w copies] [-o file] [scene ...]\n");
+	fprintf(file, "scenes:");
+	for (int32 i = 0; g_sceneEntries[i].name != NULL; ++i)
+	{
+		fprintf(file, " %s", g_sceneEntries[i].name);
+	}
+	fprintf(file, "\n");
+}
+
+static bool IsScene(const char* name)
+{
+	for (int32 i = 0; g_sceneEntries[i].name != NULL; ++i)
+	{
+		if (strcmp(g_sceneEntries[i].name, name) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	int32 threadCount = 1;
+	int32 copies = 0;
+	const char* path = NULL;
+
+	int first = 1;
+	while (first < argc && argv[first][0] == '-')
+	{
+		if (strcmp(argv[first], "-h") == 0 || strcmp(argv[first], "--help") == 0)
+		{
+			PrintUsage(stdout);
+			return 0;
+		}
+
+		const char* option = argv[first];
+		if (strcmp(option, "-t") != 0 && strcmp(option, "-w") != 0 && strcmp(option, "-o") != 0)
+		{
+			fprintf(stderr, "unknown option %s\n", option);
+			PrintUsage(stderr);
+			return 1;
+		}
+
+		if (first + 1 == argc)
+		{
+			fprintf(stderr, "%s needs a value\n", option);
+			PrintUsage(stderr);
+			return 1;
+		}
+
+		if (strcmp(option, "-t") == 0)
+		{
+			threadCount = atoi(argv[first + 1]);
+		}
+		else if (strcmp(option, "-w") == 0)
+		{
+			copies = atoi(argv[first + 1]);
+		}
+		else
+		{
+			path = argv[first + 1];
+		}
+
+		first += 2;
+	}
+
+	for (int i = first; i < argc; ++i)
+	{
+		if (IsScene(argv[i]) == false)
+		{
+			fprintf(stderr, "unknown scene %s\n", argv[i]);
+			PrintUsage(stderr);
+			return 1;
+		}
+	}
+
+	FILE* file = stdout;
+	if (path != NULL)
+	{
+		file = fopen(path, "w");
+		if (file == NULL)
+		{
+			fprintf(stderr, "cannot open %s\n", path);
+			return 1;
+		}
+	}
+
+	b2ThreadPool* threadPool = NULL;
+	if (threadCount > 1)
+	{
+		threadPool = new b2ThreadPool(threadCount);
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"version\": \"%d.%d.%d\",\n", b2_version.major, b2_version.minor, b2_version.revision);
+	fprintf(file, "\t\"threads\": %d,\n", threadPool != NULL ? threadPool->GetThreadCount() : 1);
+
+	int32 count = 0;
+	if (copies > 0)
+	{
+		RunGroup(file, copies, threadPool, argc, argv, first);
+		count = 1;
+	}
+	else
+	{
+		fprintf(file, "\t\"scenes\": [\n");
+
+		for (int32 i = 0; g_sceneEntries[i].name != NULL; ++i)
+		{
+			if (IsSelected(g_sceneEntries[i].name, argc, argv, first))
+			{
+				RunScene(file, g_sceneEntries[i], threadPool, count == 0);
+				++count;
+			}
+		}
+
+		fprintf(file, "\n\t]\n");
+	}
+
+	fprintf(file, "}\n");
+
+	delete threadPool;
+
+	if (file != stdout)
+	{
+		fclose(file);
+	}
+
+	return count > 0 ? 0 : 1;
+}
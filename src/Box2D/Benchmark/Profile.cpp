@@ -0,0 +1,115 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Profile.h"
+
+#include <cstddef>
+
+struct ProfileField
+{
+	const char* name;
+	size_t offset;
+	bool isCounter;
+};
+
+static const ProfileField s_profileFields[] =
+{
+	{"step", offsetof(b2Profile, step), false},
+	{"collide", offsetof(b2Profile, collide), false},
+	{"solve", offsetof(b2Profile, solve), false},
+	{"solveInit", offsetof(b2Profile, solveInit), false},
+	{"solveVelocity", offsetof(b2Profile, solveVelocity), false},
+	{"solvePosition", offsetof(b2Profile, solvePosition), false},
+	{"broadphase", offsetof(b2Profile, broadphase), false},
+	{"solveTOI", offsetof(b2Profile, solveTOI), false},
+	{"proxiesMoved", offsetof(b2Profile, proxiesMoved), true},
+	{"treeReinsertions", offsetof(b2Profile, treeReinsertions), true},
+	{"pairsFound", offsetof(b2Profile, pairsFound), true},
+	{"contactsCreated", offsetof(b2Profile, contactsCreated), true},
+	{"contactsDestroyed", offsetof(b2Profile, contactsDestroyed), true},
+	{"manifoldsUpdated", offsetof(b2Profile, manifoldsUpdated), true},
+	{"islandCount", offsetof(b2Profile, islandCount), true},
+	{"islandBodies", offsetof(b2Profile, islandBodies), true},
+	{"maxIslandBodies", offsetof(b2Profile, maxIslandBodies), true},
+	{"toiEvents", offsetof(b2Profile, toiEvents), true},
+	{"velocityIterations", offsetof(b2Profile, velocityIterations), true},
+	{"positionIterations", offsetof(b2Profile, positionIterations), true},
+	{"allocCount", offsetof(b2Profile, allocCount), true},
+	{"allocBytes", offsetof(b2Profile, allocBytes), true}
+};
+
+// Fails to compile when the table and e_profileFieldCount disagree.
+typedef char ProfileFieldCountCheck[sizeof(s_profileFields) / sizeof(s_profileFields[0]) == e_profileFieldCount ? 1 : -1];
+
+static float64 GetProfileField(const b2Profile& profile, int32 index)
+{
+	const ProfileField& field = s_profileFields[index];
+	const char* p = (const char*)&profile + field.offset;
+	if (field.isCounter)
+	{
+		return *(const int32*)p;
+	}
+
+	return *(const float32*)p;
+}
+
+static void WriteFields(FILE* file, int32 depth, const char* name, const float64* values)
+{
+	fprintf(file, "%.*s\"%s\": {", depth, "\t\t\t\t\t\t\t\t", name);
+	for (int32 i = 0; i < e_profileFieldCount; ++i)
+	{
+		fprintf(file, "%s\"%s\": %.4f", i > 0 ? ", " : "", s_profileFields[i].name, values[i]);
+	}
+	fprintf(file, "}");
+}
+
+ProfileStats::ProfileStats()
+{
+	m_count = 0;
+	for (int32 i = 0; i < e_profileFieldCount; ++i)
+	{
+		m_sum[i] = 0.0;
+		m_maximum[i] = 0.0;
+	}
+}
+
+void ProfileStats::Add(const b2Profile& profile)
+{
+	for (int32 i = 0; i < e_profileFieldCount; ++i)
+	{
+		float64 value = GetProfileField(profile, i);
+		m_sum[i] += value;
+		m_maximum[i] = b2Max(m_maximum[i], value);
+	}
+	++m_count;
+}
+
+void ProfileStats::Write(FILE* file, int32 depth) const
+{
+	float64 mean[e_profileFieldCount];
+	for (int32 i = 0; i < e_profileFieldCount; ++i)
+	{
+		mean[i] = m_count > 0 ? m_sum[i] / m_count : 0.0;
+	}
+
+	fprintf(file, "%.*s\"profile\": {\n", depth, "\t\t\t\t\t\t\t\t");
+	WriteFields(file, depth + 1, "mean", mean);
+	fprintf(file, ",\n");
+	WriteFields(file, depth + 1, "max", m_maximum);
+	fprintf(file, "\n%.*s}", depth, "\t\t\t\t\t\t\t\t");
+}
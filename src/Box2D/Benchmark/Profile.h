@@ -0,0 +1,47 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <Box2D/Box2D.h>
+#include <cstdio>
+
+enum
+{
+	e_profileFieldCount = 22
+};
+
+/// Sums b2Profile over steps and writes the mean and maximum of each field.
+class ProfileStats
+{
+public:
+	ProfileStats();
+
+	void Add(const b2Profile& profile);
+
+	/// Write a "profile" JSON member indented by depth tabs.
+	void Write(FILE* file, int32 depth) const;
+
+private:
+	int32 m_count;
+	float64 m_sum[e_profileFieldCount];
+	float64 m_maximum[e_profileFieldCount];
+};
+
+#endif
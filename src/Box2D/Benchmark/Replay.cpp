@@ -0,0 +1,202 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Profile.h"
+
+#include <Box2D/Dynamics/b2Recorder.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Usage: box2d_replay [-t threads] [-o file] log
+// Replays a log written by b2Recorder on an empty world and writes JSON with
+// the step time distribution and the b2Profile mean and maximum. Only the
+// world steps are timed, not the recorded calls between them.
+
+static void* ReadFile(const char* path, int32* size)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		return NULL;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	void* data = NULL;
+	if (length > 0)
+	{
+		data = malloc(length);
+		if (fread(data, 1, length, file) != size_t(length))
+		{
+			free(data);
+			data = NULL;
+		}
+	}
+
+	fclose(file);
+	*size = int32(length);
+	return data;
+}
+
+static float64 GetPercentile(const std::vector<float64>& sorted, float64 fraction)
+{
+	if (sorted.empty())
+	{
+		return 0.0;
+	}
+
+	size_t index = size_t(fraction * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+int main(int argc, char** argv)
+{
+	int32 threadCount = 1;
+	const char* path = NULL;
+
+	int first = 1;
+	while (first + 1 < argc && argv[first][0] == '-')
+	{
+		if (strcmp(argv[first], "-t") == 0)
+		{
+			threadCount = atoi(argv[first + 1]);
+		}
+		else if (strcmp(argv[first], "-o") == 0)
+		{
+			path = argv[first + 1];
+		}
+		else
+		{
+			break;
+		}
+
+		first += 2;
+	}
+
+	if (first + 1 != argc)
+	{
+		fprintf(stderr, "usage: box2d_replay [-t threads] [-o file] log\n");
+		return 1;
+	}
+
+	const char* logPath = argv[first];
+	int32 size = 0;
+	void* data = ReadFile(logPath, &size);
+	if (data == NULL)
+	{
+		fprintf(stderr, "cannot read %s\n", logPath);
+		return 1;
+	}
+
+	FILE* file = stdout;
+	if (path != NULL)
+	{
+		file = fopen(path, "w");
+		if (file == NULL)
+		{
+			fprintf(stderr, "cannot open %s\n", path);
+			free(data);
+			return 1;
+		}
+	}
+
+	b2ThreadPool* threadPool = NULL;
+	if (threadCount > 1)
+	{
+		threadPool = new b2ThreadPool(threadCount);
+	}
+
+	// The log starts with a snapshot, which replaces the world contents.
+	b2World world(b2Vec2(0.0f, -10.0f));
+	world.SetThreadPool(threadPool);
+
+	b2Replay replay(data, size);
+	b2ReplayStep step;
+	ProfileStats stats;
+	std::vector<float64> stepTimes;
+	float64 seconds = 0.0;
+	while (replay.ReadStep(&world, &step))
+	{
+		b2Timer timer;
+		world.Step(step.dt, step.velocityIterations, step.positionIterations);
+		float64 milliseconds = timer.GetMilliseconds();
+
+		seconds += 0.001 * milliseconds;
+		stepTimes.push_back(milliseconds);
+		stats.Add(world.GetProfile());
+	}
+
+	bool complete = replay.IsComplete();
+	if (complete == false)
+	{
+		fprintf(stderr, "%s does not replay after step %d: %s\n", logPath, int32(stepTimes.size()), replay.GetError());
+	}
+
+	float64 mean = 0.0;
+	for (size_t i = 0; i < stepTimes.size(); ++i)
+	{
+		mean += stepTimes[i];
+	}
+	mean = stepTimes.empty() ? 0.0 : mean / stepTimes.size();
+
+	std::vector<float64> sorted(stepTimes);
+	std::sort(sorted.begin(), sorted.end());
+
+	// Same as box2d_bench, so a replay can be checked against the device.
+	float64 checksum = 0.0;
+	for (b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		b2Vec2 p = b->GetPosition();
+		checksum += p.x + p.y + b->GetAngle();
+	}
+
+	int32 stepCount = int32(stepTimes.size());
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"version\": \"%d.%d.%d\",\n", b2_version.major, b2_version.minor, b2_version.revision);
+	fprintf(file, "\t\"threads\": %d,\n", threadPool != NULL ? threadPool->GetThreadCount() : 1);
+	fprintf(file, "\t\"log\": \"%s\",\n", logPath);
+	fprintf(file, "\t\"complete\": %s,\n", complete ? "true" : "false");
+	fprintf(file, "\t\"steps\": %d,\n", stepCount);
+	fprintf(file, "\t\"bodies\": %d,\n", world.GetBodyCount());
+	fprintf(file, "\t\"joints\": %d,\n", world.GetJointCount());
+	fprintf(file, "\t\"contacts\": %d,\n", world.GetContactCount());
+	fprintf(file, "\t\"seconds\": %.4f,\n", seconds);
+	fprintf(file, "\t\"stepsPerSecond\": %.2f,\n", seconds > 0.0 ? stepCount / seconds : 0.0);
+	fprintf(file, "\t\"stepTime\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+		mean, GetPercentile(sorted, 0.5), GetPercentile(sorted, 0.95), GetPercentile(sorted, 0.99),
+		sorted.empty() ? 0.0 : sorted.back());
+	fprintf(file, "\t\"checksum\": %.6f,\n", checksum);
+	stats.Write(file, 1);
+	fprintf(file, "\n}\n");
+
+	// The world must go before its thread pool.
+	world.SetThreadPool(NULL);
+	delete threadPool;
+	free(data);
+
+	if (file != stdout)
+	{
+		fclose(file);
+	}
+
+	return complete ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BENCHMARK_SCENE_H
+#define BENCHMARK_SCENE_H
+
+#include <Box2D/Box2D.h>
+#include <cstdio>
+
+/// A benchmark scene. Scenes are built from a fixed seed and stepped a fixed
+/// number of times, so results can be compared across commits.
+class Scene
+{
+public:
+	Scene();
+	virtual ~Scene() {}
+
+	/// Build the scene. The world is empty and has default settings.
+	virtual void Build(b2World* world) = 0;
+
+	/// Called before every step, for scenes that add bodies over time.
+	virtual void Step(b2World* world, int32 stepIndex) { B2_NOT_USED(world); B2_NOT_USED(stepIndex); }
+
+	/// Write extra JSON members, each preceded by a comma.
+	virtual void Report(FILE* file, b2World* world) { B2_NOT_USED(file); B2_NOT_USED(world); }
+
+	/// A random number in [lo, hi) from the scene seed.
+	float32 RandomFloat(float32 lo, float32 hi);
+
+protected:
+	uint32 m_seed;
+};
+
+typedef Scene* SceneCreateFcn();
+
+struct SceneEntry
+{
+	const char* name;
+	int32 stepCount;
+	SceneCreateFcn* createFcn;
+};
+
+/// The scenes, ending with an entry whose name is NULL.
+extern SceneEntry g_sceneEntries[];
+
+#endif
@@ -0,0 +1,597 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Scene.h"
+
+Scene::Scene()
+{
+	m_seed = 1;
+}
+
+float32 Scene::RandomFloat(float32 lo, float32 hi)
+{
+	// A fixed LCG, so every platform builds the same scene.
+	m_seed = m_seed * 1103515245u + 12345u;
+	float32 r = (float32)((m_seed >> 8) & 0xFFFF) / 65536.0f;
+	return lo + r * (hi - lo);
+}
+
+static b2Body* CreateGround(b2World* world, float32 halfWidth)
+{
+	b2BodyDef bd;
+	b2Body* ground = world->CreateBody(&bd);
+
+	b2EdgeShape shape;
+	shape.Set(b2Vec2(-halfWidth, 0.0f), b2Vec2(halfWidth, 0.0f));
+	ground->CreateFixture(&shape, 0.0f);
+	return ground;
+}
+
+// Four pyramids of 20 rows: deep stacks with long contact chains.
+class Pyramid : public Scene
+{
+public:
+	enum
+	{
+		e_pyramidCount = 4,
+		e_rowCount = 20
+	};
+
+	void Build(b2World* world)
+	{
+		CreateGround(world, 80.0f);
+
+		float32 a = 0.5f;
+		b2PolygonShape shape;
+		shape.SetAsBox(a, a);
+
+		for (int32 p = 0; p < e_pyramidCount; ++p)
+		{
+			b2Vec2 x(-60.0f + 30.0f * p, 0.75f);
+			b2Vec2 deltaX(0.5625f, 1.25f);
+			b2Vec2 deltaY(1.125f, 0.0f);
+
+			for (int32 i = 0; i < e_rowCount; ++i)
+			{
+				b2Vec2 y = x;
+
+				for (int32 j = i; j < e_rowCount; ++j)
+				{
+					b2BodyDef bd;
+					bd.type = b2_dynamicBody;
+					bd.position = y;
+					b2Body* body = world->CreateBody(&bd);
+					body->CreateFixture(&shape, 5.0f);
+
+					y += deltaY;
+				}
+
+				x += deltaX;
+			}
+		}
+	}
+
+	static Scene* Create()
+	{
+		return new Pyramid;
+	}
+};
+
+// A motorized box that keeps tumbling small boxes added one per step.
+class Tumbler : public Scene
+{
+public:
+	enum
+	{
+		e_count = 800
+	};
+
+	Tumbler()
+	{
+		m_count = 0;
+	}
+
+	void Build(b2World* world)
+	{
+		b2BodyDef bd;
+		b2Body* ground = world->CreateBody(&bd);
+
+		bd.type = b2_dynamicBody;
+		bd.allowSleep = false;
+		bd.position.Set(0.0f, 10.0f);
+		b2Body* body = world->CreateBody(&bd);
+
+		b2PolygonShape shape;
+		shape.SetAsBox(0.5f, 10.0f, b2Vec2( 10.0f, 0.0f), 0.0);
+		body->CreateFixture(&shape, 5.0f);
+		shape.SetAsBox(0.5f, 10.0f, b2Vec2(-10.0f, 0.0f), 0.0);
+		body->CreateFixture(&shape, 5.0f);
+		shape.SetAsBox(10.0f, 0.5f, b2Vec2(0.0f, 10.0f), 0.0);
+		body->CreateFixture(&shape, 5.0f);
+		shape.SetAsBox(10.0f, 0.5f, b2Vec2(0.0f, -10.0f), 0.0);
+		body->CreateFixture(&shape, 5.0f);
+
+		b2RevoluteJointDef jd;
+		jd.bodyA = ground;
+		jd.bodyB = body;
+		jd.localAnchorA.Set(0.0f, 10.0f);
+		jd.localAnchorB.Set(0.0f, 0.0f);
+		jd.referenceAngle = 0.0f;
+		jd.motorSpeed = 0.05f * b2_pi;
+		jd.maxMotorTorque = 1e8f;
+		jd.enableMotor = true;
+		world->CreateJoint(&jd);
+	}
+
+	void Step(b2World* world, int32 stepIndex)
+	{
+		B2_NOT_USED(stepIndex);
+
+		if (m_count < e_count)
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.position.Set(0.0f, 10.0f);
+			b2Body* body = world->CreateBody(&bd);
+
+			b2PolygonShape shape;
+			shape.SetAsBox(0.125f, 0.125f);
+			body->CreateFixture(&shape, 1.0f);
+
+			++m_count;
+		}
+	}
+
+	static Scene* Create()
+	{
+		return new Tumbler;
+	}
+
+	int32 m_count;
+};
+
+// Thousands of circles poured into a bin.
+class Circles : public Scene
+{
+public:
+	enum
+	{
+		e_count = 3000
+	};
+
+	void Build(b2World* world)
+	{
+		m_seed = 3;
+
+		b2Body* ground = CreateGround(world, 20.0f);
+
+		b2PolygonShape wall;
+		wall.SetAsBox(0.5f, 40.0f, b2Vec2(-20.5f, 40.0f), 0.0f);
+		ground->CreateFixture(&wall, 0.0f);
+		wall.SetAsBox(0.5f, 40.0f, b2Vec2(20.5f, 40.0f), 0.0f);
+		ground->CreateFixture(&wall, 0.0f);
+
+		b2CircleShape shape;
+		b2FixtureDef fd;
+		fd.shape = &shape;
+		fd.density = 1.0f;
+		fd.friction = 0.3f;
+
+		for (int32 i = 0; i < e_count; ++i)
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.position.Set(RandomFloat(-19.0f, 19.0f), 2.0f + 0.04f * i);
+			b2Body* body = world->CreateBody(&bd);
+
+			shape.m_radius = RandomFloat(0.15f, 0.3f);
+			body->CreateFixture(&fd);
+		}
+	}
+
+	static Scene* Create()
+	{
+		return new Circles;
+	}
+};
+
+// Cars with wheel joints driving over a long chain shape.
+class Terrain : public Scene
+{
+public:
+	enum
+	{
+		e_vertexCount = 400,
+		e_carCount = 20
+	};
+
+	void Build(b2World* world)
+	{
+		m_seed = 5;
+
+		b2BodyDef bd;
+		b2Body* ground = world->CreateBody(&bd);
+
+		b2Vec2 vertices[e_vertexCount];
+		float32 h = 0.0f;
+		for (int32 i = 0; i < e_vertexCount; ++i)
+		{
+			h = b2Clamp(h + RandomFloat(-0.6f, 0.6f), -4.0f, 4.0f);
+			vertices[i].Set(-40.0f + 2.0f * i, i < 30 ? 0.0f : h);
+		}
+
+		b2ChainShape chain;
+		chain.CreateChain(vertices, e_vertexCount);
+		b2FixtureDef fd;
+		fd.shape = &chain;
+		fd.friction = 0.8f;
+		ground->CreateFixture(&fd);
+
+		b2PolygonShape chassis;
+		b2Vec2 hull[6];
+		hull[0].Set(-1.5f, -0.5f);
+		hull[1].Set(1.5f, -0.5f);
+		hull[2].Set(1.5f, 0.0f);
+		hull[3].Set(0.0f, 0.9f);
+		hull[4].Set(-1.15f, 0.9f);
+		hull[5].Set(-1.5f, 0.2f);
+		chassis.Set(hull, 6);
+
+		b2CircleShape wheel;
+		wheel.m_radius = 0.4f;
+
+		b2FixtureDef wheelDef;
+		wheelDef.shape = &wheel;
+		wheelDef.density = 1.0f;
+		wheelDef.friction = 0.9f;
+
+		// Cars of one group do not collide with each other.
+		wheelDef.filter.groupIndex = -1;
+
+		b2FixtureDef chassisDef;
+		chassisDef.shape = &chassis;
+		chassisDef.density = 1.0f;
+		chassisDef.filter.groupIndex = -1;
+
+		for (int32 i = 0; i < e_carCount; ++i)
+		{
+			float32 x = -35.0f + 3.5f * i;
+
+			b2BodyDef cd;
+			cd.type = b2_dynamicBody;
+			cd.position.Set(x, 1.5f);
+			b2Body* car = world->CreateBody(&cd);
+			car->CreateFixture(&chassisDef);
+
+			cd.position.Set(x - 1.0f, 0.75f);
+			b2Body* wheel1 = world->CreateBody(&cd);
+			wheel1->CreateFixture(&wheelDef);
+
+			cd.position.Set(x + 1.0f, 0.75f);
+			b2Body* wheel2 = world->CreateBody(&cd);
+			wheel2->CreateFixture(&wheelDef);
+
+			b2WheelJointDef jd;
+			b2Vec2 axis(0.0f, 1.0f);
+			jd.Initialize(car, wheel1, wheel1->GetPosition(), axis);
+			jd.motorSpeed = -20.0f;
+			jd.maxMotorTorque = 20.0f;
+			jd.enableMotor = true;
+			jd.frequencyHz = 4.0f;
+			jd.dampingRatio = 0.7f;
+			world->CreateJoint(&jd);
+
+			jd.Initialize(car, wheel2, wheel2->GetPosition(), axis);
+			jd.motorSpeed = 0.0f;
+			jd.maxMotorTorque = 10.0f;
+			jd.enableMotor = false;
+			world->CreateJoint(&jd);
+		}
+	}
+
+	static Scene* Create()
+	{
+		return new Terrain;
+	}
+};
+
+// Ragdolls of ten bodies and nine limited revolute joints.
+class Ragdolls : public Scene
+{
+public:
+	enum
+	{
+		e_count = 60
+	};
+
+	b2Body* CreatePart(b2World* world, const b2Vec2& position, const b2Shape* shape)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position = position;
+		bd.linearVelocity.Set(RandomFloat(-5.0f, 5.0f), RandomFloat(-5.0f, 5.0f));
+		b2Body* body = world->CreateBody(&bd);
+
+		b2FixtureDef fd;
+		fd.shape = shape;
+		fd.density = 1.0f;
+		fd.friction = 0.4f;
+		fd.filter.groupIndex = -1;
+		body->CreateFixture(&fd);
+		return body;
+	}
+
+	void Connect(b2World* world, b2Body* bodyA, b2Body* bodyB, const b2Vec2& anchor, float32 lower, float32 upper)
+	{
+		b2RevoluteJointDef jd;
+		jd.Initialize(bodyA, bodyB, anchor);
+		jd.enableLimit = true;
+		jd.lowerAngle = lower;
+		jd.upperAngle = upper;
+		world->CreateJoint(&jd);
+	}
+
+	void CreateRagdoll(b2World* world, const b2Vec2& p)
+	{
+		b2CircleShape head;
+		head.m_radius = 0.25f;
+
+		b2PolygonShape torso;
+		torso.SetAsBox(0.2f, 0.25f);
+
+		b2PolygonShape limb;
+		limb.SetAsBox(0.08f, 0.25f);
+
+		float32 q = 0.25f * b2_pi;
+
+		b2Body* chest = CreatePart(world, p + b2Vec2(0.0f, 1.5f), &torso);
+		b2Body* belly = CreatePart(world, p + b2Vec2(0.0f, 1.0f), &torso);
+		b2Body* hips = CreatePart(world, p + b2Vec2(0.0f, 0.5f), &torso);
+		b2Body* neck = CreatePart(world, p + b2Vec2(0.0f, 2.0f), &head);
+		Connect(world, chest, belly, p + b2Vec2(0.0f, 1.25f), -q, q);
+		Connect(world, belly, hips, p + b2Vec2(0.0f, 0.75f), -q, q);
+		Connect(world, chest, neck, p + b2Vec2(0.0f, 1.75f), -q, q);
+
+		for (int32 side = -1; side <= 1; side += 2)
+		{
+			float32 s = (float32)side;
+
+			b2Body* upperArm = CreatePart(world, p + b2Vec2(0.3f * s, 1.5f), &limb);
+			b2Body* lowerArm = CreatePart(world, p + b2Vec2(0.3f * s, 1.0f), &limb);
+			Connect(world, chest, upperArm, p + b2Vec2(0.3f * s, 1.75f), -2.0f * q, 2.0f * q);
+			Connect(world, upperArm, lowerArm, p + b2Vec2(0.3f * s, 1.25f), -2.0f * q, 0.0f);
+
+			b2Body* upperLeg = CreatePart(world, p + b2Vec2(0.12f * s, 0.0f), &limb);
+			b2Body* lowerLeg = CreatePart(world, p + b2Vec2(0.12f * s, -0.5f), &limb);
+			Connect(world, hips, upperLeg, p + b2Vec2(0.12f * s, 0.25f), -q, q);
+			Connect(world, upperLeg, lowerLeg, p + b2Vec2(0.12f * s, -0.25f), 0.0f, 2.0f * q);
+		}
+	}
+
+	void Build(b2World* world)
+	{
+		m_seed = 11;
+
+		CreateGround(world, 40.0f);
+
+		for (int32 i = 0; i < e_count; ++i)
+		{
+			b2Vec2 p(-30.0f + 6.0f * (i % 10), 2.0f + 4.0f * (i / 10));
+			CreateRagdoll(world, p);
+		}
+	}
+
+	static Scene* Create()
+	{
+		return new Ragdolls;
+	}
+};
+
+// Fast bodies fired at a thin wall. Half of them are bullets. The report
+// counts the bodies that passed through the wall.
+class Bullets : public Scene
+{
+public:
+	enum
+	{
+		e_count = 200
+	};
+
+	Bullets(bool speculative)
+	{
+		m_speculative = speculative;
+	}
+
+	void Build(b2World* world)
+	{
+		m_seed = 7;
+
+		world->SetSpeculativeContacts(m_speculative);
+
+		b2Body* ground = CreateGround(world, 100.0f);
+
+		b2PolygonShape wall;
+		wall.SetAsBox(0.05f, 20.0f, b2Vec2(40.0f, 20.0f), 0.0f);
+		ground->CreateFixture(&wall, 0.0f);
+
+		b2CircleShape circle;
+		circle.m_radius = 0.1f;
+
+		b2PolygonShape box;
+		box.SetAsBox(0.1f, 0.1f);
+
+		for (int32 i = 0; i < e_count; ++i)
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.bullet = (i % 2) == 0;
+			bd.position.Set(RandomFloat(-20.0f, 20.0f), 1.0f + (i % 30));
+			bd.linearVelocity.Set(RandomFloat(150.0f, 350.0f), -5.0f);
+			b2Body* body = world->CreateBody(&bd);
+
+			b2FixtureDef fd;
+			fd.density = 1.0f;
+			fd.shape = (i % 3) != 0 ? (b2Shape*)&circle : (b2Shape*)&box;
+			body->CreateFixture(&fd);
+		}
+	}
+
+	void Report(FILE* file, b2World* world)
+	{
+		int32 count = 0;
+		int32 tunnelled = 0;
+		for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+		{
+			if (b->GetType() != b2_dynamicBody)
+			{
+				continue;
+			}
+
+			++count;
+			if (b->GetPosition().x > 40.0f)
+			{
+				++tunnelled;
+			}
+		}
+
+		fprintf(file, ", \"tunnelled\": %d, \"tunnelRate\": %.4f", tunnelled, count > 0 ? (float32)tunnelled / count : 0.0f);
+	}
+
+	static Scene* CreateTOI()
+	{
+		return new Bullets(false);
+	}
+
+	static Scene* CreateSpeculative()
+	{
+		return new Bullets(true);
+	}
+
+	bool m_speculative;
+};
+
+// Sleeping columns of boxes and a few circles kept awake by a kinematic
+// paddle. The columns settle before timing starts, so about 95% of the
+// bodies sleep for the whole run.
+class Sleeping : public Scene
+{
+public:
+	enum
+	{
+		e_columnCount = 190,
+		e_rowCount = 10,
+		e_circleCount = 100,
+		e_settleSteps = 240
+	};
+
+	void Build(b2World* world)
+	{
+		m_seed = 13;
+
+		b2Body* ground = CreateGround(world, 160.0f);
+
+		b2PolygonShape box;
+		box.SetAsBox(0.5f, 0.5f);
+
+		for (int32 i = 0; i < e_columnCount; ++i)
+		{
+			for (int32 j = 0; j < e_rowCount; ++j)
+			{
+				b2BodyDef bd;
+				bd.type = b2_dynamicBody;
+				bd.position.Set(-150.0f + 1.5f * i, 0.5f + 1.0f * j);
+				b2Body* body = world->CreateBody(&bd);
+				body->CreateFixture(&box, 1.0f);
+			}
+		}
+
+		// The awake bodies are boxed in, away from the columns.
+		b2PolygonShape wall;
+		wall.SetAsBox(0.5f, 10.0f, b2Vec2(140.0f, 10.0f), 0.0f);
+		ground->CreateFixture(&wall, 0.0f);
+		wall.SetAsBox(0.5f, 10.0f, b2Vec2(160.0f, 10.0f), 0.0f);
+		ground->CreateFixture(&wall, 0.0f);
+		wall.SetAsBox(10.5f, 0.5f, b2Vec2(150.0f, 20.5f), 0.0f);
+		ground->CreateFixture(&wall, 0.0f);
+
+		b2BodyDef pd;
+		pd.type = b2_kinematicBody;
+		pd.position.Set(150.0f, 2.0f);
+		pd.angularVelocity = 2.0f;
+		b2Body* paddle = world->CreateBody(&pd);
+		b2PolygonShape blade;
+		blade.SetAsBox(4.0f, 0.25f);
+		paddle->CreateFixture(&blade, 0.0f);
+
+		b2CircleShape circle;
+		circle.m_radius = 0.3f;
+
+		for (int32 i = 0; i < e_circleCount; ++i)
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.position.Set(RandomFloat(142.0f, 158.0f), RandomFloat(6.0f, 18.0f));
+			b2Body* body = world->CreateBody(&bd);
+			body->CreateFixture(&circle, 1.0f);
+		}
+
+		for (int32 i = 0; i < e_settleSteps; ++i)
+		{
+			world->Step(1.0f / 60.0f, 8, 3);
+		}
+	}
+
+	void Report(FILE* file, b2World* world)
+	{
+		int32 count = 0;
+		int32 awake = 0;
+		for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+		{
+			if (b->GetType() != b2_dynamicBody)
+			{
+				continue;
+			}
+
+			++count;
+			if (b->IsAwake())
+			{
+				++awake;
+			}
+		}
+
+		fprintf(file, ", \"awakeFraction\": %.4f", count > 0 ? (float32)awake / count : 0.0f);
+	}
+
+	static Scene* Create()
+	{
+		return new Sleeping;
+	}
+};
+
+SceneEntry g_sceneEntries[] =
+{
+	{"pyramid", 600, Pyramid::Create},
+	{"tumbler", 1000, Tumbler::Create},
+	{"circles", 600, Circles::Create},
+	{"terrain", 900, Terrain::Create},
+	{"ragdolls", 600, Ragdolls::Create},
+	{"bullets_toi", 240, Bullets::CreateTOI},
+	{"bullets_speculative", 240, Bullets::CreateSpeculative},
+	{"sleeping", 600, Sleeping::Create},
+	{NULL, 0, NULL}
+};
@@ -0,0 +1,211 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Scene.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Usage: box2d_snapshot_check [-n corruptions] [scene ...]
+// Feeds damaged snapshots to b2World::LoadSnapshot. Each scene is stepped
+// halfway and saved. Every truncated copy of the snapshot must fail to load
+// and leave the world empty. Copies with a few random bytes changed must
+// either fail the same way or load into a world that can be queried and
+// cleared. The intact snapshot must still load and then step exactly like
+// the saved world. Exits with 1 on a failed check. Build with AddressSanitizer to also catch out of bounds accesses.
+
+struct CountFixtures : public b2QueryCallback
+{
+	bool ReportFixture(b2Fixture* fixture)
+	{
+		B2_NOT_USED(fixture);
+		++count;
+		return true;
+	}
+
+	int32 count;
+};
+
+static bool IsEmpty(const b2World* world)
+{
+	return world->GetBodyCount() == 0 && world->GetJointCount() == 0 &&
+		world->GetContactCount() == 0 && world->GetProxyCount() == 0;
+}
+
+// Step both worlds and compare the body transforms bit by bit. The bodies
+// of a loaded world keep their list order.
+static bool StepsAlike(b2World* a, b2World* b, int32 stepCount)
+{
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		a->Step(1.0f / 60.0f, 8, 3);
+		b->Step(1.0f / 60.0f, 8, 3);
+	}
+
+	const b2Body* bodyB = b->GetBodyList();
+	for (const b2Body* bodyA = a->GetBodyList(); bodyA; bodyA = bodyA->GetNext())
+	{
+		if (bodyB == NULL)
+		{
+			return false;
+		}
+
+		b2Transform xfA = bodyA->GetTransform();
+		b2Transform xfB = bodyB->GetTransform();
+		if (memcmp(&xfA, &xfB, sizeof(b2Transform)) != 0)
+		{
+			return false;
+		}
+		bodyB = bodyB->GetNext();
+	}
+
+	return bodyB == NULL;
+}
+
+static uint32 g_seed = 1;
+
+static int32 RandomInt(int32 count)
+{
+	g_seed = g_seed * 1664525u + 1013904223u;
+	return int32((g_seed >> 8) % uint32(count));
+}
+
+static bool CheckScene(const SceneEntry& entry, int32 corruptionCount)
+{
+	b2World world(b2Vec2(0.0f, -10.0f));
+	Scene* scene = entry.createFcn();
+	scene->Build(&world);
+	for (int32 i = 0; i < entry.stepCount / 2; ++i)
+	{
+		scene->Step(&world, i);
+		world.Step(1.0f / 60.0f, 8, 3);
+	}
+	delete scene;
+
+	int32 size = world.SaveSnapshot(NULL, 0);
+	std::vector<char> snapshot(size);
+	world.SaveSnapshot(&snapshot[0], size);
+
+	b2World loaded(b2Vec2(0.0f, -10.0f));
+	bool passed = true;
+
+	// Truncated copies, at most a few hundred of them.
+	int32 truncatedCount = 0;
+	for (int32 cut = 0; cut < size; cut += 1 + size / 256)
+	{
+		if (loaded.LoadSnapshot(&snapshot[0], cut) || IsEmpty(&loaded) == false)
+		{
+			printf("%s: truncated at %d bytes was not rejected\n", entry.name, cut);
+			passed = false;
+		}
+		++truncatedCount;
+	}
+
+	// Corrupted copies.
+	int32 rejectedCount = 0;
+	std::vector<char> corrupted(size);
+	for (int32 i = 0; i < corruptionCount; ++i)
+	{
+		corrupted = snapshot;
+		int32 byteCount = 1 + RandomInt(4);
+		for (int32 j = 0; j < byteCount; ++j)
+		{
+			corrupted[RandomInt(size)] = char(RandomInt(256));
+		}
+
+		if (loaded.LoadSnapshot(&corrupted[0], size) == false)
+		{
+			if (IsEmpty(&loaded) == false)
+			{
+				printf("%s: corrupted copy %d failed but left objects\n", entry.name, i);
+				passed = false;
+			}
+			++rejectedCount;
+			continue;
+		}
+
+		// Damaged values can still be accepted. The proxies must be usable.
+		b2AABB aabb;
+		aabb.lowerBound.Set(-b2_maxFloat, -b2_maxFloat);
+		aabb.upperBound.Set(b2_maxFloat, b2_maxFloat);
+		CountFixtures callback;
+		callback.count = 0;
+		loaded.QueryAABB(&callback, aabb);
+		loaded.Clear();
+	}
+
+	if (loaded.LoadSnapshot(&snapshot[0], size) == false)
+	{
+		printf("%s: the intact snapshot did not load\n", entry.name);
+		passed = false;
+	}
+	else if (StepsAlike(&world, &loaded, 120) == false)
+	{
+		printf("%s: the loaded world diverged\n", entry.name);
+		passed = false;
+	}
+
+	printf("%-20s bytes %6d truncated %3d corrupted %4d rejected %4d %s\n",
+		entry.name, size, truncatedCount, corruptionCount, rejectedCount, passed ? "ok" : "FAILED");
+	return passed;
+}
+
+int main(int argc, char** argv)
+{
+	int32 corruptionCount = 200;
+
+	int first = 1;
+	while (first + 1 < argc && argv[first][0] == '-')
+	{
+		if (strcmp(argv[first], "-n") == 0)
+		{
+			corruptionCount = atoi(argv[first + 1]);
+		}
+		else
+		{
+			fprintf(stderr, "usage: box2d_snapshot_check [-n corruptions] [scene ...]\n");
+			return 1;
+		}
+
+		first += 2;
+	}
+
+	bool passed = true;
+	int32 count = 0;
+	for (int32 i = 0; g_sceneEntries[i].name != NULL; ++i)
+	{
+		const SceneEntry& entry = g_sceneEntries[i];
+
+		bool selected = first == argc;
+		for (int j = first; j < argc; ++j)
+		{
+			selected = selected || strcmp(argv[j], entry.name) == 0;
+		}
+
+		if (selected == false)
+		{
+			continue;
+		}
+
+		passed = CheckScene(entry, corruptionCount) && passed;
+		++count;
+	}
+
+	return count > 0 && passed ? 0 : 1;
+}
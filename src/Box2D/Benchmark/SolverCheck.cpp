@@ -0,0 +1,264 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Scene.h"
+
+#include <Box2D/Common/b2Simd.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// Usage: box2d_solver_check [-i iterations] [scene ...]
+// Checks the wide contact solver against the scalar solver. Each scene is
+// stepped with the sequential solver. Every few steps the world is forked
+// twice and the copies are stepped once, one with the sequential solver and
+// one with the colored solver, using the given velocity iterations. The
+// colored copy solves every wide group lane by lane with the scalar solver as
+// well, see b2World::SetWideSolverCheck. Exits with 1 if any lane differs by
+// more than a relative 1e-5.
+// The colored and sequential solvers visit the constraints in a different
+// order, so their results drift apart. The largest difference over all checks
+// is printed per scene, but it does not fail the check.
+// Each scene is checked a second time with sub-stepping, where every step
+// solves at most one TOI event. The colored copy then runs on a thread pool,
+// so TOIs are computed both in parallel and one by one.
+// A bouncing ball is also dropped at several speeds, once with TOI events and
+// once with speculative contacts. Both must bounce back to the same height.
+
+enum
+{
+	e_checkInterval = 10
+};
+
+struct SolverDiff
+{
+	float32 velocity;
+	float32 position;
+	int32 checks;
+	int32 differing;	// checks where the results were not identical
+	int32 lanes;		// wide solver lanes compared with the scalar solver
+	int32 mismatched;	// lanes that differed
+};
+
+// Gauss-Seidel results depend on the constraint order, so single bodies can
+// differ a lot while the island as a whole agrees. The root mean square of
+// the velocity difference is taken relative to that of the velocities, and
+// the position difference is in meters.
+static void Compare(b2World* sequential, b2World* colored, SolverDiff* diff)
+{
+	float64 velocitySum = 0.0, velocityDiffSum = 0.0, positionDiffSum = 0.0;
+	int32 count = 0;
+
+	const b2Body* a = sequential->GetBodyList();
+	const b2Body* b = colored->GetBodyList();
+	for (; a && b; a = a->GetNext(), b = b->GetNext())
+	{
+		b2Vec2 va = a->GetLinearVelocity();
+		float32 wa = a->GetAngularVelocity();
+		b2Vec2 dv = va - b->GetLinearVelocity();
+		float32 dw = wa - b->GetAngularVelocity();
+		velocitySum += b2Dot(va, va) + wa * wa;
+		velocityDiffSum += b2Dot(dv, dv) + dw * dw;
+
+		b2Vec2 dp = a->GetPosition() - b->GetPosition();
+		positionDiffSum += b2Dot(dp, dp);
+		++count;
+	}
+
+	b2Assert(a == NULL && b == NULL);
+
+	++diff->checks;
+	if (velocityDiffSum > 0.0 || positionDiffSum > 0.0)
+	{
+		++diff->differing;
+		float64 velocity = sqrt(velocityDiffSum / b2Max(velocitySum, 1.0));
+		float64 position = sqrt(positionDiffSum / count);
+		diff->velocity = b2Max(diff->velocity, float32(velocity));
+		diff->position = b2Max(diff->position, float32(position));
+	}
+}
+
+static void Fork(b2World* world, b2World* copy, bool colored)
+{
+	bool ok = world->Fork(copy);
+	b2Assert(ok);
+	B2_NOT_USED(ok);
+	copy->SetColoredSolver(colored);
+}
+
+static void CheckScene(const SceneEntry& entry, int32 iterations, b2ThreadPool* threadPool, SolverDiff* diff)
+{
+	b2World world(b2Vec2(0.0f, -10.0f));
+	b2World sequential(b2Vec2(0.0f, -10.0f));
+	b2World colored(b2Vec2(0.0f, -10.0f));
+	colored.SetThreadPool(threadPool);
+	colored.SetWideSolverCheck(true);
+
+	Scene* scene = entry.createFcn();
+	scene->Build(&world);
+	world.SetSubStepping(threadPool != NULL);
+
+	for (int32 i = 0; i < entry.stepCount; ++i)
+	{
+		scene->Step(&world, i);
+
+		if (i % e_checkInterval == 0)
+		{
+			Fork(&world, &sequential, false);
+			Fork(&world, &colored, true);
+			sequential.Step(1.0f / 60.0f, iterations, 3);
+			colored.Step(1.0f / 60.0f, iterations, 3);
+			Compare(&sequential, &colored, diff);
+		}
+
+		world.Step(1.0f / 60.0f, 8, 3);
+	}
+
+	diff->lanes = colored.GetWideSolverStats().laneCount;
+	diff->mismatched = colored.GetWideSolverStats().mismatchCount;
+
+	delete scene;
+}
+
+// Drop a ball with full restitution onto the ground and return the height of
+// its first bounce.
+static float32 Bounce(bool speculative, float32 speed)
+{
+	b2World world(b2Vec2(0.0f, -10.0f));
+	world.SetSpeculativeContacts(speculative);
+
+	b2BodyDef bd;
+	b2Body* ground = world.CreateBody(&bd);
+	b2EdgeShape edge;
+	edge.Set(b2Vec2(-10.0f, 0.0f), b2Vec2(10.0f, 0.0f));
+	ground->CreateFixture(&edge, 0.0f);
+
+	bd.type = b2_dynamicBody;
+	bd.bullet = true;
+	bd.position.Set(0.0f, 2.0f);
+	bd.linearVelocity.Set(0.0f, -speed);
+	b2Body* ball = world.CreateBody(&bd);
+
+	b2CircleShape circle;
+	circle.m_radius = 0.25f;
+	b2FixtureDef fd;
+	fd.shape = &circle;
+	fd.density = 1.0f;
+	fd.friction = 0.0f;
+	fd.restitution = 1.0f;
+	ball->CreateFixture(&fd);
+
+	bool bounced = false;
+	float32 height = 0.0f;
+	for (int32 i = 0; i < 600; ++i)
+	{
+		world.Step(1.0f / 60.0f, 8, 3);
+
+		float32 vy = ball->GetLinearVelocity().y;
+		if (bounced && vy <= 0.0f)
+		{
+			break;
+		}
+
+		bounced = bounced || vy > 0.0f;
+		height = ball->GetPosition().y;
+	}
+
+	return bounced ? height : 0.0f;
+}
+
+int main(int argc, char** argv)
+{
+	int32 iterations = 8;
+
+	int first = 1;
+	while (first + 1 < argc && argv[first][0] == '-')
+	{
+		if (strcmp(argv[first], "-i") == 0)
+		{
+			iterations = atoi(argv[first + 1]);
+		}
+		else
+		{
+			fprintf(stderr, "usage: box2d_solver_check [-i iterations] [scene ...]\n");
+			return 1;
+		}
+
+		first += 2;
+	}
+
+	b2ThreadPool threadPool(4);
+
+	bool passed = true;
+	int32 count = 0;
+	int32 laneCount = 0;
+	for (int32 i = 0; g_sceneEntries[i].name != NULL; ++i)
+	{
+		const SceneEntry& entry = g_sceneEntries[i];
+
+		bool selected = first == argc;
+		for (int j = first; j < argc; ++j)
+		{
+			selected = selected || strcmp(argv[j], entry.name) == 0;
+		}
+
+		if (selected == false)
+		{
+			continue;
+		}
+
+		for (int32 subStepping = 0; subStepping < 2; ++subStepping)
+		{
+			SolverDiff diff;
+			memset(&diff, 0, sizeof(diff));
+			CheckScene(entry, iterations, subStepping ? &threadPool : NULL, &diff);
+
+			bool ok = diff.mismatched == 0;
+			printf("%-20s %-8s checks %4d differing %4d velocity %.6f position %.6f lanes %7d mismatched %d %s\n",
+				entry.name, subStepping ? "substep" : "", diff.checks, diff.differing,
+				diff.velocity, diff.position, diff.lanes, diff.mismatched, ok ? "ok" : "FAILED");
+
+			passed = passed && ok;
+			laneCount += diff.lanes;
+		}
+
+		++count;
+	}
+
+	// The scenes with large islands must have reached the wide solver.
+	if (B2_SIMD_WIDTH > 0 && count > 0 && laneCount == 0)
+	{
+		printf("no wide solver lanes were checked\n");
+		passed = false;
+	}
+
+	const float32 speeds[] = {5.0f, 20.0f, 60.0f};
+	for (int32 i = 0; i < int32(sizeof(speeds) / sizeof(speeds[0])); ++i)
+	{
+		float32 toi = Bounce(false, speeds[i]);
+		float32 speculative = Bounce(true, speeds[i]);
+		bool ok = b2Abs(speculative - toi) <= 0.1f * toi;
+		printf("bounce %5.1f m/s            toi %.3f speculative %.3f %s\n",
+			speeds[i], toi, speculative, ok ? "ok" : "FAILED");
+
+		passed = passed && ok;
+	}
+
+	return count > 0 && passed ? 0 : 1;
+}
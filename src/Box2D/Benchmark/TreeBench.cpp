@@ -0,0 +1,337 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Box2D.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Usage: box2d_tree_bench [-n maxProxies] [-o file]
+// Benchmarks b2DynamicTree on its own at 1k, 10k, 100k and 1M proxies for
+// uniform, clustered and corridor layouts. Each phase reports its throughput
+// and the tree height, maximum balance and area ratio afterwards.
+
+enum Distribution
+{
+	e_uniform,
+	e_clustered,
+	e_corridor,
+	e_distributionCount
+};
+
+static const char* s_distributionNames[e_distributionCount] =
+{
+	"uniform",
+	"clustered",
+	"corridor"
+};
+
+enum
+{
+	e_clusterCount = 32,
+	e_queryCount = 10000,
+	e_rayCount = 10000
+};
+
+static uint32 s_seed = 1;
+
+static float32 RandomFloat(float32 lo, float32 hi)
+{
+	s_seed = s_seed * 1103515245u + 12345u;
+	float32 r = (float32)((s_seed >> 8) & 0xFFFF) / 65536.0f;
+	return lo + r * (hi - lo);
+}
+
+static int32 RandomInt(int32 count)
+{
+	s_seed = s_seed * 1103515245u + 12345u;
+	return (int32)((s_seed >> 8) % (uint32)count);
+}
+
+// Proxy centers for one layout. Every layout has about one proxy per four
+// square meters on average.
+class Layout
+{
+public:
+	Layout(Distribution distribution, int32 count)
+	{
+		m_distribution = distribution;
+
+		float32 area = 4.0f * count;
+		if (distribution == e_corridor)
+		{
+			m_extent.Set(area / 8.0f, 8.0f);
+		}
+		else
+		{
+			float32 side = b2Sqrt(area);
+			m_extent.Set(side, side);
+		}
+
+		for (int32 i = 0; i < e_clusterCount; ++i)
+		{
+			m_clusters[i].Set(RandomFloat(0.0f, m_extent.x), RandomFloat(0.0f, m_extent.y));
+		}
+
+		// Clusters cover a tenth of the area, so they are ten times as dense.
+		m_clusterRadius = b2Sqrt(0.1f * area / (e_clusterCount * b2_pi));
+	}
+
+	b2Vec2 Sample()
+	{
+		if (m_distribution == e_clustered)
+		{
+			const b2Vec2& c = m_clusters[RandomInt(e_clusterCount)];
+			float32 r = m_clusterRadius;
+			b2Vec2 offset(RandomFloat(-r, r) + RandomFloat(-r, r), RandomFloat(-r, r) + RandomFloat(-r, r));
+			return c + 0.5f * offset;
+		}
+
+		return b2Vec2(RandomFloat(0.0f, m_extent.x), RandomFloat(0.0f, m_extent.y));
+	}
+
+	Distribution m_distribution;
+	b2Vec2 m_extent;
+	b2Vec2 m_clusters[e_clusterCount];
+	float32 m_clusterRadius;
+};
+
+struct Proxy
+{
+	b2Vec2 center;
+	b2Vec2 halfExtent;
+	int32 id;
+};
+
+static b2AABB GetAABB(const Proxy& proxy)
+{
+	b2AABB aabb;
+	aabb.lowerBound = proxy.center - proxy.halfExtent;
+	aabb.upperBound = proxy.center + proxy.halfExtent;
+	return aabb;
+}
+
+class QueryCounter
+{
+public:
+	QueryCounter()
+	{
+		m_count = 0;
+	}
+
+	bool QueryCallback(int32 proxyId)
+	{
+		B2_NOT_USED(proxyId);
+		++m_count;
+		return true;
+	}
+
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		B2_NOT_USED(proxyId);
+		++m_count;
+		return input.maxFraction;
+	}
+
+	int32 m_count;
+};
+
+static void WritePhase(FILE* file, const char* name, float64 seconds, int32 operations, const b2DynamicTree& tree, const char* extraName, int32 extra, bool first)
+{
+	fprintf(file, "%s\t\t\t\t{\"name\": \"%s\", \"seconds\": %.6f, \"opsPerSecond\": %.0f", first ? "" : ",\n", name, seconds, seconds > 0.0 ? operations / seconds : 0.0);
+	if (extraName != NULL)
+	{
+		fprintf(file, ", \"%s\": %d", extraName, extra);
+	}
+	fprintf(file, ", \"height\": %d, \"maxBalance\": %d, \"areaRatio\": %.4f}", tree.GetHeight(), tree.GetMaxBalance(), tree.GetAreaRatio());
+}
+
+// Move every proxy once. The jitter stays inside the fat AABB margin, the
+// drift usually leaves it and the teleport moves to a new sample.
+static void MoveProxies(FILE* file, const char* name, b2DynamicTree* tree, Proxy* proxies, int32 count, Layout* layout, float32 step)
+{
+	b2Timer timer;
+	int32 reinsertions = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		Proxy& proxy = proxies[i];
+		b2Vec2 displacement;
+		if (step > 0.0f)
+		{
+			displacement.Set(RandomFloat(-step, step), RandomFloat(-step, step));
+			proxy.center += displacement;
+		}
+		else
+		{
+			displacement.SetZero();
+			proxy.center = layout->Sample();
+		}
+
+		if (tree->MoveProxy(proxy.id, GetAABB(proxy), displacement))
+		{
+			++reinsertions;
+		}
+	}
+	float64 seconds = 0.001 * timer.GetMilliseconds();
+
+	WritePhase(file, name, seconds, count, *tree, "reinsertions", reinsertions, false);
+}
+
+static void Run(FILE* file, Distribution distribution, int32 count, bool first)
+{
+	s_seed = 1 + 7919 * count + distribution;
+
+	Layout layout(distribution, count);
+	Proxy* proxies = (Proxy*)b2Alloc(count * sizeof(Proxy));
+	for (int32 i = 0; i < count; ++i)
+	{
+		proxies[i].center = layout.Sample();
+		proxies[i].halfExtent.Set(RandomFloat(0.25f, 0.5f), RandomFloat(0.25f, 0.5f));
+	}
+
+	fprintf(file, "%s\t\t{\n", first ? "" : ",\n");
+	fprintf(file, "\t\t\t\"distribution\": \"%s\",\n", s_distributionNames[distribution]);
+	fprintf(file, "\t\t\t\"proxies\": %d,\n", count);
+	fprintf(file, "\t\t\t\"phases\": [\n");
+
+	b2DynamicTree tree;
+
+	b2Timer timer;
+	for (int32 i = 0; i < count; ++i)
+	{
+		proxies[i].id = tree.CreateProxy(GetAABB(proxies[i]), proxies + i);
+	}
+	WritePhase(file, "create", 0.001 * timer.GetMilliseconds(), count, tree, NULL, 0, true);
+
+	MoveProxies(file, "moveJitter", &tree, proxies, count, &layout, 0.05f);
+	MoveProxies(file, "moveDrift", &tree, proxies, count, &layout, 0.5f);
+	MoveProxies(file, "moveTeleport", &tree, proxies, count, &layout, 0.0f);
+
+	// Queries and rays start at proxy centers, so they sample dense regions
+	// as often as the proxies do.
+	QueryCounter counter;
+	timer.Reset();
+	for (int32 i = 0; i < e_queryCount; ++i)
+	{
+		const Proxy& proxy = proxies[RandomInt(count)];
+
+		b2AABB aabb;
+		aabb.lowerBound = proxy.center - b2Vec2(2.0f, 2.0f);
+		aabb.upperBound = proxy.center + b2Vec2(2.0f, 2.0f);
+		tree.Query(&counter, aabb);
+	}
+	WritePhase(file, "query", 0.001 * timer.GetMilliseconds(), e_queryCount, tree, "hits", counter.m_count, false);
+
+	counter.m_count = 0;
+	timer.Reset();
+	for (int32 i = 0; i < e_rayCount; ++i)
+	{
+		const Proxy& proxy = proxies[RandomInt(count)];
+		float32 angle = RandomFloat(-b2_pi, b2_pi);
+
+		b2RayCastInput input;
+		input.p1 = proxy.center;
+		input.p2 = proxy.center + 10.0f * b2Vec2(cosf(angle), sinf(angle));
+		input.maxFraction = 1.0f;
+		tree.RayCast(&counter, input);
+	}
+	WritePhase(file, "rayCast", 0.001 * timer.GetMilliseconds(), e_rayCount, tree, "hits", counter.m_count, false);
+
+	// Destroy half of the proxies in random order, then the rest.
+	for (int32 i = count - 1; i > 0; --i)
+	{
+		b2Swap(proxies[i], proxies[RandomInt(i + 1)]);
+	}
+
+	int32 half = count / 2;
+	timer.Reset();
+	for (int32 i = 0; i < half; ++i)
+	{
+		tree.DestroyProxy(proxies[i].id);
+	}
+	WritePhase(file, "destroyHalf", 0.001 * timer.GetMilliseconds(), half, tree, NULL, 0, false);
+
+	timer.Reset();
+	for (int32 i = half; i < count; ++i)
+	{
+		tree.DestroyProxy(proxies[i].id);
+	}
+	WritePhase(file, "destroyRest", 0.001 * timer.GetMilliseconds(), count - half, tree, NULL, 0, false);
+
+	fprintf(file, "\n\t\t\t]\n\t\t}");
+
+	b2Free(proxies);
+}
+
+int main(int argc, char** argv)
+{
+	int32 maxCount = 1000000;
+	const char* path = NULL;
+
+	for (int i = 1; i < argc; i += 2)
+	{
+		if (i + 1 < argc && strcmp(argv[i], "-n") == 0)
+		{
+			maxCount = atoi(argv[i + 1]);
+		}
+		else if (i + 1 < argc && strcmp(argv[i], "-o") == 0)
+		{
+			path = argv[i + 1];
+		}
+		else
+		{
+			fprintf(stderr, "usage: box2d_tree_bench [-n maxProxies] [-o file]\n");
+			return 1;
+		}
+	}
+
+	FILE* file = stdout;
+	if (path != NULL)
+	{
+		file = fopen(path, "w");
+		if (file == NULL)
+		{
+			fprintf(stderr, "cannot open %s\n", path);
+			return 1;
+		}
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"version\": \"%d.%d.%d\",\n", b2_version.major, b2_version.minor, b2_version.revision);
+	fprintf(file, "\t\"runs\": [\n");
+
+	bool first = true;
+	for (int32 count = 1000; count <= maxCount; count *= 10)
+	{
+		for (int32 d = 0; d < e_distributionCount; ++d)
+		{
+			Run(file, (Distribution)d, count, first);
+			first = false;
+		}
+	}
+
+	fprintf(file, "\n\t]\n}\n");
+
+	if (file != stdout)
+	{
+		fclose(file);
+	}
+
+	return 0;
+}
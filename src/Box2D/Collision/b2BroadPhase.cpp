@@ -17,26 +17,30 @@
 */
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Common/b2Stream.h>
 #include <cstring>
 using namespace std;
 
-b2BroadPhase::b2BroadPhase()
+b2BroadPhase::b2BroadPhase(b2Allocator* allocator) : m_tree(allocator)
 {
+	m_allocator = allocator;
 	m_proxyCount = 0;
 
 	m_pairCapacity = 16;
 	m_pairCount = 0;
-	m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	m_pairBuffer = (b2Pair*)b2Alloc(m_allocator, m_pairCapacity * sizeof(b2Pair), b2_allocBroadPhase);
 
 	m_moveCapacity = 16;
 	m_moveCount = 0;
-	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	m_moveBuffer = (int32*)b2Alloc(m_allocator, m_moveCapacity * sizeof(int32), b2_allocBroadPhase);
+
+	ResetCounters();
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
-	b2Free(m_moveBuffer);
-	b2Free(m_pairBuffer);
+	b2Free(m_allocator, m_moveBuffer);
+	b2Free(m_allocator, m_pairBuffer);
 }
 
 int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
@@ -56,9 +60,11 @@ void b2BroadPhase::DestroyProxy(int32 proxyId)
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
+	++m_counters.proxiesMoved;
 	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
 	if (buffer)
 	{
+		++m_counters.treeReinsertions;
 		BufferMove(proxyId);
 	}
 }
@@ -74,9 +80,9 @@ void b2BroadPhase::BufferMove(int32 proxyId)
 	{
 		int32* oldBuffer = m_moveBuffer;
 		m_moveCapacity *= 2;
-		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+		m_moveBuffer = (int32*)b2Alloc(m_allocator, m_moveCapacity * sizeof(int32), b2_allocBroadPhase);
 		memcpy(m_moveBuffer, oldBuffer, m_moveCount * sizeof(int32));
-		b2Free(oldBuffer);
+		b2Free(m_allocator, oldBuffer);
 	}
 
 	m_moveBuffer[m_moveCount] = proxyId;
@@ -109,9 +115,9 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 	{
 		b2Pair* oldBuffer = m_pairBuffer;
 		m_pairCapacity *= 2;
-		m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+		m_pairBuffer = (b2Pair*)b2Alloc(m_allocator, m_pairCapacity * sizeof(b2Pair), b2_allocBroadPhase);
 		memcpy(m_pairBuffer, oldBuffer, m_pairCount * sizeof(b2Pair));
-		b2Free(oldBuffer);
+		b2Free(m_allocator, oldBuffer);
 	}
 
 	m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyId, m_queryProxyId);
@@ -120,3 +126,72 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 
 	return true;
 }
+
+void b2BroadPhase::Save(b2StreamWriter* writer) const
+{
+	m_tree.Save(writer);
+	writer->Write(m_proxyCount);
+	writer->Write(m_moveCount);
+	writer->Write(m_moveBuffer, m_moveCount * sizeof(int32));
+}
+
+bool b2BroadPhase::Load(b2StreamReader* reader)
+{
+	m_pairCount = 0;
+	m_moveCount = 0;
+	m_proxyCount = 0;
+
+	if (m_tree.Load(reader) == false)
+	{
+		return false;
+	}
+
+	int32 leafCount = 0;
+	for (int32 i = 0; i < m_tree.GetNodeCapacity(); ++i)
+	{
+		if (m_tree.IsProxy(i))
+		{
+			++leafCount;
+		}
+	}
+
+	int32 proxyCount, moveCount;
+	reader->Read(&proxyCount);
+	reader->Read(&moveCount);
+	if (reader->IsOk() == false || proxyCount != leafCount || moveCount < 0 || moveCount > reader->GetRemaining() / int32(sizeof(int32)))
+	{
+		m_tree.Reset();
+		return false;
+	}
+
+	if (moveCount > m_moveCapacity)
+	{
+		b2Free(m_allocator, m_moveBuffer);
+		m_moveCapacity = moveCount;
+		m_moveBuffer = (int32*)b2Alloc(m_allocator, m_moveCapacity * sizeof(int32), b2_allocBroadPhase);
+	}
+
+	bool ok = reader->Read(m_moveBuffer, moveCount * sizeof(int32));
+	for (int32 i = 0; ok && i < moveCount; ++i)
+	{
+		ok = m_moveBuffer[i] == e_nullProxy || m_tree.IsProxy(m_moveBuffer[i]);
+	}
+
+	if (ok == false)
+	{
+		m_tree.Reset();
+		return false;
+	}
+
+	m_proxyCount = proxyCount;
+	m_moveCount = moveCount;
+	return true;
+}
+
+void b2BroadPhase::Reset()
+{
+	m_tree.Reset();
+	m_proxyCount = 0;
+	m_moveCount = 0;
+	m_pairCount = 0;
+}
@@ -31,6 +31,14 @@ struct b2Pair
 	int32 next;
 };
 
+/// Work done by the broad-phase since the counters were last reset.
+struct b2BroadPhaseCounters
+{
+	int32 proxiesMoved;		///< calls to MoveProxy
+	int32 treeReinsertions;	///< moved proxies that left their fat AABB
+	int32 pairsFound;		///< unique pairs reported by UpdatePairs
+};
+
 /// The broad-phase is used for computing pairs and performing volume queries and ray casts.
 /// This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
 /// It is up to the client to consume the new pairs and to track subsequent overlap.
@@ -43,7 +51,8 @@ public:
 		e_nullProxy = -1
 	};
 
-	b2BroadPhase();
+	/// @param allocator the heap for the tree and pair buffers, or NULL for b2Alloc.
+	b2BroadPhase(b2Allocator* allocator = NULL);
 	~b2BroadPhase();
 
 	/// Create a proxy with an initial AABB. Pairs are not reported until
@@ -100,6 +109,31 @@ public:
 	/// Get the quality metric of the embedded tree.
 	float32 GetTreeQuality() const;
 
+	/// Set user data of a proxy. This is used to fix proxies after Load.
+	void SetUserData(int32 proxyId, void* userData);
+
+	/// Check that an id refers to a proxy. Any id is accepted, so this can
+	/// check ids that come from loaded data before they are used.
+	bool IsProxy(int32 proxyId) const;
+
+	/// Write the tree and the pending moves for a world snapshot.
+	void Save(b2StreamWriter* writer) const;
+
+	/// Replace the proxies with ones written by Save. The tree links and the
+	/// pending moves are checked. The proxy user data is NULL and must be set
+	/// again with SetUserData.
+	/// @return false if the data is malformed. There are then no proxies.
+	bool Load(b2StreamReader* reader);
+
+	/// Drop all proxies at once.
+	void Reset();
+
+	/// Get the work counters.
+	const b2BroadPhaseCounters& GetCounters() const;
+
+	/// Zero the work counters.
+	void ResetCounters();
+
 private:
 
 	friend class b2DynamicTree;
@@ -122,6 +156,10 @@ private:
 	int32 m_pairCount;
 
 	int32 m_queryProxyId;
+
+	b2BroadPhaseCounters m_counters;
+
+	b2Allocator* m_allocator;
 };
 
 /// This is used to sort pairs.
@@ -145,6 +183,16 @@ inline void* b2BroadPhase::GetUserData(int32 proxyId) const
 	return m_tree.GetUserData(proxyId);
 }
 
+inline void b2BroadPhase::SetUserData(int32 proxyId, void* userData)
+{
+	m_tree.SetUserData(proxyId, userData);
+}
+
+inline bool b2BroadPhase::IsProxy(int32 proxyId) const
+{
+	return m_tree.IsProxy(proxyId);
+}
+
 inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
 {
 	const b2AABB& aabbA = m_tree.GetFatAABB(proxyIdA);
@@ -162,6 +210,18 @@ inline int32 b2BroadPhase::GetProxyCount() const
 	return m_proxyCount;
 }
 
+inline const b2BroadPhaseCounters& b2BroadPhase::GetCounters() const
+{
+	return m_counters;
+}
+
+inline void b2BroadPhase::ResetCounters()
+{
+	m_counters.proxiesMoved = 0;
+	m_counters.treeReinsertions = 0;
+	m_counters.pairsFound = 0;
+}
+
 inline int32 b2BroadPhase::GetTreeHeight() const
 {
 	return m_tree.GetHeight();
@@ -215,6 +275,7 @@ void b2BroadPhase::UpdatePairs(T* callback)
 		void* userDataB = m_tree.GetUserData(primaryPair->proxyIdB);
 
 		callback->AddPair(userDataA, userDataB);
+		++m_counters.pairsFound;
 		++i;
 
 		// Skip any duplicate pairs.
@@ -21,8 +21,11 @@
 #include <Box2D/Collision/Shapes/b2EdgeShape.h>
 #include <Box2D/Collision/Shapes/b2ChainShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Common/b2ThreadPool.h>
 
 // GJK using Voronoi regions (Christer Ericson) and Barycentric coordinates.
+// The statistics are only updated with B2_COLLISION_STATS. Pool threads
+// compute distances, so the updates are atomic.
 int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
 
 void b2DistanceProxy::Set(const b2Shape* shape, int32 index)
@@ -444,7 +447,7 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache,
 				const b2DistanceInput* input)
 {
-	++b2_gjkCalls;
+	B2_COLLISION_STAT(b2AtomicAdd(&b2_gjkCalls, 1));
 
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
@@ -541,7 +544,6 @@ void b2Distance(b2DistanceOutput* output,
 
 		// Iteration count is equated to the number of support point calls.
 		++iter;
-		++b2_gjkIters;
 
 		// Check for duplicate support points. This is the main termination criteria.
 		bool duplicate = false;
@@ -564,7 +566,8 @@ void b2Distance(b2DistanceOutput* output,
 		++simplex.m_count;
 	}
 
-	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, iter);
+	B2_COLLISION_STAT(b2AtomicAdd(&b2_gjkIters, iter));
+	B2_COLLISION_STAT(b2AtomicMax(&b2_gjkMaxIters, iter));
 
 	// Prepare output.
 	simplex.GetWitnessPoints(&output->pointA, &output->pointB);
@@ -17,18 +17,20 @@
 */
 
 #include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Common/b2Stream.h>
 #include <cstring>
 #include <cfloat>
 using namespace std;
 
 
-b2DynamicTree::b2DynamicTree()
+b2DynamicTree::b2DynamicTree(b2Allocator* allocator)
 {
+	m_allocator = allocator;
 	m_root = b2_nullNode;
 
 	m_nodeCapacity = 16;
 	m_nodeCount = 0;
-	m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	m_nodes = (b2TreeNode*)b2Alloc(m_allocator, m_nodeCapacity * sizeof(b2TreeNode), b2_allocDynamicTree);
 	memset(m_nodes, 0, m_nodeCapacity * sizeof(b2TreeNode));
 
 	// Build a linked list for the free list.
@@ -49,7 +51,7 @@ b2DynamicTree::b2DynamicTree()
 b2DynamicTree::~b2DynamicTree()
 {
 	// This frees the entire tree in one shot.
-	b2Free(m_nodes);
+	b2Free(m_allocator, m_nodes);
 }
 
 // Allocate a node from the pool. Grow the pool if necessary.
@@ -63,9 +65,9 @@ int32 b2DynamicTree::AllocateNode()
 		// The free list is empty. Rebuild a bigger pool.
 		b2TreeNode* oldNodes = m_nodes;
 		m_nodeCapacity *= 2;
-		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+		m_nodes = (b2TreeNode*)b2Alloc(m_allocator, m_nodeCapacity * sizeof(b2TreeNode), b2_allocDynamicTree);
 		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2TreeNode));
-		b2Free(oldNodes);
+		b2Free(m_allocator, oldNodes);
 
 		// Build a linked list for the free list. The parent
 		// pointer becomes the "next" pointer.
@@ -696,7 +698,7 @@ int32 b2DynamicTree::GetMaxBalance() const
 
 void b2DynamicTree::RebuildBottomUp()
 {
-	int32* nodes = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32* nodes = (int32*)b2Alloc(m_allocator, m_nodeCount * sizeof(int32), b2_allocDynamicTree);
 	int32 count = 0;
 
 	// Build array of leaves. Free the rest.
@@ -765,7 +767,185 @@ void b2DynamicTree::RebuildBottomUp()
 	}
 
 	m_root = nodes[0];
-	b2Free(nodes);
+	b2Free(m_allocator, nodes);
 
 	Validate();
 }
+
+// The bytes Save writes per node: the AABB and four links.
+static const int32 b2_savedNodeSize = sizeof(b2AABB) + 4 * sizeof(int32);
+
+void b2DynamicTree::Save(b2StreamWriter* writer) const
+{
+	writer->Write(m_root);
+	writer->Write(m_nodeCount);
+	writer->Write(m_nodeCapacity);
+	writer->Write(m_freeList);
+	writer->Write(m_path);
+	writer->Write(m_insertionCount);
+
+	// Node by node without the user data, so the pointer size does not matter.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		const b2TreeNode* node = m_nodes + i;
+		writer->Write(node->aabb);
+		writer->Write(node->parent);
+		writer->Write(node->child1);
+		writer->Write(node->child2);
+		writer->Write(node->height);
+	}
+}
+
+bool b2DynamicTree::Load(b2StreamReader* reader)
+{
+	int32 root, nodeCount, nodeCapacity, freeList, insertionCount;
+	uint32 path;
+	reader->Read(&root);
+	reader->Read(&nodeCount);
+	reader->Read(&nodeCapacity);
+	reader->Read(&freeList);
+	reader->Read(&path);
+	reader->Read(&insertionCount);
+
+	bool valid = reader->IsOk() && 0 < nodeCapacity && 0 <= nodeCount && nodeCount <= nodeCapacity
+		&& b2_nullNode <= root && root < nodeCapacity
+		&& b2_nullNode <= freeList && freeList < nodeCapacity
+		&& nodeCapacity <= reader->GetRemaining() / b2_savedNodeSize;
+
+	if (valid == false)
+	{
+		Reset();
+		return false;
+	}
+
+	if (nodeCapacity != m_nodeCapacity)
+	{
+		b2Free(m_allocator, m_nodes);
+		m_nodeCapacity = nodeCapacity;
+		m_nodes = (b2TreeNode*)b2Alloc(m_allocator, m_nodeCapacity * sizeof(b2TreeNode), b2_allocDynamicTree);
+	}
+
+	m_root = root;
+	m_nodeCount = nodeCount;
+	m_freeList = freeList;
+	m_path = path;
+	m_insertionCount = insertionCount;
+
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		b2TreeNode* node = m_nodes + i;
+		reader->Read(&node->aabb);
+		reader->Read(&node->parent);
+		reader->Read(&node->child1);
+		reader->Read(&node->child2);
+		reader->Read(&node->height);
+		node->userData = NULL;
+	}
+
+	if (reader->IsOk() == false || IsWellFormed() == false)
+	{
+		Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool b2DynamicTree::IsWellFormed() const
+{
+	if ((m_root == b2_nullNode) != (m_nodeCount == 0))
+	{
+		return false;
+	}
+
+	if (m_root != b2_nullNode && (m_nodes[m_root].height < 0 || m_nodes[m_root].parent != b2_nullNode))
+	{
+		return false;
+	}
+
+	// Every child must point back at its parent and be exactly one level
+	// lower, which rules out cycles. Together with the parent check of every
+	// node but the root, this makes the used nodes a single tree.
+	int32 usedCount = 0;
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		const b2TreeNode* node = m_nodes + i;
+		if (node->height < 0)
+		{
+			continue;
+		}
+
+		++usedCount;
+
+		if (i != m_root)
+		{
+			int32 parent = node->parent;
+			if (parent < 0 || parent >= m_nodeCapacity ||
+				(m_nodes[parent].child1 != i && m_nodes[parent].child2 != i))
+			{
+				return false;
+			}
+		}
+
+		if (node->height == 0)
+		{
+			if (node->child1 != b2_nullNode || node->child2 != b2_nullNode)
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		int32 child1 = node->child1;
+		int32 child2 = node->child2;
+		if (child1 < 0 || child1 >= m_nodeCapacity || child2 < 0 || child2 >= m_nodeCapacity || child1 == child2)
+		{
+			return false;
+		}
+
+		const b2TreeNode* node1 = m_nodes + child1;
+		const b2TreeNode* node2 = m_nodes + child2;
+		if (node1->height < 0 || node2->height < 0 || node1->parent != i || node2->parent != i ||
+			node->height != 1 + b2Max(node1->height, node2->height))
+		{
+			return false;
+		}
+	}
+
+	if (usedCount != m_nodeCount)
+	{
+		return false;
+	}
+
+	// The free list must hold every other node exactly once.
+	int32 freeIndex = m_freeList;
+	for (int32 i = 0; i < m_nodeCapacity - m_nodeCount; ++i)
+	{
+		if (freeIndex < 0 || freeIndex >= m_nodeCapacity || m_nodes[freeIndex].height != -1)
+		{
+			return false;
+		}
+
+		freeIndex = m_nodes[freeIndex].next;
+	}
+
+	return freeIndex == b2_nullNode;
+}
+
+void b2DynamicTree::Reset()
+{
+	// Build a linked list for the free list.
+	for (int32 i = 0; i < m_nodeCapacity - 1; ++i)
+	{
+		m_nodes[i].next = i + 1;
+		m_nodes[i].height = -1;
+	}
+	m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+	m_nodes[m_nodeCapacity-1].height = -1;
+	m_root = b2_nullNode;
+	m_nodeCount = 0;
+	m_freeList = 0;
+	m_path = 0;
+	m_insertionCount = 0;
+}
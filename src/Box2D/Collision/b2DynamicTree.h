@@ -22,6 +22,9 @@
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2GrowableStack.h>
 
+class b2StreamWriter;
+class b2StreamReader;
+
 #define b2_nullNode (-1)
 
 /// A node in the dynamic tree. The client does not interact with this directly.
@@ -62,7 +65,8 @@ class b2DynamicTree
 {
 public:
 	/// Constructing the tree initializes the node pool.
-	b2DynamicTree();
+	/// @param allocator the heap for the node pool, or NULL for b2Alloc.
+	b2DynamicTree(b2Allocator* allocator = NULL);
 
 	/// Destroy the tree, freeing the node pool.
 	~b2DynamicTree();
@@ -83,6 +87,9 @@ public:
 	/// @return the proxy user data or 0 if the id is invalid.
 	void* GetUserData(int32 proxyId) const;
 
+	/// Set proxy user data.
+	void SetUserData(int32 proxyId, void* userData);
+
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
@@ -118,6 +125,27 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Write the node pool, including free nodes, so that a loaded tree keeps
+	/// its proxy ids and shape. User data is not written.
+	void Save(b2StreamWriter* writer) const;
+
+	/// Replace this tree with one written by Save. Every node link is checked
+	/// before it is used. The user data of every proxy is NULL and must be set
+	/// again with SetUserData.
+	/// @return false if the data is malformed. The tree is then empty.
+	bool Load(b2StreamReader* reader);
+
+	/// Check that an id refers to a proxy. Unlike the other accessors this
+	/// accepts any id, so it can check ids that come from loaded data.
+	bool IsProxy(int32 proxyId) const;
+
+	/// Get the number of nodes in the pool, including free ones. Proxy ids
+	/// are less than this.
+	int32 GetNodeCapacity() const;
+
+	/// Free all nodes. The node pool keeps its capacity.
+	void Reset();
+
 private:
 
 	int32 AllocateNode();
@@ -134,6 +162,9 @@ private:
 	void ValidateStructure(int32 index) const;
 	void ValidateMetrics(int32 index) const;
 
+	// Check the node pool read by Load. Unlike Validate this does not assert.
+	bool IsWellFormed() const;
+
 	int32 m_root;
 
 	b2TreeNode* m_nodes;
@@ -146,6 +177,8 @@ private:
 	uint32 m_path;
 
 	int32 m_insertionCount;
+
+	b2Allocator* m_allocator;
 };
 
 inline void* b2DynamicTree::GetUserData(int32 proxyId) const
@@ -154,6 +187,22 @@ inline void* b2DynamicTree::GetUserData(int32 proxyId) const
 	return m_nodes[proxyId].userData;
 }
 
+inline void b2DynamicTree::SetUserData(int32 proxyId, void* userData)
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	m_nodes[proxyId].userData = userData;
+}
+
+inline bool b2DynamicTree::IsProxy(int32 proxyId) const
+{
+	return 0 <= proxyId && proxyId < m_nodeCapacity && m_nodes[proxyId].height == 0;
+}
+
+inline int32 b2DynamicTree::GetNodeCapacity() const
+{
+	return m_nodeCapacity;
+}
+
 inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -163,7 +212,7 @@ inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
 template <typename T>
 inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 {
-	b2GrowableStack<int32, 256> stack;
+	b2GrowableStack<int32, 256> stack(m_allocator);
 	stack.Push(m_root);
 
 	while (stack.GetCount() > 0)
@@ -221,7 +270,7 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 		segmentAABB.upperBound = b2Max(p1, t);
 	}
 
-	b2GrowableStack<int32, 256> stack;
+	b2GrowableStack<int32, 256> stack(m_allocator);
 	stack.Push(m_root);
 
 	while (stack.GetCount() > 0)
@@ -21,10 +21,13 @@
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Common/b2ThreadPool.h>
 
 #include <cstdio>
 using namespace std;
 
+// These statistics are only updated with B2_COLLISION_STATS. Pool threads
+// compute TOIs, so the updates are atomic.
 int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
 int32 b2_toiRootIters, b2_toiMaxRootIters;
 
@@ -256,7 +259,7 @@ struct b2SeparationFunction
 // by computing the largest time at which separation is maintained.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 {
-	++b2_toiCalls;
+	B2_COLLISION_STAT(b2AtomicAdd(&b2_toiCalls, 1));
 
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
@@ -444,7 +447,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 
 				++rootIterCount;
-				++b2_toiRootIters;
 
 				if (rootIterCount == 50)
 				{
@@ -452,7 +454,8 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 			}
 
-			b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, rootIterCount);
+			B2_COLLISION_STAT(b2AtomicAdd(&b2_toiRootIters, rootIterCount));
+			B2_COLLISION_STAT(b2AtomicMax(&b2_toiMaxRootIters, rootIterCount));
 
 			++pushBackIter;
 
@@ -463,7 +466,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 
 		++iter;
-		++b2_toiIters;
 
 		if (done)
 		{
@@ -479,5 +481,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 	}
 
-	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
+	B2_COLLISION_STAT(b2AtomicAdd(&b2_toiIters, iter));
+	B2_COLLISION_STAT(b2AtomicMax(&b2_toiMaxIters, iter));
 }
@@ -0,0 +1,91 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2AllocCounter.h>
+#include <cstring>
+
+const char* b2GetAllocTagName(b2AllocTag tag)
+{
+	switch (tag)
+	{
+	case b2_allocUntagged:
+		return "untagged";
+	case b2_allocStackAllocator:
+		return "stackAllocator";
+	case b2_allocGrowableStack:
+		return "growableStack";
+	case b2_allocBroadPhase:
+		return "broadPhase";
+	case b2_allocDynamicTree:
+		return "dynamicTree";
+	case b2_allocBlockChunk:
+		return "blockChunk";
+	case b2_allocBlockLarge:
+		return "blockLarge";
+	case b2_allocBodyStore:
+		return "bodyStore";
+	case b2_allocTOIQueue:
+		return "toiQueue";
+	case b2_allocWorld:
+		return "world";
+	default:
+		return "unknown";
+	}
+}
+
+b2AllocCounter::b2AllocCounter(b2Allocator* allocator)
+{
+	m_allocator = allocator;
+	m_guarded = false;
+	Reset();
+}
+
+void* b2AllocCounter::Allocate(int32 size)
+{
+	return AllocateTagged(size, b2_allocUntagged);
+}
+
+void b2AllocCounter::Free(void* mem)
+{
+	b2Free(m_allocator, mem);
+}
+
+void* b2AllocCounter::AllocateTagged(int32 size, b2AllocTag tag)
+{
+	b2Assert(0 <= tag && tag < b2_allocTagCount);
+
+	if (m_guarded)
+	{
+		b2Log("heap allocation of %d bytes by %s after warm-up\n", size, b2GetAllocTagName(tag));
+		b2Assert(false);
+	}
+
+	m_lock.Lock();
+	++m_stats.count;
+	m_stats.bytes += size;
+	++m_stats.tagCounts[tag];
+	m_stats.tagBytes[tag] += size;
+	m_lock.Unlock();
+
+	return b2Alloc(m_allocator, size, tag);
+}
+
+void b2AllocCounter::Reset()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
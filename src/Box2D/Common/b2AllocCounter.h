@@ -0,0 +1,71 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ALLOC_COUNTER_H
+#define B2_ALLOC_COUNTER_H
+
+#include <Box2D/Common/b2Settings.h>
+#include <Box2D/Common/b2ThreadPool.h>
+
+/// Heap allocations counted by a b2AllocCounter.
+struct b2AllocStats
+{
+	int32 count;						///< allocations of all tags
+	int32 bytes;						///< bytes in allocations of all tags
+	int32 tagCounts[b2_allocTagCount];	///< allocations per b2AllocTag
+	int32 tagBytes[b2_allocTagCount];	///< bytes per b2AllocTag
+};
+
+/// Get the name of an allocation tag, for logs.
+const char* b2GetAllocTagName(b2AllocTag tag);
+
+/// Counts the allocations made through it by tag and passes them on to
+/// another allocator. b2World puts one in front of its allocator to count
+/// the heap allocations of each step. Frees are not counted.
+class b2AllocCounter : public b2Allocator
+{
+public:
+	/// @param allocator where the memory comes from, or NULL for b2Alloc.
+	b2AllocCounter(b2Allocator* allocator = NULL);
+
+	void* Allocate(int32 size);
+	void Free(void* mem);
+	void* AllocateTagged(int32 size, b2AllocTag tag);
+
+	/// Get the allocations since the last Reset.
+	const b2AllocStats& GetStats() const { return m_stats; }
+
+	/// Zero the counters.
+	void Reset();
+
+	/// While guarded, an allocation logs its tag and asserts. Use this to
+	/// check that a warmed up world no longer touches the heap.
+	void SetGuarded(bool flag) { m_guarded = flag; }
+	bool IsGuarded() const { return m_guarded; }
+
+private:
+
+	b2Allocator* m_allocator;
+	b2AllocStats m_stats;
+	bool m_guarded;
+
+	// Pool threads allocate too, when their stack allocators overflow.
+	b2SpinLock m_lock;
+};
+
+#endif
@@ -17,13 +17,14 @@
 */
 
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Math.h>
 #include <cstdlib>
 #include <climits>
 #include <cstring>
 #include <memory>
 using namespace std;
 
-int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] = 
+const int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] =
 {
 	16,		// 0
 	32,		// 1
@@ -40,12 +41,37 @@ int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] =
 	512,	// 12
 	640,	// 13
 };
-uint8 b2BlockAllocator::s_blockSizeLookup[b2_maxBlockSize + 1];
-bool b2BlockAllocator::s_blockSizeLookupInitialized;
+
+// Get the size class of a request in [1, b2_maxBlockSize]. This follows the
+// steps of s_blockSizes: 16, 32, 64, then 32 bytes up to 256, 64 bytes up to
+// 512 and one class up to 640. It needs no table, so it cannot be used before
+// its initialization, even from static constructors.
+inline int32 b2GetSizeClass(int32 size)
+{
+	b2Assert(0 < size && size <= b2_maxBlockSize);
+
+	if (size <= 64)
+	{
+		return size <= 16 ? 0 : (size <= 32 ? 1 : 2);
+	}
+
+	if (size <= 256)
+	{
+		return (size + 31) / 32;
+	}
+
+	if (size <= 512)
+	{
+		return (size + 63) / 64 + 4;
+	}
+
+	return 13;
+}
 
 struct b2Chunk
 {
 	int32 blockSize;
+	int32 size;
 	b2Block* blocks;
 };
 
@@ -54,46 +80,73 @@ struct b2Block
 	b2Block* next;
 };
 
-b2BlockAllocator::b2BlockAllocator()
+b2BlockAllocator::b2BlockAllocator(b2Allocator* allocator)
 {
 	b2Assert(b2_blockSizes < UCHAR_MAX);
 
+	m_allocator = allocator;
+
 	m_chunkSpace = b2_chunkArrayIncrement;
 	m_chunkCount = 0;
-	m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
+	m_chunkSize = b2_chunkSize;
+	m_chunks = (b2Chunk*)b2Alloc(m_allocator, m_chunkSpace * sizeof(b2Chunk), b2_allocBlockChunk);
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
 
-	if (s_blockSizeLookupInitialized == false)
-	{
-		int32 j = 0;
-		for (int32 i = 1; i <= b2_maxBlockSize; ++i)
-		{
-			b2Assert(j < b2_blockSizes);
-			if (i <= s_blockSizes[j])
-			{
-				s_blockSizeLookup[i] = (uint8)j;
-			}
-			else
-			{
-				++j;
-				s_blockSizeLookup[i] = (uint8)j;
-			}
-		}
-
-		s_blockSizeLookupInitialized = true;
-	}
+	memset(m_liveBlocks, 0, sizeof(m_liveBlocks));
+	m_requestedBytes = 0;
+	m_largeCount = 0;
+	m_largeBytes = 0;
 }
 
 b2BlockAllocator::~b2BlockAllocator()
 {
 	for (int32 i = 0; i < m_chunkCount; ++i)
 	{
-		b2Free(m_chunks[i].blocks);
+		b2Free(m_allocator, m_chunks[i].blocks);
 	}
 
-	b2Free(m_chunks);
+	b2Free(m_allocator, m_chunks);
+}
+
+// Carve a new chunk into blocks of the size class and put them on the
+// free list, which must be empty.
+void b2BlockAllocator::AllocateChunk(int32 index)
+{
+	b2Assert(m_freeLists[index] == NULL);
+
+	if (m_chunkCount == m_chunkSpace)
+	{
+		b2Chunk* oldChunks = m_chunks;
+		m_chunkSpace += b2_chunkArrayIncrement;
+		m_chunks = (b2Chunk*)b2Alloc(m_allocator, m_chunkSpace * sizeof(b2Chunk), b2_allocBlockChunk);
+		memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
+		memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
+		b2Free(m_allocator, oldChunks);
+	}
+
+	b2Chunk* chunk = m_chunks + m_chunkCount;
+	chunk->size = m_chunkSize;
+	chunk->blocks = (b2Block*)b2Alloc(m_allocator, chunk->size, b2_allocBlockChunk);
+#if defined(_DEBUG)
+	memset(chunk->blocks, 0xcd, chunk->size);
+#endif
+	int32 blockSize = s_blockSizes[index];
+	chunk->blockSize = blockSize;
+	int32 blockCount = chunk->size / blockSize;
+	b2Assert(blockCount * blockSize <= chunk->size);
+	for (int32 i = 0; i < blockCount - 1; ++i)
+	{
+		b2Block* block = (b2Block*)((int8*)chunk->blocks + blockSize * i);
+		b2Block* next = (b2Block*)((int8*)chunk->blocks + blockSize * (i + 1));
+		block->next = next;
+	}
+	b2Block* last = (b2Block*)((int8*)chunk->blocks + blockSize * (blockCount - 1));
+	last->next = NULL;
+
+	m_freeLists[index] = chunk->blocks;
+	++m_chunkCount;
 }
 
 void* b2BlockAllocator::Allocate(int32 size)
@@ -105,53 +158,25 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		return b2Alloc(size);
+		++m_largeCount;
+		m_largeBytes += size;
+		return b2Alloc(m_allocator, size, b2_allocBlockLarge);
 	}
 
-	int32 index = s_blockSizeLookup[size];
+	int32 index = b2GetSizeClass(size);
 	b2Assert(0 <= index && index < b2_blockSizes);
 
-	if (m_freeLists[index])
+	++m_liveBlocks[index];
+	m_requestedBytes += size;
+
+	if (m_freeLists[index] == NULL)
 	{
-		b2Block* block = m_freeLists[index];
-		m_freeLists[index] = block->next;
-		return block;
+		AllocateChunk(index);
 	}
-	else
-	{
-		if (m_chunkCount == m_chunkSpace)
-		{
-			b2Chunk* oldChunks = m_chunks;
-			m_chunkSpace += b2_chunkArrayIncrement;
-			m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
-			memcpy(m_chunks, oldChunks, m_chunkCount * sizeof(b2Chunk));
-			memset(m_chunks + m_chunkCount, 0, b2_chunkArrayIncrement * sizeof(b2Chunk));
-			b2Free(oldChunks);
-		}
-
-		b2Chunk* chunk = m_chunks + m_chunkCount;
-		chunk->blocks = (b2Block*)b2Alloc(b2_chunkSize);
-#if defined(_DEBUG)
-		memset(chunk->blocks, 0xcd, b2_chunkSize);
-#endif
-		int32 blockSize = s_blockSizes[index];
-		chunk->blockSize = blockSize;
-		int32 blockCount = b2_chunkSize / blockSize;
-		b2Assert(blockCount * blockSize <= b2_chunkSize);
-		for (int32 i = 0; i < blockCount - 1; ++i)
-		{
-			b2Block* block = (b2Block*)((int8*)chunk->blocks + blockSize * i);
-			b2Block* next = (b2Block*)((int8*)chunk->blocks + blockSize * (i + 1));
-			block->next = next;
-		}
-		b2Block* last = (b2Block*)((int8*)chunk->blocks + blockSize * (blockCount - 1));
-		last->next = NULL;
 
-		m_freeLists[index] = chunk->blocks->next;
-		++m_chunkCount;
-
-		return chunk->blocks;
-	}
+	b2Block* block = m_freeLists[index];
+	m_freeLists[index] = block->next;
+	return block;
 }
 
 void b2BlockAllocator::Free(void* p, int32 size)
@@ -165,11 +190,13 @@ void b2BlockAllocator::Free(void* p, int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		b2Free(p);
+		--m_largeCount;
+		m_largeBytes -= size;
+		b2Free(m_allocator, p);
 		return;
 	}
 
-	int32 index = s_blockSizeLookup[size];
+	int32 index = b2GetSizeClass(size);
 	b2Assert(0 <= index && index < b2_blockSizes);
 
 #ifdef _DEBUG
@@ -182,11 +209,11 @@ void b2BlockAllocator::Free(void* p, int32 size)
 		if (chunk->blockSize != blockSize)
 		{
 			b2Assert(	(int8*)p + blockSize <= (int8*)chunk->blocks ||
-						(int8*)chunk->blocks + b2_chunkSize <= (int8*)p);
+						(int8*)chunk->blocks + chunk->size <= (int8*)p);
 		}
 		else
 		{
-			if ((int8*)chunk->blocks <= (int8*)p && (int8*)p + blockSize <= (int8*)chunk->blocks + b2_chunkSize)
+			if ((int8*)chunk->blocks <= (int8*)p && (int8*)p + blockSize <= (int8*)chunk->blocks + chunk->size)
 			{
 				found = true;
 			}
@@ -198,6 +225,9 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	memset(p, 0xfd, blockSize);
 #endif
 
+	--m_liveBlocks[index];
+	m_requestedBytes -= size;
+
 	b2Block* block = (b2Block*)p;
 	block->next = m_freeLists[index];
 	m_freeLists[index] = block;
@@ -207,11 +237,48 @@ void b2BlockAllocator::Clear()
 {
 	for (int32 i = 0; i < m_chunkCount; ++i)
 	{
-		b2Free(m_chunks[i].blocks);
+		b2Free(m_allocator, m_chunks[i].blocks);
 	}
 
 	m_chunkCount = 0;
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(m_liveBlocks, 0, sizeof(m_liveBlocks));
+	m_requestedBytes = 0;
+
+	// Allocations over b2_maxBlockSize are not owned by the chunks and stay counted.
+}
+
+void b2BlockAllocator::SetChunkSize(int32 size)
+{
+	b2Assert(size >= b2_maxBlockSize);
+	m_chunkSize = b2Max(size, b2_maxBlockSize);
+}
+
+void b2BlockAllocator::GetStats(b2BlockAllocatorStats* stats) const
+{
+	memset(stats, 0, sizeof(b2BlockAllocatorStats));
+
+	for (int32 index = 0; index < b2_blockSizes; ++index)
+	{
+		stats->blockSizes[index] = s_blockSizes[index];
+		stats->liveBlocks[index] = m_liveBlocks[index];
+	}
+	stats->requestedBytes = m_requestedBytes;
+	stats->largeCount = m_largeCount;
+	stats->largeBytes = m_largeBytes;
+
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		const b2Chunk* chunk = m_chunks + i;
+		++stats->chunkCounts[b2GetSizeClass(chunk->blockSize)];
+		stats->chunkBytes += chunk->size;
+	}
+	stats->chunkCount = m_chunkCount;
+
+	if (stats->chunkBytes > 0)
+	{
+		stats->fragmentation = 1.0f - float32(stats->requestedBytes) / float32(stats->chunkBytes);
+	}
 }
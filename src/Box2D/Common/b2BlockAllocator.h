@@ -29,34 +29,77 @@ const int32 b2_chunkArrayIncrement = 128;
 struct b2Block;
 struct b2Chunk;
 
+/// Memory use of a b2BlockAllocator.
+struct b2BlockAllocatorStats
+{
+	int32 blockSizes[b2_blockSizes];	///< the block size of each size class
+	int32 liveBlocks[b2_blockSizes];	///< blocks in use per size class
+	int32 chunkCounts[b2_blockSizes];	///< chunks per size class
+	int32 chunkCount;					///< chunks in all size classes
+	int32 chunkBytes;					///< bytes held in chunks
+	int32 requestedBytes;				///< bytes asked for by the live blocks
+	int32 largeCount;					///< live allocations over b2_maxBlockSize
+	int32 largeBytes;					///< bytes in live allocations over b2_maxBlockSize
+
+	/// The fraction of chunk memory that does not hold requested bytes: free
+	/// blocks, rounding up to the block size and unused chunk tails.
+	float32 fragmentation;
+};
+
 /// This is a small object allocator used for allocating small
 /// objects that persist for more than one time step.
 /// See: http://www.codeproject.com/useritems/Small_Block_Allocator.asp
 class b2BlockAllocator
 {
 public:
-	b2BlockAllocator();
+	/// @param allocator the source of chunks and large blocks, or NULL for b2Alloc.
+	b2BlockAllocator(b2Allocator* allocator = NULL);
 	~b2BlockAllocator();
 
-	/// Allocate memory. This will use b2Alloc if the size is larger than b2_maxBlockSize.
+	/// Allocate memory. This will use the heap if the size is larger than b2_maxBlockSize.
 	void* Allocate(int32 size);
 
-	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
+	/// Free memory. This will use the heap if the size is larger than b2_maxBlockSize.
 	void Free(void* p, int32 size);
 
 	void Clear();
 
+	/// Set the size of the chunks taken from the heap. Chunks that already
+	/// exist keep their size. Smaller chunks waste less in small worlds.
+	/// @param size at least b2_maxBlockSize.
+	void SetChunkSize(int32 size);
+
+	/// Get the chunk size.
+	int32 GetChunkSize() const;
+
+	/// Get memory statistics. This walks the chunks.
+	void GetStats(b2BlockAllocatorStats* stats) const;
+
 private:
 
+	void AllocateChunk(int32 index);
+
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
+	int32 m_chunkSize;
 
 	b2Block* m_freeLists[b2_blockSizes];
 
-	static int32 s_blockSizes[b2_blockSizes];
-	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
-	static bool s_blockSizeLookupInitialized;
+	// Counters for GetStats.
+	int32 m_liveBlocks[b2_blockSizes];
+	int32 m_requestedBytes;
+	int32 m_largeCount;
+	int32 m_largeBytes;
+
+	b2Allocator* m_allocator;
+
+	static const int32 s_blockSizes[b2_blockSizes];
 };
 
+inline int32 b2BlockAllocator::GetChunkSize() const
+{
+	return m_chunkSize;
+}
+
 #endif
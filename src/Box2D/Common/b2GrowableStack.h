@@ -28,18 +28,20 @@ template <typename T, int32 N>
 class b2GrowableStack
 {
 public:
-	b2GrowableStack()
+	/// @param allocator the heap used to grow, or NULL for b2Alloc.
+	b2GrowableStack(b2Allocator* allocator = NULL)
 	{
 		m_stack = m_array;
 		m_count = 0;
 		m_capacity = N;
+		m_allocator = allocator;
 	}
 
 	~b2GrowableStack()
 	{
 		if (m_stack != m_array)
 		{
-			b2Free(m_stack);
+			b2Free(m_allocator, m_stack);
 			m_stack = NULL;
 		}
 	}
@@ -50,11 +52,11 @@ public:
 		{
 			T* old = m_stack;
 			m_capacity *= 2;
-			m_stack = (T*)b2Alloc(m_capacity * sizeof(T));
+			m_stack = (T*)b2Alloc(m_allocator, m_capacity * sizeof(T), b2_allocGrowableStack);
 			std::memcpy(m_stack, old, m_count * sizeof(T));
 			if (old != m_array)
 			{
-				b2Free(old);
+				b2Free(m_allocator, old);
 			}
 		}
 
@@ -79,6 +81,7 @@ private:
 	T m_array[N];
 	int32 m_count;
 	int32 m_capacity;
+	b2Allocator* m_allocator;
 };
 
 
@@ -75,6 +75,10 @@ typedef double float64;
 /// Making it larger may create artifacts for vertex collision.
 #define b2_polygonRadius		(2.0f * b2_linearSlop)
 
+/// Speculative contacts get a point when the shapes may come this close within
+/// the next step. This covers the velocity gained during the step.
+#define b2_speculativeDistance	(4.0f * b2_linearSlop)
+
 /// Maximum number of sub-steps per contact in continuous physics simulation.
 #define b2_maxSubSteps			8
 
@@ -112,6 +116,16 @@ typedef double float64;
 #define b2_baumgarte				0.2f
 #define b2_toiBaugarte				0.75f
 
+/// The number of colors used to split contact constraints for parallel solving.
+/// Constraints that do not fit in a color are solved on a single thread.
+#define b2_graphColorCount			12
+
+/// Islands with fewer contacts than this are not split across threads.
+#define b2_minColoredContacts		256
+
+/// TOI candidates are computed on the thread pool when there are at least this many.
+#define b2_minParallelTOIContacts	64
+
 
 // Sleep
 
@@ -124,6 +138,24 @@ typedef double float64;
 /// A body cannot sleep if its angular velocity is above this tolerance.
 #define b2_angularSleepTolerance	(2.0f / 180.0f * b2_pi)
 
+// Profiling
+
+/// The number of steps kept for the profile minimum, average and maximum.
+#define b2_profileHistory			60
+
+/// Define B2_COLLISION_STATS as 1 to count GJK and TOI calls and iterations in
+/// b2_gjkCalls, b2_toiCalls and the like. These counters are global and are
+/// updated atomically, so they are off by default and cost nothing then.
+#if !defined(B2_COLLISION_STATS)
+	#define B2_COLLISION_STATS 0
+#endif
+
+#if B2_COLLISION_STATS
+	#define B2_COLLISION_STAT(statement) statement
+#else
+	#define B2_COLLISION_STAT(statement)
+#endif
+
 // Memory Allocation
 
 /// Implement this function to use your own memory allocator.
@@ -132,6 +164,65 @@ void* b2Alloc(int32 size);
 /// If you implement b2Alloc, you should also implement this function.
 void b2Free(void* mem);
 
+/// Where a heap allocation is made, for allocation accounting.
+enum b2AllocTag
+{
+	b2_allocUntagged,
+	b2_allocStackAllocator,		///< b2StackAllocator chunks
+	b2_allocGrowableStack,		///< b2GrowableStack growth in tree queries
+	b2_allocBroadPhase,			///< b2BroadPhase move and pair buffers
+	b2_allocDynamicTree,		///< b2DynamicTree nodes
+	b2_allocBlockChunk,			///< b2BlockAllocator chunks and chunk array
+	b2_allocBlockLarge,			///< b2BlockAllocator blocks over b2_maxBlockSize
+	b2_allocBodyStore,			///< b2BodyStore arrays
+	b2_allocTOIQueue,			///< b2TOIQueue buffers
+	b2_allocWorld,				///< b2World thread stacks and fork buffer
+	b2_allocTagCount
+};
+
+/// Memory for one b2World: its block and stack allocators, broad-phase and
+/// dynamic tree all allocate here. Use this to give a world an arena or
+/// huge-page backed memory. Blocks must be aligned like b2Alloc. When the world
+/// has a thread pool, Allocate and Free may be called from pool threads.
+class b2Allocator
+{
+public:
+	virtual ~b2Allocator() {}
+
+	/// Allocate size bytes.
+	virtual void* Allocate(int32 size) = 0;
+
+	/// Free a block returned by Allocate. The pointer may be NULL.
+	virtual void Free(void* mem) = 0;
+
+	/// Allocate size bytes for a tagged call site. Override this to see where
+	/// the memory goes. The default ignores the tag.
+	virtual void* AllocateTagged(int32 size, b2AllocTag tag)
+	{
+		B2_NOT_USED(tag);
+		return Allocate(size);
+	}
+};
+
+/// Allocate from an allocator, or with b2Alloc if it is NULL.
+inline void* b2Alloc(b2Allocator* allocator, int32 size, b2AllocTag tag = b2_allocUntagged)
+{
+	return allocator != NULL ? allocator->AllocateTagged(size, tag) : b2Alloc(size);
+}
+
+/// Free to an allocator, or with b2Free if it is NULL.
+inline void b2Free(b2Allocator* allocator, void* mem)
+{
+	if (allocator != NULL)
+	{
+		allocator->Free(mem);
+	}
+	else
+	{
+		b2Free(mem);
+	}
+}
+
 /// Logging function.
 void b2Log(const char* string, ...);
 
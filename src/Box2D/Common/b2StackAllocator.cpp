@@ -19,38 +19,76 @@
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Math.h>
 
-b2StackAllocator::b2StackAllocator()
+b2StackAllocator::b2StackAllocator(int32 capacity, b2Allocator* allocator)
 {
-	m_index = 0;
+	b2Assert(capacity > 0);
+	m_allocator = allocator;
+	m_chunks[0].data = (char*)b2Alloc(m_allocator, capacity, b2_allocStackAllocator);
+	m_chunks[0].capacity = capacity;
+	m_chunks[0].index = 0;
+	m_chunkCount = 1;
+	m_chunkIndex = 0;
+
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_fallbackCount = 0;
 	m_entryCount = 0;
 }
 
 b2StackAllocator::~b2StackAllocator()
 {
-	b2Assert(m_index == 0);
+	b2Assert(m_allocation == 0);
 	b2Assert(m_entryCount == 0);
+
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		b2Free(m_allocator, m_chunks[i].data);
+	}
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
 	b2Assert(m_entryCount < b2_maxStackEntries);
 
-	b2StackEntry* entry = m_entries + m_entryCount;
-	entry->size = size;
-	if (m_index + size > b2_stackSize)
-	{
-		entry->data = (char*)b2Alloc(size);
-		entry->usedMalloc = true;
-	}
-	else
+	// The chunks come from the heap, so they start aligned.
+	size = (size + b2_stackAlignment - 1) & ~(b2_stackAlignment - 1);
+
+	b2StackChunk* chunk = m_chunks + m_chunkIndex;
+	if (chunk->index + size > chunk->capacity)
 	{
-		entry->data = m_data + m_index;
-		entry->usedMalloc = false;
-		m_index += size;
+		// Chunks past the current one are empty. Use the next one if it is
+		// big enough, otherwise replace it with one that doubles the capacity.
+		int32 next = m_chunkIndex + 1;
+		if (next == m_chunkCount || m_chunks[next].capacity < size)
+		{
+			b2Assert(next < b2_maxStackChunks);
+
+			int32 capacity = b2Max(size, GetCapacity());
+			if (next < m_chunkCount)
+			{
+				b2Free(m_allocator, m_chunks[next].data);
+			}
+			else
+			{
+				++m_chunkCount;
+			}
+
+			m_chunks[next].data = (char*)b2Alloc(m_allocator, capacity, b2_allocStackAllocator);
+			m_chunks[next].capacity = capacity;
+			m_chunks[next].index = 0;
+			++m_fallbackCount;
+		}
+
+		m_chunkIndex = next;
+		chunk = m_chunks + next;
 	}
 
+	b2StackEntry* entry = m_entries + m_entryCount;
+	entry->data = chunk->data + chunk->index;
+	entry->size = size;
+	entry->chunk = m_chunkIndex;
+	chunk->index += size;
+
 	m_allocation += size;
 	m_maxAllocation = b2Max(m_maxAllocation, m_allocation);
 	++m_entryCount;
@@ -63,21 +101,51 @@ void b2StackAllocator::Free(void* p)
 	b2Assert(m_entryCount > 0);
 	b2StackEntry* entry = m_entries + m_entryCount - 1;
 	b2Assert(p == entry->data);
-	if (entry->usedMalloc)
+	B2_NOT_USED(p);
+
+	m_chunks[entry->chunk].index -= entry->size;
+	m_allocation -= entry->size;
+	--m_entryCount;
+
+	if (m_entryCount > 0)
 	{
-		b2Free(p);
+		m_chunkIndex = m_entries[m_entryCount - 1].chunk;
 	}
 	else
 	{
-		m_index -= entry->size;
+		m_chunkIndex = 0;
+
+		// Merge the chunks so the next step fits in one.
+		if (m_chunkCount > 1)
+		{
+			SetCapacity(GetCapacity());
+		}
 	}
-	m_allocation -= entry->size;
-	--m_entryCount;
+}
 
-	p = NULL;
+void b2StackAllocator::SetCapacity(int32 capacity)
+{
+	b2Assert(m_entryCount == 0);
+	b2Assert(capacity > 0);
+
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		b2Free(m_allocator, m_chunks[i].data);
+	}
+
+	m_chunks[0].data = (char*)b2Alloc(m_allocator, capacity, b2_allocStackAllocator);
+	m_chunks[0].capacity = capacity;
+	m_chunks[0].index = 0;
+	m_chunkCount = 1;
+	m_chunkIndex = 0;
 }
 
-int32 b2StackAllocator::GetMaxAllocation() const
+int32 b2StackAllocator::GetCapacity() const
 {
-	return m_maxAllocation;
+	int32 capacity = 0;
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		capacity += m_chunks[i].capacity;
+	}
+	return capacity;
 }
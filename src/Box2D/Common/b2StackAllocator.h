@@ -23,38 +23,77 @@
 
 const int32 b2_stackSize = 100 * 1024;	// 100k
 const int32 b2_maxStackEntries = 32;
+const int32 b2_maxStackChunks = 16;
+const int32 b2_stackAlignment = 16;	// covers pointers and SIMD lanes
 
 struct b2StackEntry
 {
 	char* data;
 	int32 size;
-	bool usedMalloc;
+	int32 chunk;
+};
+
+struct b2StackChunk
+{
+	char* data;
+	int32 capacity;
+	int32 index;
 };
 
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// Memory comes from a list of chunks. When an allocation does not fit, a
+// new chunk at least as large as all others is added. Once the stack is
+// empty again, the chunks are merged into one, so the allocator keeps its
+// high-water size and does not touch the heap in steady state. Block sizes
+// are rounded up to b2_stackAlignment so every block stays aligned.
 class b2StackAllocator
 {
 public:
-	b2StackAllocator();
+	b2StackAllocator(int32 capacity = b2_stackSize, b2Allocator* allocator = NULL);
 	~b2StackAllocator();
 
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	/// Replace the memory with a single chunk of the given size.
+	/// The stack must be empty.
+	void SetCapacity(int32 capacity);
+
+	/// The total size of all chunks in bytes.
+	int32 GetCapacity() const;
+
+	/// The peak number of bytes allocated at once.
 	int32 GetMaxAllocation() const;
 
+	/// The number of times an allocation did not fit and a chunk was added.
+	int32 GetFallbackCount() const;
+
 private:
 
-	char m_data[b2_stackSize];
-	int32 m_index;
+	b2StackChunk m_chunks[b2_maxStackChunks];
+	int32 m_chunkCount;
+	int32 m_chunkIndex;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_fallbackCount;
 
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
+
+	b2Allocator* m_allocator;
 };
 
+inline int32 b2StackAllocator::GetMaxAllocation() const
+{
+	return m_maxAllocation;
+}
+
+inline int32 b2StackAllocator::GetFallbackCount() const
+{
+	return m_fallbackCount;
+}
+
 #endif
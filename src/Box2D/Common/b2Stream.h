@@ -0,0 +1,137 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_STREAM_H
+#define B2_STREAM_H
+
+#include <Box2D/Common/b2Settings.h>
+#include <cstring>
+
+/// Writes raw bytes into a caller buffer. Writing past the capacity only
+/// counts the bytes, so a pass with a NULL buffer measures the size needed.
+class b2StreamWriter
+{
+public:
+	b2StreamWriter(void* buffer, int32 capacity)
+	{
+		m_data = (uint8*)buffer;
+		m_capacity = buffer != NULL ? capacity : 0;
+		m_size = 0;
+	}
+
+	void Write(const void* data, int32 size)
+	{
+		if (m_size + size <= m_capacity)
+		{
+			std::memcpy(m_data + m_size, data, size);
+		}
+		m_size += size;
+	}
+
+	template <typename T>
+	void Write(const T& value)
+	{
+		Write(&value, sizeof(T));
+	}
+
+	/// Get the number of bytes written, including those that did not fit.
+	int32 GetSize() const
+	{
+		return m_size;
+	}
+
+	/// Did every byte fit in the buffer?
+	bool IsComplete() const
+	{
+		return m_size <= m_capacity;
+	}
+
+private:
+	uint8* m_data;
+	int32 m_capacity;
+	int32 m_size;
+};
+
+/// Reads raw bytes written by b2StreamWriter. A read past the end fails,
+/// zero fills the destination and puts the reader in an error state.
+class b2StreamReader
+{
+public:
+	b2StreamReader(const void* buffer, int32 size)
+	{
+		m_data = (const uint8*)buffer;
+		m_size = size;
+		m_offset = 0;
+		m_ok = true;
+	}
+
+	bool Read(void* data, int32 size)
+	{
+		if (m_ok == false || size < 0 || m_offset + size > m_size)
+		{
+			m_ok = false;
+			std::memset(data, 0, size > 0 ? size : 0);
+			return false;
+		}
+
+		std::memcpy(data, m_data + m_offset, size);
+		m_offset += size;
+		return true;
+	}
+
+	template <typename T>
+	bool Read(T* value)
+	{
+		return Read(value, sizeof(T));
+	}
+
+	/// Skip bytes without copying them.
+	/// @return the skipped bytes, or NULL if the read failed.
+	const void* Skip(int32 size)
+	{
+		if (m_ok == false || size < 0 || m_offset + size > m_size)
+		{
+			m_ok = false;
+			return NULL;
+		}
+
+		const void* data = m_data + m_offset;
+		m_offset += size;
+		return data;
+	}
+
+	/// Has every read so far succeeded?
+	bool IsOk() const
+	{
+		return m_ok;
+	}
+
+	/// Get the number of bytes not read yet.
+	int32 GetRemaining() const
+	{
+		return m_size - m_offset;
+	}
+
+private:
+	const uint8* m_data;
+	int32 m_size;
+	int32 m_offset;
+	bool m_ok;
+};
+
+#endif
@@ -0,0 +1,335 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2ThreadPool.h>
+#include <Box2D/Common/b2Math.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+
+#include <pthread.h>
+#include <sched.h>
+
+// Spins before a barrier gives up its time slice.
+const int32 b2_barrierSpinCount = 1000;
+
+struct b2ThreadPoolWorker
+{
+	b2ThreadPool* pool;
+	int32 threadIndex;
+	pthread_t thread;
+};
+
+struct b2ThreadPoolImpl
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t workCondition;
+	pthread_cond_t doneCondition;
+	b2ThreadPoolWorker workers[b2_maxThreads];
+};
+
+static void* b2ThreadPoolEntry(void* arg)
+{
+	b2ThreadPoolWorker* worker = (b2ThreadPoolWorker*)arg;
+	worker->pool->WorkerMain(worker->threadIndex);
+	return NULL;
+}
+
+b2ThreadPool::b2ThreadPool(int32 threadCount)
+{
+	m_threadCount = b2Clamp(threadCount, 1, b2_maxThreads);
+	m_task = NULL;
+	m_count = 0;
+	m_next = 0;
+	m_generation = 0;
+	m_busyCount = 0;
+	m_quit = false;
+
+	b2ThreadPoolImpl* impl = (b2ThreadPoolImpl*)b2Alloc(sizeof(b2ThreadPoolImpl));
+	pthread_mutex_init(&impl->mutex, NULL);
+	pthread_cond_init(&impl->workCondition, NULL);
+	pthread_cond_init(&impl->doneCondition, NULL);
+	m_impl = impl;
+
+	// Thread 0 is the caller of ParallelFor.
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		b2ThreadPoolWorker* worker = impl->workers + i;
+		worker->pool = this;
+		worker->threadIndex = i;
+		if (pthread_create(&worker->thread, NULL, b2ThreadPoolEntry, worker) != 0)
+		{
+			// Run with the threads we have.
+			m_threadCount = i;
+			break;
+		}
+	}
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	b2ThreadPoolImpl* impl = (b2ThreadPoolImpl*)m_impl;
+
+	pthread_mutex_lock(&impl->mutex);
+	m_quit = true;
+	pthread_cond_broadcast(&impl->workCondition);
+	pthread_mutex_unlock(&impl->mutex);
+
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		pthread_join(impl->workers[i].thread, NULL);
+	}
+
+	pthread_cond_destroy(&impl->doneCondition);
+	pthread_cond_destroy(&impl->workCondition);
+	pthread_mutex_destroy(&impl->mutex);
+	b2Free(impl);
+}
+
+void b2ThreadPool::WorkerMain(int32 threadIndex)
+{
+	b2ThreadPoolImpl* impl = (b2ThreadPoolImpl*)m_impl;
+	int32 generation = 0;
+
+	pthread_mutex_lock(&impl->mutex);
+	for (;;)
+	{
+		while (m_quit == false && m_generation == generation)
+		{
+			pthread_cond_wait(&impl->workCondition, &impl->mutex);
+		}
+
+		if (m_quit)
+		{
+			break;
+		}
+
+		generation = m_generation;
+		pthread_mutex_unlock(&impl->mutex);
+
+		RunItems(threadIndex);
+
+		pthread_mutex_lock(&impl->mutex);
+		--m_busyCount;
+		if (m_busyCount == 0)
+		{
+			pthread_cond_signal(&impl->doneCondition);
+		}
+	}
+	pthread_mutex_unlock(&impl->mutex);
+}
+
+void b2ThreadPool::ParallelFor(b2Task* task, int32 count)
+{
+	if (m_threadCount == 1 || count <= 1)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			task->Execute(i, 0);
+		}
+		return;
+	}
+
+	b2ThreadPoolImpl* impl = (b2ThreadPoolImpl*)m_impl;
+
+	pthread_mutex_lock(&impl->mutex);
+	b2Assert(m_task == NULL);
+	m_task = task;
+	m_count = count;
+	m_next = 0;
+	m_busyCount = m_threadCount - 1;
+	++m_generation;
+	pthread_cond_broadcast(&impl->workCondition);
+	pthread_mutex_unlock(&impl->mutex);
+
+	RunItems(0);
+
+	pthread_mutex_lock(&impl->mutex);
+	while (m_busyCount > 0)
+	{
+		pthread_cond_wait(&impl->doneCondition, &impl->mutex);
+	}
+	m_task = NULL;
+	pthread_mutex_unlock(&impl->mutex);
+}
+
+void b2ThreadPool::RunItems(int32 threadIndex)
+{
+	for (;;)
+	{
+		int32 index = __sync_fetch_and_add(&m_next, 1);
+		if (index >= m_count)
+		{
+			break;
+		}
+
+		m_task->Execute(index, threadIndex);
+	}
+}
+
+b2ThreadBarrier::b2ThreadBarrier(int32 count)
+{
+	m_count = count;
+	m_arrived = 0;
+	m_generation = 0;
+}
+
+void b2ThreadBarrier::Wait()
+{
+	// All accesses are full barriers so that work done before Wait is
+	// visible to every thread after it.
+	int32 generation = __sync_fetch_and_add(&m_generation, 0);
+
+	if (__sync_add_and_fetch(&m_arrived, 1) == m_count)
+	{
+		// Last one in releases the others.
+		__sync_lock_test_and_set(&m_arrived, 0);
+		__sync_fetch_and_add(&m_generation, 1);
+		return;
+	}
+
+	for (int32 spin = 0; __sync_fetch_and_add(&m_generation, 0) == generation; ++spin)
+	{
+		if (spin >= b2_barrierSpinCount)
+		{
+			sched_yield();
+		}
+	}
+}
+
+b2SpinLock::b2SpinLock()
+{
+	m_locked = 0;
+}
+
+void b2SpinLock::Lock()
+{
+	for (int32 spin = 0; __sync_lock_test_and_set(&m_locked, 1) != 0; ++spin)
+	{
+		while (__sync_fetch_and_add(&m_locked, 0) != 0)
+		{
+			if (++spin >= b2_barrierSpinCount)
+			{
+				sched_yield();
+			}
+		}
+	}
+}
+
+void b2SpinLock::Unlock()
+{
+	__sync_lock_release(&m_locked);
+}
+
+void b2AtomicAdd(volatile int32* value, int32 amount)
+{
+	__sync_fetch_and_add(value, amount);
+}
+
+void b2AtomicMax(volatile int32* value, int32 candidate)
+{
+	int32 current = __sync_fetch_and_add(value, 0);
+	while (candidate > current)
+	{
+		int32 previous = __sync_val_compare_and_swap(value, current, candidate);
+		if (previous == current)
+		{
+			break;
+		}
+
+		current = previous;
+	}
+}
+
+#else
+
+// No thread support on this platform. Everything runs on the caller.
+
+b2ThreadPool::b2ThreadPool(int32 threadCount)
+{
+	B2_NOT_USED(threadCount);
+	m_threadCount = 1;
+	m_task = NULL;
+	m_count = 0;
+	m_next = 0;
+	m_generation = 0;
+	m_busyCount = 0;
+	m_quit = false;
+	m_impl = NULL;
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+}
+
+void b2ThreadPool::WorkerMain(int32 threadIndex)
+{
+	B2_NOT_USED(threadIndex);
+}
+
+void b2ThreadPool::ParallelFor(b2Task* task, int32 count)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		task->Execute(i, 0);
+	}
+}
+
+void b2ThreadPool::RunItems(int32 threadIndex)
+{
+	B2_NOT_USED(threadIndex);
+}
+
+b2ThreadBarrier::b2ThreadBarrier(int32 count)
+{
+	b2Assert(count == 1);
+	m_count = count;
+	m_arrived = 0;
+	m_generation = 0;
+}
+
+void b2ThreadBarrier::Wait()
+{
+}
+
+b2SpinLock::b2SpinLock()
+{
+	m_locked = 0;
+}
+
+void b2SpinLock::Lock()
+{
+}
+
+void b2SpinLock::Unlock()
+{
+}
+
+void b2AtomicAdd(volatile int32* value, int32 amount)
+{
+	*value += amount;
+}
+
+void b2AtomicMax(volatile int32* value, int32 candidate)
+{
+	if (candidate > *value)
+	{
+		*value = candidate;
+	}
+}
+
+#endif
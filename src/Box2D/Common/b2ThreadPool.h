@@ -0,0 +1,124 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_THREAD_POOL_H
+#define B2_THREAD_POOL_H
+
+#include <Box2D/Common/b2Settings.h>
+
+const int32 b2_maxThreads = 32;
+
+/// A parallel task. Execute is called once for every item index in
+/// [0, count) and may run on any thread of the pool, in any order.
+/// Implementations must write their results per item so that the outcome
+/// does not depend on scheduling.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Process one item.
+	/// @param index the item index.
+	/// @param threadIndex the calling thread in [0, b2ThreadPool::GetThreadCount()).
+	/// Thread 0 is always the thread that called ParallelFor.
+	virtual void Execute(int32 index, int32 threadIndex) = 0;
+};
+
+/// A fixed set of worker threads used to run b2Task items in parallel.
+/// The calling thread takes part in the work, so a pool created with
+/// a thread count of 1 runs everything serially without spawning threads.
+/// Only one ParallelFor may be in flight at a time.
+class b2ThreadPool
+{
+public:
+	/// @param threadCount the total number of threads, including the caller.
+	/// This is clamped to [1, b2_maxThreads].
+	b2ThreadPool(int32 threadCount);
+	~b2ThreadPool();
+
+	/// Get the total number of threads, including the calling thread.
+	int32 GetThreadCount() const;
+
+	/// Run task->Execute for every index in [0, count) and wait for completion.
+	/// When count equals GetThreadCount() and every item waits on the same
+	/// b2ThreadBarrier, each item runs on its own thread.
+	void ParallelFor(b2Task* task, int32 count);
+
+	/// This is an internal function.
+	void WorkerMain(int32 threadIndex);
+
+private:
+
+	void RunItems(int32 threadIndex);
+
+	int32 m_threadCount;
+
+	b2Task* m_task;
+	int32 m_count;
+	volatile int32 m_next;
+
+	int32 m_generation;
+	int32 m_busyCount;
+	bool m_quit;
+
+	// Platform state, see b2ThreadPool.cpp.
+	void* m_impl;
+};
+
+/// A reusable spinning barrier for tasks that run one item per pool thread.
+class b2ThreadBarrier
+{
+public:
+	b2ThreadBarrier(int32 count);
+
+	/// Wait until count threads have called Wait.
+	void Wait();
+
+private:
+
+	int32 m_count;
+	volatile int32 m_arrived;
+	volatile int32 m_generation;
+};
+
+/// A lock for short critical sections between pool threads.
+class b2SpinLock
+{
+public:
+	b2SpinLock();
+
+	void Lock();
+	void Unlock();
+
+private:
+
+	volatile int32 m_locked;
+};
+
+/// Add to a counter shared between threads.
+void b2AtomicAdd(volatile int32* value, int32 amount);
+
+/// Raise a counter shared between threads to at least a candidate value.
+void b2AtomicMax(volatile int32* value, int32 candidate);
+
+inline int32 b2ThreadPool::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+#endif
@@ -20,24 +20,23 @@
 
 #if defined(_WIN32)
 
-float64 b2Timer::s_invFrequency = 0.0f;
-
 #include <windows.h>
 
-b2Timer::b2Timer()
+static float64 b2GetInvFrequency()
 {
 	LARGE_INTEGER largeInteger;
+	QueryPerformanceFrequency(&largeInteger);
+	float64 frequency = float64(largeInteger.QuadPart);
+	return frequency > 0.0 ? 1000.0 / frequency : 0.0;
+}
 
-	if (s_invFrequency == 0.0f)
-	{
-		QueryPerformanceFrequency(&largeInteger);
-		s_invFrequency = float64(largeInteger.QuadPart);
-		if (s_invFrequency > 0.0f)
-		{
-			s_invFrequency = 1000.0f / s_invFrequency;
-		}
-	}
+// Set once during static initialization, before any pool thread runs, so
+// timers on several threads only read it.
+float64 b2Timer::s_invFrequency = b2GetInvFrequency();
 
+b2Timer::b2Timer()
+{
+	LARGE_INTEGER largeInteger;
 	QueryPerformanceCounter(&largeInteger);
 	m_start = float64(largeInteger.QuadPart);
 }
@@ -58,28 +57,90 @@ float32 b2Timer::GetMilliseconds() const
 	return ms;
 }
 
-#elif defined(__linux__) || defined (__APPLE__)
+float64 b2Timer::GetMicroseconds() const
+{
+	LARGE_INTEGER largeInteger;
+	QueryPerformanceCounter(&largeInteger);
+	float64 count = float64(largeInteger.QuadPart);
+	return 1000.0 * s_invFrequency * (count - m_start);
+}
+
+#elif defined(__APPLE__)
+
+#include <mach/mach_time.h>
+
+static float64 b2GetInvFrequency()
+{
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+
+	// Ticks to nanoseconds, then to milliseconds.
+	return 1.0e-6 * float64(timebase.numer) / float64(timebase.denom);
+}
+
+// Set once during static initialization, before any pool thread runs, so
+// timers on several threads only read it.
+float64 b2Timer::s_invFrequency = b2GetInvFrequency();
+
+b2Timer::b2Timer()
+{
+	Reset();
+}
+
+void b2Timer::Reset()
+{
+	m_start = float64(mach_absolute_time());
+}
+
+float32 b2Timer::GetMilliseconds() const
+{
+	float64 count = float64(mach_absolute_time());
+	float32 ms = float32(s_invFrequency * (count - m_start));
+	return ms;
+}
+
+float64 b2Timer::GetMicroseconds() const
+{
+	float64 count = float64(mach_absolute_time());
+	return 1000.0 * s_invFrequency * (count - m_start);
+}
+
+#elif defined(__linux__)
 
-#include <sys/time.h>
+#include <time.h>
 
 b2Timer::b2Timer()
 {
-    Reset();
+	Reset();
 }
 
 void b2Timer::Reset()
 {
-    timeval t;
-    gettimeofday(&t, 0);
-    m_start_sec = t.tv_sec;
-    m_start_msec = t.tv_usec * 0.001f;
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	m_start_sec = t.tv_sec;
+	m_start_nsec = t.tv_nsec;
 }
 
 float32 b2Timer::GetMilliseconds() const
 {
-    timeval t;
-    gettimeofday(&t, 0);
-    return (t.tv_sec - m_start_sec) * 1000 + t.tv_usec * 0.001f - m_start_msec;
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	// Subtract before converting so that float precision does not depend on uptime.
+	float64 sec = float64(t.tv_sec - m_start_sec);
+	float64 nsec = float64(t.tv_nsec - m_start_nsec);
+	return float32(1.0e3 * sec + 1.0e-6 * nsec);
+}
+
+float64 b2Timer::GetMicroseconds() const
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	float64 sec = float64(t.tv_sec - m_start_sec);
+	float64 nsec = float64(t.tv_nsec - m_start_nsec);
+	return 1.0e6 * sec + 1.0e-3 * nsec;
 }
 
 #else
@@ -97,4 +158,9 @@ float32 b2Timer::GetMilliseconds() const
 	return 0.0f;
 }
 
+float64 b2Timer::GetMicroseconds() const
+{
+	return 0.0;
+}
+
 #endif
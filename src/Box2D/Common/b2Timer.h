@@ -18,8 +18,9 @@
 
 #include <Box2D/Common/b2Settings.h>
 
-/// Timer for profiling. This has platform specific code and may
-/// not work on every platform.
+/// Timer for profiling. This uses a monotonic high resolution clock, so it is
+/// not affected by changes to the wall clock. This has platform specific code
+/// and may not work on every platform.
 class b2Timer
 {
 public:
@@ -33,13 +34,17 @@ public:
 	/// Get the time since construction or the last reset.
 	float32 GetMilliseconds() const;
 
+	/// Get the time since construction or the last reset in double precision,
+	/// for long running timers.
+	float64 GetMicroseconds() const;
+
 private:
 
-#if defined(_WIN32)
+#if defined(_WIN32) || defined(__APPLE__)
 	float64 m_start;
 	static float64 s_invFrequency;
-#elif defined(__linux__) || defined (__APPLE__)
-	unsigned long m_start_sec;
-	unsigned long m_start_msec;
+#elif defined(__linux__)
+	long m_start_sec;
+	long m_start_nsec;
 #endif
 };
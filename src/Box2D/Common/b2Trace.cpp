@@ -0,0 +1,175 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2Trace.h>
+
+#if B2_TRACE
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Common/b2Timer.h>
+#include <pthread.h>
+#include <cstdio>
+
+struct b2TraceRecord
+{
+	const char* name;
+	float64 start;
+	float32 duration;
+	int32 arg;
+};
+
+// Only the owning thread writes a buffer. The count is published after the
+// record is written, so a reader sees complete records unless the writer
+// wraps around while it reads.
+struct b2TraceBuffer
+{
+	b2TraceRecord records[b2_traceCapacity];
+	volatile int32 count;
+};
+
+static b2Timer s_traceClock;
+static b2TraceBuffer* s_traceBuffers[b2_traceMaxThreads];
+static volatile int32 s_traceBufferCount = 0;
+static volatile int32 s_traceOpenScopes = 0;
+static pthread_key_t s_traceKey;
+static pthread_once_t s_traceOnce = PTHREAD_ONCE_INIT;
+
+static void b2TraceInitKey()
+{
+	pthread_key_create(&s_traceKey, NULL);
+}
+
+// Find the buffer of the calling thread, creating it on first use. Buffers
+// are never freed, so the events of finished threads can still be written.
+static b2TraceBuffer* b2GetTraceBuffer()
+{
+	pthread_once(&s_traceOnce, b2TraceInitKey);
+
+	b2TraceBuffer* buffer = (b2TraceBuffer*)pthread_getspecific(s_traceKey);
+	if (buffer != NULL)
+	{
+		return buffer;
+	}
+
+	int32 index = __sync_fetch_and_add(&s_traceBufferCount, 1);
+	if (index >= b2_traceMaxThreads)
+	{
+		return NULL;
+	}
+
+	buffer = (b2TraceBuffer*)b2Alloc(sizeof(b2TraceBuffer));
+	buffer->count = 0;
+	s_traceBuffers[index] = buffer;
+	__sync_synchronize();
+
+	pthread_setspecific(s_traceKey, buffer);
+	return buffer;
+}
+
+float64 b2TraceTime()
+{
+	return s_traceClock.GetMicroseconds();
+}
+
+void b2TraceEvent(const char* name, float64 start, float64 duration, int32 arg)
+{
+	b2TraceBuffer* buffer = b2GetTraceBuffer();
+	if (buffer == NULL)
+	{
+		return;
+	}
+
+	int32 count = buffer->count;
+	b2TraceRecord* record = buffer->records + (count & (b2_traceCapacity - 1));
+	record->name = name;
+	record->start = start;
+	record->duration = float32(duration);
+	record->arg = arg;
+
+	__sync_synchronize();
+	buffer->count = count + 1;
+}
+
+bool b2TraceWrite(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+
+	bool first = true;
+	int32 bufferCount = b2Min(int32(s_traceBufferCount), int32(b2_traceMaxThreads));
+	for (int32 i = 0; i < bufferCount; ++i)
+	{
+		const b2TraceBuffer* buffer = s_traceBuffers[i];
+		if (buffer == NULL)
+		{
+			// The thread is still creating its buffer.
+			continue;
+		}
+
+		int32 count = buffer->count;
+		int32 begin = b2Max(0, count - b2_traceCapacity);
+		for (int32 j = begin; j < count; ++j)
+		{
+			const b2TraceRecord* record = buffer->records + (j & (b2_traceCapacity - 1));
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+					first ? "" : ",\n", record->name, i, record->start, record->duration);
+			if (record->arg >= 0)
+			{
+				fprintf(file, ",\"args\":{\"n\":%d}", record->arg);
+			}
+			fprintf(file, "}");
+			first = false;
+		}
+	}
+
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	bool ok = ferror(file) == 0;
+	ok = fclose(file) == 0 && ok;
+	return ok;
+}
+
+void b2TraceOpenScope()
+{
+	__sync_fetch_and_add(&s_traceOpenScopes, 1);
+}
+
+void b2TraceCloseScope()
+{
+	__sync_fetch_and_sub(&s_traceOpenScopes, 1);
+}
+
+void b2TraceClear()
+{
+	b2Assert(__sync_fetch_and_add(&s_traceOpenScopes, 0) == 0);
+
+	int32 bufferCount = b2Min(int32(s_traceBufferCount), int32(b2_traceMaxThreads));
+	for (int32 i = 0; i < bufferCount; ++i)
+	{
+		if (s_traceBuffers[i] != NULL)
+		{
+			s_traceBuffers[i]->count = 0;
+		}
+	}
+}
+
+#endif
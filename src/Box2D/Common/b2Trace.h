@@ -0,0 +1,125 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TRACE_H
+#define B2_TRACE_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// Scoped trace events for looking at a frame as a timeline. Define B2_TRACE
+/// as 1 to record them. Otherwise the macros expand to nothing and cost
+/// nothing. Each thread records into its own ring buffer without locks, and
+/// b2TraceWrite saves the events as Chrome trace JSON, which can be opened in
+/// chrome://tracing or Perfetto. Only the newest b2_traceCapacity events of
+/// each thread are kept.
+///
+/// Names must be string literals or otherwise outlive the trace:
+/// @code
+/// void Update()
+/// {
+///     B2_TRACE_SCOPE("Update");
+///     ...
+/// }
+/// @endcode
+
+#if !defined(B2_TRACE)
+	#define B2_TRACE 0
+#endif
+
+#if B2_TRACE
+
+/// The number of events kept per thread. This must be a power of two.
+#define b2_traceCapacity	16384
+
+/// The number of threads that can record events.
+#define b2_traceMaxThreads	64
+
+/// Get the trace clock in microseconds.
+float64 b2TraceTime();
+
+/// Record an event that started at start and lasted duration microseconds.
+/// A negative arg is not written.
+void b2TraceEvent(const char* name, float64 start, float64 duration, int32 arg);
+
+/// Write the recorded events of all threads as Chrome trace JSON. Events
+/// recorded while this runs may be missing or torn, so call it between steps.
+/// @return false if the file could not be written.
+bool b2TraceWrite(const char* path);
+
+/// Drop the recorded events of all threads. Pool threads write their
+/// buffers without locks, so this may only be called between steps while
+/// every pool is idle. It asserts that no trace scope is open on any thread,
+/// which holds exactly then because each step runs inside a scope.
+void b2TraceClear();
+
+/// Count a scope as open or closed for b2TraceClear.
+/// This is an internal function.
+void b2TraceOpenScope();
+void b2TraceCloseScope();
+
+/// Records an event from construction to destruction.
+class b2TraceScope
+{
+public:
+	b2TraceScope(const char* name, int32 arg = -1)
+	{
+		m_name = name;
+		m_arg = arg;
+		b2TraceOpenScope();
+		m_start = b2TraceTime();
+	}
+
+	~b2TraceScope()
+	{
+		b2TraceEvent(m_name, m_start, b2TraceTime() - m_start, m_arg);
+		b2TraceCloseScope();
+	}
+
+private:
+	const char* m_name;
+	int32 m_arg;
+	float64 m_start;
+};
+
+#define B2_TRACE_JOIN2(a, b) a##b
+#define B2_TRACE_JOIN(a, b) B2_TRACE_JOIN2(a, b)
+
+/// Trace the rest of the enclosing scope.
+#define B2_TRACE_SCOPE(name) b2TraceScope B2_TRACE_JOIN(b2_traceScope, __LINE__)(name)
+
+/// Trace the rest of the enclosing scope with a number, such as an item count.
+#define B2_TRACE_SCOPE_ARG(name, arg) b2TraceScope B2_TRACE_JOIN(b2_traceScope, __LINE__)(name, arg)
+
+#else
+
+#define B2_TRACE_SCOPE(name)
+#define B2_TRACE_SCOPE_ARG(name, arg)
+
+inline bool b2TraceWrite(const char* path)
+{
+	B2_NOT_USED(path);
+	return false;
+}
+
+inline void b2TraceClear()
+{
+}
+
+#endif
+
+#endif
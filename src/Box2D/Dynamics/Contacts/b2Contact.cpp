@@ -27,6 +27,7 @@
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 
 #include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Collision/b2Distance.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
 #include <Box2D/Common/b2BlockAllocator.h>
@@ -34,46 +35,45 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 
-b2ContactRegister b2Contact::s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
-bool b2Contact::s_initialized = false;
-
-void b2Contact::InitializeRegisters()
+// Indexed by [typeA][typeB] in the order of b2Shape::Type. The primary entry
+// takes the fixtures in the given order, the other one swaps them.
+const b2ContactRegister b2Contact::s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount] =
 {
-	AddType(b2CircleContact::Create, b2CircleContact::Destroy, b2Shape::e_circle, b2Shape::e_circle);
-	AddType(b2PolygonAndCircleContact::Create, b2PolygonAndCircleContact::Destroy, b2Shape::e_polygon, b2Shape::e_circle);
-	AddType(b2PolygonContact::Create, b2PolygonContact::Destroy, b2Shape::e_polygon, b2Shape::e_polygon);
-	AddType(b2EdgeAndCircleContact::Create, b2EdgeAndCircleContact::Destroy, b2Shape::e_edge, b2Shape::e_circle);
-	AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, b2Shape::e_edge, b2Shape::e_polygon);
-	AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, b2Shape::e_chain, b2Shape::e_circle);
-	AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, b2Shape::e_chain, b2Shape::e_polygon);
-}
+	// e_circle
+	{
+		{b2CircleContact::Create, b2CircleContact::Destroy, true},
+		{b2EdgeAndCircleContact::Create, b2EdgeAndCircleContact::Destroy, false},
+		{b2PolygonAndCircleContact::Create, b2PolygonAndCircleContact::Destroy, false},
+		{b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, false}
+	},
 
-void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
-						b2Shape::Type type1, b2Shape::Type type2)
-{
-	b2Assert(0 <= type1 && type1 < b2Shape::e_typeCount);
-	b2Assert(0 <= type2 && type2 < b2Shape::e_typeCount);
-	
-	s_registers[type1][type2].createFcn = createFcn;
-	s_registers[type1][type2].destroyFcn = destoryFcn;
-	s_registers[type1][type2].primary = true;
+	// e_edge
+	{
+		{b2EdgeAndCircleContact::Create, b2EdgeAndCircleContact::Destroy, true},
+		{NULL, NULL, false},
+		{b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, true},
+		{NULL, NULL, false}
+	},
 
-	if (type1 != type2)
+	// e_polygon
 	{
-		s_registers[type2][type1].createFcn = createFcn;
-		s_registers[type2][type1].destroyFcn = destoryFcn;
-		s_registers[type2][type1].primary = false;
-	}
-}
+		{b2PolygonAndCircleContact::Create, b2PolygonAndCircleContact::Destroy, true},
+		{b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, false},
+		{b2PolygonContact::Create, b2PolygonContact::Destroy, true},
+		{b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, false}
+	},
 
-b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
-{
-	if (s_initialized == false)
+	// e_chain
 	{
-		InitializeRegisters();
-		s_initialized = true;
+		{b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, true},
+		{NULL, NULL, false},
+		{b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, true},
+		{NULL, NULL, false}
 	}
+};
 
+b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
+{
 	b2Shape::Type type1 = fixtureA->GetType();
 	b2Shape::Type type2 = fixtureB->GetType();
 
@@ -100,8 +100,6 @@ b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtu
 
 void b2Contact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 {
-	b2Assert(s_initialized == true);
-
 	if (contact->m_manifold.pointCount > 0)
 	{
 		contact->GetFixtureA()->GetBody()->SetAwake(true);
@@ -132,6 +130,8 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 
 	m_prev = NULL;
 	m_next = NULL;
+	m_awakePrev = NULL;
+	m_awakeNext = NULL;
 
 	m_nodeA.contact = NULL;
 	m_nodeA.prev = NULL;
@@ -144,74 +144,70 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_nodeB.other = NULL;
 
 	m_toiCount = 0;
+	m_toiSequence = 0;
 
 	m_friction = b2MixFriction(m_fixtureA->m_friction, m_fixtureB->m_friction);
 	m_restitution = b2MixRestitution(m_fixtureA->m_restitution, m_fixtureB->m_restitution);
 }
 
-// Update the contact manifold and touching status.
+// Update the contact manifold and touching status. When speculativeDt is positive
+// and the shapes are apart, this may add a speculative point instead.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
-void b2Contact::Update(b2ContactListener* listener)
+void b2Contact::Update(b2ContactListener* listener, float32 speculativeDt)
 {
 	b2Manifold oldManifold = m_manifold;
 
 	// Re-enable this contact.
 	m_flags |= e_enabledFlag;
+	m_flags &= ~e_speculativeFlag;
 
 	bool touching = false;
 	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
 
-	bool sensorA = m_fixtureA->IsSensor();
-	bool sensorB = m_fixtureB->IsSensor();
-	bool sensor = sensorA || sensorB;
+	// Sensor overlaps are tracked by the contact manager's sensor pairs.
+	b2Assert(m_fixtureA->IsSensor() == false && m_fixtureB->IsSensor() == false);
 
 	b2Body* bodyA = m_fixtureA->GetBody();
 	b2Body* bodyB = m_fixtureB->GetBody();
 	const b2Transform& xfA = bodyA->GetTransform();
 	const b2Transform& xfB = bodyB->GetTransform();
 
-	// Is this contact a sensor?
-	if (sensor)
-	{
-		const b2Shape* shapeA = m_fixtureA->GetShape();
-		const b2Shape* shapeB = m_fixtureB->GetShape();
-		touching = b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB);
+	Evaluate(&m_manifold, xfA, xfB);
+	touching = m_manifold.pointCount > 0;
 
-		// Sensors don't generate manifolds.
-		m_manifold.pointCount = 0;
-	}
-	else
+	// Match old contact ids to new contact ids and copy the
+	// stored impulses to warm start the solver.
+	for (int32 i = 0; i < m_manifold.pointCount; ++i)
 	{
-		Evaluate(&m_manifold, xfA, xfB);
-		touching = m_manifold.pointCount > 0;
+		b2ManifoldPoint* mp2 = m_manifold.points + i;
+		mp2->normalImpulse = 0.0f;
+		mp2->tangentImpulse = 0.0f;
+		b2ContactID id2 = mp2->id;
 
-		// Match old contact ids to new contact ids and copy the
-		// stored impulses to warm start the solver.
-		for (int32 i = 0; i < m_manifold.pointCount; ++i)
+		for (int32 j = 0; j < oldManifold.pointCount; ++j)
 		{
-			b2ManifoldPoint* mp2 = m_manifold.points + i;
-			mp2->normalImpulse = 0.0f;
-			mp2->tangentImpulse = 0.0f;
-			b2ContactID id2 = mp2->id;
+			b2ManifoldPoint* mp1 = oldManifold.points + j;
 
-			for (int32 j = 0; j < oldManifold.pointCount; ++j)
+			if (mp1->id.key == id2.key)
 			{
-				b2ManifoldPoint* mp1 = oldManifold.points + j;
-
-				if (mp1->id.key == id2.key)
-				{
-					mp2->normalImpulse = mp1->normalImpulse;
-					mp2->tangentImpulse = mp1->tangentImpulse;
-					break;
-				}
+				mp2->normalImpulse = mp1->normalImpulse;
+				mp2->tangentImpulse = mp1->tangentImpulse;
+				break;
 			}
 		}
+	}
 
-		if (touching != wasTouching)
-		{
-			bodyA->SetAwake(true);
-			bodyB->SetAwake(true);
-		}
+	// Speculative points are not warm started.
+	bool speculative = false;
+	if (touching == false && speculativeDt > 0.0f)
+	{
+		speculative = EvaluateSpeculative(speculativeDt);
+	}
+
+	if (touching != wasTouching)
+	{
+		bodyA->SetAwake(true);
+		bodyB->SetAwake(true);
 	}
 
 	if (touching)
@@ -233,8 +229,94 @@ void b2Contact::Update(b2ContactListener* listener)
 		listener->EndContact(this);
 	}
 
-	if (sensor == false && touching && listener)
+	if (speculative)
+	{
+		m_flags |= e_speculativeFlag;
+	}
+
+	// Speculative contacts go through pre-solve so they can be disabled.
+	if ((touching || speculative) && listener)
 	{
 		listener->PreSolve(this, &oldManifold);
 	}
 }
+
+// Build a manifold for shapes that are apart but may touch within dt. Only
+// pairs that continuous collision handles get one: a bullet or a non-dynamic
+// body must be involved.
+bool b2Contact::EvaluateSpeculative(float32 dt)
+{
+	b2Body* bodyA = m_fixtureA->GetBody();
+	b2Body* bodyB = m_fixtureB->GetBody();
+
+	bool collideA = bodyA->IsBullet() || bodyA->GetType() != b2_dynamicBody;
+	bool collideB = bodyB->IsBullet() || bodyB->GetType() != b2_dynamicBody;
+	if (collideA == false && collideB == false)
+	{
+		return false;
+	}
+
+	const b2Shape* shapeA = m_fixtureA->GetShape();
+	const b2Shape* shapeB = m_fixtureB->GetShape();
+	const b2Transform& xfA = bodyA->GetTransform();
+	const b2Transform& xfB = bodyB->GetTransform();
+
+	b2DistanceInput input;
+	input.proxyA.Set(shapeA, m_indexA);
+	input.proxyB.Set(shapeB, m_indexB);
+	input.transformA = xfA;
+	input.transformB = xfB;
+	input.useRadii = false;
+
+	b2SimplexCache cache;
+	cache.count = 0;
+
+	b2DistanceOutput output;
+	b2Distance(&output, &cache, &input);
+
+	// Overlapping cores are handled by the regular manifold.
+	if (output.distance < 10.0f * b2_epsilon)
+	{
+		return false;
+	}
+
+	b2Vec2 normal = (1.0f / output.distance) * (output.pointB - output.pointA);
+	float32 separation = output.distance - shapeA->m_radius - shapeB->m_radius;
+
+	// How far do the shapes close in along the normal during the step?
+	b2Vec2 vA = bodyA->GetLinearVelocityFromWorldPoint(output.pointA);
+	b2Vec2 vB = bodyB->GetLinearVelocityFromWorldPoint(output.pointB);
+	float32 approach = -dt * b2Dot(vB - vA, normal);
+
+	if (separation > approach + b2_speculativeDistance)
+	{
+		return false;
+	}
+
+	// Collide the shapes with B moved onto A along the normal, slightly
+	// overlapping so that no clip point is lost. The manifold stores body local
+	// points, so it also holds for the actual transforms, where its points have
+	// a positive separation.
+	b2Transform xfMoved = xfB;
+	xfMoved.p -= (separation + b2_linearSlop) * normal;
+	Evaluate(&m_manifold, xfA, xfMoved);
+
+	if (m_manifold.pointCount == 0)
+	{
+		// Fall back to the closest points.
+		m_manifold.type = b2Manifold::e_faceA;
+		m_manifold.localNormal = b2MulT(xfA.q, normal);
+		m_manifold.localPoint = b2MulT(xfA, output.pointA);
+		m_manifold.pointCount = 1;
+		m_manifold.points[0].localPoint = b2MulT(xfB, output.pointB);
+		m_manifold.points[0].id.key = 0;
+	}
+
+	for (int32 i = 0; i < m_manifold.pointCount; ++i)
+	{
+		m_manifold.points[i].normalImpulse = 0.0f;
+		m_manifold.points[i].tangentImpulse = 0.0f;
+	}
+
+	return true;
+}
@@ -89,6 +89,12 @@ public:
 	/// Is this contact touching?
 	bool IsTouching() const;
 
+	/// Is this contact speculative? The shapes are apart, but the manifold holds
+	/// a predicted point with positive separation so the solver can stop them
+	/// from passing through each other. A speculative contact is not touching.
+	/// See b2World::SetSpeculativeContacts.
+	bool IsSpeculative() const;
+
 	/// Enable/disable this contact. This can be used inside the pre-solve
 	/// contact listener. The contact is only disabled for the current
 	/// time step (or sub-step in continuous collisions).
@@ -144,6 +150,7 @@ protected:
 	friend class b2ContactSolver;
 	friend class b2Body;
 	friend class b2Fixture;
+	friend class b2TOIQueue;
 
 	// Flags stored in m_flags
 	enum
@@ -164,15 +171,18 @@ protected:
 		e_bulletHitFlag		= 0x0010,
 
 		// This contact has a valid TOI in m_toi
-		e_toiFlag			= 0x0020
+		e_toiFlag			= 0x0020,
+
+		// This contact is on the awake contact list.
+		e_awakeListFlag		= 0x0040,
+
+		// The manifold holds a speculative point.
+		e_speculativeFlag	= 0x0080
 	};
 
 	/// Flag this contact for filtering. Filtering will occur the next time step.
 	void FlagForFiltering();
 
-	static void AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destroyFcn,
-						b2Shape::Type typeA, b2Shape::Type typeB);
-	static void InitializeRegisters();
 	static b2Contact* Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2Shape::Type typeA, b2Shape::Type typeB, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
@@ -181,10 +191,11 @@ protected:
 	b2Contact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
 	virtual ~b2Contact() {}
 
-	void Update(b2ContactListener* listener);
+	void Update(b2ContactListener* listener, float32 speculativeDt = 0.0f);
+	bool EvaluateSpeculative(float32 dt);
 
-	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
-	static bool s_initialized;
+	// Constant, so worlds on different threads share no mutable state.
+	static const b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 
 	uint32 m_flags;
 
@@ -192,6 +203,10 @@ protected:
 	b2Contact* m_prev;
 	b2Contact* m_next;
 
+	// Awake list pointers. Only valid with e_awakeListFlag.
+	b2Contact* m_awakePrev;
+	b2Contact* m_awakeNext;
+
 	// Nodes for connecting bodies.
 	b2ContactEdge m_nodeA;
 	b2ContactEdge m_nodeB;
@@ -207,6 +222,9 @@ protected:
 	int32 m_toiCount;
 	float32 m_toi;
 
+	// Sequence number of the latest b2TOIQueue entry, zero when not queued.
+	int32 m_toiSequence;
+
 	float32 m_friction;
 	float32 m_restitution;
 };
@@ -253,6 +271,11 @@ inline bool b2Contact::IsTouching() const
 	return (m_flags & e_touchingFlag) == e_touchingFlag;
 }
 
+inline bool b2Contact::IsSpeculative() const
+{
+	return (m_flags & e_speculativeFlag) == e_speculativeFlag;
+}
+
 inline b2Contact* b2Contact::GetNext()
 {
 	return m_next;
@@ -23,6 +23,9 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2ThreadPool.h>
+
+#include <cstring>
 
 #define B2_DEBUG_SOLVER 0
 
@@ -41,6 +44,99 @@ struct b2ContactPositionConstraint
 	int32 pointCount;
 };
 
+struct b2PositionSolverManifold
+{
+	void Initialize(b2ContactPositionConstraint* pc, const b2Transform& xfA, const b2Transform& xfB, int32 index)
+	{
+		b2Assert(pc->pointCount > 0);
+
+		switch (pc->type)
+		{
+		case b2Manifold::e_circles:
+			{
+				b2Vec2 pointA = b2Mul(xfA, pc->localPoint);
+				b2Vec2 pointB = b2Mul(xfB, pc->localPoints[0]);
+				normal = pointB - pointA;
+				normal.Normalize();
+				point = 0.5f * (pointA + pointB);
+				separation = b2Dot(pointB - pointA, normal) - pc->radiusA - pc->radiusB;
+			}
+			break;
+
+		case b2Manifold::e_faceA:
+			{
+				normal = b2Mul(xfA.q, pc->localNormal);
+				b2Vec2 planePoint = b2Mul(xfA, pc->localPoint);
+
+				b2Vec2 clipPoint = b2Mul(xfB, pc->localPoints[index]);
+				separation = b2Dot(clipPoint - planePoint, normal) - pc->radiusA - pc->radiusB;
+				point = clipPoint;
+			}
+			break;
+
+		case b2Manifold::e_faceB:
+			{
+				normal = b2Mul(xfB.q, pc->localNormal);
+				b2Vec2 planePoint = b2Mul(xfB, pc->localPoint);
+
+				b2Vec2 clipPoint = b2Mul(xfA, pc->localPoints[index]);
+				separation = b2Dot(clipPoint - planePoint, normal) - pc->radiusA - pc->radiusB;
+				point = clipPoint;
+
+				// Ensure normal points from A to B
+				normal = -normal;
+			}
+			break;
+
+		default:
+			b2Assert(false);
+			normal.SetZero();
+			point.SetZero();
+			separation = 0.0f;
+			break;
+		}
+	}
+
+	b2Vec2 normal;
+	b2Vec2 point;
+	float32 separation;
+};
+
+#if B2_SIMD_WIDTH > 0
+
+struct b2WideConstraintPoint
+{
+	float32 rAX[B2_SIMD_WIDTH], rAY[B2_SIMD_WIDTH];
+	float32 rBX[B2_SIMD_WIDTH], rBY[B2_SIMD_WIDTH];
+	float32 normalImpulse[B2_SIMD_WIDTH];
+	float32 tangentImpulse[B2_SIMD_WIDTH];
+	float32 normalMass[B2_SIMD_WIDTH];
+	float32 tangentMass[B2_SIMD_WIDTH];
+	float32 velocityBias[B2_SIMD_WIDTH];
+};
+
+// Velocity constraints packed one per lane. The lanes of a group come from the
+// same color, so they never share a dynamic body. Unused lanes repeat the
+// bodies of lane 0 with zero mass, which makes them no-ops. Lanes with one
+// point have a zero second point.
+struct b2WideContactConstraint
+{
+	b2WideConstraintPoint points[b2_maxManifoldPoints];
+	float32 normalX[B2_SIMD_WIDTH], normalY[B2_SIMD_WIDTH];
+	float32 k11[B2_SIMD_WIDTH], k12[B2_SIMD_WIDTH], k22[B2_SIMD_WIDTH];
+	float32 normalMass11[B2_SIMD_WIDTH], normalMass12[B2_SIMD_WIDTH];
+	float32 normalMass21[B2_SIMD_WIDTH], normalMass22[B2_SIMD_WIDTH];
+	float32 invMassA[B2_SIMD_WIDTH], invIA[B2_SIMD_WIDTH];
+	float32 invMassB[B2_SIMD_WIDTH], invIB[B2_SIMD_WIDTH];
+	float32 friction[B2_SIMD_WIDTH];
+	float32 blockSolve[B2_SIMD_WIDTH];
+	int32 indexA[B2_SIMD_WIDTH];
+	int32 indexB[B2_SIMD_WIDTH];
+	int32 constraintIndex[B2_SIMD_WIDTH];
+};
+
+#endif
+
 b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 {
 	m_step = def->step;
@@ -52,6 +148,16 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 	m_velocities = def->velocities;
 	m_contacts = def->contacts;
 
+	m_wideConstraints = NULL;
+	m_wideStats = NULL;
+
+	// Everything is overflow until the constraints are colored.
+	for (int32 i = 0; i <= b2_graphColorCount; ++i)
+	{
+		m_colorStarts[i] = 0;
+	}
+	m_colorStarts[b2_graphColorCount + 1] = m_count;
+
 	// Initialize position independent portions of the constraints.
 	for (int32 i = 0; i < m_count; ++i)
 	{
@@ -75,10 +181,10 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		vc->restitution = contact->m_restitution;
 		vc->indexA = bodyA->m_islandIndex;
 		vc->indexB = bodyB->m_islandIndex;
-		vc->invMassA = bodyA->m_invMass;
-		vc->invMassB = bodyB->m_invMass;
-		vc->invIA = bodyA->m_invI;
-		vc->invIB = bodyB->m_invI;
+		vc->invMassA = bodyA->m_sim->invMass;
+		vc->invMassB = bodyB->m_sim->invMass;
+		vc->invIA = bodyA->m_sim->invI;
+		vc->invIB = bodyB->m_sim->invI;
 		vc->contactIndex = i;
 		vc->pointCount = pointCount;
 		vc->K.SetZero();
@@ -87,12 +193,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
 		pc->indexA = bodyA->m_islandIndex;
 		pc->indexB = bodyB->m_islandIndex;
-		pc->invMassA = bodyA->m_invMass;
-		pc->invMassB = bodyB->m_invMass;
-		pc->localCenterA = bodyA->m_sweep.localCenter;
-		pc->localCenterB = bodyB->m_sweep.localCenter;
-		pc->invIA = bodyA->m_invI;
-		pc->invIB = bodyB->m_invI;
+		pc->invMassA = bodyA->m_sim->invMass;
+		pc->invMassB = bodyB->m_sim->invMass;
+		pc->localCenterA = bodyA->m_sim->sweep.localCenter;
+		pc->localCenterB = bodyB->m_sim->sweep.localCenter;
+		pc->invIA = bodyA->m_sim->invI;
+		pc->invIB = bodyB->m_sim->invI;
 		pc->localNormal = manifold->localNormal;
 		pc->localPoint = manifold->localPoint;
 		pc->pointCount = pointCount;
@@ -129,10 +235,90 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 
 b2ContactSolver::~b2ContactSolver()
 {
+	if (m_wideConstraints)
+	{
+		m_allocator->Free(m_wideConstraints);
+	}
 	m_allocator->Free(m_velocityConstraints);
 	m_allocator->Free(m_positionConstraints);
 }
 
+// Greedy coloring in island order. Only dynamic bodies create conflicts because
+// the solver never writes static or kinematic bodies.
+void b2ContactSolver::ColorConstraints()
+{
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bodyCount = b2Max(bodyCount, b2Max(vc->indexA, vc->indexB) + 1);
+	}
+
+	int32 wordCount = (bodyCount + 31) >> 5;
+	uint32* colorBodies = (uint32*)m_allocator->Allocate(b2_graphColorCount * wordCount * sizeof(uint32));
+	memset(colorBodies, 0, b2_graphColorCount * wordCount * sizeof(uint32));
+	int32* order = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+
+	int32 colorCounts[b2_graphColorCount + 1];
+	for (int32 i = 0; i <= b2_graphColorCount; ++i)
+	{
+		colorCounts[i] = 0;
+	}
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		int32 indexA = vc->indexA;
+		int32 indexB = vc->indexB;
+		uint32 maskA = vc->invMassA > 0.0f ? (1u << (indexA & 31)) : 0;
+		uint32 maskB = vc->invMassB > 0.0f ? (1u << (indexB & 31)) : 0;
+
+		int32 color = 0;
+		for (; color < b2_graphColorCount; ++color)
+		{
+			uint32* bodies = colorBodies + color * wordCount;
+			if ((bodies[indexA >> 5] & maskA) == 0 && (bodies[indexB >> 5] & maskB) == 0)
+			{
+				bodies[indexA >> 5] |= maskA;
+				bodies[indexB >> 5] |= maskB;
+				break;
+			}
+		}
+
+		// Overflow if color == b2_graphColorCount.
+		order[i] = color;
+		++colorCounts[color];
+	}
+
+	m_colorStarts[0] = 0;
+	for (int32 i = 0; i <= b2_graphColorCount; ++i)
+	{
+		m_colorStarts[i + 1] = m_colorStarts[i] + colorCounts[i];
+		colorCounts[i] = m_colorStarts[i];
+	}
+
+	// Turn the colors into destination slots, keeping island order within a color.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		order[i] = colorCounts[order[i]]++;
+	}
+
+	// Apply the permutation in place.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		while (order[i] != i)
+		{
+			int32 j = order[i];
+			b2Swap(m_velocityConstraints[i], m_velocityConstraints[j]);
+			b2Swap(m_positionConstraints[i], m_positionConstraints[j]);
+			b2Swap(order[i], order[j]);
+		}
+	}
+
+	m_allocator->Free(order);
+	m_allocator->Free(colorBodies);
+}
+
 // Initialize position dependent portions of the velocity constraints.
 void b2ContactSolver::InitializeVelocityConstraints()
 {
@@ -178,6 +364,8 @@ void b2ContactSolver::InitializeVelocityConstraints()
 
 		vc->normal = worldManifold.normal;
 
+		bool speculative = m_contacts[vc->contactIndex]->IsSpeculative();
+
 		int32 pointCount = vc->pointCount;
 		for (int32 j = 0; j < pointCount; ++j)
 		{
@@ -202,9 +390,22 @@ void b2ContactSolver::InitializeVelocityConstraints()
 
 			vcp->tangentMass = kTangent > 0.0f ? 1.0f /  kTangent : 0.0f;
 
+			float32 vRel = b2Dot(vc->normal, vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA));
+			vcp->relativeVelocity = 0.0f;
+
+			if (speculative)
+			{
+				// Let the bodies close the gap this step, but no further. The
+				// rebound is added by ApplyRestitution if they get there.
+				b2PositionSolverManifold psm;
+				psm.Initialize(pc, xfA, xfB, j);
+				vcp->velocityBias = -b2Max(psm.separation, 0.0f) * m_step.inv_dt;
+				vcp->relativeVelocity = vRel;
+				continue;
+			}
+
 			// Setup a velocity bias for restitution.
 			vcp->velocityBias = 0.0f;
-			float32 vRel = b2Dot(vc->normal, vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA));
 			if (vRel < -b2_velocityThreshold)
 			{
 				vcp->velocityBias = -vc->restitution * vRel;
@@ -245,10 +446,426 @@ void b2ContactSolver::InitializeVelocityConstraints()
 	}
 }
 
+void b2ContactSolver::PrepareWideConstraints()
+{
+#if B2_SIMD_WIDTH > 0
+	const int32 width = B2_SIMD_WIDTH;
+
+	int32 groupCount = 0;
+	for (int32 color = 0; color < b2_graphColorCount; ++color)
+	{
+		m_wideStarts[color] = groupCount;
+		int32 count = m_colorStarts[color + 1] - m_colorStarts[color];
+		groupCount += (count + width - 1) / width;
+	}
+	m_wideStarts[b2_graphColorCount] = groupCount;
+
+	m_wideConstraints = (b2WideContactConstraint*)m_allocator->Allocate(b2Max(groupCount, 1) * sizeof(b2WideContactConstraint));
+	memset(m_wideConstraints, 0, groupCount * sizeof(b2WideContactConstraint));
+
+	for (int32 color = 0; color < b2_graphColorCount; ++color)
+	{
+		int32 first = m_colorStarts[color];
+		int32 count = m_colorStarts[color + 1] - first;
+
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2WideContactConstraint* wc = m_wideConstraints + m_wideStarts[color] + i / width;
+			int32 lane = i % width;
+			int32 index = first + i;
+			const b2ContactVelocityConstraint* vc = m_velocityConstraints + index;
+
+			if (lane == 0)
+			{
+				// Point unused lanes at bodies this group owns.
+				for (int32 j = 0; j < width; ++j)
+				{
+					wc->indexA[j] = vc->indexA;
+					wc->indexB[j] = vc->indexB;
+					wc->constraintIndex[j] = -1;
+				}
+			}
+
+			wc->constraintIndex[lane] = index;
+			wc->indexA[lane] = vc->indexA;
+			wc->indexB[lane] = vc->indexB;
+			wc->invMassA[lane] = vc->invMassA;
+			wc->invIA[lane] = vc->invIA;
+			wc->invMassB[lane] = vc->invMassB;
+			wc->invIB[lane] = vc->invIB;
+			wc->normalX[lane] = vc->normal.x;
+			wc->normalY[lane] = vc->normal.y;
+			wc->friction[lane] = vc->friction;
+			wc->blockSolve[lane] = vc->pointCount == 2 ? 1.0f : 0.0f;
+			wc->k11[lane] = vc->K.ex.x;
+			wc->k12[lane] = vc->K.ex.y;
+			wc->k22[lane] = vc->K.ey.y;
+			wc->normalMass11[lane] = vc->normalMass.ex.x;
+			wc->normalMass21[lane] = vc->normalMass.ex.y;
+			wc->normalMass12[lane] = vc->normalMass.ey.x;
+			wc->normalMass22[lane] = vc->normalMass.ey.y;
+
+			for (int32 j = 0; j < vc->pointCount; ++j)
+			{
+				const b2VelocityConstraintPoint* vcp = vc->points + j;
+				b2WideConstraintPoint* wcp = wc->points + j;
+				wcp->rAX[lane] = vcp->rA.x;
+				wcp->rAY[lane] = vcp->rA.y;
+				wcp->rBX[lane] = vcp->rB.x;
+				wcp->rBY[lane] = vcp->rB.y;
+				wcp->normalImpulse[lane] = vcp->normalImpulse;
+				wcp->tangentImpulse[lane] = vcp->tangentImpulse;
+				wcp->normalMass[lane] = vcp->normalMass;
+				wcp->tangentMass[lane] = vcp->tangentMass;
+				wcp->velocityBias[lane] = vcp->velocityBias;
+			}
+		}
+	}
+#endif
+}
+
+void b2ContactSolver::SolveColorVelocityConstraints(int32 color, int32 part, int32 partCount)
+{
+	if (m_wideConstraints)
+	{
+		int32 first = m_wideStarts[color];
+		int32 count = m_wideStarts[color + 1] - first;
+		SolveWideVelocityConstraints(first + (count * part) / partCount, first + (count * (part + 1)) / partCount);
+	}
+	else
+	{
+		int32 first = m_colorStarts[color];
+		int32 count = m_colorStarts[color + 1] - first;
+		SolveVelocityConstraints(first + (count * part) / partCount, first + (count * (part + 1)) / partCount);
+	}
+}
+
+#if B2_SIMD_WIDTH > 0
+
+// Solve the lanes of a group with the scalar solver and compare them with the
+// velocities and impulses of the wide solver. See b2World::SetWideSolverCheck.
+struct b2WideLaneCheck
+{
+	void Begin(b2ContactSolver* solver, const b2WideContactConstraint* wc)
+	{
+		for (int32 lane = 0; lane < B2_SIMD_WIDTH; ++lane)
+		{
+			int32 index = wc->constraintIndex[lane];
+			if (index < 0)
+			{
+				continue;
+			}
+
+			b2ContactVelocityConstraint* vc = solver->m_velocityConstraints + index;
+			for (int32 j = 0; j < vc->pointCount; ++j)
+			{
+				vc->points[j].normalImpulse = wc->points[j].normalImpulse[lane];
+				vc->points[j].tangentImpulse = wc->points[j].tangentImpulse[lane];
+			}
+
+			b2Velocity vA = solver->m_velocities[vc->indexA];
+			b2Velocity vB = solver->m_velocities[vc->indexB];
+			solver->SolveVelocityConstraints(index, index + 1);
+			expectedA[lane] = solver->m_velocities[vc->indexA];
+			expectedB[lane] = solver->m_velocities[vc->indexB];
+
+			// Bodies without mass may be shared with lanes on other threads.
+			// The solve left them unchanged.
+			if (vc->invMassA > 0.0f)
+			{
+				solver->m_velocities[vc->indexA] = vA;
+			}
+
+			if (vc->invMassB > 0.0f)
+			{
+				solver->m_velocities[vc->indexB] = vB;
+			}
+		}
+	}
+
+	// Values near zero are compared absolutely.
+	static bool Check(float32 expected, float32 actual)
+	{
+		const float32 k_tolerance = 1e-5f;
+		return b2Abs(expected - actual) <= k_tolerance * b2Max(1.0f, b2Abs(expected));
+	}
+
+	void End(const b2ContactSolver* solver, const b2WideContactConstraint* wc, b2WideSolverStats* stats)
+	{
+		int32 laneCount = 0;
+		int32 mismatchCount = 0;
+		for (int32 lane = 0; lane < B2_SIMD_WIDTH; ++lane)
+		{
+			int32 index = wc->constraintIndex[lane];
+			if (index < 0)
+			{
+				continue;
+			}
+
+			bool ok = true;
+			const b2ContactVelocityConstraint* vc = solver->m_velocityConstraints + index;
+			for (int32 j = 0; j < vc->pointCount; ++j)
+			{
+				ok = ok && Check(vc->points[j].normalImpulse, wc->points[j].normalImpulse[lane]);
+				ok = ok && Check(vc->points[j].tangentImpulse, wc->points[j].tangentImpulse[lane]);
+			}
+
+			const b2Velocity* velocityA = solver->m_velocities + vc->indexA;
+			const b2Velocity* velocityB = solver->m_velocities + vc->indexB;
+			ok = ok && Check(expectedA[lane].v.x, velocityA->v.x);
+			ok = ok && Check(expectedA[lane].v.y, velocityA->v.y);
+			ok = ok && Check(expectedA[lane].w, velocityA->w);
+			ok = ok && Check(expectedB[lane].v.x, velocityB->v.x);
+			ok = ok && Check(expectedB[lane].v.y, velocityB->v.y);
+			ok = ok && Check(expectedB[lane].w, velocityB->w);
+
+			++laneCount;
+			mismatchCount += ok ? 0 : 1;
+		}
+
+		b2AtomicAdd(&stats->laneCount, laneCount);
+		b2AtomicAdd(&stats->mismatchCount, mismatchCount);
+	}
+
+	b2Velocity expectedA[B2_SIMD_WIDTH];
+	b2Velocity expectedB[B2_SIMD_WIDTH];
+};
+
+#endif
+
+// The same math as SolveVelocityConstraints, one constraint per lane. The block
+// solver evaluates all four cases and keeps the first valid one per lane.
+void b2ContactSolver::SolveWideVelocityConstraints(int32 begin, int32 end)
+{
+#if B2_SIMD_WIDTH > 0
+	const int32 width = B2_SIMD_WIDTH;
+	const b2FloatW zero = b2ZeroW();
+
+	for (int32 g = begin; g < end; ++g)
+	{
+		b2WideContactConstraint* wc = m_wideConstraints + g;
+
+		b2WideLaneCheck check;
+		if (m_wideStats)
+		{
+			check.Begin(this, wc);
+		}
+
+		// Gather the body velocities.
+		float32 buffer[6][B2_SIMD_WIDTH];
+		for (int32 lane = 0; lane < width; ++lane)
+		{
+			const b2Velocity* velocityA = m_velocities + wc->indexA[lane];
+			const b2Velocity* velocityB = m_velocities + wc->indexB[lane];
+			buffer[0][lane] = velocityA->v.x;
+			buffer[1][lane] = velocityA->v.y;
+			buffer[2][lane] = velocityA->w;
+			buffer[3][lane] = velocityB->v.x;
+			buffer[4][lane] = velocityB->v.y;
+			buffer[5][lane] = velocityB->w;
+		}
+
+		b2FloatW vAX = b2LoadW(buffer[0]);
+		b2FloatW vAY = b2LoadW(buffer[1]);
+		b2FloatW wA = b2LoadW(buffer[2]);
+		b2FloatW vBX = b2LoadW(buffer[3]);
+		b2FloatW vBY = b2LoadW(buffer[4]);
+		b2FloatW wB = b2LoadW(buffer[5]);
+
+		b2FloatW mA = b2LoadW(wc->invMassA);
+		b2FloatW iA = b2LoadW(wc->invIA);
+		b2FloatW mB = b2LoadW(wc->invMassB);
+		b2FloatW iB = b2LoadW(wc->invIB);
+
+		b2FloatW normalX = b2LoadW(wc->normalX);
+		b2FloatW normalY = b2LoadW(wc->normalY);
+		b2FloatW tangentX = normalY;
+		b2FloatW tangentY = b2SubW(zero, normalX);
+		b2FloatW friction = b2LoadW(wc->friction);
+
+		// Solve tangent constraints first because non-penetration is more important
+		// than friction. The second point of a one point lane has no effect.
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2WideConstraintPoint* wcp = wc->points + j;
+			b2FloatW rAX = b2LoadW(wcp->rAX);
+			b2FloatW rAY = b2LoadW(wcp->rAY);
+			b2FloatW rBX = b2LoadW(wcp->rBX);
+			b2FloatW rBY = b2LoadW(wcp->rBY);
+
+			// Relative velocity at contact
+			b2FloatW dvX = b2SubW(b2SubW(b2AddW(vBX, b2SubW(zero, b2MulW(wB, rBY))), vAX), b2SubW(zero, b2MulW(wA, rAY)));
+			b2FloatW dvY = b2SubW(b2SubW(b2AddW(vBY, b2MulW(wB, rBX)), vAY), b2MulW(wA, rAX));
+
+			// Compute tangent force
+			b2FloatW vt = b2AddW(b2MulW(dvX, tangentX), b2MulW(dvY, tangentY));
+			b2FloatW lambda = b2MulW(b2LoadW(wcp->tangentMass), b2SubW(zero, vt));
+
+			// Clamp the accumulated force
+			b2FloatW maxFriction = b2MulW(friction, b2LoadW(wcp->normalImpulse));
+			b2FloatW oldImpulse = b2LoadW(wcp->tangentImpulse);
+			b2FloatW newImpulse = b2MaxW(b2MinW(b2AddW(oldImpulse, lambda), maxFriction), b2SubW(zero, maxFriction));
+			lambda = b2SubW(newImpulse, oldImpulse);
+			b2StoreW(wcp->tangentImpulse, newImpulse);
+
+			// Apply contact impulse
+			b2FloatW PX = b2MulW(lambda, tangentX);
+			b2FloatW PY = b2MulW(lambda, tangentY);
+
+			vAX = b2SubW(vAX, b2MulW(mA, PX));
+			vAY = b2SubW(vAY, b2MulW(mA, PY));
+			wA = b2SubW(wA, b2MulW(iA, b2SubW(b2MulW(rAX, PY), b2MulW(rAY, PX))));
+
+			vBX = b2AddW(vBX, b2MulW(mB, PX));
+			vBY = b2AddW(vBY, b2MulW(mB, PY));
+			wB = b2AddW(wB, b2MulW(iB, b2SubW(b2MulW(rBX, PY), b2MulW(rBY, PX))));
+		}
+
+		// Solve normal constraints
+		{
+			b2WideConstraintPoint* cp1 = wc->points + 0;
+			b2WideConstraintPoint* cp2 = wc->points + 1;
+
+			b2FloatW rA1X = b2LoadW(cp1->rAX);
+			b2FloatW rA1Y = b2LoadW(cp1->rAY);
+			b2FloatW rB1X = b2LoadW(cp1->rBX);
+			b2FloatW rB1Y = b2LoadW(cp1->rBY);
+			b2FloatW rA2X = b2LoadW(cp2->rAX);
+			b2FloatW rA2Y = b2LoadW(cp2->rAY);
+			b2FloatW rB2X = b2LoadW(cp2->rBX);
+			b2FloatW rB2Y = b2LoadW(cp2->rBY);
+
+			b2FloatW a1 = b2LoadW(cp1->normalImpulse);
+			b2FloatW a2 = b2LoadW(cp2->normalImpulse);
+
+			// Relative velocity at contact
+			b2FloatW dv1X = b2SubW(b2SubW(b2AddW(vBX, b2SubW(zero, b2MulW(wB, rB1Y))), vAX), b2SubW(zero, b2MulW(wA, rA1Y)));
+			b2FloatW dv1Y = b2SubW(b2SubW(b2AddW(vBY, b2MulW(wB, rB1X)), vAY), b2MulW(wA, rA1X));
+			b2FloatW dv2X = b2SubW(b2SubW(b2AddW(vBX, b2SubW(zero, b2MulW(wB, rB2Y))), vAX), b2SubW(zero, b2MulW(wA, rA2Y)));
+			b2FloatW dv2Y = b2SubW(b2SubW(b2AddW(vBY, b2MulW(wB, rB2X)), vAY), b2MulW(wA, rA2X));
+
+			// Compute normal velocity
+			b2FloatW vn1 = b2AddW(b2MulW(dv1X, normalX), b2MulW(dv1Y, normalY));
+			b2FloatW vn2 = b2AddW(b2MulW(dv2X, normalX), b2MulW(dv2Y, normalY));
+
+			b2FloatW bias1 = b2LoadW(cp1->velocityBias);
+			b2FloatW bias2 = b2LoadW(cp2->velocityBias);
+
+			// One point: clamp the accumulated impulse.
+			b2FloatW lambda = b2MulW(b2SubW(zero, b2LoadW(cp1->normalMass)), b2SubW(vn1, bias1));
+			b2FloatW singleX = b2MaxW(b2AddW(a1, lambda), zero);
+
+			// Two points: compute b' = b - K * a.
+			b2FloatW k11 = b2LoadW(wc->k11);
+			b2FloatW k12 = b2LoadW(wc->k12);
+			b2FloatW k22 = b2LoadW(wc->k22);
+			b2FloatW bX = b2SubW(b2SubW(vn1, bias1), b2AddW(b2MulW(k11, a1), b2MulW(k12, a2)));
+			b2FloatW bY = b2SubW(b2SubW(vn2, bias2), b2AddW(b2MulW(k12, a1), b2MulW(k22, a2)));
+
+			// Walk the cases from last to first so the first valid case wins.
+			// No valid case leaves the impulse unchanged.
+			b2FloatW xX = a1;
+			b2FloatW xY = a2;
+
+			// Case 4: x1 = 0 and x2 = 0
+			b2FloatW valid = b2AndW(b2GreaterEqualW(bX, zero), b2GreaterEqualW(bY, zero));
+			xX = b2SelectW(valid, xX, zero);
+			xY = b2SelectW(valid, xY, zero);
+
+			// Case 3: vn2 = 0 and x1 = 0
+			b2FloatW x = b2SubW(zero, b2MulW(b2LoadW(cp2->normalMass), bY));
+			b2FloatW vn = b2AddW(b2MulW(k12, x), bX);
+			valid = b2AndW(b2GreaterEqualW(x, zero), b2GreaterEqualW(vn, zero));
+			xX = b2SelectW(valid, xX, zero);
+			xY = b2SelectW(valid, xY, x);
+
+			// Case 2: vn1 = 0 and x2 = 0
+			x = b2SubW(zero, b2MulW(b2LoadW(cp1->normalMass), bX));
+			vn = b2AddW(b2MulW(k12, x), bY);
+			valid = b2AndW(b2GreaterEqualW(x, zero), b2GreaterEqualW(vn, zero));
+			xX = b2SelectW(valid, xX, x);
+			xY = b2SelectW(valid, xY, zero);
+
+			// Case 1: vn = 0
+			b2FloatW x1 = b2SubW(zero, b2AddW(b2MulW(b2LoadW(wc->normalMass11), bX), b2MulW(b2LoadW(wc->normalMass12), bY)));
+			b2FloatW x2 = b2SubW(zero, b2AddW(b2MulW(b2LoadW(wc->normalMass21), bX), b2MulW(b2LoadW(wc->normalMass22), bY)));
+			valid = b2AndW(b2GreaterEqualW(x1, zero), b2GreaterEqualW(x2, zero));
+			xX = b2SelectW(valid, xX, x1);
+			xY = b2SelectW(valid, xY, x2);
+
+			// Pick the one or two point result.
+			b2FloatW blockSolve = b2GreaterEqualW(b2LoadW(wc->blockSolve), b2SplatW(0.5f));
+			xX = b2SelectW(blockSolve, singleX, xX);
+			xY = b2SelectW(blockSolve, a2, xY);
+
+			// Get the incremental impulse
+			b2FloatW dX = b2SubW(xX, a1);
+			b2FloatW dY = b2SubW(xY, a2);
+
+			// Apply incremental impulse
+			b2FloatW P1X = b2MulW(dX, normalX);
+			b2FloatW P1Y = b2MulW(dX, normalY);
+			b2FloatW P2X = b2MulW(dY, normalX);
+			b2FloatW P2Y = b2MulW(dY, normalY);
+
+			vAX = b2SubW(vAX, b2MulW(mA, b2AddW(P1X, P2X)));
+			vAY = b2SubW(vAY, b2MulW(mA, b2AddW(P1Y, P2Y)));
+			wA = b2SubW(wA, b2MulW(iA, b2AddW(b2SubW(b2MulW(rA1X, P1Y), b2MulW(rA1Y, P1X)), b2SubW(b2MulW(rA2X, P2Y), b2MulW(rA2Y, P2X)))));
+
+			vBX = b2AddW(vBX, b2MulW(mB, b2AddW(P1X, P2X)));
+			vBY = b2AddW(vBY, b2MulW(mB, b2AddW(P1Y, P2Y)));
+			wB = b2AddW(wB, b2MulW(iB, b2AddW(b2SubW(b2MulW(rB1X, P1Y), b2MulW(rB1Y, P1X)), b2SubW(b2MulW(rB2X, P2Y), b2MulW(rB2Y, P2X)))));
+
+			// Accumulate
+			b2StoreW(cp1->normalImpulse, xX);
+			b2StoreW(cp2->normalImpulse, xY);
+		}
+
+		// Scatter the velocities. Static and kinematic bodies are not written.
+		b2StoreW(buffer[0], vAX);
+		b2StoreW(buffer[1], vAY);
+		b2StoreW(buffer[2], wA);
+		b2StoreW(buffer[3], vBX);
+		b2StoreW(buffer[4], vBY);
+		b2StoreW(buffer[5], wB);
+
+		for (int32 lane = 0; lane < width; ++lane)
+		{
+			if (wc->invMassA[lane] > 0.0f)
+			{
+				b2Velocity* velocityA = m_velocities + wc->indexA[lane];
+				velocityA->v.Set(buffer[0][lane], buffer[1][lane]);
+				velocityA->w = buffer[2][lane];
+			}
+
+			if (wc->invMassB[lane] > 0.0f)
+			{
+				b2Velocity* velocityB = m_velocities + wc->indexB[lane];
+				velocityB->v.Set(buffer[3][lane], buffer[4][lane]);
+				velocityB->w = buffer[5][lane];
+			}
+		}
+
+		if (m_wideStats)
+		{
+			check.End(this, wc, m_wideStats);
+		}
+	}
+#else
+	B2_NOT_USED(begin);
+	B2_NOT_USED(end);
+#endif
+}
+
 void b2ContactSolver::WarmStart()
+{
+	WarmStart(0, m_count);
+}
+
+void b2ContactSolver::WarmStart(int32 begin, int32 end)
 {
 	// Warm start.
-	for (int32 i = 0; i < m_count; ++i)
+	for (int32 i = begin; i < end; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
 
@@ -278,16 +895,29 @@ void b2ContactSolver::WarmStart()
 			vB += mB * P;
 		}
 
-		m_velocities[indexA].v = vA;
-		m_velocities[indexA].w = wA;
-		m_velocities[indexB].v = vB;
-		m_velocities[indexB].w = wB;
+		// Static and kinematic bodies are not written since they may be
+		// shared with constraints solved on other threads.
+		if (mA > 0.0f)
+		{
+			m_velocities[indexA].v = vA;
+			m_velocities[indexA].w = wA;
+		}
+		if (mB > 0.0f)
+		{
+			m_velocities[indexB].v = vB;
+			m_velocities[indexB].w = wB;
+		}
 	}
 }
 
 void b2ContactSolver::SolveVelocityConstraints()
 {
-	for (int32 i = 0; i < m_count; ++i)
+	SolveVelocityConstraints(0, m_count);
+}
+
+void b2ContactSolver::SolveVelocityConstraints(int32 begin, int32 end)
+{
+	for (int32 i = begin; i < end; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
 
@@ -588,15 +1218,50 @@ void b2ContactSolver::SolveVelocityConstraints()
 			}
 		}
 
-		m_velocities[indexA].v = vA;
-		m_velocities[indexA].w = wA;
-		m_velocities[indexB].v = vB;
-		m_velocities[indexB].w = wB;
+		// Static and kinematic bodies are not written since they may be
+		// shared with constraints solved on other threads.
+		if (mA > 0.0f)
+		{
+			m_velocities[indexA].v = vA;
+			m_velocities[indexA].w = wA;
+		}
+		if (mB > 0.0f)
+		{
+			m_velocities[indexB].v = vB;
+			m_velocities[indexB].w = wB;
+		}
 	}
 }
 
 void b2ContactSolver::StoreImpulses()
 {
+#if B2_SIMD_WIDTH > 0
+	// Copy the impulses of the wide solver back.
+	if (m_wideConstraints)
+	{
+		int32 groupCount = m_wideStarts[b2_graphColorCount];
+		for (int32 g = 0; g < groupCount; ++g)
+		{
+			const b2WideContactConstraint* wc = m_wideConstraints + g;
+			for (int32 lane = 0; lane < B2_SIMD_WIDTH; ++lane)
+			{
+				int32 index = wc->constraintIndex[lane];
+				if (index < 0)
+				{
+					continue;
+				}
+
+				b2ContactVelocityConstraint* vc = m_velocityConstraints + index;
+				for (int32 j = 0; j < vc->pointCount; ++j)
+				{
+					vc->points[j].normalImpulse = wc->points[j].normalImpulse[lane];
+					vc->points[j].tangentImpulse = wc->points[j].tangentImpulse[lane];
+				}
+			}
+		}
+	}
+#endif
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
@@ -610,63 +1275,79 @@ void b2ContactSolver::StoreImpulses()
 	}
 }
 
-struct b2PositionSolverManifold
+// Sequential solver.
+void b2ContactSolver::ApplyRestitution()
 {
-	void Initialize(b2ContactPositionConstraint* pc, const b2Transform& xfA, const b2Transform& xfB, int32 index)
+	for (int32 i = 0; i < m_count; ++i)
 	{
-		b2Assert(pc->pointCount > 0);
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		if (vc->restitution == 0.0f)
+		{
+			continue;
+		}
 
-		switch (pc->type)
+		int32 indexA = vc->indexA;
+		int32 indexB = vc->indexB;
+		float32 mA = vc->invMassA;
+		float32 iA = vc->invIA;
+		float32 mB = vc->invMassB;
+		float32 iB = vc->invIB;
+		b2Vec2 normal = vc->normal;
+
+		b2Vec2 vA = m_velocities[indexA].v;
+		float32 wA = m_velocities[indexA].w;
+		b2Vec2 vB = m_velocities[indexB].v;
+		float32 wB = m_velocities[indexB].w;
+
+		for (int32 j = 0; j < vc->pointCount; ++j)
 		{
-		case b2Manifold::e_circles:
+			b2VelocityConstraintPoint* vcp = vc->points + j;
+
+			// Only points that were approaching and stopped the bodies bounce.
+			if (vcp->relativeVelocity > -b2_velocityThreshold || vcp->normalImpulse == 0.0f)
 			{
-				b2Vec2 pointA = b2Mul(xfA, pc->localPoint);
-				b2Vec2 pointB = b2Mul(xfB, pc->localPoints[0]);
-				normal = pointB - pointA;
-				normal.Normalize();
-				point = 0.5f * (pointA + pointB);
-				separation = b2Dot(pointB - pointA, normal) - pc->radiusA - pc->radiusB;
+				continue;
 			}
-			break;
 
-		case b2Manifold::e_faceA:
-			{
-				normal = b2Mul(xfA.q, pc->localNormal);
-				b2Vec2 planePoint = b2Mul(xfA, pc->localPoint);
+			b2Vec2 dv = vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA);
+			float32 vn = b2Dot(dv, normal);
 
-				b2Vec2 clipPoint = b2Mul(xfB, pc->localPoints[index]);
-				separation = b2Dot(clipPoint - planePoint, normal) - pc->radiusA - pc->radiusB;
-				point = clipPoint;
-			}
-			break;
+			float32 lambda = -vcp->normalMass * (vn + vc->restitution * vcp->relativeVelocity);
 
-		case b2Manifold::e_faceB:
-			{
-				normal = b2Mul(xfB.q, pc->localNormal);
-				b2Vec2 planePoint = b2Mul(xfB, pc->localPoint);
+			// Clamp the accumulated impulse
+			float32 newImpulse = b2Max(vcp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - vcp->normalImpulse;
+			vcp->normalImpulse = newImpulse;
 
-				b2Vec2 clipPoint = b2Mul(xfA, pc->localPoints[index]);
-				separation = b2Dot(clipPoint - planePoint, normal) - pc->radiusA - pc->radiusB;
-				point = clipPoint;
+			b2Vec2 P = lambda * normal;
+			vA -= mA * P;
+			wA -= iA * b2Cross(vcp->rA, P);
 
-				// Ensure normal points from A to B
-				normal = -normal;
-			}
-			break;
+			vB += mB * P;
+			wB += iB * b2Cross(vcp->rB, P);
 		}
-	}
 
-	b2Vec2 normal;
-	b2Vec2 point;
-	float32 separation;
-};
+		m_velocities[indexA].v = vA;
+		m_velocities[indexA].w = wA;
+		m_velocities[indexB].v = vB;
+		m_velocities[indexB].w = wB;
+	}
+}
 
-// Sequential solver.
 bool b2ContactSolver::SolvePositionConstraints()
+{
+	float32 minSeparation = SolvePositionConstraints(0, m_count);
+
+	// We can't expect minSpeparation >= -b2_linearSlop because we don't
+	// push the separation above -b2_linearSlop.
+	return minSeparation >= -3.0f * b2_linearSlop;
+}
+
+float32 b2ContactSolver::SolvePositionConstraints(int32 begin, int32 end)
 {
 	float32 minSeparation = 0.0f;
 
-	for (int32 i = 0; i < m_count; ++i)
+	for (int32 i = begin; i < end; ++i)
 	{
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
 
@@ -728,16 +1409,19 @@ bool b2ContactSolver::SolvePositionConstraints()
 			aB += iB * b2Cross(rB, P);
 		}
 
-		m_positions[indexA].c = cA;
-		m_positions[indexA].a = aA;
-
-		m_positions[indexB].c = cB;
-		m_positions[indexB].a = aB;
+		if (mA > 0.0f)
+		{
+			m_positions[indexA].c = cA;
+			m_positions[indexA].a = aA;
+		}
+		if (mB > 0.0f)
+		{
+			m_positions[indexB].c = cB;
+			m_positions[indexB].a = aB;
+		}
 	}
 
-	// We can't expect minSpeparation >= -b2_linearSlop because we don't
-	// push the separation above -b2_linearSlop.
-	return minSeparation >= -3.0f * b2_linearSlop;
+	return minSeparation;
 }
 
 // Sequential position solver for position constraints.
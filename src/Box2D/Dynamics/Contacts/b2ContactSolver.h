@@ -20,6 +20,7 @@
 #define B2_CONTACT_SOLVER_H
 
 #include <Box2D/Common/b2Math.h>
+#include <Box2D/Common/b2Simd.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -27,6 +28,7 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2WideContactConstraint;
 
 struct b2VelocityConstraintPoint
 {
@@ -37,6 +39,7 @@ struct b2VelocityConstraintPoint
 	float32 normalMass;
 	float32 tangentMass;
 	float32 velocityBias;
+	float32 relativeVelocity;	// normal velocity before the solve, for speculative restitution
 };
 
 struct b2ContactVelocityConstraint
@@ -71,13 +74,41 @@ public:
 	b2ContactSolver(b2ContactSolverDef* def);
 	~b2ContactSolver();
 
+	/// Reorder the constraints by graph color so that no two constraints in
+	/// a color share a dynamic body. Color i is the range
+	/// [m_colorStarts[i], m_colorStarts[i + 1]). Constraints that do not fit
+	/// in any color go to the overflow range that starts at
+	/// m_colorStarts[b2_graphColorCount]. Call this before initializing the
+	/// velocity constraints.
+	void ColorConstraints();
+
 	void InitializeVelocityConstraints();
 
+	/// Pack each color into groups of B2_SIMD_WIDTH constraints for the wide
+	/// velocity solver. Call this after coloring and warm starting. This does
+	/// nothing if B2_SIMD_WIDTH is 0.
+	void PrepareWideConstraints();
+
 	void WarmStart();
+	void WarmStart(int32 begin, int32 end);
 	void SolveVelocityConstraints();
+	void SolveVelocityConstraints(int32 begin, int32 end);
+
+	/// Solve one of partCount even parts of a color, using the wide solver
+	/// if it was prepared.
+	void SolveColorVelocityConstraints(int32 color, int32 part, int32 partCount);
+
 	void StoreImpulses();
 
+	/// Speculative points only stop the bodies at the surface. Give the points
+	/// that became active their restitution, like the velocity bias does for
+	/// touching points. Call this after storing the impulses.
+	void ApplyRestitution();
+
 	bool SolvePositionConstraints();
+	/// Solve a range of position constraints.
+	/// @return the minimum separation found.
+	float32 SolvePositionConstraints(int32 begin, int32 end);
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
 	b2TimeStep m_step;
@@ -88,6 +119,17 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+	int32 m_colorStarts[b2_graphColorCount + 2];
+	b2WideContactConstraint* m_wideConstraints;
+	int32 m_wideStarts[b2_graphColorCount + 1];
+
+	// If set, every wide group is also solved lane by lane with the scalar
+	// solver and the lanes are counted here.
+	b2WideSolverStats* m_wideStats;
+
+private:
+
+	void SolveWideVelocityConstraints(int32 begin, int32 end);
 };
 
 #endif
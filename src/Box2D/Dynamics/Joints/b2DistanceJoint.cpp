@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Stream.h>
 
 // 1-D constrained system
 // m (v2 - v1) = lambda
@@ -63,12 +64,12 @@ void b2DistanceJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	m_indexA = m_bodyA->m_islandIndex;
 	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+	m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+	m_invMassA = m_bodyA->m_sim->invMass;
+	m_invMassB = m_bodyB->m_sim->invMass;
+	m_invIA = m_bodyA->m_sim->invI;
+	m_invIB = m_bodyB->m_sim->invI;
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -258,3 +259,23 @@ void b2DistanceJoint::Dump()
 	b2Log("  jd.dampingRatio = %.15lef;\n", m_dampingRatio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2DistanceJoint::SaveState(b2StreamWriter* writer) const
+{
+	writer->Write(m_frequencyHz);
+	writer->Write(m_dampingRatio);
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_impulse);
+	writer->Write(m_length);
+}
+
+void b2DistanceJoint::LoadState(b2StreamReader* reader)
+{
+	reader->Read(&m_frequencyHz);
+	reader->Read(&m_dampingRatio);
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_impulse);
+	reader->Read(&m_length);
+}
@@ -110,6 +110,9 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void SaveState(b2StreamWriter* writer) const;
+	void LoadState(b2StreamReader* reader);
+
 	float32 m_frequencyHz;
 	float32 m_dampingRatio;
 	float32 m_bias;
@@ -92,6 +92,9 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void SaveState(b2StreamWriter* writer) const;
+	void LoadState(b2StreamReader* reader);
+
 	b2Vec2 m_localAnchorA;
 	b2Vec2 m_localAnchorB;
 
@@ -21,6 +21,7 @@
 #include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Stream.h>
 
 // Gear Joint:
 // C0 = (coordinate1 + ratio * coordinate2)_initial
@@ -61,10 +62,10 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 	m_bodyA = m_joint1->GetBodyB();
 
 	// Get geometry of joint1
-	b2Transform xfA = m_bodyA->m_xf;
-	float32 aA = m_bodyA->m_sweep.a;
-	b2Transform xfC = m_bodyC->m_xf;
-	float32 aC = m_bodyC->m_sweep.a;
+	b2Transform xfA = m_bodyA->m_sim->xf;
+	float32 aA = m_bodyA->m_sim->sweep.a;
+	b2Transform xfC = m_bodyC->m_sim->xf;
+	float32 aC = m_bodyC->m_sim->sweep.a;
 
 	if (m_typeA == e_revoluteJoint)
 	{
@@ -93,10 +94,10 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 	m_bodyB = m_joint2->GetBodyB();
 
 	// Get geometry of joint2
-	b2Transform xfB = m_bodyB->m_xf;
-	float32 aB = m_bodyB->m_sweep.a;
-	b2Transform xfD = m_bodyD->m_xf;
-	float32 aD = m_bodyD->m_sweep.a;
+	b2Transform xfB = m_bodyB->m_sim->xf;
+	float32 aB = m_bodyB->m_sim->sweep.a;
+	b2Transform xfD = m_bodyD->m_sim->xf;
+	float32 aD = m_bodyD->m_sim->sweep.a;
 
 	if (m_typeB == e_revoluteJoint)
 	{
@@ -134,18 +135,18 @@ void b2GearJoint::InitVelocityConstraints(const b2SolverData& data)
 	m_indexB = m_bodyB->m_islandIndex;
 	m_indexC = m_bodyC->m_islandIndex;
 	m_indexD = m_bodyD->m_islandIndex;
-	m_lcA = m_bodyA->m_sweep.localCenter;
-	m_lcB = m_bodyB->m_sweep.localCenter;
-	m_lcC = m_bodyC->m_sweep.localCenter;
-	m_lcD = m_bodyD->m_sweep.localCenter;
-	m_mA = m_bodyA->m_invMass;
-	m_mB = m_bodyB->m_invMass;
-	m_mC = m_bodyC->m_invMass;
-	m_mD = m_bodyD->m_invMass;
-	m_iA = m_bodyA->m_invI;
-	m_iB = m_bodyB->m_invI;
-	m_iC = m_bodyC->m_invI;
-	m_iD = m_bodyD->m_invI;
+	m_lcA = m_bodyA->m_sim->sweep.localCenter;
+	m_lcB = m_bodyB->m_sim->sweep.localCenter;
+	m_lcC = m_bodyC->m_sim->sweep.localCenter;
+	m_lcD = m_bodyD->m_sim->sweep.localCenter;
+	m_mA = m_bodyA->m_sim->invMass;
+	m_mB = m_bodyB->m_sim->invMass;
+	m_mC = m_bodyC->m_sim->invMass;
+	m_mD = m_bodyD->m_sim->invMass;
+	m_iA = m_bodyA->m_sim->invI;
+	m_iB = m_bodyB->m_sim->invI;
+	m_iC = m_bodyC->m_sim->invI;
+	m_iD = m_bodyD->m_sim->invI;
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -421,3 +422,33 @@ void b2GearJoint::Dump()
 	b2Log("  jd.ratio = %.15lef;\n", m_ratio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2GearJoint::SaveState(b2StreamWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_localAnchorC);
+	writer->Write(m_localAnchorD);
+	writer->Write(m_localAxisC);
+	writer->Write(m_localAxisD);
+	writer->Write(m_referenceAngleA);
+	writer->Write(m_referenceAngleB);
+	writer->Write(m_constant);
+	writer->Write(m_ratio);
+	writer->Write(m_impulse);
+}
+
+void b2GearJoint::LoadState(b2StreamReader* reader)
+{
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_localAnchorC);
+	reader->Read(&m_localAnchorD);
+	reader->Read(&m_localAxisC);
+	reader->Read(&m_localAxisD);
+	reader->Read(&m_referenceAngleA);
+	reader->Read(&m_referenceAngleB);
+	reader->Read(&m_constant);
+	reader->Read(&m_ratio);
+	reader->Read(&m_impulse);
+}
@@ -78,12 +78,16 @@ public:
 protected:
 
 	friend class b2Joint;
+	friend class b2World;
 	b2GearJoint(const b2GearJointDef* data);
 
 	void InitVelocityConstraints(const b2SolverData& data);
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void SaveState(b2StreamWriter* writer) const;
+	void LoadState(b2StreamReader* reader);
+
 	b2Joint* m_joint1;
 	b2Joint* m_joint2;
 
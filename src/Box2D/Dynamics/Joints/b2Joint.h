@@ -25,6 +25,8 @@ class b2Body;
 class b2Joint;
 struct b2SolverData;
 class b2BlockAllocator;
+class b2StreamWriter;
+class b2StreamReader;
 
 enum b2JointType
 {
@@ -163,6 +165,14 @@ protected:
 	// This returns true if the position errors are within tolerance.
 	virtual bool SolvePositionConstraints(const b2SolverData& data) = 0;
 
+	// Write the settings and the accumulated impulses for a snapshot, field
+	// by field. The solver temporaries are rebuilt by InitVelocityConstraints.
+	virtual void SaveState(b2StreamWriter* writer) const = 0;
+
+	// Read the state written by SaveState. A failed read leaves the reader
+	// in an error state.
+	virtual void LoadState(b2StreamReader* reader) = 0;
+
 	b2JointType m_type;
 	b2Joint* m_prev;
 	b2Joint* m_next;
@@ -19,6 +19,8 @@
 #include <Box2D/Dynamics/Joints/b2MouseJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Stream.h>
+#include <Box2D/Dynamics/b2World.h>
 
 // p = attached point, m = mouse point
 // C = p - m
@@ -51,6 +53,12 @@ b2MouseJoint::b2MouseJoint(const b2MouseJointDef* def)
 
 void b2MouseJoint::SetTarget(const b2Vec2& target)
 {
+	b2Recorder* recorder = m_bodyB->GetWorld()->GetRecorder();
+	if (recorder)
+	{
+		recorder->RecordMouseTarget(this, target);
+	}
+
 	if (m_bodyB->IsAwake() == false)
 	{
 		m_bodyB->SetAwake(true);
@@ -96,9 +104,9 @@ float32 b2MouseJoint::GetDampingRatio() const
 void b2MouseJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIB = m_bodyB->m_invI;
+	m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+	m_invMassB = m_bodyB->m_sim->invMass;
+	m_invIB = m_bodyB->m_sim->invI;
 
 	b2Vec2 cB = data.positions[m_indexB].c;
 	float32 aB = data.positions[m_indexB].a;
@@ -215,3 +223,23 @@ float32 b2MouseJoint::GetReactionTorque(float32 inv_dt) const
 {
 	return inv_dt * 0.0f;
 }
+
+void b2MouseJoint::SaveState(b2StreamWriter* writer) const
+{
+	writer->Write(m_localAnchorB);
+	writer->Write(m_targetA);
+	writer->Write(m_frequencyHz);
+	writer->Write(m_dampingRatio);
+	writer->Write(m_impulse);
+	writer->Write(m_maxForce);
+}
+
+void b2MouseJoint::LoadState(b2StreamReader* reader)
+{
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_targetA);
+	reader->Read(&m_frequencyHz);
+	reader->Read(&m_dampingRatio);
+	reader->Read(&m_impulse);
+	reader->Read(&m_maxForce);
+}
@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Stream.h>
 
 // Linear constraint (point-to-line)
 // d = p2 - p1 = x2 + r2 - x1 - r1
@@ -127,12 +128,12 @@ void b2PrismaticJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	m_indexA = m_bodyA->m_islandIndex;
 	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+	m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+	m_invMassA = m_bodyA->m_sim->invMass;
+	m_invMassB = m_bodyB->m_sim->invMass;
+	m_invIA = m_bodyA->m_sim->invI;
+	m_invIB = m_bodyB->m_sim->invI;
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -528,17 +529,17 @@ float32 b2PrismaticJoint::GetJointSpeed() const
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
 
-	b2Vec2 rA = b2Mul(bA->m_xf.q, m_localAnchorA - bA->m_sweep.localCenter);
-	b2Vec2 rB = b2Mul(bB->m_xf.q, m_localAnchorB - bB->m_sweep.localCenter);
-	b2Vec2 p1 = bA->m_sweep.c + rA;
-	b2Vec2 p2 = bB->m_sweep.c + rB;
+	b2Vec2 rA = b2Mul(bA->m_sim->xf.q, m_localAnchorA - bA->m_sim->sweep.localCenter);
+	b2Vec2 rB = b2Mul(bB->m_sim->xf.q, m_localAnchorB - bB->m_sim->sweep.localCenter);
+	b2Vec2 p1 = bA->m_sim->sweep.c + rA;
+	b2Vec2 p2 = bB->m_sim->sweep.c + rB;
 	b2Vec2 d = p2 - p1;
-	b2Vec2 axis = b2Mul(bA->m_xf.q, m_localXAxisA);
+	b2Vec2 axis = b2Mul(bA->m_sim->xf.q, m_localXAxisA);
 
-	b2Vec2 vA = bA->m_linearVelocity;
-	b2Vec2 vB = bB->m_linearVelocity;
-	float32 wA = bA->m_angularVelocity;
-	float32 wB = bB->m_angularVelocity;
+	b2Vec2 vA = bA->m_velocity->v;
+	b2Vec2 vB = bB->m_velocity->v;
+	float32 wA = bA->m_velocity->w;
+	float32 wB = bB->m_velocity->w;
 
 	float32 speed = b2Dot(d, b2Cross(wA, axis)) + b2Dot(axis, vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA));
 	return speed;
@@ -635,3 +636,44 @@ void b2PrismaticJoint::Dump()
 	b2Log("  jd.maxMotorForce = %.15lef;\n", m_maxMotorForce);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2PrismaticJoint::SaveState(b2StreamWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_localXAxisA);
+	writer->Write(m_localYAxisA);
+	writer->Write(m_referenceAngle);
+	writer->Write(m_impulse);
+	writer->Write(m_motorImpulse);
+	writer->Write(m_lowerTranslation);
+	writer->Write(m_upperTranslation);
+	writer->Write(m_maxMotorForce);
+	writer->Write(m_motorSpeed);
+	writer->Write(uint8(m_enableLimit));
+	writer->Write(uint8(m_enableMotor));
+	writer->Write(int32(m_limitState));
+}
+
+void b2PrismaticJoint::LoadState(b2StreamReader* reader)
+{
+	int32 limitState;
+	uint8 enableLimit, enableMotor;
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_localXAxisA);
+	reader->Read(&m_localYAxisA);
+	reader->Read(&m_referenceAngle);
+	reader->Read(&m_impulse);
+	reader->Read(&m_motorImpulse);
+	reader->Read(&m_lowerTranslation);
+	reader->Read(&m_upperTranslation);
+	reader->Read(&m_maxMotorForce);
+	reader->Read(&m_motorSpeed);
+	reader->Read(&enableLimit);
+	reader->Read(&enableMotor);
+	reader->Read(&limitState);
+	m_enableLimit = enableLimit != 0;
+	m_enableMotor = enableMotor != 0;
+	m_limitState = b2LimitState(limitState);
+}
@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Stream.h>
 
 // Pulley:
 // length1 = norm(p1 - s1)
@@ -74,12 +75,12 @@ void b2PulleyJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	m_indexA = m_bodyA->m_islandIndex;
 	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+	m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+	m_invMassA = m_bodyA->m_sim->invMass;
+	m_invMassB = m_bodyB->m_sim->invMass;
+	m_invIA = m_bodyA->m_sim->invI;
+	m_invIB = m_bodyB->m_sim->invI;
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -330,3 +331,29 @@ void b2PulleyJoint::Dump()
 	b2Log("  jd.ratio = %.15lef;\n", m_ratio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2PulleyJoint::SaveState(b2StreamWriter* writer) const
+{
+	writer->Write(m_groundAnchorA);
+	writer->Write(m_groundAnchorB);
+	writer->Write(m_lengthA);
+	writer->Write(m_lengthB);
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_constant);
+	writer->Write(m_ratio);
+	writer->Write(m_impulse);
+}
+
+void b2PulleyJoint::LoadState(b2StreamReader* reader)
+{
+	reader->Read(&m_groundAnchorA);
+	reader->Read(&m_groundAnchorB);
+	reader->Read(&m_lengthA);
+	reader->Read(&m_lengthB);
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_constant);
+	reader->Read(&m_ratio);
+	reader->Read(&m_impulse);
+}
@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Stream.h>
 
 // Point-to-point constraint
 // C = p2 - p1
@@ -65,12 +66,12 @@ void b2RevoluteJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	m_indexA = m_bodyA->m_islandIndex;
 	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_localCenterA = m_bodyA->m_sim->sweep.localCenter;
+	m_localCenterB = m_bodyB->m_sim->sweep.localCenter;
+	m_invMassA = m_bodyA->m_sim->invMass;
+	m_invMassB = m_bodyB->m_sim->invMass;
+	m_invIA = m_bodyA->m_sim->invI;
+	m_invIB = m_bodyB->m_sim->invI;
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -401,14 +402,14 @@ float32 b2RevoluteJoint::GetJointAngle() const
 {
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
-	return bB->m_sweep.a - bA->m_sweep.a - m_referenceAngle;
+	return bB->m_sim->sweep.a - bA->m_sim->sweep.a - m_referenceAngle;
 }
 
 float32 b2RevoluteJoint::GetJointSpeed() const
 {
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
-	return bB->m_angularVelocity - bA->m_angularVelocity;
+	return bB->m_velocity->w - bA->m_velocity->w;
 }
 
 bool b2RevoluteJoint::IsMotorEnabled() const
@@ -502,3 +503,40 @@ void b2RevoluteJoint::Dump()
 	b2Log("  jd.maxMotorTorque = %.15lef;\n", m_maxMotorTorque);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2RevoluteJoint::SaveState(b2StreamWriter* writer) const
+{
+	writer->Write(m_localAnchorA);
+	writer->Write(m_localAnchorB);
+	writer->Write(m_impulse);
+	writer->Write(m_motorImpulse);
+	writer->Write(uint8(m_enableMotor));
+	writer->Write(m_maxMotorTorque);
+	writer->Write(m_motorSpeed);
+	writer->Write(uint8(m_enableLimit));
+	writer->Write(m_referenceAngle);
+	writer->Write(m_lowerAngle);
+	writer->Write(m_upperAngle);
+	writer->Write(int32(m_limitState));
+}
+
+void b2RevoluteJoint::LoadState(b2StreamReader* reader)
+{
+	int32 limitState;
+	uint8 enableMotor, enableLimit;
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_impulse);
+	reader->Read(&m_motorImpulse);
+	reader->Read(&enableMotor);
+	reader->Read(&m_maxMotorTorque);
+	reader->Read(&m_motorSpeed);
+	reader->Read(&enableLimit);
+	reader->Read(&m_referenceAngle);
+	reader->Read(&m_lowerAngle);
+	reader->Read(&m_upperAngle);
+	reader->Read(&limitState);
+	m_enableMotor = enableMotor != 0;
+	m_enableLimit = enableLimit != 0;
+	m_limitState = b2LimitState(limitState);
+}
@@ -56,48 +56,58 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 
 	m_world = world;
 
-	m_xf.p = bd->position;
-	m_xf.q.Set(bd->angle);
+	// This binds m_sim, m_velocity and m_forceAccum.
+	world->m_bodyStore.Create(this);
 
-	m_sweep.localCenter.SetZero();
-	m_sweep.c0 = m_xf.p;
-	m_sweep.c = m_xf.p;
-	m_sweep.a0 = bd->angle;
-	m_sweep.a = bd->angle;
-	m_sweep.alpha0 = 0.0f;
+	m_sim->xf.p = bd->position;
+	m_sim->xf.q.Set(bd->angle);
+
+	m_sim->sweep.localCenter.SetZero();
+	m_sim->sweep.c0 = m_sim->xf.p;
+	m_sim->sweep.c = m_sim->xf.p;
+	m_sim->sweep.a0 = bd->angle;
+	m_sim->sweep.a = bd->angle;
+	m_sim->sweep.alpha0 = 0.0f;
+
+	m_prevPosition = m_sim->xf.p;
+	m_prevAngle = bd->angle;
 
 	m_jointList = NULL;
 	m_contactList = NULL;
+	m_sensorList = NULL;
 	m_prev = NULL;
 	m_next = NULL;
+	m_awakePrev = NULL;
+	m_awakeNext = NULL;
 
-	m_linearVelocity = bd->linearVelocity;
-	m_angularVelocity = bd->angularVelocity;
+	m_velocity->v = bd->linearVelocity;
+	m_velocity->w = bd->angularVelocity;
 
-	m_linearDamping = bd->linearDamping;
-	m_angularDamping = bd->angularDamping;
-	m_gravityScale = bd->gravityScale;
+	m_motion->linearDamping = bd->linearDamping;
+	m_motion->angularDamping = bd->angularDamping;
+	m_motion->gravityScale = bd->gravityScale;
 
-	m_force.SetZero();
-	m_torque = 0.0f;
+	m_forceAccum->force.SetZero();
+	m_forceAccum->torque = 0.0f;
 
 	m_sleepTime = 0.0f;
 
 	m_type = bd->type;
+	m_motion->type = m_type;
 
 	if (m_type == b2_dynamicBody)
 	{
 		m_mass = 1.0f;
-		m_invMass = 1.0f;
+		m_sim->invMass = 1.0f;
 	}
 	else
 	{
 		m_mass = 0.0f;
-		m_invMass = 0.0f;
+		m_sim->invMass = 0.0f;
 	}
 
 	m_I = 0.0f;
-	m_invI = 0.0f;
+	m_sim->invI = 0.0f;
 
 	m_userData = bd->userData;
 
@@ -105,11 +115,49 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	m_fixtureCount = 0;
 }
 
+b2Body::b2Body(b2World* world, int32 handle)
+{
+	m_world = world;
+	m_prev = NULL;
+	m_next = NULL;
+	m_awakePrev = NULL;
+	m_awakeNext = NULL;
+	m_fixtureList = NULL;
+	m_fixtureCount = 0;
+	m_jointList = NULL;
+	m_contactList = NULL;
+	m_sensorList = NULL;
+	m_userData = NULL;
+
+	world->m_bodyStore.Attach(this, handle);
+}
+
 b2Body::~b2Body()
 {
 	// shapes and joints are destroyed in b2World::Destroy
 }
 
+void b2Body::RecordInput(int32 type, const void* data, int32 size)
+{
+	m_world->m_recorder->RecordBody(this, type, data, size);
+}
+
+void b2Body::AddToAwakeList()
+{
+	if ((m_flags & e_awakeListFlag) == 0)
+	{
+		m_world->AddAwakeBody(this);
+	}
+
+	for (b2ContactEdge* ce = m_contactList; ce; ce = ce->next)
+	{
+		m_world->m_contactManager.AddAwakeContact(ce->contact);
+	}
+
+	// A body woken during the TOI phase brings new TOI candidates.
+	m_world->m_toiQueue.AddWokenBody(this);
+}
+
 void b2Body::SetType(b2BodyType type)
 {
 	b2Assert(m_world->IsLocked() == false);
@@ -118,28 +166,35 @@ void b2Body::SetType(b2BodyType type)
 		return;
 	}
 
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		int32 data = type;
+		RecordInput(b2Recorder::e_type, &data, sizeof(data));
+	}
+
 	if (m_type == type)
 	{
 		return;
 	}
 
 	m_type = type;
+	m_motion->type = m_type;
 
 	ResetMassData();
 
 	if (m_type == b2_staticBody)
 	{
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_sweep.a0 = m_sweep.a;
-		m_sweep.c0 = m_sweep.c;
+		m_velocity->v.SetZero();
+		m_velocity->w = 0.0f;
+		m_sim->sweep.a0 = m_sim->sweep.a;
+		m_sim->sweep.c0 = m_sim->sweep.c;
 		SynchronizeFixtures();
 	}
 
 	SetAwake(true);
 
-	m_force.SetZero();
-	m_torque = 0.0f;
+	m_forceAccum->force.SetZero();
+	m_forceAccum->torque = 0.0f;
 
 	// Since the body type changed, we need to flag contacts for filtering.
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
@@ -156,6 +211,11 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 		return NULL;
 	}
 
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		m_world->m_recorder->RecordCreateFixture(this, def);
+	}
+
 	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
 
 	void* memory = allocator->Allocate(sizeof(b2Fixture));
@@ -165,7 +225,7 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 	if (m_flags & e_activeFlag)
 	{
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
-		fixture->CreateProxies(broadPhase, m_xf);
+		fixture->CreateProxies(broadPhase, m_sim->xf);
 	}
 
 	fixture->m_next = m_fixtureList;
@@ -204,6 +264,11 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 		return;
 	}
 
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		m_world->m_recorder->RecordDestroyFixture(fixture);
+	}
+
 	b2Assert(fixture->m_body == this);
 
 	// Remove the fixture from this body's singly linked list.
@@ -243,6 +308,19 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 		}
 	}
 
+	// Destroy any sensor pairs associated with the fixture.
+	b2SensorEdge* se = m_sensorList;
+	while (se)
+	{
+		b2SensorPair* p = se->pair;
+		se = se->next;
+
+		if (fixture == p->fixtureA || fixture == p->fixtureB)
+		{
+			m_world->m_contactManager.Destroy(p);
+		}
+	}
+
 	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
 
 	if (m_flags & e_activeFlag)
@@ -265,19 +343,24 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 
 void b2Body::ResetMassData()
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_resetMassData, NULL, 0);
+	}
+
 	// Compute mass data from shapes. Each shape has its own density.
 	m_mass = 0.0f;
-	m_invMass = 0.0f;
+	m_sim->invMass = 0.0f;
 	m_I = 0.0f;
-	m_invI = 0.0f;
-	m_sweep.localCenter.SetZero();
+	m_sim->invI = 0.0f;
+	m_sim->sweep.localCenter.SetZero();
 
 	// Static and kinematic bodies have zero mass.
 	if (m_type == b2_staticBody || m_type == b2_kinematicBody)
 	{
-		m_sweep.c0 = m_xf.p;
-		m_sweep.c = m_xf.p;
-		m_sweep.a0 = m_sweep.a;
+		m_sim->sweep.c0 = m_sim->xf.p;
+		m_sim->sweep.c = m_sim->xf.p;
+		m_sim->sweep.a0 = m_sim->sweep.a;
 		return;
 	}
 
@@ -302,14 +385,14 @@ void b2Body::ResetMassData()
 	// Compute center of mass.
 	if (m_mass > 0.0f)
 	{
-		m_invMass = 1.0f / m_mass;
-		localCenter *= m_invMass;
+		m_sim->invMass = 1.0f / m_mass;
+		localCenter *= m_sim->invMass;
 	}
 	else
 	{
 		// Force all dynamic bodies to have a positive mass.
 		m_mass = 1.0f;
-		m_invMass = 1.0f;
+		m_sim->invMass = 1.0f;
 	}
 
 	if (m_I > 0.0f && (m_flags & e_fixedRotationFlag) == 0)
@@ -317,22 +400,22 @@ void b2Body::ResetMassData()
 		// Center the inertia about the center of mass.
 		m_I -= m_mass * b2Dot(localCenter, localCenter);
 		b2Assert(m_I > 0.0f);
-		m_invI = 1.0f / m_I;
+		m_sim->invI = 1.0f / m_I;
 
 	}
 	else
 	{
 		m_I = 0.0f;
-		m_invI = 0.0f;
+		m_sim->invI = 0.0f;
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter = localCenter;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = m_sim->sweep.c;
+	m_sim->sweep.localCenter = localCenter;
+	m_sim->sweep.c0 = m_sim->sweep.c = b2Mul(m_sim->xf, m_sim->sweep.localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	m_velocity->v += b2Cross(m_velocity->w, m_sim->sweep.c - oldCenter);
 }
 
 void b2Body::SetMassData(const b2MassData* massData)
@@ -343,14 +426,19 @@ void b2Body::SetMassData(const b2MassData* massData)
 		return;
 	}
 
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_massData, massData, sizeof(b2MassData));
+	}
+
 	if (m_type != b2_dynamicBody)
 	{
 		return;
 	}
 
-	m_invMass = 0.0f;
+	m_sim->invMass = 0.0f;
 	m_I = 0.0f;
-	m_invI = 0.0f;
+	m_sim->invI = 0.0f;
 
 	m_mass = massData->mass;
 	if (m_mass <= 0.0f)
@@ -358,22 +446,22 @@ void b2Body::SetMassData(const b2MassData* massData)
 		m_mass = 1.0f;
 	}
 
-	m_invMass = 1.0f / m_mass;
+	m_sim->invMass = 1.0f / m_mass;
 
 	if (massData->I > 0.0f && (m_flags & b2Body::e_fixedRotationFlag) == 0)
 	{
 		m_I = massData->I - m_mass * b2Dot(massData->center, massData->center);
 		b2Assert(m_I > 0.0f);
-		m_invI = 1.0f / m_I;
+		m_sim->invI = 1.0f / m_I;
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter =  massData->center;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = m_sim->sweep.c;
+	m_sim->sweep.localCenter =  massData->center;
+	m_sim->sweep.c0 = m_sim->sweep.c = b2Mul(m_sim->xf, m_sim->sweep.localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	m_velocity->v += b2Cross(m_velocity->w, m_sim->sweep.c - oldCenter);
 }
 
 bool b2Body::ShouldCollide(const b2Body* other) const
@@ -407,34 +495,72 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 		return;
 	}
 
-	m_xf.q.Set(angle);
-	m_xf.p = position;
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		float32 data[3] = {position.x, position.y, angle};
+		RecordInput(b2Recorder::e_transform, data, sizeof(data));
+	}
+
+	m_sim->xf.q.Set(angle);
+	m_sim->xf.p = position;
 
-	m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
-	m_sweep.a = angle;
+	m_sim->sweep.c = b2Mul(m_sim->xf, m_sim->sweep.localCenter);
+	m_sim->sweep.a = angle;
 
-	m_sweep.c0 = m_sweep.c;
-	m_sweep.a0 = angle;
+	m_sim->sweep.c0 = m_sim->sweep.c;
+	m_sim->sweep.a0 = angle;
+	m_world->m_bodyStore.MarkMoved(m_handle);
+
+	// Teleport without interpolating.
+	m_prevPosition = position;
+	m_prevAngle = angle;
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
-		f->Synchronize(broadPhase, m_xf, m_xf);
+		f->Synchronize(broadPhase, m_sim->xf, m_sim->xf);
 	}
 
 	m_world->m_contactManager.FindNewContacts();
 }
 
+void b2Body::GetSweepTransforms(b2Transform* xf1, b2Transform* xf2) const
+{
+	xf1->q.Set(m_sim->sweep.a0);
+	xf1->p = m_sim->sweep.c0 - b2Mul(xf1->q, m_sim->sweep.localCenter);
+	*xf2 = m_sim->xf;
+}
+
+// Cover the motion expected over the next step of length dt, so that the
+// broad-phase finds speculative contacts before the shapes touch.
+void b2Body::GetPredictedTransforms(float32 dt, b2Transform* xf1, b2Transform* xf2) const
+{
+	*xf1 = m_sim->xf;
+	xf2->q.Set(m_sim->sweep.a + dt * m_velocity->w);
+	xf2->p = m_sim->sweep.c + dt * m_velocity->v - b2Mul(xf2->q, m_sim->sweep.localCenter);
+}
+
 void b2Body::SynchronizeFixtures()
 {
-	b2Transform xf1;
-	xf1.q.Set(m_sweep.a0);
-	xf1.p = m_sweep.c0 - b2Mul(xf1.q, m_sweep.localCenter);
+	b2Transform xf1, xf2;
+	GetSweepTransforms(&xf1, &xf2);
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
-		f->Synchronize(broadPhase, xf1, m_xf);
+		f->Synchronize(broadPhase, xf1, xf2);
+	}
+}
+
+void b2Body::SynchronizePredictedFixtures(float32 dt)
+{
+	b2Transform xf1, xf2;
+	GetPredictedTransforms(dt, &xf1, &xf2);
+
+	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+	{
+		f->Synchronize(broadPhase, xf1, xf2);
 	}
 }
 
@@ -442,6 +568,12 @@ void b2Body::SetActive(bool flag)
 {
 	b2Assert(m_world->IsLocked() == false);
 
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		uint8 data = flag;
+		RecordInput(b2Recorder::e_active, &data, sizeof(data));
+	}
+
 	if (flag == IsActive())
 	{
 		return;
@@ -455,7 +587,7 @@ void b2Body::SetActive(bool flag)
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
-			f->CreateProxies(broadPhase, m_xf);
+			f->CreateProxies(broadPhase, m_sim->xf);
 		}
 
 		// Contacts are created the next time step.
@@ -480,6 +612,16 @@ void b2Body::SetActive(bool flag)
 			m_world->m_contactManager.Destroy(ce0->contact);
 		}
 		m_contactList = NULL;
+
+		// Destroy the attached sensor pairs.
+		b2SensorEdge* se = m_sensorList;
+		while (se)
+		{
+			b2SensorEdge* se0 = se;
+			se = se->next;
+			m_world->m_contactManager.Destroy(se0->pair);
+		}
+		m_sensorList = NULL;
 	}
 }
 
@@ -490,18 +632,18 @@ void b2Body::Dump()
 	b2Log("{\n");
 	b2Log("  b2BodyDef bd;\n");
 	b2Log("  bd.type = b2BodyType(%d);\n", m_type);
-	b2Log("  bd.position.Set(%.15lef, %.15lef);\n", m_xf.p.x, m_xf.p.y);
-	b2Log("  bd.angle = %.15lef;\n", m_sweep.a);
-	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", m_linearVelocity.x, m_linearVelocity.y);
-	b2Log("  bd.angularVelocity = %.15lef;\n", m_angularVelocity);
-	b2Log("  bd.linearDamping = %.15lef;\n", m_linearDamping);
-	b2Log("  bd.angularDamping = %.15lef;\n", m_angularDamping);
+	b2Log("  bd.position.Set(%.15lef, %.15lef);\n", m_sim->xf.p.x, m_sim->xf.p.y);
+	b2Log("  bd.angle = %.15lef;\n", m_sim->sweep.a);
+	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", m_velocity->v.x, m_velocity->v.y);
+	b2Log("  bd.angularVelocity = %.15lef;\n", m_velocity->w);
+	b2Log("  bd.linearDamping = %.15lef;\n", m_motion->linearDamping);
+	b2Log("  bd.angularDamping = %.15lef;\n", m_motion->angularDamping);
 	b2Log("  bd.allowSleep = bool(%d);\n", m_flags & e_autoSleepFlag);
 	b2Log("  bd.awake = bool(%d);\n", m_flags & e_awakeFlag);
 	b2Log("  bd.fixedRotation = bool(%d);\n", m_flags & e_fixedRotationFlag);
 	b2Log("  bd.bullet = bool(%d);\n", m_flags & e_bulletFlag);
 	b2Log("  bd.active = bool(%d);\n", m_flags & e_activeFlag);
-	b2Log("  bd.gravityScale = %.15lef;\n", m_gravityScale);
+	b2Log("  bd.gravityScale = %.15lef;\n", m_motion->gravityScale);
 	b2Log("  bodies[%d] = m_world->CreateBody(&bd);\n", m_islandIndex);
 	b2Log("\n");
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
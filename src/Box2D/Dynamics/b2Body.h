@@ -21,6 +21,8 @@
 
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Dynamics/b2BodyStore.h>
+#include <Box2D/Dynamics/b2Recorder.h>
 #include <memory>
 
 class b2Fixture;
@@ -31,6 +33,7 @@ class b2World;
 struct b2FixtureDef;
 struct b2JointEdge;
 struct b2ContactEdge;
+struct b2SensorEdge;
 
 /// The body type.
 /// static: zero mass, zero velocity, may be manually moved
@@ -160,23 +163,24 @@ public:
 	/// @param angle the world rotation in radians.
 	void SetTransform(const b2Vec2& position, float32 angle);
 
-	/// Get the body transform for the body's origin.
+	/// Get the body transform for the body's origin. The pose lives in arrays
+	/// that move when bodies are created, so it is returned by value.
 	/// @return the world transform of the body's origin.
-	const b2Transform& GetTransform() const;
+	b2Transform GetTransform() const;
 
 	/// Get the world body origin position.
 	/// @return the world position of the body's origin.
-	const b2Vec2& GetPosition() const;
+	b2Vec2 GetPosition() const;
 
 	/// Get the angle in radians.
 	/// @return the current world rotation angle in radians.
 	float32 GetAngle() const;
 
 	/// Get the world position of the center of mass.
-	const b2Vec2& GetWorldCenter() const;
+	b2Vec2 GetWorldCenter() const;
 
 	/// Get the local position of the center of mass.
-	const b2Vec2& GetLocalCenter() const;
+	b2Vec2 GetLocalCenter() const;
 
 	/// Set the linear velocity of the center of mass.
 	/// @param v the new linear velocity of the center of mass.
@@ -371,6 +375,10 @@ public:
 	/// Set the user data. Use this to store your application specific data.
 	void SetUserData(void* data);
 
+	/// Get the handle of this body in its world. Handles are small, dense
+	/// integers that are reused after a body is destroyed.
+	int32 GetHandle() const;
+
 	/// Get the parent world of this body.
 	b2World* GetWorld();
 	const b2World* GetWorld() const;
@@ -381,10 +389,15 @@ public:
 private:
 
 	friend class b2World;
+	friend class b2BodyStore;
 	friend class b2Island;
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2Contact;
+	friend class b2Fixture;
+	friend class b2FixedStepper;
+	friend class b2Recorder;
+	friend class b2FixtureBatch;
 	
 	friend class b2DistanceJoint;
 	friend class b2GearJoint;
@@ -406,54 +419,77 @@ private:
 		e_bulletFlag		= 0x0008,
 		e_fixedRotationFlag	= 0x0010,
 		e_activeFlag		= 0x0020,
-		e_toiFlag			= 0x0040
+		e_toiFlag			= 0x0040,
+		e_awakeListFlag		= 0x0080,
+		e_recordFlag		= 0x0100
 	};
 
 	b2Body(const b2BodyDef* bd, b2World* world);
+
+	// This is used by b2World::LoadSnapshot, which sets the other members.
+	b2Body(b2World* world, int32 handle);
+
 	~b2Body();
 
 	void SynchronizeFixtures();
+	void SynchronizePredictedFixtures(float32 dt);
 	void SynchronizeTransform();
 
+	// The swept transforms passed to the fixtures by SynchronizeFixtures and
+	// SynchronizePredictedFixtures.
+	void GetSweepTransforms(b2Transform* xf1, b2Transform* xf2) const;
+	void GetPredictedTransforms(float32 dt, b2Transform* xf1, b2Transform* xf2) const;
+
 	// This is used to prevent connected bodies from colliding.
 	// It may lie, depending on the collideConnected flag.
 	bool ShouldCollide(const b2Body* other) const;
 
 	void Advance(float32 t);
 
+	// Put this body and its contacts on the world's awake lists, unless
+	// they are already there.
+	void AddToAwakeList();
+
+	// Pass a call to the world's recorder. Only called with e_recordFlag.
+	void RecordInput(int32 type, const void* data, int32 size);
+
 	b2BodyType m_type;
 
 	uint16 m_flags;
 
 	int32 m_islandIndex;
 
-	b2Transform m_xf;		// the body origin transform
-	b2Sweep m_sweep;		// the swept motion for CCD
+	// The hot state lives in the world's b2BodyStore. These point into its
+	// arrays and are rebound when the arrays grow.
+	int32 m_handle;
+	b2BodySim* m_sim;
+	b2Velocity* m_velocity;
+	b2BodyForce* m_forceAccum;
+	b2BodyMotion* m_motion;
 
-	b2Vec2 m_linearVelocity;
-	float32 m_angularVelocity;
-
-	b2Vec2 m_force;
-	float32 m_torque;
+	// The origin and angle before the last step of a b2FixedStepper.
+	b2Vec2 m_prevPosition;
+	float32 m_prevAngle;
 
 	b2World* m_world;
 	b2Body* m_prev;
 	b2Body* m_next;
 
+	// Awake list pointers. Only valid with e_awakeListFlag.
+	b2Body* m_awakePrev;
+	b2Body* m_awakeNext;
+
 	b2Fixture* m_fixtureList;
 	int32 m_fixtureCount;
 
 	b2JointEdge* m_jointList;
 	b2ContactEdge* m_contactList;
+	b2SensorEdge* m_sensorList;
 
-	float32 m_mass, m_invMass;
+	float32 m_mass;
 
 	// Rotational inertia about the center of mass.
-	float32 m_I, m_invI;
-
-	float32 m_linearDamping;
-	float32 m_angularDamping;
-	float32 m_gravityScale;
+	float32 m_I;
 
 	float32 m_sleepTime;
 
@@ -465,33 +501,38 @@ inline b2BodyType b2Body::GetType() const
 	return m_type;
 }
 
-inline const b2Transform& b2Body::GetTransform() const
+inline b2Transform b2Body::GetTransform() const
 {
-	return m_xf;
+	return m_sim->xf;
 }
 
-inline const b2Vec2& b2Body::GetPosition() const
+inline b2Vec2 b2Body::GetPosition() const
 {
-	return m_xf.p;
+	return m_sim->xf.p;
 }
 
 inline float32 b2Body::GetAngle() const
 {
-	return m_sweep.a;
+	return m_sim->sweep.a;
 }
 
-inline const b2Vec2& b2Body::GetWorldCenter() const
+inline b2Vec2 b2Body::GetWorldCenter() const
 {
-	return m_sweep.c;
+	return m_sim->sweep.c;
 }
 
-inline const b2Vec2& b2Body::GetLocalCenter() const
+inline b2Vec2 b2Body::GetLocalCenter() const
 {
-	return m_sweep.localCenter;
+	return m_sim->sweep.localCenter;
 }
 
 inline void b2Body::SetLinearVelocity(const b2Vec2& v)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_linearVelocity, &v, sizeof(v));
+	}
+
 	if (m_type == b2_staticBody)
 	{
 		return;
@@ -502,16 +543,21 @@ inline void b2Body::SetLinearVelocity(const b2Vec2& v)
 		SetAwake(true);
 	}
 
-	m_linearVelocity = v;
+	m_velocity->v = v;
 }
 
 inline b2Vec2 b2Body::GetLinearVelocity() const
 {
-	return m_linearVelocity;
+	return m_velocity->v;
 }
 
 inline void b2Body::SetAngularVelocity(float32 w)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_angularVelocity, &w, sizeof(w));
+	}
+
 	if (m_type == b2_staticBody)
 	{
 		return;
@@ -522,12 +568,12 @@ inline void b2Body::SetAngularVelocity(float32 w)
 		SetAwake(true);
 	}
 
-	m_angularVelocity = w;
+	m_velocity->w = w;
 }
 
 inline float32 b2Body::GetAngularVelocity() const
 {
-	return m_angularVelocity;
+	return m_velocity->w;
 }
 
 inline float32 b2Body::GetMass() const
@@ -537,39 +583,39 @@ inline float32 b2Body::GetMass() const
 
 inline float32 b2Body::GetInertia() const
 {
-	return m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
+	return m_I + m_mass * b2Dot(m_sim->sweep.localCenter, m_sim->sweep.localCenter);
 }
 
 inline void b2Body::GetMassData(b2MassData* data) const
 {
 	data->mass = m_mass;
-	data->I = m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
-	data->center = m_sweep.localCenter;
+	data->I = m_I + m_mass * b2Dot(m_sim->sweep.localCenter, m_sim->sweep.localCenter);
+	data->center = m_sim->sweep.localCenter;
 }
 
 inline b2Vec2 b2Body::GetWorldPoint(const b2Vec2& localPoint) const
 {
-	return b2Mul(m_xf, localPoint);
+	return b2Mul(m_sim->xf, localPoint);
 }
 
 inline b2Vec2 b2Body::GetWorldVector(const b2Vec2& localVector) const
 {
-	return b2Mul(m_xf.q, localVector);
+	return b2Mul(m_sim->xf.q, localVector);
 }
 
 inline b2Vec2 b2Body::GetLocalPoint(const b2Vec2& worldPoint) const
 {
-	return b2MulT(m_xf, worldPoint);
+	return b2MulT(m_sim->xf, worldPoint);
 }
 
 inline b2Vec2 b2Body::GetLocalVector(const b2Vec2& worldVector) const
 {
-	return b2MulT(m_xf.q, worldVector);
+	return b2MulT(m_sim->xf.q, worldVector);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromWorldPoint(const b2Vec2& worldPoint) const
 {
-	return m_linearVelocity + b2Cross(m_angularVelocity, worldPoint - m_sweep.c);
+	return m_velocity->v + b2Cross(m_velocity->w, worldPoint - m_sim->sweep.c);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromLocalPoint(const b2Vec2& localPoint) const
@@ -579,36 +625,57 @@ inline b2Vec2 b2Body::GetLinearVelocityFromLocalPoint(const b2Vec2& localPoint)
 
 inline float32 b2Body::GetLinearDamping() const
 {
-	return m_linearDamping;
+	return m_motion->linearDamping;
 }
 
 inline void b2Body::SetLinearDamping(float32 linearDamping)
 {
-	m_linearDamping = linearDamping;
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_linearDamping, &linearDamping, sizeof(linearDamping));
+	}
+
+	m_motion->linearDamping = linearDamping;
 }
 
 inline float32 b2Body::GetAngularDamping() const
 {
-	return m_angularDamping;
+	return m_motion->angularDamping;
 }
 
 inline void b2Body::SetAngularDamping(float32 angularDamping)
 {
-	m_angularDamping = angularDamping;
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_angularDamping, &angularDamping, sizeof(angularDamping));
+	}
+
+	m_motion->angularDamping = angularDamping;
 }
 
 inline float32 b2Body::GetGravityScale() const
 {
-	return m_gravityScale;
+	return m_motion->gravityScale;
 }
 
 inline void b2Body::SetGravityScale(float32 scale)
 {
-	m_gravityScale = scale;
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_gravityScale, &scale, sizeof(scale));
+	}
+
+	m_motion->gravityScale = scale;
 }
 
 inline void b2Body::SetBullet(bool flag)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		uint8 data = flag;
+		RecordInput(b2Recorder::e_bullet, &data, sizeof(data));
+	}
+
 	if (flag)
 	{
 		m_flags |= e_bulletFlag;
@@ -626,22 +693,40 @@ inline bool b2Body::IsBullet() const
 
 inline void b2Body::SetAwake(bool flag)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		uint8 data = flag;
+		RecordInput(b2Recorder::e_awake, &data, sizeof(data));
+	}
+
 	if (flag)
 	{
 		if ((m_flags & e_awakeFlag) == 0)
 		{
 			m_flags |= e_awakeFlag;
 			m_sleepTime = 0.0f;
+
+			// The contacts may have left the awake list while this body slept.
+			if (m_type != b2_staticBody)
+			{
+				AddToAwakeList();
+			}
+		}
+		else if ((m_flags & e_awakeListFlag) == 0 && m_type != b2_staticBody)
+		{
+			// This body was static.
+			AddToAwakeList();
 		}
 	}
 	else
 	{
+		// The world drops the body from its awake list during the next step.
 		m_flags &= ~e_awakeFlag;
 		m_sleepTime = 0.0f;
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_force.SetZero();
-		m_torque = 0.0f;
+		m_velocity->v.SetZero();
+		m_velocity->w = 0.0f;
+		m_forceAccum->force.SetZero();
+		m_forceAccum->torque = 0.0f;
 	}
 }
 
@@ -657,6 +742,12 @@ inline bool b2Body::IsActive() const
 
 inline void b2Body::SetFixedRotation(bool flag)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		uint8 data = flag;
+		RecordInput(b2Recorder::e_fixedRotation, &data, sizeof(data));
+	}
+
 	if (flag)
 	{
 		m_flags |= e_fixedRotationFlag;
@@ -676,6 +767,12 @@ inline bool b2Body::IsFixedRotation() const
 
 inline void b2Body::SetSleepingAllowed(bool flag)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		uint8 data = flag;
+		RecordInput(b2Recorder::e_sleepingAllowed, &data, sizeof(data));
+	}
+
 	if (flag)
 	{
 		m_flags |= e_autoSleepFlag;
@@ -744,6 +841,12 @@ inline void* b2Body::GetUserData() const
 
 inline void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		b2Vec2 data[2] = {force, point};
+		RecordInput(b2Recorder::e_force, data, sizeof(data));
+	}
+
 	if (m_type != b2_dynamicBody)
 	{
 		return;
@@ -754,12 +857,17 @@ inline void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point)
 		SetAwake(true);
 	}
 
-	m_force += force;
-	m_torque += b2Cross(point - m_sweep.c, force);
+	m_forceAccum->force += force;
+	m_forceAccum->torque += b2Cross(point - m_sim->sweep.c, force);
 }
 
 inline void b2Body::ApplyForceToCenter(const b2Vec2& force)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_forceToCenter, &force, sizeof(force));
+	}
+
 	if (m_type != b2_dynamicBody)
 	{
 		return;
@@ -770,11 +878,16 @@ inline void b2Body::ApplyForceToCenter(const b2Vec2& force)
 		SetAwake(true);
 	}
 
-	m_force += force;
+	m_forceAccum->force += force;
 }
 
 inline void b2Body::ApplyTorque(float32 torque)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_torque, &torque, sizeof(torque));
+	}
+
 	if (m_type != b2_dynamicBody)
 	{
 		return;
@@ -785,11 +898,17 @@ inline void b2Body::ApplyTorque(float32 torque)
 		SetAwake(true);
 	}
 
-	m_torque += torque;
+	m_forceAccum->torque += torque;
 }
 
 inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& point)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		b2Vec2 data[2] = {impulse, point};
+		RecordInput(b2Recorder::e_linearImpulse, data, sizeof(data));
+	}
+
 	if (m_type != b2_dynamicBody)
 	{
 		return;
@@ -799,12 +918,17 @@ inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& poin
 	{
 		SetAwake(true);
 	}
-	m_linearVelocity += m_invMass * impulse;
-	m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
+	m_velocity->v += m_sim->invMass * impulse;
+	m_velocity->w += m_sim->invI * b2Cross(point - m_sim->sweep.c, impulse);
 }
 
 inline void b2Body::ApplyAngularImpulse(float32 impulse)
 {
+	if ((m_flags & e_recordFlag) != 0)
+	{
+		RecordInput(b2Recorder::e_angularImpulse, &impulse, sizeof(impulse));
+	}
+
 	if (m_type != b2_dynamicBody)
 	{
 		return;
@@ -814,23 +938,28 @@ inline void b2Body::ApplyAngularImpulse(float32 impulse)
 	{
 		SetAwake(true);
 	}
-	m_angularVelocity += m_invI * impulse;
+	m_velocity->w += m_sim->invI * impulse;
 }
 
 inline void b2Body::SynchronizeTransform()
 {
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	m_sim->xf.q.Set(m_sim->sweep.a);
+	m_sim->xf.p = m_sim->sweep.c - b2Mul(m_sim->xf.q, m_sim->sweep.localCenter);
 }
 
 inline void b2Body::Advance(float32 alpha)
 {
 	// Advance to the new safe time. This doesn't sync the broad-phase.
-	m_sweep.Advance(alpha);
-	m_sweep.c = m_sweep.c0;
-	m_sweep.a = m_sweep.a0;
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	m_sim->sweep.Advance(alpha);
+	m_sim->sweep.c = m_sim->sweep.c0;
+	m_sim->sweep.a = m_sim->sweep.a0;
+	m_sim->xf.q.Set(m_sim->sweep.a);
+	m_sim->xf.p = m_sim->sweep.c - b2Mul(m_sim->xf.q, m_sim->sweep.localCenter);
+}
+
+inline int32 b2Body::GetHandle() const
+{
+	return m_handle;
 }
 
 inline b2World* b2Body::GetWorld()
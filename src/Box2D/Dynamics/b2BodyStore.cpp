@@ -0,0 +1,317 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2BodyStore.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Common/b2Stream.h>
+#include <string.h>
+
+b2BodyStore::b2BodyStore(b2Allocator* allocator)
+{
+	m_allocator = allocator;
+	m_sims = NULL;
+	m_velocities = NULL;
+	m_forces = NULL;
+	m_motions = NULL;
+	m_bodies = NULL;
+	m_freeHandles = NULL;
+	m_freeCount = 0;
+	m_movedFlags = NULL;
+	m_movedHandles = NULL;
+	m_movedCount = 0;
+	m_count = 0;
+	m_capacity = 0;
+}
+
+b2BodyStore::~b2BodyStore()
+{
+	b2Free(m_allocator, m_sims);
+	b2Free(m_allocator, m_velocities);
+	b2Free(m_allocator, m_forces);
+	b2Free(m_allocator, m_motions);
+	b2Free(m_allocator, m_bodies);
+	b2Free(m_allocator, m_freeHandles);
+	b2Free(m_allocator, m_movedFlags);
+	b2Free(m_allocator, m_movedHandles);
+}
+
+inline void b2BodyStore::Bind(int32 handle)
+{
+	b2Body* body = m_bodies[handle];
+	body->m_handle = handle;
+	body->m_sim = m_sims + handle;
+	body->m_velocity = m_velocities + handle;
+	body->m_forceAccum = m_forces + handle;
+	body->m_motion = m_motions + handle;
+}
+
+void b2BodyStore::Grow()
+{
+	int32 capacity = m_capacity > 0 ? 2 * m_capacity : 64;
+
+	b2BodySim* sims = (b2BodySim*)b2Alloc(m_allocator, capacity * sizeof(b2BodySim), b2_allocBodyStore);
+	b2Velocity* velocities = (b2Velocity*)b2Alloc(m_allocator, capacity * sizeof(b2Velocity), b2_allocBodyStore);
+	b2BodyForce* forces = (b2BodyForce*)b2Alloc(m_allocator, capacity * sizeof(b2BodyForce), b2_allocBodyStore);
+	b2BodyMotion* motions = (b2BodyMotion*)b2Alloc(m_allocator, capacity * sizeof(b2BodyMotion), b2_allocBodyStore);
+	b2Body** bodies = (b2Body**)b2Alloc(m_allocator, capacity * sizeof(b2Body*), b2_allocBodyStore);
+	int32* freeHandles = (int32*)b2Alloc(m_allocator, capacity * sizeof(int32), b2_allocBodyStore);
+	uint8* movedFlags = (uint8*)b2Alloc(m_allocator, capacity * sizeof(uint8), b2_allocBodyStore);
+	int32* movedHandles = (int32*)b2Alloc(m_allocator, capacity * sizeof(int32), b2_allocBodyStore);
+
+	// The first grow has no arrays to copy.
+	if (m_capacity > 0)
+	{
+		memcpy(sims, m_sims, m_count * sizeof(b2BodySim));
+		memcpy(velocities, m_velocities, m_count * sizeof(b2Velocity));
+		memcpy(forces, m_forces, m_count * sizeof(b2BodyForce));
+		memcpy(motions, m_motions, m_count * sizeof(b2BodyMotion));
+		memcpy(bodies, m_bodies, m_count * sizeof(b2Body*));
+		memcpy(freeHandles, m_freeHandles, m_freeCount * sizeof(int32));
+		memcpy(movedFlags, m_movedFlags, m_count * sizeof(uint8));
+		memcpy(movedHandles, m_movedHandles, m_movedCount * sizeof(int32));
+	}
+
+	b2Free(m_allocator, m_sims);
+	b2Free(m_allocator, m_velocities);
+	b2Free(m_allocator, m_forces);
+	b2Free(m_allocator, m_motions);
+	b2Free(m_allocator, m_bodies);
+	b2Free(m_allocator, m_freeHandles);
+	b2Free(m_allocator, m_movedFlags);
+	b2Free(m_allocator, m_movedHandles);
+
+	m_sims = sims;
+	m_velocities = velocities;
+	m_forces = forces;
+	m_motions = motions;
+	m_bodies = bodies;
+	m_freeHandles = freeHandles;
+	m_movedFlags = movedFlags;
+	m_movedHandles = movedHandles;
+	m_capacity = capacity;
+
+	// The bodies point into the old arrays.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		if (m_bodies[i])
+		{
+			Bind(i);
+		}
+	}
+}
+
+int32 b2BodyStore::Create(b2Body* body)
+{
+	int32 handle;
+	if (m_freeCount > 0)
+	{
+		handle = m_freeHandles[--m_freeCount];
+	}
+	else
+	{
+		if (m_count == m_capacity)
+		{
+			Grow();
+		}
+
+		handle = m_count++;
+		m_movedFlags[handle] = 0;
+	}
+
+	m_bodies[handle] = body;
+	m_velocities[handle].v.SetZero();
+	m_velocities[handle].w = 0.0f;
+	m_forces[handle].force.SetZero();
+	m_forces[handle].torque = 0.0f;
+	Bind(handle);
+
+	// A new body has not been exported yet.
+	MarkMoved(handle);
+	return handle;
+}
+
+void b2BodyStore::Destroy(int32 handle)
+{
+	b2Assert(0 <= handle && handle < m_count);
+	b2Assert(m_bodies[handle] != NULL);
+
+	// A moved flag is kept with the slot. Export skips it while the slot is
+	// free and a body that reuses it is flagged anyway.
+	m_bodies[handle] = NULL;
+
+	// Free slots keep zero force so ClearForces can sweep them with the rest.
+	m_forces[handle].force.SetZero();
+	m_forces[handle].torque = 0.0f;
+
+	m_freeHandles[m_freeCount++] = handle;
+}
+
+void b2BodyStore::ClearForces()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_forces[i].force.SetZero();
+		m_forces[i].torque = 0.0f;
+	}
+}
+
+int32 b2BodyStore::Export(b2BodyPose* poses, int32 capacity, bool movedOnly)
+{
+	int32 count = 0;
+
+	if (movedOnly)
+	{
+		int32 i = 0;
+		while (i < m_movedCount && count < capacity)
+		{
+			int32 handle = m_movedHandles[i++];
+			m_movedFlags[handle] = 0;
+
+			if (m_bodies[handle] == NULL)
+			{
+				continue;
+			}
+
+			b2BodyPose* pose = poses + count++;
+			pose->handle = handle;
+			pose->xf = m_sims[handle].xf;
+			pose->angle = m_sims[handle].sweep.a;
+		}
+
+		// Keep the bodies that did not fit for the next call.
+		memmove(m_movedHandles, m_movedHandles + i, (m_movedCount - i) * sizeof(int32));
+		m_movedCount -= i;
+		return count;
+	}
+
+	int32 handle = 0;
+	for (; handle < m_count; ++handle)
+	{
+		if (m_bodies[handle] == NULL)
+		{
+			continue;
+		}
+
+		if (count == capacity)
+		{
+			break;
+		}
+
+		b2BodyPose* pose = poses + count++;
+		pose->handle = handle;
+		pose->xf = m_sims[handle].xf;
+		pose->angle = m_sims[handle].sweep.a;
+	}
+
+	// The flags are only dropped when every body fit.
+	if (handle < m_count)
+	{
+		return count;
+	}
+
+	for (int32 i = 0; i < m_movedCount; ++i)
+	{
+		m_movedFlags[m_movedHandles[i]] = 0;
+	}
+	m_movedCount = 0;
+	return count;
+}
+
+void b2BodyStore::Save(b2StreamWriter* writer) const
+{
+	writer->Write(m_count);
+	writer->Write(m_freeCount);
+
+	// These structures only hold floats, so they are copied in bulk.
+	writer->Write(m_sims, m_count * sizeof(b2BodySim));
+	writer->Write(m_velocities, m_count * sizeof(b2Velocity));
+	writer->Write(m_forces, m_count * sizeof(b2BodyForce));
+	writer->Write(m_freeHandles, m_freeCount * sizeof(int32));
+}
+
+bool b2BodyStore::Load(b2StreamReader* reader)
+{
+	int32 count, freeCount;
+	reader->Read(&count);
+	reader->Read(&freeCount);
+
+	m_count = 0;
+	m_freeCount = 0;
+	m_movedCount = 0;
+
+	int32 slotSize = sizeof(b2BodySim) + sizeof(b2Velocity) + sizeof(b2BodyForce);
+	if (reader->IsOk() == false || count < 0 || freeCount < 0 || freeCount > count
+		|| count > reader->GetRemaining() / slotSize)
+	{
+		return false;
+	}
+
+	while (m_capacity < count)
+	{
+		Grow();
+	}
+
+	reader->Read(m_sims, count * sizeof(b2BodySim));
+	reader->Read(m_velocities, count * sizeof(b2Velocity));
+	reader->Read(m_forces, count * sizeof(b2BodyForce));
+	reader->Read(m_freeHandles, freeCount * sizeof(int32));
+	if (reader->IsOk() == false)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < freeCount; ++i)
+	{
+		if (m_freeHandles[i] < 0 || m_freeHandles[i] >= count)
+		{
+			return false;
+		}
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		m_bodies[i] = NULL;
+		m_movedFlags[i] = 0;
+	}
+
+	m_count = count;
+	m_freeCount = freeCount;
+	return true;
+}
+
+void b2BodyStore::Reset()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Assert(m_bodies[i] == NULL);
+	}
+
+	m_count = 0;
+	m_freeCount = 0;
+	m_movedCount = 0;
+}
+
+void b2BodyStore::Attach(b2Body* body, int32 handle)
+{
+	b2Assert(0 <= handle && handle < m_count);
+	b2Assert(m_bodies[handle] == NULL);
+
+	m_bodies[handle] = body;
+	Bind(handle);
+	MarkMoved(handle);
+}
@@ -0,0 +1,192 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_BODY_STORE_H
+#define B2_BODY_STORE_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+class b2Body;
+class b2StreamWriter;
+class b2StreamReader;
+
+/// The pose of a body written by b2World::ExportTransforms. The transform
+/// rotation holds the cosine and sine of the angle, so together with the
+/// position it is the 2x3 matrix of the body.
+struct b2BodyPose
+{
+	int32 handle;
+	b2Transform xf;
+	float32 angle;
+};
+
+/// This is an internal structure. The body state read and written by the solver.
+struct b2BodySim
+{
+	b2Transform xf;		// the body origin transform
+	b2Sweep sweep;		// the swept motion for CCD
+	float32 invMass;
+	float32 invI;		// inverse rotational inertia about the center of mass
+};
+
+/// This is an internal structure. The force accumulated on a body until the
+/// forces are cleared.
+struct b2BodyForce
+{
+	b2Vec2 force;
+	float32 torque;
+};
+
+/// This is an internal structure. The per-body settings read when the solver
+/// integrates velocities.
+struct b2BodyMotion
+{
+	float32 linearDamping;
+	float32 angularDamping;
+	float32 gravityScale;
+	int32 type;			// mirrors b2Body::m_type
+};
+
+/// This is an internal class. The world keeps the hot state of its bodies in
+/// dense arrays indexed by a body handle. A handle is stable for the life of
+/// its body and is reused once the body is destroyed. Each body holds pointers
+/// into these arrays, which are rebound whenever the arrays grow.
+class b2BodyStore
+{
+public:
+	b2BodyStore(b2Allocator* allocator = NULL);
+	~b2BodyStore();
+
+	/// Take a slot for a body and bind the body's state pointers to it.
+	/// The body is flagged as moved.
+	int32 Create(b2Body* body);
+
+	/// Release the slot of a body.
+	void Destroy(int32 handle);
+
+	/// Zero the force and torque of every slot.
+	void ClearForces();
+
+	/// Flag a body whose transform changed since the last export.
+	void MarkMoved(int32 handle);
+
+	/// Get the number of flagged slots, including destroyed ones.
+	int32 GetMovedCount() const;
+
+	/// Write the poses of the flagged bodies, or of all bodies, and clear the
+	/// flags of the bodies written. Returns the number of poses written.
+	int32 Export(b2BodyPose* poses, int32 capacity, bool movedOnly);
+
+	/// Write the slots for a world snapshot.
+	void Save(b2StreamWriter* writer) const;
+
+	/// Replace the slots with ones written by Save. The store must not hold
+	/// bodies. The loaded slots have no bodies until Attach is called.
+	/// @return false if the data is malformed. The store is then empty.
+	bool Load(b2StreamReader* reader);
+
+	/// Drop all slots. The store must not hold bodies.
+	void Reset();
+
+	/// Bind a body to a loaded slot. The body is flagged as moved.
+	void Attach(b2Body* body, int32 handle);
+
+	/// Get the body in a slot, or NULL if the slot is free.
+	b2Body* GetBody(int32 handle) const;
+
+	/// Get the number of slots, including free ones. Handles are less than this.
+	int32 GetCount() const;
+
+	b2BodySim* GetSims();
+	b2Velocity* GetVelocities();
+	b2BodyForce* GetForces();
+	b2BodyMotion* GetMotions();
+
+private:
+
+	void Grow();
+	void Bind(int32 handle);
+
+	b2BodySim* m_sims;
+	b2Velocity* m_velocities;
+	b2BodyForce* m_forces;
+	b2BodyMotion* m_motions;
+	b2Body** m_bodies;
+
+	int32* m_freeHandles;
+	int32 m_freeCount;
+
+	// A slot is on the moved list at most once, so the list fits the capacity.
+	uint8* m_movedFlags;
+	int32* m_movedHandles;
+	int32 m_movedCount;
+
+	int32 m_count;
+	int32 m_capacity;
+
+	b2Allocator* m_allocator;
+};
+
+inline b2Body* b2BodyStore::GetBody(int32 handle) const
+{
+	b2Assert(0 <= handle && handle < m_count);
+	return m_bodies[handle];
+}
+
+inline int32 b2BodyStore::GetCount() const
+{
+	return m_count;
+}
+
+inline void b2BodyStore::MarkMoved(int32 handle)
+{
+	b2Assert(0 <= handle && handle < m_count);
+	if (m_movedFlags[handle] == 0)
+	{
+		m_movedFlags[handle] = 1;
+		m_movedHandles[m_movedCount++] = handle;
+	}
+}
+
+inline int32 b2BodyStore::GetMovedCount() const
+{
+	return m_movedCount;
+}
+
+inline b2BodySim* b2BodyStore::GetSims()
+{
+	return m_sims;
+}
+
+inline b2Velocity* b2BodyStore::GetVelocities()
+{
+	return m_velocities;
+}
+
+inline b2BodyForce* b2BodyStore::GetForces()
+{
+	return m_forces;
+}
+
+inline b2BodyMotion* b2BodyStore::GetMotions()
+{
+	return m_motions;
+}
+
+#endif
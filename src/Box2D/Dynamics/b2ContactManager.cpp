@@ -21,17 +21,26 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <new>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
-b2ContactManager::b2ContactManager()
+b2ContactManager::b2ContactManager(b2Allocator* allocator) : m_broadPhase(allocator)
 {
 	m_contactList = NULL;
 	m_contactCount = 0;
+	m_awakeContactList = NULL;
+	m_awakeContactTail = NULL;
+	m_sensorList = NULL;
+	m_sensorCount = 0;
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+	m_createCount = 0;
+	m_destroyCount = 0;
+	m_updateCount = 0;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -46,6 +55,11 @@ void b2ContactManager::Destroy(b2Contact* c)
 		m_contactListener->EndContact(c);
 	}
 
+	if (c->m_flags & b2Contact::e_awakeListFlag)
+	{
+		RemoveAwakeContact(c);
+	}
+
 	// Remove from the world.
 	if (c->m_prev)
 	{
@@ -96,16 +110,134 @@ void b2ContactManager::Destroy(b2Contact* c)
 
 	// Call the factory.
 	b2Contact::Destroy(c, m_allocator);
+	++m_destroyCount;
 	--m_contactCount;
 }
 
+void b2ContactManager::Destroy(b2SensorPair* p)
+{
+	b2Body* bodyA = p->fixtureA->GetBody();
+	b2Body* bodyB = p->fixtureB->GetBody();
+
+	if (m_contactListener && (p->flags & b2SensorPair::e_touchingFlag))
+	{
+		m_contactListener->EndOverlap(p->fixtureA, p->fixtureB);
+	}
+
+	// Remove from the world.
+	if (p->prev)
+	{
+		p->prev->next = p->next;
+	}
+
+	if (p->next)
+	{
+		p->next->prev = p->prev;
+	}
+
+	if (p == m_sensorList)
+	{
+		m_sensorList = p->next;
+	}
+
+	// Remove from body 1
+	if (p->nodeA.prev)
+	{
+		p->nodeA.prev->next = p->nodeA.next;
+	}
+
+	if (p->nodeA.next)
+	{
+		p->nodeA.next->prev = p->nodeA.prev;
+	}
+
+	if (&p->nodeA == bodyA->m_sensorList)
+	{
+		bodyA->m_sensorList = p->nodeA.next;
+	}
+
+	// Remove from body 2
+	if (p->nodeB.prev)
+	{
+		p->nodeB.prev->next = p->nodeB.next;
+	}
+
+	if (p->nodeB.next)
+	{
+		p->nodeB.next->prev = p->nodeB.prev;
+	}
+
+	if (&p->nodeB == bodyB->m_sensorList)
+	{
+		bodyB->m_sensorList = p->nodeB.next;
+	}
+
+	m_allocator->Free(p, sizeof(b2SensorPair));
+	--m_sensorCount;
+}
+
+void b2ContactManager::AddAwakeContact(b2Contact* c)
+{
+	if (c->m_flags & b2Contact::e_awakeListFlag)
+	{
+		return;
+	}
+
+	// The contact was not looked at while it slept, so its TOI state is stale.
+	c->m_flags |= b2Contact::e_awakeListFlag;
+	c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+	c->m_toiCount = 0;
+	c->m_toi = 1.0f;
+
+	c->m_awakePrev = m_awakeContactTail;
+	c->m_awakeNext = NULL;
+	if (m_awakeContactTail != NULL)
+	{
+		m_awakeContactTail->m_awakeNext = c;
+	}
+	else
+	{
+		m_awakeContactList = c;
+	}
+	m_awakeContactTail = c;
+}
+
+void b2ContactManager::RemoveAwakeContact(b2Contact* c)
+{
+	b2Assert(c->m_flags & b2Contact::e_awakeListFlag);
+
+	if (c->m_awakePrev)
+	{
+		c->m_awakePrev->m_awakeNext = c->m_awakeNext;
+	}
+
+	if (c->m_awakeNext)
+	{
+		c->m_awakeNext->m_awakePrev = c->m_awakePrev;
+	}
+
+	if (c == m_awakeContactList)
+	{
+		m_awakeContactList = c->m_awakeNext;
+	}
+
+	if (c == m_awakeContactTail)
+	{
+		m_awakeContactTail = c->m_awakePrev;
+	}
+
+	c->m_awakePrev = NULL;
+	c->m_awakeNext = NULL;
+	c->m_flags &= ~(b2Contact::e_awakeListFlag | b2Contact::e_islandFlag);
+}
+
 // This is the top level collision call for the time step. Here
-// all the narrow phase collision is processed for the world
+// all the narrow phase collision is processed for the awake
 // contact list.
-void b2ContactManager::Collide()
+void b2ContactManager::Collide(float32 speculativeDt)
 {
 	// Update awake contacts.
-	b2Contact* c = m_contactList;
+	b2Contact* c = m_awakeContactList;
 	while (c)
 	{
 		b2Fixture* fixtureA = c->GetFixtureA();
@@ -122,7 +254,7 @@ void b2ContactManager::Collide()
 			if (bodyB->ShouldCollide(bodyA) == false)
 			{
 				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
+				c = cNuke->m_awakeNext;
 				Destroy(cNuke);
 				continue;
 			}
@@ -131,7 +263,7 @@ void b2ContactManager::Collide()
 			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 			{
 				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
+				c = cNuke->m_awakeNext;
 				Destroy(cNuke);
 				continue;
 			}
@@ -144,9 +276,12 @@ void b2ContactManager::Collide()
 		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
 
 		// At least one body must be awake and it must be dynamic or kinematic.
+		// Otherwise both bodies went to sleep and the contact leaves the list.
 		if (activeA == false && activeB == false)
 		{
-			c = c->GetNext();
+			b2Contact* cSleep = c;
+			c = cSleep->m_awakeNext;
+			RemoveAwakeContact(cSleep);
 			continue;
 		}
 
@@ -158,14 +293,95 @@ void b2ContactManager::Collide()
 		if (overlap == false)
 		{
 			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
+			c = cNuke->m_awakeNext;
 			Destroy(cNuke);
 			continue;
 		}
 
 		// The contact persists.
-		c->Update(m_contactListener);
-		c = c->GetNext();
+		c->Update(m_contactListener, speculativeDt);
+		++m_updateCount;
+		c = c->m_awakeNext;
+	}
+
+	CollideSensors();
+}
+
+// Sensor pairs only need a boolean overlap test. This never builds a
+// manifold and never wakes bodies.
+void b2ContactManager::CollideSensors()
+{
+	b2SensorPair* p = m_sensorList;
+	while (p)
+	{
+		b2Fixture* fixtureA = p->fixtureA;
+		b2Fixture* fixtureB = p->fixtureB;
+		int32 indexA = p->indexA;
+		int32 indexB = p->indexB;
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
+
+		// Is this pair flagged for filtering?
+		if (p->flags & b2SensorPair::e_filterFlag)
+		{
+			if (bodyB->ShouldCollide(bodyA) == false ||
+				(m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false))
+			{
+				b2SensorPair* pNuke = p;
+				p = pNuke->next;
+				Destroy(pNuke);
+				continue;
+			}
+
+			p->flags &= ~b2SensorPair::e_filterFlag;
+		}
+
+		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+
+		// At least one body must be awake and it must be dynamic or kinematic.
+		if (activeA == false && activeB == false)
+		{
+			p = p->next;
+			continue;
+		}
+
+		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
+
+		// Destroy pairs that cease to overlap in the broad-phase.
+		if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
+		{
+			b2SensorPair* pNuke = p;
+			p = pNuke->next;
+			Destroy(pNuke);
+			continue;
+		}
+
+		bool wasTouching = (p->flags & b2SensorPair::e_touchingFlag) == b2SensorPair::e_touchingFlag;
+		bool touching = b2TestOverlap(fixtureA->GetShape(), indexA, fixtureB->GetShape(), indexB,
+									  bodyA->GetTransform(), bodyB->GetTransform());
+
+		if (touching)
+		{
+			p->flags |= b2SensorPair::e_touchingFlag;
+		}
+		else
+		{
+			p->flags &= ~b2SensorPair::e_touchingFlag;
+		}
+
+		if (m_contactListener && wasTouching == false && touching == true)
+		{
+			m_contactListener->BeginOverlap(fixtureA, fixtureB);
+		}
+
+		if (m_contactListener && wasTouching == true && touching == false)
+		{
+			m_contactListener->EndOverlap(fixtureA, fixtureB);
+		}
+
+		p = p->next;
 	}
 }
 
@@ -194,6 +410,31 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	// Are these fixtures tracked as a sensor pair?
+	if (fixtureA->IsSensor() || fixtureB->IsSensor())
+	{
+		for (b2SensorEdge* se = bodyB->m_sensorList; se; se = se->next)
+		{
+			if (se->other != bodyA)
+			{
+				continue;
+			}
+
+			b2SensorPair* p = se->pair;
+			if (p->fixtureA == fixtureA && p->fixtureB == fixtureB && p->indexA == indexA && p->indexB == indexB)
+			{
+				// A sensor pair already exists.
+				return;
+			}
+
+			if (p->fixtureA == fixtureB && p->fixtureB == fixtureA && p->indexA == indexB && p->indexB == indexA)
+			{
+				// A sensor pair already exists.
+				return;
+			}
+		}
+	}
+
 	// TODO_ERIN use a hash table to remove a potential bottleneck when both
 	// bodies have a lot of contacts.
 	// Does a contact already exist?
@@ -235,6 +476,13 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	// Sensors only track overlap.
+	if (fixtureA->IsSensor() || fixtureB->IsSensor())
+	{
+		AddSensorPair(fixtureA, indexA, fixtureB, indexB);
+		return;
+	}
+
 	// Call the factory.
 	b2Contact* c = b2Contact::Create(fixtureA, indexA, fixtureB, indexB, m_allocator);
 	if (c == NULL)
@@ -242,6 +490,8 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	++m_createCount;
+
 	// Contact creation may swap fixtures.
 	fixtureA = c->GetFixtureA();
 	fixtureB = c->GetFixtureB();
@@ -289,5 +539,61 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	bodyA->SetAwake(true);
 	bodyB->SetAwake(true);
 
+	AddAwakeContact(c);
+
 	++m_contactCount;
 }
+
+void b2ContactManager::AddSensorPair(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB)
+{
+	// Keep the sensor in slot A.
+	if (fixtureA->IsSensor() == false)
+	{
+		b2Swap(fixtureA, fixtureB);
+		b2Swap(indexA, indexB);
+	}
+
+	b2Body* bodyA = fixtureA->GetBody();
+	b2Body* bodyB = fixtureB->GetBody();
+
+	void* mem = m_allocator->Allocate(sizeof(b2SensorPair));
+	b2SensorPair* p = new (mem) b2SensorPair;
+	p->flags = 0;
+	p->fixtureA = fixtureA;
+	p->fixtureB = fixtureB;
+	p->indexA = indexA;
+	p->indexB = indexB;
+
+	// Insert into the world.
+	p->prev = NULL;
+	p->next = m_sensorList;
+	if (m_sensorList != NULL)
+	{
+		m_sensorList->prev = p;
+	}
+	m_sensorList = p;
+
+	// Connect to body A
+	p->nodeA.pair = p;
+	p->nodeA.other = bodyB;
+	p->nodeA.prev = NULL;
+	p->nodeA.next = bodyA->m_sensorList;
+	if (bodyA->m_sensorList != NULL)
+	{
+		bodyA->m_sensorList->prev = &p->nodeA;
+	}
+	bodyA->m_sensorList = &p->nodeA;
+
+	// Connect to body B
+	p->nodeB.pair = p;
+	p->nodeB.other = bodyA;
+	p->nodeB.prev = NULL;
+	p->nodeB.next = bodyB->m_sensorList;
+	if (bodyB->m_sensorList != NULL)
+	{
+		bodyB->m_sensorList->prev = &p->nodeB;
+	}
+	bodyB->m_sensorList = &p->nodeB;
+
+	++m_sensorCount;
+}
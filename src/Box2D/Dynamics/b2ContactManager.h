@@ -21,16 +21,60 @@
 
 #include <Box2D/Collision/b2BroadPhase.h>
 
+class b2Body;
 class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2Fixture;
+struct b2SensorPair;
+
+/// A sensor edge connects a body to a sensor pair. This mirrors b2ContactEdge,
+/// but sensor pairs are not part of the island graph.
+struct b2SensorEdge
+{
+	b2Body* other;			///< provides quick access to the other body attached.
+	b2SensorPair* pair;		///< the sensor pair
+	b2SensorEdge* prev;		///< the previous sensor edge in the body's sensor list
+	b2SensorEdge* next;		///< the next sensor edge in the body's sensor list
+};
+
+/// A sensor pair tracks the overlap of a sensor fixture with another fixture.
+/// Overlap is found with the fat AABBs and b2TestOverlap, so no manifold is
+/// computed and no b2Contact is created. Sensor pairs never reach the solver
+/// or the TOI loop. Fixture A is always a sensor.
+struct b2SensorPair
+{
+	enum
+	{
+		// Set when the shapes overlap.
+		e_touchingFlag	= 0x0001,
+
+		// This pair needs filtering because a fixture filter was changed.
+		e_filterFlag	= 0x0002
+	};
+
+	uint32 flags;
+
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	int32 indexA;
+	int32 indexB;
+
+	// World list pointers.
+	b2SensorPair* prev;
+	b2SensorPair* next;
+
+	// Nodes for connecting bodies.
+	b2SensorEdge nodeA;
+	b2SensorEdge nodeB;
+};
 
 // Delegate of b2World.
 class b2ContactManager
 {
 public:
-	b2ContactManager();
+	b2ContactManager(b2Allocator* allocator = NULL);
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -38,15 +82,38 @@ public:
 	void FindNewContacts();
 
 	void Destroy(b2Contact* c);
+	void Destroy(b2SensorPair* p);
 
-	void Collide();
+	// Update the awake contacts. A positive speculativeDt enables speculative
+	// points for contacts whose shapes may touch within that time.
+	void Collide(float32 speculativeDt);
+
+	// Contacts with at least one awake, non-static body are kept on the awake
+	// list. Adding is done when a body wakes. Removal is lazy: Collide drops
+	// contacts whose bodies have both gone to sleep. Contacts are appended, so
+	// bodies woken during Collide still get their contacts updated.
+	void AddAwakeContact(b2Contact* c);
+	void RemoveAwakeContact(b2Contact* c);
+
+	// Sensor fixtures are tracked with sensor pairs instead of contacts.
+	void AddSensorPair(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
+	void CollideSensors();
             
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
 	int32 m_contactCount;
+	b2Contact* m_awakeContactList;
+	b2Contact* m_awakeContactTail;
+	b2SensorPair* m_sensorList;
+	int32 m_sensorCount;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+
+	// Work counters for b2Profile. The world resets them when a step starts.
+	int32 m_createCount;
+	int32 m_destroyCount;
+	int32 m_updateCount;
 };
 
 #endif
@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2FixedStepper.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2World.h>
+
+b2FixedStepper::b2FixedStepper(b2World* world, float32 timeStep, int32 velocityIterations,
+							   int32 positionIterations, int32 maxSubSteps)
+{
+	b2Assert(timeStep > 0.0f);
+	b2Assert(maxSubSteps > 0);
+
+	m_world = world;
+	m_timeStep = timeStep;
+	m_velocityIterations = velocityIterations;
+	m_positionIterations = positionIterations;
+	m_maxSubSteps = maxSubSteps;
+
+	m_accumulator = 0.0f;
+	m_stepCount = 0;
+}
+
+int32 b2FixedStepper::Advance(float32 elapsedTime)
+{
+	b2Assert(m_world->IsLocked() == false);
+
+	if (elapsedTime > 0.0f)
+	{
+		m_accumulator += elapsedTime;
+	}
+
+	int32 count = (int32)(m_accumulator / m_timeStep);
+	if (count > m_maxSubSteps)
+	{
+		// Fall behind instead of spiralling: keep only the step phase.
+		count = m_maxSubSteps;
+		m_accumulator = count * m_timeStep + fmodf(m_accumulator, m_timeStep);
+	}
+
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	bool autoClearForces = m_world->GetAutoClearForces();
+	m_world->SetAutoClearForces(false);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (i == count - 1)
+		{
+			SavePreviousState();
+		}
+
+		m_world->Step(m_timeStep, m_velocityIterations, m_positionIterations);
+		m_accumulator -= m_timeStep;
+	}
+
+	m_world->ClearForces();
+	m_world->SetAutoClearForces(autoClearForces);
+
+	// Rounding can leave the accumulator just outside [0, timeStep).
+	m_accumulator = b2Clamp(m_accumulator, 0.0f, m_timeStep * (1.0f - b2_epsilon));
+
+	m_stepCount += count;
+	return count;
+}
+
+// Sleeping and static bodies are saved too, so that a body that falls asleep
+// in the last step does not blend from a stale position.
+void b2FixedStepper::SavePreviousState()
+{
+	for (b2Body* b = m_world->GetBodyList(); b; b = b->GetNext())
+	{
+		b->m_prevPosition = b->m_sim->xf.p;
+		b->m_prevAngle = b->m_sim->sweep.a;
+	}
+}
+
+b2Vec2 b2FixedStepper::GetInterpolatedPosition(const b2Body* body) const
+{
+	float32 alpha = GetAlpha();
+	return (1.0f - alpha) * body->m_prevPosition + alpha * body->m_sim->xf.p;
+}
+
+float32 b2FixedStepper::GetInterpolatedAngle(const b2Body* body) const
+{
+	float32 alpha = GetAlpha();
+	return (1.0f - alpha) * body->m_prevAngle + alpha * body->m_sim->sweep.a;
+}
+
+b2Transform b2FixedStepper::GetInterpolatedTransform(const b2Body* body) const
+{
+	return b2Transform(GetInterpolatedPosition(body), b2Rot(GetInterpolatedAngle(body)));
+}
@@ -0,0 +1,107 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_FIXED_STEPPER_H
+#define B2_FIXED_STEPPER_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2World;
+class b2Body;
+
+/// Steps a world with a fixed time step from a variable frame time.
+/// Elapsed time is collected in an accumulator and consumed in whole steps,
+/// so the simulation runs at the same rate whatever the frame rate. Forces
+/// applied before Advance act on every step of that call and are cleared
+/// after the last one, or kept for the next call if no step was taken.
+/// The leftover time gives an interpolation factor, and
+/// the body positions before the last step are kept so that rendering can
+/// blend between the last two steps.
+class b2FixedStepper
+{
+public:
+	/// @param world the world to step. It must outlive the stepper.
+	/// @param timeStep the fixed time step in seconds.
+	/// @param velocityIterations passed to b2World::Step.
+	/// @param positionIterations passed to b2World::Step.
+	/// @param maxSubSteps the most steps taken by one Advance. Time beyond
+	/// that is dropped, so a slow frame cannot cause ever slower frames.
+	b2FixedStepper(b2World* world, float32 timeStep, int32 velocityIterations,
+					int32 positionIterations, int32 maxSubSteps);
+
+	/// Add elapsed real time and take as many fixed steps as it covers.
+	/// @return the number of steps taken, in [0, maxSubSteps].
+	int32 Advance(float32 elapsedTime);
+
+	/// Drop the accumulated time.
+	void Reset();
+
+	/// Get the fraction of a step left in the accumulator, in [0, 1).
+	/// Render at prev + alpha * (current - prev).
+	float32 GetAlpha() const;
+
+	/// Get the body origin blended between the last two steps.
+	b2Vec2 GetInterpolatedPosition(const b2Body* body) const;
+
+	/// Get the body angle blended between the last two steps.
+	float32 GetInterpolatedAngle(const b2Body* body) const;
+
+	/// Get the body transform blended between the last two steps.
+	b2Transform GetInterpolatedTransform(const b2Body* body) const;
+
+	/// Get the fixed time step.
+	float32 GetTimeStep() const;
+
+	/// Get the number of steps taken since construction.
+	int32 GetStepCount() const;
+
+private:
+
+	void SavePreviousState();
+
+	b2World* m_world;
+	float32 m_timeStep;
+	int32 m_velocityIterations;
+	int32 m_positionIterations;
+	int32 m_maxSubSteps;
+
+	float32 m_accumulator;
+	int32 m_stepCount;
+};
+
+inline void b2FixedStepper::Reset()
+{
+	m_accumulator = 0.0f;
+}
+
+inline float32 b2FixedStepper::GetAlpha() const
+{
+	return m_accumulator / m_timeStep;
+}
+
+inline float32 b2FixedStepper::GetTimeStep() const
+{
+	return m_timeStep;
+}
+
+inline int32 b2FixedStepper::GetStepCount() const
+{
+	return m_stepCount;
+}
+
+#endif
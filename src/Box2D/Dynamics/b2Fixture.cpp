@@ -26,6 +26,7 @@
 #include <Box2D/Collision/b2BroadPhase.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Stream.h>
 
 b2Fixture::b2Fixture()
 {
@@ -177,9 +178,19 @@ void b2Fixture::SetFilterData(const b2Filter& filter)
 {
 	m_filter = filter;
 
+	if (m_body != NULL && (m_body->m_flags & b2Body::e_recordFlag) != 0)
+	{
+		RecordChange(true);
+	}
+
 	Refilter();
 }
 
+void b2Fixture::RecordChange(bool refilter)
+{
+	m_body->m_world->m_recorder->RecordFixture(this, refilter);
+}
+
 void b2Fixture::Refilter()
 {
 	if (m_body == NULL)
@@ -202,6 +213,16 @@ void b2Fixture::Refilter()
 		edge = edge->next;
 	}
 
+	// Flag associated sensor pairs for filtering.
+	for (b2SensorEdge* se = m_body->m_sensorList; se; se = se->next)
+	{
+		b2SensorPair* p = se->pair;
+		if (p->fixtureA == this || p->fixtureB == this)
+		{
+			p->flags |= b2SensorPair::e_filterFlag;
+		}
+	}
+
 	b2World* world = m_body->GetWorld();
 
 	if (world == NULL)
@@ -219,10 +240,59 @@ void b2Fixture::Refilter()
 
 void b2Fixture::SetSensor(bool sensor)
 {
-	if (sensor != m_isSensor)
+	if (sensor == m_isSensor)
 	{
-		m_body->SetAwake(true);
-		m_isSensor = sensor;
+		return;
+	}
+
+	m_isSensor = sensor;
+
+	if (m_body == NULL)
+	{
+		return;
+	}
+
+	if ((m_body->m_flags & b2Body::e_recordFlag) != 0)
+	{
+		RecordChange(false);
+	}
+
+	b2World* world = m_body->GetWorld();
+	b2Assert(world->IsLocked() == false);
+
+	m_body->SetAwake(true);
+
+	// Sensors are tracked with sensor pairs, solid fixtures with contacts.
+	// Destroy the old kind of pair and let the broad-phase find them again.
+	b2ContactManager* contactManager = &world->m_contactManager;
+
+	b2ContactEdge* edge = m_body->GetContactList();
+	while (edge)
+	{
+		b2Contact* c = edge->contact;
+		edge = edge->next;
+
+		if (c->GetFixtureA() == this || c->GetFixtureB() == this)
+		{
+			contactManager->Destroy(c);
+		}
+	}
+
+	b2SensorEdge* se = m_body->m_sensorList;
+	while (se)
+	{
+		b2SensorPair* p = se->pair;
+		se = se->next;
+
+		if (p->fixtureA == this || p->fixtureB == this)
+		{
+			contactManager->Destroy(p);
+		}
+	}
+
+	for (int32 i = 0; i < m_proxyCount; ++i)
+	{
+		contactManager->m_broadPhase.TouchProxy(m_proxies[i].proxyId);
 	}
 }
 
@@ -301,3 +371,143 @@ void b2Fixture::Dump(int32 bodyIndex)
 	b2Log("\n");
 	b2Log("    bodies[%d]->CreateFixture(&fd);\n", bodyIndex);
 }
+
+void b2SaveShape(b2StreamWriter* writer, const b2Shape* shape)
+{
+	writer->Write(int32(shape->m_type));
+	writer->Write(shape->m_radius);
+
+	switch (shape->m_type)
+	{
+	case b2Shape::e_circle:
+		{
+			const b2CircleShape* s = (const b2CircleShape*)shape;
+			writer->Write(s->m_p);
+		}
+		break;
+
+	case b2Shape::e_edge:
+		{
+			const b2EdgeShape* s = (const b2EdgeShape*)shape;
+			writer->Write(s->m_vertex0);
+			writer->Write(s->m_vertex1);
+			writer->Write(s->m_vertex2);
+			writer->Write(s->m_vertex3);
+			writer->Write(uint8(s->m_hasVertex0));
+			writer->Write(uint8(s->m_hasVertex3));
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			const b2PolygonShape* s = (const b2PolygonShape*)shape;
+			writer->Write(s->m_vertexCount);
+			writer->Write(s->m_centroid);
+			writer->Write(s->m_vertices, s->m_vertexCount * sizeof(b2Vec2));
+			writer->Write(s->m_normals, s->m_vertexCount * sizeof(b2Vec2));
+		}
+		break;
+
+	case b2Shape::e_chain:
+		{
+			const b2ChainShape* s = (const b2ChainShape*)shape;
+			writer->Write(s->m_count);
+			writer->Write(s->m_vertices, s->m_count * sizeof(b2Vec2));
+			writer->Write(s->m_prevVertex);
+			writer->Write(s->m_nextVertex);
+			writer->Write(uint8(s->m_hasPrevVertex));
+			writer->Write(uint8(s->m_hasNextVertex));
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+bool b2LoadShape(b2StreamReader* reader, b2FixtureDef* def,
+				 b2CircleShape* circle, b2EdgeShape* edge,
+				 b2PolygonShape* polygon, b2ChainShape* chain)
+{
+	int32 type;
+	float32 radius;
+	reader->Read(&type);
+	reader->Read(&radius);
+	if (reader->IsOk() == false)
+	{
+		return false;
+	}
+
+	switch (type)
+	{
+	case b2Shape::e_circle:
+		circle->m_radius = radius;
+		reader->Read(&circle->m_p);
+		def->shape = circle;
+		break;
+
+	case b2Shape::e_edge:
+		{
+			uint8 hasVertex0, hasVertex3;
+			edge->m_radius = radius;
+			reader->Read(&edge->m_vertex0);
+			reader->Read(&edge->m_vertex1);
+			reader->Read(&edge->m_vertex2);
+			reader->Read(&edge->m_vertex3);
+			reader->Read(&hasVertex0);
+			reader->Read(&hasVertex3);
+			edge->m_hasVertex0 = hasVertex0 != 0;
+			edge->m_hasVertex3 = hasVertex3 != 0;
+			def->shape = edge;
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			int32 count;
+			reader->Read(&count);
+			if (count < 0 || count > b2_maxPolygonVertices)
+			{
+				return false;
+			}
+			polygon->m_radius = radius;
+			polygon->m_vertexCount = count;
+			reader->Read(&polygon->m_centroid);
+			reader->Read(polygon->m_vertices, count * sizeof(b2Vec2));
+			reader->Read(polygon->m_normals, count * sizeof(b2Vec2));
+			def->shape = polygon;
+		}
+		break;
+
+	case b2Shape::e_chain:
+		{
+			int32 count;
+			reader->Read(&count);
+			if (count < 2 || count > reader->GetRemaining() / int32(sizeof(b2Vec2)))
+			{
+				return false;
+			}
+
+			// The chain frees its vertices when it goes out of scope.
+			uint8 hasPrevVertex, hasNextVertex;
+			chain->m_radius = radius;
+			chain->m_vertices = (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+			chain->m_count = count;
+			reader->Read(chain->m_vertices, count * sizeof(b2Vec2));
+			reader->Read(&chain->m_prevVertex);
+			reader->Read(&chain->m_nextVertex);
+			reader->Read(&hasPrevVertex);
+			reader->Read(&hasNextVertex);
+			chain->m_hasPrevVertex = hasPrevVertex != 0;
+			chain->m_hasNextVertex = hasNextVertex != 0;
+			def->shape = chain;
+		}
+		break;
+
+	default:
+		return false;
+	}
+
+	return reader->IsOk();
+}
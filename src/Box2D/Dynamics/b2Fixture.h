@@ -27,6 +27,12 @@ class b2BlockAllocator;
 class b2Body;
 class b2BroadPhase;
 class b2Fixture;
+class b2StreamWriter;
+class b2StreamReader;
+class b2CircleShape;
+class b2EdgeShape;
+class b2PolygonShape;
+class b2ChainShape;
 
 /// This holds contact filtering data.
 struct b2Filter
@@ -82,8 +88,9 @@ struct b2FixtureDef
 	/// The density, usually in kg/m^2.
 	float32 density;
 
-	/// A sensor shape collects contact information but never generates a collision
-	/// response.
+	/// A sensor shape collects overlap information but never generates a collision
+	/// response. Sensors do not create contacts; overlaps are reported through
+	/// b2ContactListener::BeginOverlap/EndOverlap.
 	bool isSensor;
 
 	/// Contact filtering data.
@@ -99,6 +106,15 @@ struct b2FixtureProxy
 	int32 proxyId;
 };
 
+/// Write a shape to a stream. This is used by snapshots and recordings.
+void b2SaveShape(b2StreamWriter* writer, const b2Shape* shape);
+
+/// Read a shape written by b2SaveShape into the matching local shape and
+/// point the definition at it.
+bool b2LoadShape(b2StreamReader* reader, b2FixtureDef* def,
+				 b2CircleShape* circle, b2EdgeShape* edge,
+				 b2PolygonShape* polygon, b2ChainShape* chain);
+
 /// A fixture is used to attach a shape to a body for collision detection. A fixture
 /// inherits its transform from its parent. Fixtures hold additional non-geometric data
 /// such as friction, collision filters, etc.
@@ -117,7 +133,9 @@ public:
 	b2Shape* GetShape();
 	const b2Shape* GetShape() const;
 
-	/// Set if this fixture is a sensor.
+	/// Set if this fixture is a sensor. This drops the existing contacts
+	/// (or sensor pairs) of this fixture; they are found again on the next step.
+	/// @warning This function is locked during callbacks.
 	void SetSensor(bool sensor);
 
 	/// Is this fixture a sensor (non-solid)?
@@ -201,6 +219,7 @@ protected:
 	friend class b2World;
 	friend class b2Contact;
 	friend class b2ContactManager;
+	friend class b2FixtureBatch;
 
 	b2Fixture();
 
@@ -215,6 +234,10 @@ protected:
 
 	void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2);
 
+	// Pass the fixture settings to the world's recorder. Refilter is set
+	// by SetFilterData, which also touches the proxies.
+	void RecordChange(bool refilter);
+
 	float32 m_density;
 
 	b2Fixture* m_next;
@@ -294,6 +317,11 @@ inline void b2Fixture::SetDensity(float32 density)
 {
 	b2Assert(b2IsValid(density) && density >= 0.0f);
 	m_density = density;
+
+	if (m_body != NULL && (m_body->m_flags & b2Body::e_recordFlag) != 0)
+	{
+		RecordChange(false);
+	}
 }
 
 inline float32 b2Fixture::GetDensity() const
@@ -309,6 +337,11 @@ inline float32 b2Fixture::GetFriction() const
 inline void b2Fixture::SetFriction(float32 friction)
 {
 	m_friction = friction;
+
+	if (m_body != NULL && (m_body->m_flags & b2Body::e_recordFlag) != 0)
+	{
+		RecordChange(false);
+	}
 }
 
 inline float32 b2Fixture::GetRestitution() const
@@ -319,6 +352,11 @@ inline float32 b2Fixture::GetRestitution() const
 inline void b2Fixture::SetRestitution(float32 restitution)
 {
 	m_restitution = restitution;
+
+	if (m_body != NULL && (m_body->m_flags & b2Body::e_recordFlag) != 0)
+	{
+		RecordChange(false);
+	}
 }
 
 inline bool b2Fixture::TestPoint(const b2Vec2& p) const
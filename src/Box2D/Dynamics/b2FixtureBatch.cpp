@@ -0,0 +1,382 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2FixtureBatch.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2Simd.h>
+
+#if B2_SIMD_WIDTH > 0
+const int32 b2_batchWidth = B2_SIMD_WIDTH;
+#else
+const int32 b2_batchWidth = 1;
+#endif
+
+// Rows after the points.
+enum
+{
+	e_radiusRow,
+	e_c1Row, e_s1Row, e_x1Row, e_y1Row,
+	e_c2Row, e_s2Row, e_x2Row, e_y2Row
+};
+
+b2FixtureBatch::b2FixtureBatch(b2StackAllocator* allocator)
+{
+	m_allocator = allocator;
+
+	for (int32 i = 0; i < e_groupCount; ++i)
+	{
+		b2ProxyGroup* group = m_groups + i;
+		group->count = 0;
+		group->capacity = 0;
+		group->pointCount = 0;
+		group->rows = NULL;
+		group->proxies = NULL;
+	}
+
+	m_groups[e_circleGroup].pointCount = 1;
+	m_groups[e_segmentGroup].pointCount = 2;
+	m_groups[e_polygonGroup].pointCount = 1;
+
+	m_moved = NULL;
+	m_movedCount = 0;
+	m_movedCapacity = 0;
+}
+
+b2FixtureBatch::~b2FixtureBatch()
+{
+	// Stack order.
+	for (int32 i = e_groupCount - 1; i >= 0; --i)
+	{
+		b2ProxyGroup* group = m_groups + i;
+		if (group->rows != NULL)
+		{
+			m_allocator->Free(group->proxies);
+			m_allocator->Free(group->rows);
+		}
+	}
+
+	if (m_moved != NULL)
+	{
+		m_allocator->Free(m_moved);
+	}
+}
+
+void b2FixtureBatch::Count(const b2Body* body)
+{
+	for (const b2Fixture* f = body->m_fixtureList; f; f = f->m_next)
+	{
+		if (f->m_proxyCount == 0)
+		{
+			continue;
+		}
+
+		const b2Shape* shape = f->m_shape;
+		switch (shape->GetType())
+		{
+		case b2Shape::e_circle:
+			m_groups[e_circleGroup].capacity += f->m_proxyCount;
+			break;
+
+		case b2Shape::e_edge:
+		case b2Shape::e_chain:
+			m_groups[e_segmentGroup].capacity += f->m_proxyCount;
+			break;
+
+		case b2Shape::e_polygon:
+			{
+				b2ProxyGroup* group = m_groups + e_polygonGroup;
+				group->capacity += f->m_proxyCount;
+				group->pointCount = b2Max(group->pointCount, ((const b2PolygonShape*)shape)->m_vertexCount);
+			}
+			break;
+
+		default:
+			b2Assert(false);
+			break;
+		}
+
+		m_movedCapacity += f->m_proxyCount;
+	}
+}
+
+void b2FixtureBatch::Allocate()
+{
+	if (m_movedCapacity > 0)
+	{
+		m_moved = (b2MovedProxy*)m_allocator->Allocate(m_movedCapacity * sizeof(b2MovedProxy));
+	}
+
+	for (int32 i = 0; i < e_groupCount; ++i)
+	{
+		b2ProxyGroup* group = m_groups + i;
+		if (group->capacity == 0)
+		{
+			continue;
+		}
+
+		group->capacity = b2_batchWidth * ((group->capacity + b2_batchWidth - 1) / b2_batchWidth);
+		group->rows = (float32*)m_allocator->Allocate(GetRowCount(*group) * group->capacity * sizeof(float32));
+		group->proxies = (b2FixtureProxy**)m_allocator->Allocate(group->capacity * sizeof(b2FixtureProxy*));
+	}
+}
+
+void b2FixtureBatch::AddProxy(int32 groupIndex, b2FixtureProxy* proxy, const b2Vec2* points, int32 count,
+							  float32 radius, const b2Transform& xf1, const b2Transform& xf2)
+{
+	b2ProxyGroup* group = m_groups + groupIndex;
+	b2Assert(group->count < group->capacity);
+	b2Assert(count <= group->pointCount);
+
+	int32 lane = group->count++;
+	int32 stride = group->capacity;
+	float32* column = group->rows + lane;
+
+	// Short polygons repeat their first vertex, which leaves the bounds alone.
+	for (int32 i = 0; i < group->pointCount; ++i)
+	{
+		const b2Vec2& p = points[i < count ? i : 0];
+		column[(2 * i + 0) * stride] = p.x;
+		column[(2 * i + 1) * stride] = p.y;
+	}
+
+	float32* tail = column + 2 * group->pointCount * stride;
+	tail[e_radiusRow * stride] = radius;
+	tail[e_c1Row * stride] = xf1.q.c;
+	tail[e_s1Row * stride] = xf1.q.s;
+	tail[e_x1Row * stride] = xf1.p.x;
+	tail[e_y1Row * stride] = xf1.p.y;
+	tail[e_c2Row * stride] = xf2.q.c;
+	tail[e_s2Row * stride] = xf2.q.s;
+	tail[e_x2Row * stride] = xf2.p.x;
+	tail[e_y2Row * stride] = xf2.p.y;
+
+	group->proxies[lane] = proxy;
+}
+
+void b2FixtureBatch::Add(b2Body* body, const b2Transform& xf1, const b2Transform& xf2)
+{
+	b2Vec2 displacement = xf2.p - xf1.p;
+
+	for (b2Fixture* f = body->m_fixtureList; f; f = f->m_next)
+	{
+		const b2Shape* shape = f->m_shape;
+		for (int32 i = 0; i < f->m_proxyCount; ++i)
+		{
+			b2FixtureProxy* proxy = f->m_proxies + i;
+
+			switch (shape->GetType())
+			{
+			case b2Shape::e_circle:
+				{
+					const b2CircleShape* circle = (const b2CircleShape*)shape;
+					AddProxy(e_circleGroup, proxy, &circle->m_p, 1, circle->m_radius, xf1, xf2);
+				}
+				break;
+
+			case b2Shape::e_edge:
+				{
+					const b2EdgeShape* edge = (const b2EdgeShape*)shape;
+					b2Vec2 points[2] = {edge->m_vertex1, edge->m_vertex2};
+					AddProxy(e_segmentGroup, proxy, points, 2, edge->m_radius, xf1, xf2);
+				}
+				break;
+
+			case b2Shape::e_chain:
+				{
+					// Chain segments have no radius in their AABB.
+					const b2ChainShape* chain = (const b2ChainShape*)shape;
+					int32 i1 = proxy->childIndex;
+					int32 i2 = i1 + 1 < chain->m_count ? i1 + 1 : 0;
+					b2Vec2 points[2] = {chain->m_vertices[i1], chain->m_vertices[i2]};
+					AddProxy(e_segmentGroup, proxy, points, 2, 0.0f, xf1, xf2);
+				}
+				break;
+
+			case b2Shape::e_polygon:
+				{
+					const b2PolygonShape* polygon = (const b2PolygonShape*)shape;
+					AddProxy(e_polygonGroup, proxy, polygon->m_vertices, polygon->m_vertexCount, polygon->m_radius, xf1, xf2);
+				}
+				break;
+
+			default:
+				b2Assert(false);
+				break;
+			}
+
+			b2Assert(m_movedCount < m_movedCapacity);
+			b2MovedProxy* moved = m_moved + m_movedCount++;
+			moved->proxy = proxy;
+			moved->displacement = displacement;
+		}
+	}
+}
+
+#if B2_SIMD_WIDTH > 0
+
+// The AABB of the points of W proxies under one transform. This does the
+// same operations as b2Shape::ComputeAABB, so the results are identical.
+static void b2ComputeBoundsW(const float32* rows, int32 stride, int32 pointCount,
+							 b2FloatW c, b2FloatW s, b2FloatW x, b2FloatW y, b2FloatW radius,
+							 b2FloatW* lowerX, b2FloatW* lowerY, b2FloatW* upperX, b2FloatW* upperY)
+{
+	b2FloatW px = b2LoadW(rows);
+	b2FloatW py = b2LoadW(rows + stride);
+	b2FloatW vx = b2AddW(b2SubW(b2MulW(c, px), b2MulW(s, py)), x);
+	b2FloatW vy = b2AddW(b2AddW(b2MulW(s, px), b2MulW(c, py)), y);
+	b2FloatW lx = vx, ly = vy, ux = vx, uy = vy;
+
+	for (int32 i = 1; i < pointCount; ++i)
+	{
+		px = b2LoadW(rows + (2 * i + 0) * stride);
+		py = b2LoadW(rows + (2 * i + 1) * stride);
+		vx = b2AddW(b2SubW(b2MulW(c, px), b2MulW(s, py)), x);
+		vy = b2AddW(b2AddW(b2MulW(s, px), b2MulW(c, py)), y);
+		lx = b2MinW(lx, vx);
+		ly = b2MinW(ly, vy);
+		ux = b2MaxW(ux, vx);
+		uy = b2MaxW(uy, vy);
+	}
+
+	*lowerX = b2SubW(lx, radius);
+	*lowerY = b2SubW(ly, radius);
+	*upperX = b2AddW(ux, radius);
+	*upperY = b2AddW(uy, radius);
+}
+
+void b2FixtureBatch::ComputeAABBs(b2ProxyGroup* group)
+{
+	int32 stride = group->capacity;
+	int32 pointCount = group->pointCount;
+
+	// Fill the padding lanes with the last proxy so they compute something sane.
+	int32 rowCount = GetRowCount(*group);
+	for (int32 lane = group->count; lane < group->capacity; ++lane)
+	{
+		for (int32 row = 0; row < rowCount; ++row)
+		{
+			group->rows[row * stride + lane] = group->rows[row * stride + group->count - 1];
+		}
+	}
+
+	for (int32 base = 0; base < group->count; base += B2_SIMD_WIDTH)
+	{
+		const float32* points = group->rows + base;
+		const float32* tail = points + 2 * pointCount * stride;
+
+		b2FloatW radius = b2LoadW(tail + e_radiusRow * stride);
+		b2FloatW c1 = b2LoadW(tail + e_c1Row * stride);
+		b2FloatW s1 = b2LoadW(tail + e_s1Row * stride);
+		b2FloatW x1 = b2LoadW(tail + e_x1Row * stride);
+		b2FloatW y1 = b2LoadW(tail + e_y1Row * stride);
+		b2FloatW c2 = b2LoadW(tail + e_c2Row * stride);
+		b2FloatW s2 = b2LoadW(tail + e_s2Row * stride);
+		b2FloatW x2 = b2LoadW(tail + e_x2Row * stride);
+		b2FloatW y2 = b2LoadW(tail + e_y2Row * stride);
+
+		b2FloatW lx1, ly1, ux1, uy1;
+		b2FloatW lx2, ly2, ux2, uy2;
+		b2ComputeBoundsW(points, stride, pointCount, c1, s1, x1, y1, radius, &lx1, &ly1, &ux1, &uy1);
+		b2ComputeBoundsW(points, stride, pointCount, c2, s2, x2, y2, radius, &lx2, &ly2, &ux2, &uy2);
+
+		// b2AABB::Combine
+		float32 lowerX[B2_SIMD_WIDTH], lowerY[B2_SIMD_WIDTH];
+		float32 upperX[B2_SIMD_WIDTH], upperY[B2_SIMD_WIDTH];
+		b2StoreW(lowerX, b2MinW(lx1, lx2));
+		b2StoreW(lowerY, b2MinW(ly1, ly2));
+		b2StoreW(upperX, b2MaxW(ux1, ux2));
+		b2StoreW(upperY, b2MaxW(uy1, uy2));
+
+		int32 laneCount = b2Min(B2_SIMD_WIDTH, group->count - base);
+		for (int32 j = 0; j < laneCount; ++j)
+		{
+			b2AABB& aabb = group->proxies[base + j]->aabb;
+			aabb.lowerBound.Set(lowerX[j], lowerY[j]);
+			aabb.upperBound.Set(upperX[j], upperY[j]);
+		}
+	}
+}
+
+#else
+
+void b2FixtureBatch::ComputeAABBs(b2ProxyGroup* group)
+{
+	int32 stride = group->capacity;
+	int32 pointCount = group->pointCount;
+
+	for (int32 lane = 0; lane < group->count; ++lane)
+	{
+		const float32* points = group->rows + lane;
+		const float32* tail = points + 2 * pointCount * stride;
+		b2Vec2 r(tail[e_radiusRow * stride], tail[e_radiusRow * stride]);
+
+		b2Transform xfs[2];
+		xfs[0].q.c = tail[e_c1Row * stride];
+		xfs[0].q.s = tail[e_s1Row * stride];
+		xfs[0].p.Set(tail[e_x1Row * stride], tail[e_y1Row * stride]);
+		xfs[1].q.c = tail[e_c2Row * stride];
+		xfs[1].q.s = tail[e_s2Row * stride];
+		xfs[1].p.Set(tail[e_x2Row * stride], tail[e_y2Row * stride]);
+
+		b2AABB aabbs[2];
+		for (int32 k = 0; k < 2; ++k)
+		{
+			b2Vec2 lower = b2Mul(xfs[k], b2Vec2(points[0], points[stride]));
+			b2Vec2 upper = lower;
+			for (int32 i = 1; i < pointCount; ++i)
+			{
+				b2Vec2 v = b2Mul(xfs[k], b2Vec2(points[(2 * i + 0) * stride], points[(2 * i + 1) * stride]));
+				lower = b2Min(lower, v);
+				upper = b2Max(upper, v);
+			}
+
+			aabbs[k].lowerBound = lower - r;
+			aabbs[k].upperBound = upper + r;
+		}
+
+		group->proxies[lane]->aabb.Combine(aabbs[0], aabbs[1]);
+	}
+}
+
+#endif
+
+void b2FixtureBatch::Synchronize(b2BroadPhase* broadPhase)
+{
+	for (int32 i = 0; i < e_groupCount; ++i)
+	{
+		if (m_groups[i].count > 0)
+		{
+			ComputeAABBs(m_groups + i);
+		}
+	}
+
+	// Move in the order of b2Body::SynchronizeFixtures, which sets the order
+	// of the new pairs.
+	for (int32 i = 0; i < m_movedCount; ++i)
+	{
+		const b2MovedProxy* moved = m_moved + i;
+		broadPhase->MoveProxy(moved->proxy->proxyId, moved->proxy->aabb, moved->displacement);
+	}
+}
@@ -0,0 +1,95 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_FIXTURE_BATCH_H
+#define B2_FIXTURE_BATCH_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Body;
+class b2BroadPhase;
+class b2StackAllocator;
+struct b2FixtureProxy;
+
+/// Synchronizes the proxies of many moved bodies with the broad-phase at
+/// once. The proxies are gathered by shape type into structure of arrays
+/// form, their swept AABBs are computed several at a time with b2Simd.h and
+/// then the proxies are moved in the order they were added. This gives the
+/// same AABBs and pairs as b2Body::SynchronizeFixtures.
+/// Usage: Count every body, Allocate, Add every body, Synchronize.
+class b2FixtureBatch
+{
+public:
+	b2FixtureBatch(b2StackAllocator* allocator);
+	~b2FixtureBatch();
+
+	/// Count the proxies of a body.
+	void Count(const b2Body* body);
+
+	/// Allocate room for the counted proxies.
+	void Allocate();
+
+	/// Add the proxies of a counted body, swept from xf1 to xf2.
+	void Add(b2Body* body, const b2Transform& xf1, const b2Transform& xf2);
+
+	/// Compute the swept AABBs and move the proxies.
+	void Synchronize(b2BroadPhase* broadPhase);
+
+private:
+
+	// Proxies of one shape type. Each row holds one float per proxy, padded
+	// to the SIMD width: the local points, the radius, then both transforms.
+	struct b2ProxyGroup
+	{
+		int32 count;
+		int32 capacity;
+		int32 pointCount;
+		float32* rows;
+		b2FixtureProxy** proxies;
+	};
+
+	// A proxy in the order it was added.
+	struct b2MovedProxy
+	{
+		b2FixtureProxy* proxy;
+		b2Vec2 displacement;
+	};
+
+	enum
+	{
+		e_circleGroup,
+		e_segmentGroup,		// edges and chain segments
+		e_polygonGroup,
+		e_groupCount
+	};
+
+	int32 GetRowCount(const b2ProxyGroup& group) const { return 2 * group.pointCount + 9; }
+	void AddProxy(int32 groupIndex, b2FixtureProxy* proxy, const b2Vec2* points, int32 count,
+				  float32 radius, const b2Transform& xf1, const b2Transform& xf2);
+	void ComputeAABBs(b2ProxyGroup* group);
+
+	b2StackAllocator* m_allocator;
+
+	b2ProxyGroup m_groups[e_groupCount];
+
+	b2MovedProxy* m_moved;
+	int32 m_movedCount;
+	int32 m_movedCapacity;
+};
+
+#endif
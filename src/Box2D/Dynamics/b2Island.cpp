@@ -25,6 +25,7 @@
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2ThreadPool.h>
 #include <Box2D/Common/b2Timer.h>
 
 /*
@@ -145,7 +146,148 @@ This might be faster than computing sin+cos.
 However, we can compute sin+cos of the same angle fast.
 */
 
+/// Solves the contacts of one island with one item per pool thread. Each graph
+/// color is split evenly between the items and followed by a barrier, so the
+/// result does not depend on timing. Item 0 also solves the joints and the
+/// overflow constraints, in the same order as the sequential solver.
+class b2ColoredSolverTask : public b2Task
+{
+public:
+	b2ColoredSolverTask(int32 threadCount) : barrier(threadCount)
+	{
+		this->threadCount = threadCount;
+	}
+
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		if (solvePositions)
+		{
+			SolvePositions(index);
+		}
+		else
+		{
+			SolveVelocities(index);
+		}
+	}
+
+	void GetRange(int32 color, int32 index, int32* begin, int32* end) const
+	{
+		int32 first = contactSolver->m_colorStarts[color];
+		int32 count = contactSolver->m_colorStarts[color + 1] - first;
+		*begin = first + (count * index) / threadCount;
+		*end = first + (count * (index + 1)) / threadCount;
+	}
+
+	void SolveOverflow()
+	{
+		contactSolver->SolveVelocityConstraints(contactSolver->m_colorStarts[b2_graphColorCount], contactSolver->m_count);
+	}
+
+	void SolveVelocities(int32 index)
+	{
+		for (int32 i = 0; i < solverData->step.velocityIterations; ++i)
+		{
+			if (index == 0)
+			{
+				if (i > 0)
+				{
+					SolveOverflow();
+				}
+
+				island->SolveJointVelocityConstraints(*solverData);
+			}
+
+			barrier.Wait();
+
+			for (int32 color = 0; color < b2_graphColorCount; ++color)
+			{
+				contactSolver->SolveColorVelocityConstraints(color, index, threadCount);
+				barrier.Wait();
+			}
+		}
+
+		if (index == 0 && solverData->step.velocityIterations > 0)
+		{
+			SolveOverflow();
+		}
+	}
+
+	void SolvePositions(int32 index)
+	{
+		for (int32 i = 0; i < solverData->step.positionIterations; ++i)
+		{
+			if (index == 0)
+			{
+				positionIterations = i + 1;
+			}
+
+			float32 minSeparation = 0.0f;
+			for (int32 color = 0; color < b2_graphColorCount; ++color)
+			{
+				int32 begin, end;
+				GetRange(color, index, &begin, &end);
+				minSeparation = b2Min(minSeparation, contactSolver->SolvePositionConstraints(begin, end));
+				barrier.Wait();
+			}
+
+			minSeparations[index] = minSeparation;
+			barrier.Wait();
+
+			if (index == 0)
+			{
+				minSeparation = contactSolver->SolvePositionConstraints(contactSolver->m_colorStarts[b2_graphColorCount], contactSolver->m_count);
+				for (int32 j = 0; j < threadCount; ++j)
+				{
+					minSeparation = b2Min(minSeparation, minSeparations[j]);
+				}
+
+				// See b2ContactSolver::SolvePositionConstraints.
+				bool contactsOkay = minSeparation >= -3.0f * b2_linearSlop;
+
+				bool jointsOkay = island->SolveJointPositionConstraints(*solverData);
+
+				positionSolved = contactsOkay && jointsOkay;
+			}
+
+			barrier.Wait();
+
+			if (positionSolved)
+			{
+				// Exit early if the position errors are small.
+				break;
+			}
+		}
+	}
+
+	b2Island* island;
+	b2ContactSolver* contactSolver;
+	b2SolverData* solverData;
+	int32 threadCount;
+
+	bool solvePositions;
+	volatile bool positionSolved;
+	int32 positionIterations;
+	float32 minSeparations[b2_maxThreads];
+
+	b2ThreadBarrier barrier;
+};
+
+static void b2RunColoredSolver(b2ThreadPool* pool, b2ColoredSolverTask* task)
+{
+	if (pool != NULL)
+	{
+		pool->ParallelFor(task, task->threadCount);
+	}
+	else
+	{
+		task->Execute(0, 0);
+	}
+}
+
 b2Island::b2Island(
+	b2BodyStore* store,
 	int32 bodyCapacity,
 	int32 contactCapacity,
 	int32 jointCapacity,
@@ -161,22 +303,71 @@ b2Island::b2Island(
 
 	m_allocator = allocator;
 	m_listener = listener;
+	m_threadPool = NULL;
+	m_colored = false;
+	m_wideSolverStats = NULL;
 
+	m_store = store;
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
+	m_handles = (int32*)m_allocator->Allocate(bodyCapacity * sizeof(int32));
+	m_indices = (int32*)m_allocator->Allocate(bodyCapacity * sizeof(int32));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
 	m_joints = (b2Joint**)m_allocator->Allocate(jointCapacity * sizeof(b2Joint*));
 
 	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
 	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+
+	m_ownsArrays = true;
+}
+
+b2Island::b2Island(
+	b2BodyStore* store,
+	b2Body** bodies, int32* handles, int32* indices, int32 bodyCount,
+	b2Contact** contacts, int32 contactCount,
+	b2Joint** joints, int32 jointCount,
+	b2Position* positions, b2Velocity* velocities,
+	b2StackAllocator* allocator, b2ContactListener* listener)
+{
+	m_bodyCapacity = bodyCount;
+	m_contactCapacity = contactCount;
+	m_jointCapacity = jointCount;
+	m_bodyCount = bodyCount;
+	m_contactCount = contactCount;
+	m_jointCount = jointCount;
+
+	m_allocator = allocator;
+	m_listener = listener;
+	m_threadPool = NULL;
+	m_colored = false;
+	m_wideSolverStats = NULL;
+
+	m_store = store;
+	m_bodies = bodies;
+	m_handles = handles;
+	m_indices = indices;
+	m_contacts = contacts;
+	m_joints = joints;
+
+	m_velocities = velocities;
+	m_positions = positions;
+
+	m_ownsArrays = false;
 }
 
 b2Island::~b2Island()
 {
+	if (m_ownsArrays == false)
+	{
+		return;
+	}
+
 	// Warning: the order should reverse the constructor order.
 	m_allocator->Free(m_positions);
 	m_allocator->Free(m_velocities);
 	m_allocator->Free(m_joints);
 	m_allocator->Free(m_contacts);
+	m_allocator->Free(m_indices);
+	m_allocator->Free(m_handles);
 	m_allocator->Free(m_bodies);
 }
 
@@ -186,25 +377,38 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 	float32 h = step.dt;
 
+	b2BodySim* sims = m_store->GetSims();
+	b2Velocity* velocities = m_store->GetVelocities();
+	const b2BodyForce* forces = m_store->GetForces();
+	const b2BodyMotion* motions = m_store->GetMotions();
+
 	// Integrate velocities and apply damping. Initialize the body state.
+	// Static bodies may be shared with islands solved on other threads,
+	// so they are only read here.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Body* b = m_bodies[i];
+		int32 handle = m_handles[i];
+		int32 index = m_indices[i];
+		b2BodySim* sim = sims + handle;
+		const b2BodyMotion* motion = motions + handle;
 
-		b2Vec2 c = b->m_sweep.c;
-		float32 a = b->m_sweep.a;
-		b2Vec2 v = b->m_linearVelocity;
-		float32 w = b->m_angularVelocity;
+		b2Vec2 c = sim->sweep.c;
+		float32 a = sim->sweep.a;
+		b2Vec2 v = velocities[handle].v;
+		float32 w = velocities[handle].w;
 
-		// Store positions for continuous collision.
-		b->m_sweep.c0 = b->m_sweep.c;
-		b->m_sweep.a0 = b->m_sweep.a;
+		if (motion->type != b2_staticBody)
+		{
+			// Store positions for continuous collision.
+			sim->sweep.c0 = sim->sweep.c;
+			sim->sweep.a0 = sim->sweep.a;
+		}
 
-		if (b->m_type == b2_dynamicBody)
+		if (motion->type == b2_dynamicBody)
 		{
 			// Integrate velocities.
-			v += h * (b->m_gravityScale * gravity + b->m_invMass * b->m_force);
-			w += h * b->m_invI * b->m_torque;
+			v += h * (motion->gravityScale * gravity + sim->invMass * forces[handle].force);
+			w += h * sim->invI * forces[handle].torque;
 
 			// Apply damping.
 			// ODE: dv/dt + c * v = 0
@@ -213,14 +417,14 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			// v2 = exp(-c * dt) * v1
 			// Taylor expansion:
 			// v2 = (1.0f - c * dt) * v1
-			v *= b2Clamp(1.0f - h * b->m_linearDamping, 0.0f, 1.0f);
-			w *= b2Clamp(1.0f - h * b->m_angularDamping, 0.0f, 1.0f);
+			v *= b2Clamp(1.0f - h * motion->linearDamping, 0.0f, 1.0f);
+			w *= b2Clamp(1.0f - h * motion->angularDamping, 0.0f, 1.0f);
 		}
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+		m_positions[index].c = c;
+		m_positions[index].a = a;
+		m_velocities[index].v = v;
+		m_velocities[index].w = w;
 	}
 
 	timer.Reset();
@@ -241,12 +445,35 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	contactSolverDef.allocator = m_allocator;
 
 	b2ContactSolver contactSolver(&contactSolverDef);
+	contactSolver.m_wideStats = m_wideSolverStats;
+
+	// Large islands are split into graph colors and solved on the thread pool.
+	// Colors are also what lets the wide solver batch constraints, so they can
+	// be requested without a pool. Otherwise the sequential order is kept.
+	int32 threadCount = m_threadPool != NULL ? m_threadPool->GetThreadCount() : 1;
+	bool colored = (threadCount > 1 || m_colored) && m_contactCount >= b2_minColoredContacts;
+	b2ColoredSolverTask coloredTask(threadCount);
+	if (colored)
+	{
+		contactSolver.ColorConstraints();
+		coloredTask.island = this;
+		coloredTask.contactSolver = &contactSolver;
+		coloredTask.solverData = &solverData;
+		coloredTask.positionSolved = false;
+		coloredTask.positionIterations = 0;
+	}
+
 	contactSolver.InitializeVelocityConstraints();
 
 	if (step.warmStarting)
 	{
 		contactSolver.WarmStart();
 	}
+
+	if (colored)
+	{
+		contactSolver.PrepareWideConstraints();
+	}
 	
 	for (int32 i = 0; i < m_jointCount; ++i)
 	{
@@ -257,27 +484,34 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 	// Solve velocity constraints
 	timer.Reset();
-	for (int32 i = 0; i < step.velocityIterations; ++i)
+	if (colored)
+	{
+		coloredTask.solvePositions = false;
+		b2RunColoredSolver(m_threadPool, &coloredTask);
+	}
+	else
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
+		for (int32 i = 0; i < step.velocityIterations; ++i)
 		{
-			m_joints[j]->SolveVelocityConstraints(solverData);
+			SolveJointVelocityConstraints(solverData);
+			contactSolver.SolveVelocityConstraints();
 		}
-
-		contactSolver.SolveVelocityConstraints();
 	}
 
 	// Store impulses for warm starting
 	contactSolver.StoreImpulses();
+	contactSolver.ApplyRestitution();
 	profile->solveVelocity = timer.GetMilliseconds();
 
 	// Integrate positions
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Vec2 c = m_positions[i].c;
-		float32 a = m_positions[i].a;
-		b2Vec2 v = m_velocities[i].v;
-		float32 w = m_velocities[i].w;
+		int32 index = m_indices[i];
+
+		b2Vec2 c = m_positions[index].c;
+		float32 a = m_positions[index].a;
+		b2Vec2 v = m_velocities[index].v;
+		float32 w = m_velocities[index].w;
 
 		// Check for large velocities
 		b2Vec2 translation = h * v;
@@ -298,48 +532,74 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		c += h * v;
 		a += h * w;
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+		m_positions[index].c = c;
+		m_positions[index].a = a;
+		m_velocities[index].v = v;
+		m_velocities[index].w = w;
 	}
 
 	// Solve position constraints
 	timer.Reset();
 	bool positionSolved = false;
-	for (int32 i = 0; i < step.positionIterations; ++i)
+	int32 positionIterations = 0;
+	if (colored)
 	{
-		bool contactsOkay = contactSolver.SolvePositionConstraints();
-
-		bool jointsOkay = true;
-		for (int32 i = 0; i < m_jointCount; ++i)
+		coloredTask.solvePositions = true;
+		b2RunColoredSolver(m_threadPool, &coloredTask);
+		positionSolved = coloredTask.positionSolved;
+		positionIterations = coloredTask.positionIterations;
+	}
+	else
+	{
+		for (int32 i = 0; i < step.positionIterations; ++i)
 		{
-			bool jointOkay = m_joints[i]->SolvePositionConstraints(solverData);
-			jointsOkay = jointsOkay && jointOkay;
-		}
+			++positionIterations;
+			bool contactsOkay = contactSolver.SolvePositionConstraints();
+			bool jointsOkay = SolveJointPositionConstraints(solverData);
 
-		if (contactsOkay && jointsOkay)
-		{
-			// Exit early if the position errors are small.
-			positionSolved = true;
-			break;
+			if (contactsOkay && jointsOkay)
+			{
+				// Exit early if the position errors are small.
+				positionSolved = true;
+				break;
+			}
 		}
 	}
 
-	// Copy state buffers back to the bodies
+	// Copy state buffers back to the bodies. Static bodies did not move.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Body* body = m_bodies[i];
-		body->m_sweep.c = m_positions[i].c;
-		body->m_sweep.a = m_positions[i].a;
-		body->m_linearVelocity = m_velocities[i].v;
-		body->m_angularVelocity = m_velocities[i].w;
-		body->SynchronizeTransform();
+		int32 handle = m_handles[i];
+		if (motions[handle].type == b2_staticBody)
+		{
+			continue;
+		}
+
+		int32 index = m_indices[i];
+		b2BodySim* sim = sims + handle;
+		sim->sweep.c = m_positions[index].c;
+		sim->sweep.a = m_positions[index].a;
+		velocities[handle] = m_velocities[index];
+		sim->xf.q.Set(sim->sweep.a);
+		sim->xf.p = sim->sweep.c - b2Mul(sim->xf.q, sim->sweep.localCenter);
 	}
 
 	profile->solvePosition = timer.GetMilliseconds();
+	profile->islandCount = 1;
+	profile->islandBodies = m_bodyCount;
+	profile->maxIslandBodies = m_bodyCount;
+	profile->velocityIterations = step.velocityIterations;
+	profile->positionIterations = positionIterations;
 
-	Report(contactSolver.m_velocityConstraints);
+	if (colored)
+	{
+		// The constraints were reordered by color.
+		Report();
+	}
+	else
+	{
+		Report(contactSolver.m_velocityConstraints);
+	}
 
 	if (allowSleep)
 	{
@@ -350,15 +610,17 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 		for (int32 i = 0; i < m_bodyCount; ++i)
 		{
-			b2Body* b = m_bodies[i];
-			if (b->GetType() == b2_staticBody)
+			int32 handle = m_handles[i];
+			if (motions[handle].type == b2_staticBody)
 			{
 				continue;
 			}
 
+			b2Body* b = m_bodies[i];
+			const b2Velocity* velocity = velocities + handle;
 			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
-				b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
-				b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+				velocity->w * velocity->w > angTolSqr ||
+				b2Dot(velocity->v, velocity->v) > linTolSqr)
 			{
 				b->m_sleepTime = 0.0f;
 				minSleepTime = 0.0f;
@@ -374,26 +636,49 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		{
 			for (int32 i = 0; i < m_bodyCount; ++i)
 			{
-				b2Body* b = m_bodies[i];
-				b->SetAwake(false);
+				if (motions[m_handles[i]].type != b2_staticBody)
+				{
+					m_bodies[i]->SetAwake(false);
+				}
 			}
 		}
 	}
 }
 
+void b2Island::SolveJointVelocityConstraints(const b2SolverData& data)
+{
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		m_joints[i]->SolveVelocityConstraints(data);
+	}
+}
+
+bool b2Island::SolveJointPositionConstraints(const b2SolverData& data)
+{
+	bool jointsOkay = true;
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		bool jointOkay = m_joints[i]->SolvePositionConstraints(data);
+		jointsOkay = jointsOkay && jointOkay;
+	}
+	return jointsOkay;
+}
+
 void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB)
 {
 	b2Assert(toiIndexA < m_bodyCount);
 	b2Assert(toiIndexB < m_bodyCount);
 
+	b2BodySim* sims = m_store->GetSims();
+	b2Velocity* velocities = m_store->GetVelocities();
+
 	// Initialize the body state.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Body* b = m_bodies[i];
-		m_positions[i].c = b->m_sweep.c;
-		m_positions[i].a = b->m_sweep.a;
-		m_velocities[i].v = b->m_linearVelocity;
-		m_velocities[i].w = b->m_angularVelocity;
+		const b2BodySim* sim = sims + m_handles[i];
+		m_positions[i].c = sim->sweep.c;
+		m_positions[i].a = sim->sweep.a;
+		m_velocities[i] = velocities[m_handles[i]];
 	}
 
 	b2ContactSolverDef contactSolverDef;
@@ -449,10 +734,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 #endif
 
 	// Leap of faith to new safe state.
-	m_bodies[toiIndexA]->m_sweep.c0 = m_positions[toiIndexA].c;
-	m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
-	m_bodies[toiIndexB]->m_sweep.c0 = m_positions[toiIndexB].c;
-	m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+	sims[m_handles[toiIndexA]].sweep.c0 = m_positions[toiIndexA].c;
+	sims[m_handles[toiIndexA]].sweep.a0 = m_positions[toiIndexA].a;
+	sims[m_handles[toiIndexB]].sweep.c0 = m_positions[toiIndexB].c;
+	sims[m_handles[toiIndexB]].sweep.a0 = m_positions[toiIndexB].a;
 
 	// No warm starting is needed for TOI events because warm
 	// starting impulses were applied in the discrete solver.
@@ -502,12 +787,13 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 		m_velocities[i].w = w;
 
 		// Sync bodies
-		b2Body* body = m_bodies[i];
-		body->m_sweep.c = c;
-		body->m_sweep.a = a;
-		body->m_linearVelocity = v;
-		body->m_angularVelocity = w;
-		body->SynchronizeTransform();
+		b2BodySim* sim = sims + m_handles[i];
+		sim->sweep.c = c;
+		sim->sweep.a = a;
+		velocities[m_handles[i]].v = v;
+		velocities[m_handles[i]].w = w;
+		sim->xf.q.Set(a);
+		sim->xf.p = c - b2Mul(sim->xf.q, sim->sweep.localCenter);
 	}
 
 	Report(contactSolver.m_velocityConstraints);
@@ -537,3 +823,28 @@ void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 		m_listener->PostSolve(c, &impulse);
 	}
 }
+
+void b2Island::Report()
+{
+	if (m_listener == NULL)
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < m_contactCount; ++i)
+	{
+		b2Contact* c = m_contacts[i];
+
+		const b2Manifold* manifold = c->GetManifold();
+
+		b2ContactImpulse impulse;
+		impulse.count = manifold->pointCount;
+		for (int32 j = 0; j < manifold->pointCount; ++j)
+		{
+			impulse.normalImpulses[j] = manifold->points[j].normalImpulse;
+			impulse.tangentImpulses[j] = manifold->points[j].tangentImpulse;
+		}
+
+		m_listener->PostSolve(c, &impulse);
+	}
+}
@@ -27,15 +27,29 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ThreadPool;
+class b2BodyStore;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
+struct b2SolverData;
 
 /// This is an internal class.
 class b2Island
 {
 public:
-	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
+	b2Island(b2BodyStore* store, int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
 			b2StackAllocator* allocator, b2ContactListener* listener);
+
+	/// Wrap island arrays that were gathered elsewhere. Nothing is allocated
+	/// or freed. The body positions and velocities are indexed by the island
+	/// indices, which must match b2Body::m_islandIndex.
+	b2Island(b2BodyStore* store,
+			b2Body** bodies, int32* handles, int32* indices, int32 bodyCount,
+			b2Contact** contacts, int32 contactCount,
+			b2Joint** joints, int32 jointCount,
+			b2Position* positions, b2Velocity* velocities,
+			b2StackAllocator* allocator, b2ContactListener* listener);
+
 	~b2Island();
 
 	void Clear()
@@ -49,11 +63,16 @@ public:
 
 	void SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB);
 
+	void SolveJointVelocityConstraints(const b2SolverData& data);
+	bool SolveJointPositionConstraints(const b2SolverData& data);
+
 	void Add(b2Body* body)
 	{
 		b2Assert(m_bodyCount < m_bodyCapacity);
 		body->m_islandIndex = m_bodyCount;
 		m_bodies[m_bodyCount] = body;
+		m_handles[m_bodyCount] = body->m_handle;
+		m_indices[m_bodyCount] = m_bodyCount;
 		++m_bodyCount;
 	}
 
@@ -71,10 +90,28 @@ public:
 
 	void Report(const b2ContactVelocityConstraint* constraints);
 
+	/// Report the impulses stored in the contact manifolds. This is used
+	/// when the island was solved without a listener.
+	void Report();
+
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
+	// If set, large islands split their contacts across these threads.
+	b2ThreadPool* m_threadPool;
+
+	// If set, large islands are solved by graph color even without a pool.
+	bool m_colored;
+
+	// If set, the wide solver is checked lane by lane. See b2World::SetWideSolverCheck.
+	b2WideSolverStats* m_wideSolverStats;
+
+	// The solver loops stream the store arrays by body handle. The body
+	// pointers are only used for sleep bookkeeping and reporting.
+	b2BodyStore* m_store;
 	b2Body** m_bodies;
+	int32* m_handles;
+	int32* m_indices;
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
 
@@ -88,6 +125,8 @@ public:
 	int32 m_bodyCapacity;
 	int32 m_contactCapacity;
 	int32 m_jointCapacity;
+
+	bool m_ownsArrays;
 };
 
 #endif
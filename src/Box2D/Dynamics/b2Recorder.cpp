@@ -0,0 +1,1193 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2Recorder.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2FrictionJoint.h>
+#include <Box2D/Dynamics/Joints/b2GearJoint.h>
+#include <Box2D/Dynamics/Joints/b2MouseJoint.h>
+#include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
+#include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/Joints/b2RopeJoint.h>
+#include <Box2D/Dynamics/Joints/b2WeldJoint.h>
+#include <Box2D/Dynamics/Joints/b2WheelJoint.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <cstring>
+
+// "B2RC" followed by the format version.
+static const uint32 b2_recordMagic = 0x43523242;
+static const int32 b2_recordVersion = 2;
+
+enum b2RecordStepFlags
+{
+	e_recordAllowSleep		= 0x01,
+	e_recordWarmStarting	= 0x02,
+	e_recordContinuous		= 0x04,
+	e_recordSubStepping		= 0x08,
+	e_recordSpeculative		= 0x10,
+	e_recordAutoClearForces	= 0x20
+};
+
+static int32 b2GetFixtureIndex(b2Fixture* fixture)
+{
+	int32 index = 0;
+	for (b2Fixture* f = fixture->GetBody()->GetFixtureList(); f != fixture; f = f->GetNext())
+	{
+		++index;
+	}
+	return index;
+}
+
+b2Recorder::b2Recorder()
+{
+	m_world = NULL;
+	m_inStep = false;
+	m_data = NULL;
+	m_size = 0;
+	m_capacity = 0;
+	m_joints = NULL;
+	m_jointCount = 0;
+	m_jointCapacity = 0;
+}
+
+b2Recorder::~b2Recorder()
+{
+	End();
+	b2Free(m_data);
+	b2Free(m_joints);
+}
+
+void b2Recorder::Begin(b2World* world)
+{
+	b2Assert(world->IsLocked() == false);
+
+	End();
+	m_size = 0;
+	Write(b2_recordMagic);
+	Write(b2_recordVersion);
+	Resume(world);
+}
+
+void b2Recorder::Resume(b2World* world)
+{
+	b2Assert(world->IsLocked() == false);
+	b2Assert(m_size > 0);
+
+	End();
+	b2Assert(world->m_recorder == NULL);
+	m_world = world;
+	m_world->m_recorder = this;
+	m_inStep = false;
+	MarkBodies(true);
+	RecordSnapshot();
+}
+
+void b2Recorder::End()
+{
+	if (m_world == NULL)
+	{
+		return;
+	}
+
+	MarkBodies(false);
+	m_world->m_recorder = NULL;
+	m_world = NULL;
+}
+
+int32 b2Recorder::GetBodyRecordSize(int32 type)
+{
+	switch (type)
+	{
+	case e_transform:
+		return 3 * sizeof(float32);
+	case e_linearVelocity:
+	case e_forceToCenter:
+		return sizeof(b2Vec2);
+	case e_force:
+	case e_linearImpulse:
+		return 2 * sizeof(b2Vec2);
+	case e_angularVelocity:
+	case e_torque:
+	case e_angularImpulse:
+	case e_linearDamping:
+	case e_angularDamping:
+	case e_gravityScale:
+		return sizeof(float32);
+	case e_type:
+		return sizeof(int32);
+	case e_awake:
+	case e_active:
+	case e_bullet:
+	case e_fixedRotation:
+	case e_sleepingAllowed:
+		return sizeof(uint8);
+	case e_massData:
+		return sizeof(b2MassData);
+	case e_resetMassData:
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+void b2Recorder::Reserve(int32 size)
+{
+	if (m_size + size <= m_capacity)
+	{
+		return;
+	}
+
+	int32 capacity = b2Max(2 * m_capacity, 4096);
+	while (capacity < m_size + size)
+	{
+		capacity *= 2;
+	}
+
+	uint8* data = (uint8*)b2Alloc(capacity);
+	if (m_data)
+	{
+		memcpy(data, m_data, m_size);
+		b2Free(m_data);
+	}
+	m_data = data;
+	m_capacity = capacity;
+}
+
+void b2Recorder::Write(const void* data, int32 size)
+{
+	Reserve(size);
+	memcpy(m_data + m_size, data, size);
+	m_size += size;
+}
+
+void b2Recorder::WriteFixture(b2Fixture* fixture)
+{
+	Write(fixture->GetBody()->GetHandle());
+	Write(b2GetFixtureIndex(fixture));
+}
+
+void b2Recorder::WriteJointDef(const b2JointDef* def)
+{
+	switch (def->type)
+	{
+	case e_revoluteJoint:
+		{
+			const b2RevoluteJointDef* d = (const b2RevoluteJointDef*)def;
+			Write(d->localAnchorA);
+			Write(d->localAnchorB);
+			Write(d->referenceAngle);
+			Write(uint8(d->enableLimit));
+			Write(d->lowerAngle);
+			Write(d->upperAngle);
+			Write(uint8(d->enableMotor));
+			Write(d->motorSpeed);
+			Write(d->maxMotorTorque);
+		}
+		break;
+
+	case e_prismaticJoint:
+		{
+			const b2PrismaticJointDef* d = (const b2PrismaticJointDef*)def;
+			Write(d->localAnchorA);
+			Write(d->localAnchorB);
+			Write(d->localAxisA);
+			Write(d->referenceAngle);
+			Write(uint8(d->enableLimit));
+			Write(d->lowerTranslation);
+			Write(d->upperTranslation);
+			Write(uint8(d->enableMotor));
+			Write(d->maxMotorForce);
+			Write(d->motorSpeed);
+		}
+		break;
+
+	case e_distanceJoint:
+		{
+			const b2DistanceJointDef* d = (const b2DistanceJointDef*)def;
+			Write(d->localAnchorA);
+			Write(d->localAnchorB);
+			Write(d->length);
+			Write(d->frequencyHz);
+			Write(d->dampingRatio);
+		}
+		break;
+
+	case e_pulleyJoint:
+		{
+			const b2PulleyJointDef* d = (const b2PulleyJointDef*)def;
+			Write(d->groundAnchorA);
+			Write(d->groundAnchorB);
+			Write(d->localAnchorA);
+			Write(d->localAnchorB);
+			Write(d->lengthA);
+			Write(d->lengthB);
+			Write(d->ratio);
+		}
+		break;
+
+	case e_mouseJoint:
+		{
+			const b2MouseJointDef* d = (const b2MouseJointDef*)def;
+			Write(d->target);
+			Write(d->maxForce);
+			Write(d->frequencyHz);
+			Write(d->dampingRatio);
+		}
+		break;
+
+	case e_gearJoint:
+		{
+			const b2GearJointDef* d = (const b2GearJointDef*)def;
+			Write(d->ratio);
+		}
+		break;
+
+	case e_wheelJoint:
+		{
+			const b2WheelJointDef* d = (const b2WheelJointDef*)def;
+			Write(d->localAnchorA);
+			Write(d->localAnchorB);
+			Write(d->localAxisA);
+			Write(uint8(d->enableMotor));
+			Write(d->maxMotorTorque);
+			Write(d->motorSpeed);
+			Write(d->frequencyHz);
+			Write(d->dampingRatio);
+		}
+		break;
+
+	case e_weldJoint:
+		{
+			const b2WeldJointDef* d = (const b2WeldJointDef*)def;
+			Write(d->localAnchorA);
+			Write(d->localAnchorB);
+			Write(d->referenceAngle);
+			Write(d->frequencyHz);
+			Write(d->dampingRatio);
+		}
+		break;
+
+	case e_frictionJoint:
+		{
+			const b2FrictionJointDef* d = (const b2FrictionJointDef*)def;
+			Write(d->localAnchorA);
+			Write(d->localAnchorB);
+			Write(d->maxForce);
+			Write(d->maxTorque);
+		}
+		break;
+
+	case e_ropeJoint:
+		{
+			const b2RopeJointDef* d = (const b2RopeJointDef*)def;
+			Write(d->localAnchorA);
+			Write(d->localAnchorB);
+			Write(d->maxLength);
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+void b2Recorder::MarkBodies(bool flag)
+{
+	for (b2Body* b = m_world->GetBodyList(); b; b = b->GetNext())
+	{
+		if (flag)
+		{
+			b->m_flags |= b2Body::e_recordFlag;
+		}
+		else
+		{
+			b->m_flags &= ~b2Body::e_recordFlag;
+		}
+	}
+}
+
+void b2Recorder::ResetJoints()
+{
+	// The world list is newest first.
+	m_jointCount = 0;
+	for (b2Joint* j = m_world->GetJointList(); j; j = j->GetNext())
+	{
+		AddJoint(j);
+	}
+
+	for (int32 i = 0; i < m_jointCount / 2; ++i)
+	{
+		b2Swap(m_joints[i], m_joints[m_jointCount - 1 - i]);
+	}
+}
+
+void b2Recorder::AddJoint(b2Joint* joint)
+{
+	if (m_jointCount == m_jointCapacity)
+	{
+		m_jointCapacity = b2Max(2 * m_jointCapacity, 16);
+		b2Joint** joints = (b2Joint**)b2Alloc(m_jointCapacity * sizeof(b2Joint*));
+		if (m_joints)
+		{
+			memcpy(joints, m_joints, m_jointCount * sizeof(b2Joint*));
+			b2Free(m_joints);
+		}
+		m_joints = joints;
+	}
+
+	m_joints[m_jointCount++] = joint;
+}
+
+int32 b2Recorder::FindJoint(const b2Joint* joint) const
+{
+	// Recent joints are the likely ones.
+	for (int32 i = m_jointCount - 1; i >= 0; --i)
+	{
+		if (m_joints[i] == joint)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+void b2Recorder::RecordSnapshot()
+{
+	int32 size = m_world->SaveSnapshot(NULL, 0);
+	Write(uint8(e_snapshot));
+	Write(size);
+	Reserve(size);
+	m_world->SaveSnapshot(m_data + m_size, size);
+	m_size += size;
+
+	ResetJoints();
+}
+
+void b2Recorder::RecordStep(float32 dt, int32 velocityIterations, int32 positionIterations)
+{
+	uint8 flags = 0;
+	flags |= m_world->GetAllowSleeping() ? e_recordAllowSleep : 0;
+	flags |= m_world->GetWarmStarting() ? e_recordWarmStarting : 0;
+	flags |= m_world->GetContinuousPhysics() ? e_recordContinuous : 0;
+	flags |= m_world->GetSubStepping() ? e_recordSubStepping : 0;
+	flags |= m_world->GetSpeculativeContacts() ? e_recordSpeculative : 0;
+	flags |= m_world->GetAutoClearForces() ? e_recordAutoClearForces : 0;
+
+	Write(uint8(e_step));
+	Write(dt);
+	Write(velocityIterations);
+	Write(positionIterations);
+	Write(m_world->GetGravity());
+	Write(flags);
+
+	m_inStep = true;
+}
+
+void b2Recorder::RecordStepEnd()
+{
+	m_inStep = false;
+}
+
+void b2Recorder::RecordClearForces()
+{
+	if (m_inStep)
+	{
+		return;
+	}
+
+	Write(uint8(e_clearForces));
+}
+
+void b2Recorder::RecordCreateBody(b2Body* body, const b2BodyDef* def)
+{
+	body->m_flags |= b2Body::e_recordFlag;
+
+	uint8 flags = 0;
+	flags |= def->allowSleep ? 0x01 : 0;
+	flags |= def->awake ? 0x02 : 0;
+	flags |= def->fixedRotation ? 0x04 : 0;
+	flags |= def->bullet ? 0x08 : 0;
+	flags |= def->active ? 0x10 : 0;
+
+	Write(uint8(e_createBody));
+	Write(body->GetHandle());
+	Write(int32(def->type));
+	Write(def->position);
+	Write(def->angle);
+	Write(def->linearVelocity);
+	Write(def->angularVelocity);
+	Write(def->linearDamping);
+	Write(def->angularDamping);
+	Write(def->gravityScale);
+	Write(flags);
+}
+
+void b2Recorder::RecordDestroyBody(b2Body* body)
+{
+	Write(uint8(e_destroyBody));
+	Write(body->GetHandle());
+
+	// Destroying the contacts wakes the body, and that is not input.
+	body->m_flags &= ~b2Body::e_recordFlag;
+}
+
+void b2Recorder::RecordCreateFixture(b2Body* body, const b2FixtureDef* def)
+{
+	Write(uint8(e_createFixture));
+	Write(body->GetHandle());
+	Write(def->density);
+	Write(def->friction);
+	Write(def->restitution);
+	Write(def->filter);
+	Write(uint8(def->isSensor));
+
+	// Measure the shape, then write it in place.
+	b2StreamWriter counter(NULL, 0);
+	b2SaveShape(&counter, def->shape);
+	int32 size = counter.GetSize();
+	Reserve(size);
+	b2StreamWriter writer(m_data + m_size, size);
+	b2SaveShape(&writer, def->shape);
+	m_size += size;
+}
+
+void b2Recorder::RecordDestroyFixture(b2Fixture* fixture)
+{
+	Write(uint8(e_destroyFixture));
+	WriteFixture(fixture);
+}
+
+void b2Recorder::RecordFixture(b2Fixture* fixture, bool refilter)
+{
+	Write(uint8(e_fixture));
+	WriteFixture(fixture);
+	Write(fixture->GetDensity());
+	Write(fixture->GetFriction());
+	Write(fixture->GetRestitution());
+	Write(fixture->GetFilterData());
+	Write(uint8(fixture->IsSensor()));
+	Write(uint8(refilter));
+}
+
+void b2Recorder::RecordCreateJoint(b2Joint* joint, const b2JointDef* def)
+{
+	Write(uint8(e_createJoint));
+	Write(int32(def->type));
+	Write(def->bodyA->GetHandle());
+	Write(def->bodyB->GetHandle());
+	Write(uint8(def->collideConnected));
+	WriteJointDef(def);
+
+	if (def->type == e_gearJoint)
+	{
+		const b2GearJointDef* gearDef = (const b2GearJointDef*)def;
+		Write(FindJoint(gearDef->joint1));
+		Write(FindJoint(gearDef->joint2));
+	}
+
+	AddJoint(joint);
+}
+
+void b2Recorder::RecordDestroyJoint(b2Joint* joint)
+{
+	int32 id = FindJoint(joint);
+	b2Assert(id >= 0);
+
+	Write(uint8(e_destroyJoint));
+	Write(id);
+	m_joints[id] = NULL;
+}
+
+void b2Recorder::RecordMouseTarget(b2Joint* joint, const b2Vec2& target)
+{
+	Write(uint8(e_mouseTarget));
+	Write(FindJoint(joint));
+	Write(target);
+}
+
+void b2Recorder::RecordBody(b2Body* body, int32 type, const void* data, int32 size)
+{
+	b2Assert(size == GetBodyRecordSize(type));
+
+	// The world wakes bodies as it steps.
+	if (type == e_awake && m_inStep)
+	{
+		return;
+	}
+
+	Write(uint8(type));
+	Write(body->GetHandle());
+	Write(data, size);
+}
+
+b2Replay::b2Replay(const void* data, int32 size) : m_reader(data, size)
+{
+	m_started = false;
+	m_ok = true;
+	m_error = NULL;
+	m_joints = NULL;
+	m_jointCount = 0;
+	m_jointCapacity = 0;
+}
+
+b2Replay::~b2Replay()
+{
+	b2Free(m_joints);
+}
+
+bool b2Replay::ReadStep(b2World* world, b2ReplayStep* step)
+{
+	b2Assert(world->IsLocked() == false);
+
+	if (m_started == false)
+	{
+		uint32 magic;
+		int32 version;
+		m_reader.Read(&magic);
+		m_reader.Read(&version);
+		m_started = true;
+
+		// Byte swapped logs fail the magic check.
+		if (m_reader.IsOk() == false || magic != b2_recordMagic)
+		{
+			Fail("not a b2Recorder log, or written with another byte order");
+		}
+		else if (version != b2_recordVersion)
+		{
+			Fail("the log format version is not supported by this build");
+		}
+	}
+
+	while (m_ok && m_reader.GetRemaining() > 0)
+	{
+		uint8 type;
+		m_reader.Read(&type);
+
+		if (type == b2Recorder::e_snapshot)
+		{
+			if (ReadRecord(world, type) == false)
+			{
+				Fail("the snapshot in the log does not load");
+			}
+			continue;
+		}
+
+		if (type != b2Recorder::e_step)
+		{
+			if (ReadRecord(world, type) == false || m_reader.IsOk() == false)
+			{
+				Fail("a record does not match the world");
+			}
+			continue;
+		}
+
+		b2Vec2 gravity;
+		uint8 flags;
+		m_reader.Read(&step->dt);
+		m_reader.Read(&step->velocityIterations);
+		m_reader.Read(&step->positionIterations);
+		m_reader.Read(&gravity);
+		m_reader.Read(&flags);
+		if (m_reader.IsOk() == false)
+		{
+			Fail("a record does not match the world");
+			return false;
+		}
+
+		world->SetGravity(gravity);
+		world->SetAllowSleeping((flags & e_recordAllowSleep) != 0);
+		world->SetWarmStarting((flags & e_recordWarmStarting) != 0);
+		world->SetContinuousPhysics((flags & e_recordContinuous) != 0);
+		world->SetSubStepping((flags & e_recordSubStepping) != 0);
+		world->SetSpeculativeContacts((flags & e_recordSpeculative) != 0);
+		world->SetAutoClearForces((flags & e_recordAutoClearForces) != 0);
+		return true;
+	}
+
+	return false;
+}
+
+void b2Replay::Fail(const char* error)
+{
+	// A read past the end is the likely cause of any other error.
+	m_error = m_reader.IsOk() ? error : "the log is truncated";
+	m_ok = false;
+}
+
+bool b2Replay::ReadRecord(b2World* world, int32 type)
+{
+	switch (type)
+	{
+	case b2Recorder::e_snapshot:
+		{
+			int32 size;
+			m_reader.Read(&size);
+			const void* data = m_reader.Skip(size);
+			if (data == NULL || world->LoadSnapshot(data, size) == false)
+			{
+				return false;
+			}
+
+			ResetJoints(world);
+		}
+		return true;
+
+	case b2Recorder::e_clearForces:
+		world->ClearForces();
+		return true;
+
+	case b2Recorder::e_createBody:
+		{
+			int32 handle;
+			int32 bodyType;
+			uint8 flags;
+			b2BodyDef def;
+			m_reader.Read(&handle);
+			m_reader.Read(&bodyType);
+			m_reader.Read(&def.position);
+			m_reader.Read(&def.angle);
+			m_reader.Read(&def.linearVelocity);
+			m_reader.Read(&def.angularVelocity);
+			m_reader.Read(&def.linearDamping);
+			m_reader.Read(&def.angularDamping);
+			m_reader.Read(&def.gravityScale);
+			m_reader.Read(&flags);
+			if (m_reader.IsOk() == false || bodyType < b2_staticBody || bodyType > b2_dynamicBody)
+			{
+				return false;
+			}
+
+			def.type = b2BodyType(bodyType);
+			def.allowSleep = (flags & 0x01) != 0;
+			def.awake = (flags & 0x02) != 0;
+			def.fixedRotation = (flags & 0x04) != 0;
+			def.bullet = (flags & 0x08) != 0;
+			def.active = (flags & 0x10) != 0;
+
+			// Handles are given out in order, so this one must match.
+			b2Body* body = world->CreateBody(&def);
+			return body != NULL && body->GetHandle() == handle;
+		}
+
+	case b2Recorder::e_destroyBody:
+		{
+			// The joints of the body were destroyed by their own records.
+			b2Body* body = ReadBody(world);
+			if (body == NULL)
+			{
+				return false;
+			}
+
+			world->DestroyBody(body);
+		}
+		return true;
+
+	case b2Recorder::e_createFixture:
+		{
+			b2Body* body = ReadBody(world);
+
+			b2FixtureDef def;
+			uint8 isSensor;
+			m_reader.Read(&def.density);
+			m_reader.Read(&def.friction);
+			m_reader.Read(&def.restitution);
+			m_reader.Read(&def.filter);
+			m_reader.Read(&isSensor);
+			def.isSensor = isSensor != 0;
+
+			b2CircleShape circle;
+			b2EdgeShape edge;
+			b2PolygonShape polygon;
+			b2ChainShape chain;
+			if (body == NULL || b2LoadShape(&m_reader, &def, &circle, &edge, &polygon, &chain) == false)
+			{
+				return false;
+			}
+
+			body->CreateFixture(&def);
+		}
+		return true;
+
+	case b2Recorder::e_destroyFixture:
+		{
+			b2Fixture* fixture = ReadFixture(world);
+			if (fixture == NULL)
+			{
+				return false;
+			}
+
+			fixture->GetBody()->DestroyFixture(fixture);
+		}
+		return true;
+
+	case b2Recorder::e_fixture:
+		{
+			b2Fixture* fixture = ReadFixture(world);
+
+			float32 density, friction, restitution;
+			b2Filter filter;
+			uint8 isSensor, refilter;
+			m_reader.Read(&density);
+			m_reader.Read(&friction);
+			m_reader.Read(&restitution);
+			m_reader.Read(&filter);
+			m_reader.Read(&isSensor);
+			m_reader.Read(&refilter);
+			if (fixture == NULL || m_reader.IsOk() == false)
+			{
+				return false;
+			}
+
+			// The setters are cheap when nothing changes, except the filter.
+			fixture->SetDensity(density);
+			fixture->SetFriction(friction);
+			fixture->SetRestitution(restitution);
+			fixture->SetSensor(isSensor != 0);
+			if (refilter)
+			{
+				fixture->SetFilterData(filter);
+			}
+		}
+		return true;
+
+	case b2Recorder::e_createJoint:
+		{
+			int32 jointType;
+			int32 handleA, handleB;
+			uint8 collideConnected;
+			m_reader.Read(&jointType);
+			m_reader.Read(&handleA);
+			m_reader.Read(&handleB);
+			m_reader.Read(&collideConnected);
+
+			b2RevoluteJointDef revoluteDef;
+			b2PrismaticJointDef prismaticDef;
+			b2DistanceJointDef distanceDef;
+			b2PulleyJointDef pulleyDef;
+			b2MouseJointDef mouseDef;
+			b2GearJointDef gearDef;
+			b2WheelJointDef wheelDef;
+			b2WeldJointDef weldDef;
+			b2FrictionJointDef frictionDef;
+			b2RopeJointDef ropeDef;
+
+			b2JointDef* def = NULL;
+			switch (jointType)
+			{
+			case e_revoluteJoint:	def = &revoluteDef; break;
+			case e_prismaticJoint:	def = &prismaticDef; break;
+			case e_distanceJoint:	def = &distanceDef; break;
+			case e_pulleyJoint:		def = &pulleyDef; break;
+			case e_mouseJoint:		def = &mouseDef; break;
+			case e_gearJoint:		def = &gearDef; break;
+			case e_wheelJoint:		def = &wheelDef; break;
+			case e_weldJoint:		def = &weldDef; break;
+			case e_frictionJoint:	def = &frictionDef; break;
+			case e_ropeJoint:		def = &ropeDef; break;
+			default:
+				return false;
+			}
+
+			def->type = b2JointType(jointType);
+			ReadJointDef(def);
+			def->bodyA = world->GetBody(handleA);
+			def->bodyB = world->GetBody(handleB);
+			def->collideConnected = collideConnected != 0;
+
+			if (def->type == e_gearJoint)
+			{
+				int32 id1, id2;
+				gearDef.joint1 = ReadJoint(&id1);
+				gearDef.joint2 = ReadJoint(&id2);
+				if (gearDef.joint1 == NULL || gearDef.joint2 == NULL)
+				{
+					return false;
+				}
+			}
+
+			if (m_reader.IsOk() == false || def->bodyA == NULL || def->bodyB == NULL)
+			{
+				return false;
+			}
+
+			AddJoint(world->CreateJoint(def));
+		}
+		return true;
+
+	case b2Recorder::e_destroyJoint:
+		{
+			int32 id;
+			b2Joint* joint = ReadJoint(&id);
+			if (joint == NULL)
+			{
+				return false;
+			}
+
+			world->DestroyJoint(joint);
+			m_joints[id] = NULL;
+		}
+		return true;
+
+	case b2Recorder::e_mouseTarget:
+		{
+			int32 id;
+			b2Joint* joint = ReadJoint(&id);
+			b2Vec2 target;
+			m_reader.Read(&target);
+			if (joint == NULL || joint->GetType() != e_mouseJoint || m_reader.IsOk() == false)
+			{
+				return false;
+			}
+
+			((b2MouseJoint*)joint)->SetTarget(target);
+		}
+		return true;
+
+	default:
+		{
+			if (type < b2Recorder::e_transform || type >= b2Recorder::e_recordTypeCount)
+			{
+				return false;
+			}
+
+			b2Body* body = ReadBody(world);
+			return body != NULL && ReadBodyRecord(body, type);
+		}
+	}
+}
+
+bool b2Replay::ReadBodyRecord(b2Body* body, int32 type)
+{
+	// Large enough for every body record.
+	float32 data[4];
+	int32 size = b2Recorder::GetBodyRecordSize(type);
+	b2Assert(size <= int32(sizeof(data)));
+	if (m_reader.Read(data, size) == false)
+	{
+		return false;
+	}
+
+	const b2Vec2* vectors = (const b2Vec2*)data;
+	uint8 flag = *(const uint8*)data;
+
+	switch (type)
+	{
+	case b2Recorder::e_transform:
+		body->SetTransform(b2Vec2(data[0], data[1]), data[2]);
+		break;
+
+	case b2Recorder::e_linearVelocity:
+		body->SetLinearVelocity(vectors[0]);
+		break;
+
+	case b2Recorder::e_angularVelocity:
+		body->SetAngularVelocity(data[0]);
+		break;
+
+	case b2Recorder::e_force:
+		body->ApplyForce(vectors[0], vectors[1]);
+		break;
+
+	case b2Recorder::e_forceToCenter:
+		body->ApplyForceToCenter(vectors[0]);
+		break;
+
+	case b2Recorder::e_torque:
+		body->ApplyTorque(data[0]);
+		break;
+
+	case b2Recorder::e_linearImpulse:
+		body->ApplyLinearImpulse(vectors[0], vectors[1]);
+		break;
+
+	case b2Recorder::e_angularImpulse:
+		body->ApplyAngularImpulse(data[0]);
+		break;
+
+	case b2Recorder::e_type:
+		{
+			int32 bodyType;
+			memcpy(&bodyType, data, sizeof(bodyType));
+			if (bodyType < b2_staticBody || bodyType > b2_dynamicBody)
+			{
+				return false;
+			}
+			body->SetType(b2BodyType(bodyType));
+		}
+		break;
+
+	case b2Recorder::e_awake:
+		body->SetAwake(flag != 0);
+		break;
+
+	case b2Recorder::e_active:
+		body->SetActive(flag != 0);
+		break;
+
+	case b2Recorder::e_bullet:
+		body->SetBullet(flag != 0);
+		break;
+
+	case b2Recorder::e_fixedRotation:
+		body->SetFixedRotation(flag != 0);
+		break;
+
+	case b2Recorder::e_sleepingAllowed:
+		body->SetSleepingAllowed(flag != 0);
+		break;
+
+	case b2Recorder::e_linearDamping:
+		body->SetLinearDamping(data[0]);
+		break;
+
+	case b2Recorder::e_angularDamping:
+		body->SetAngularDamping(data[0]);
+		break;
+
+	case b2Recorder::e_gravityScale:
+		body->SetGravityScale(data[0]);
+		break;
+
+	case b2Recorder::e_massData:
+		{
+			b2MassData massData;
+			memcpy(&massData, data, sizeof(massData));
+			body->SetMassData(&massData);
+		}
+		break;
+
+	case b2Recorder::e_resetMassData:
+		body->ResetMassData();
+		break;
+
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+void b2Replay::ReadJointDef(b2JointDef* def)
+{
+	uint8 enableLimit, enableMotor;
+
+	switch (def->type)
+	{
+	case e_revoluteJoint:
+		{
+			b2RevoluteJointDef* d = (b2RevoluteJointDef*)def;
+			m_reader.Read(&d->localAnchorA);
+			m_reader.Read(&d->localAnchorB);
+			m_reader.Read(&d->referenceAngle);
+			m_reader.Read(&enableLimit);
+			m_reader.Read(&d->lowerAngle);
+			m_reader.Read(&d->upperAngle);
+			m_reader.Read(&enableMotor);
+			m_reader.Read(&d->motorSpeed);
+			m_reader.Read(&d->maxMotorTorque);
+			d->enableLimit = enableLimit != 0;
+			d->enableMotor = enableMotor != 0;
+		}
+		break;
+
+	case e_prismaticJoint:
+		{
+			b2PrismaticJointDef* d = (b2PrismaticJointDef*)def;
+			m_reader.Read(&d->localAnchorA);
+			m_reader.Read(&d->localAnchorB);
+			m_reader.Read(&d->localAxisA);
+			m_reader.Read(&d->referenceAngle);
+			m_reader.Read(&enableLimit);
+			m_reader.Read(&d->lowerTranslation);
+			m_reader.Read(&d->upperTranslation);
+			m_reader.Read(&enableMotor);
+			m_reader.Read(&d->maxMotorForce);
+			m_reader.Read(&d->motorSpeed);
+			d->enableLimit = enableLimit != 0;
+			d->enableMotor = enableMotor != 0;
+		}
+		break;
+
+	case e_distanceJoint:
+		{
+			b2DistanceJointDef* d = (b2DistanceJointDef*)def;
+			m_reader.Read(&d->localAnchorA);
+			m_reader.Read(&d->localAnchorB);
+			m_reader.Read(&d->length);
+			m_reader.Read(&d->frequencyHz);
+			m_reader.Read(&d->dampingRatio);
+		}
+		break;
+
+	case e_pulleyJoint:
+		{
+			b2PulleyJointDef* d = (b2PulleyJointDef*)def;
+			m_reader.Read(&d->groundAnchorA);
+			m_reader.Read(&d->groundAnchorB);
+			m_reader.Read(&d->localAnchorA);
+			m_reader.Read(&d->localAnchorB);
+			m_reader.Read(&d->lengthA);
+			m_reader.Read(&d->lengthB);
+			m_reader.Read(&d->ratio);
+		}
+		break;
+
+	case e_mouseJoint:
+		{
+			b2MouseJointDef* d = (b2MouseJointDef*)def;
+			m_reader.Read(&d->target);
+			m_reader.Read(&d->maxForce);
+			m_reader.Read(&d->frequencyHz);
+			m_reader.Read(&d->dampingRatio);
+		}
+		break;
+
+	case e_gearJoint:
+		{
+			b2GearJointDef* d = (b2GearJointDef*)def;
+			m_reader.Read(&d->ratio);
+		}
+		break;
+
+	case e_wheelJoint:
+		{
+			b2WheelJointDef* d = (b2WheelJointDef*)def;
+			m_reader.Read(&d->localAnchorA);
+			m_reader.Read(&d->localAnchorB);
+			m_reader.Read(&d->localAxisA);
+			m_reader.Read(&enableMotor);
+			m_reader.Read(&d->maxMotorTorque);
+			m_reader.Read(&d->motorSpeed);
+			m_reader.Read(&d->frequencyHz);
+			m_reader.Read(&d->dampingRatio);
+			d->enableMotor = enableMotor != 0;
+		}
+		break;
+
+	case e_weldJoint:
+		{
+			b2WeldJointDef* d = (b2WeldJointDef*)def;
+			m_reader.Read(&d->localAnchorA);
+			m_reader.Read(&d->localAnchorB);
+			m_reader.Read(&d->referenceAngle);
+			m_reader.Read(&d->frequencyHz);
+			m_reader.Read(&d->dampingRatio);
+		}
+		break;
+
+	case e_frictionJoint:
+		{
+			b2FrictionJointDef* d = (b2FrictionJointDef*)def;
+			m_reader.Read(&d->localAnchorA);
+			m_reader.Read(&d->localAnchorB);
+			m_reader.Read(&d->maxForce);
+			m_reader.Read(&d->maxTorque);
+		}
+		break;
+
+	case e_ropeJoint:
+		{
+			b2RopeJointDef* d = (b2RopeJointDef*)def;
+			m_reader.Read(&d->localAnchorA);
+			m_reader.Read(&d->localAnchorB);
+			m_reader.Read(&d->maxLength);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+b2Body* b2Replay::ReadBody(b2World* world)
+{
+	int32 handle;
+	if (m_reader.Read(&handle) == false)
+	{
+		return NULL;
+	}
+
+	return world->GetBody(handle);
+}
+
+b2Fixture* b2Replay::ReadFixture(b2World* world)
+{
+	b2Body* body = ReadBody(world);
+	int32 index;
+	if (m_reader.Read(&index) == false || body == NULL)
+	{
+		return NULL;
+	}
+
+	b2Fixture* fixture = body->GetFixtureList();
+	for (int32 i = 0; i < index && fixture; ++i)
+	{
+		fixture = fixture->GetNext();
+	}
+	return fixture;
+}
+
+b2Joint* b2Replay::ReadJoint(int32* id)
+{
+	if (m_reader.Read(id) == false || *id < 0 || *id >= m_jointCount)
+	{
+		return NULL;
+	}
+
+	return m_joints[*id];
+}
+
+void b2Replay::AddJoint(b2Joint* joint)
+{
+	if (m_jointCount == m_jointCapacity)
+	{
+		m_jointCapacity = b2Max(2 * m_jointCapacity, 16);
+		b2Joint** joints = (b2Joint**)b2Alloc(m_jointCapacity * sizeof(b2Joint*));
+		if (m_joints)
+		{
+			memcpy(joints, m_joints, m_jointCount * sizeof(b2Joint*));
+			b2Free(m_joints);
+		}
+		m_joints = joints;
+	}
+
+	m_joints[m_jointCount++] = joint;
+}
+
+void b2Replay::ResetJoints(b2World* world)
+{
+	// Match the ids of b2Recorder::ResetJoints.
+	m_jointCount = 0;
+	for (b2Joint* j = world->GetJointList(); j; j = j->GetNext())
+	{
+		AddJoint(j);
+	}
+
+	for (int32 i = 0; i < m_jointCount / 2; ++i)
+	{
+		b2Swap(m_joints[i], m_joints[m_jointCount - 1 - i]);
+	}
+}
@@ -0,0 +1,210 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_RECORDER_H
+#define B2_RECORDER_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Common/b2Stream.h>
+
+class b2World;
+class b2Body;
+class b2Fixture;
+class b2Joint;
+struct b2BodyDef;
+struct b2FixtureDef;
+struct b2JointDef;
+
+/// Records the input of a world into a compact binary log: a snapshot when
+/// recording begins, then the calls that change the world. These are body,
+/// fixture and joint creation and destruction, forces, impulses, velocities,
+/// transforms, body and fixture settings, mouse joint targets and each Step
+/// with the world settings in effect. Other joint setters are not recorded.
+/// Calls made from callbacks during a step are replayed after that step.
+/// b2Replay runs a log on another world. Values are written field by field as
+/// fixed size little endian integers and floats, so a log recorded by a 32 bit
+/// device replays on a 64 bit desktop. The log starts with a format version
+/// that the replay checks.
+class b2Recorder
+{
+public:
+	b2Recorder();
+	~b2Recorder();
+
+	/// Start recording a world, dropping any previous log. Only one recorder
+	/// can record a world at a time.
+	/// @warning This function is locked during callbacks.
+	void Begin(b2World* world);
+
+	/// Stop recording. The log stays available.
+	void End();
+
+	/// Record a world again after End, appending to the log. This starts
+	/// with a snapshot of the world.
+	void Resume(b2World* world);
+
+	/// Is a world being recorded?
+	bool IsRecording() const { return m_world != NULL; }
+
+	/// Get the log.
+	const void* GetData() const { return m_data; }
+
+	/// Get the size of the log in bytes.
+	int32 GetSize() const { return m_size; }
+
+	enum RecordType
+	{
+		e_end = 0,
+		e_snapshot,
+		e_step,
+		e_clearForces,
+		e_createBody,
+		e_destroyBody,
+		e_createFixture,
+		e_destroyFixture,
+		e_fixture,
+		e_createJoint,
+		e_destroyJoint,
+		e_mouseTarget,
+
+		// Body records. The payload follows the body handle.
+		e_transform,
+		e_linearVelocity,
+		e_angularVelocity,
+		e_force,
+		e_forceToCenter,
+		e_torque,
+		e_linearImpulse,
+		e_angularImpulse,
+		e_type,
+		e_awake,
+		e_active,
+		e_bullet,
+		e_fixedRotation,
+		e_sleepingAllowed,
+		e_linearDamping,
+		e_angularDamping,
+		e_gravityScale,
+		e_massData,
+		e_resetMassData,
+		e_recordTypeCount
+	};
+
+	/// Get the payload size of a body record.
+	static int32 GetBodyRecordSize(int32 type);
+
+	/// These are internal functions called by the recorded world.
+	void RecordSnapshot();
+	void RecordStep(float32 dt, int32 velocityIterations, int32 positionIterations);
+	void RecordStepEnd();
+	void RecordClearForces();
+	void RecordCreateBody(b2Body* body, const b2BodyDef* def);
+	void RecordDestroyBody(b2Body* body);
+	void RecordCreateFixture(b2Body* body, const b2FixtureDef* def);
+	void RecordDestroyFixture(b2Fixture* fixture);
+	void RecordFixture(b2Fixture* fixture, bool refilter);
+	void RecordCreateJoint(b2Joint* joint, const b2JointDef* def);
+	void RecordDestroyJoint(b2Joint* joint);
+	void RecordMouseTarget(b2Joint* joint, const b2Vec2& target);
+	void RecordBody(b2Body* body, int32 type, const void* data, int32 size);
+
+private:
+
+	void Reserve(int32 size);
+	void Write(const void* data, int32 size);
+
+	template <typename T>
+	void Write(const T& value)
+	{
+		Write(&value, sizeof(T));
+	}
+
+	void WriteFixture(b2Fixture* fixture);
+	void WriteJointDef(const b2JointDef* def);
+	void MarkBodies(bool flag);
+	void ResetJoints();
+	void AddJoint(b2Joint* joint);
+	int32 FindJoint(const b2Joint* joint) const;
+
+	b2World* m_world;
+
+	// Calls made by the world during a step are not input.
+	bool m_inStep;
+
+	uint8* m_data;
+	int32 m_size;
+	int32 m_capacity;
+
+	// Joints by id. Ids are given oldest first and destroyed joints leave
+	// a NULL slot, so the replay gives out the same ids.
+	b2Joint** m_joints;
+	int32 m_jointCount;
+	int32 m_jointCapacity;
+};
+
+/// The parameters of a recorded step.
+struct b2ReplayStep
+{
+	float32 dt;
+	int32 velocityIterations;
+	int32 positionIterations;
+};
+
+/// Runs a log written by b2Recorder on a world. The log is not copied.
+class b2Replay
+{
+public:
+	b2Replay(const void* data, int32 size);
+	~b2Replay();
+
+	/// Apply the recorded calls up to the next step, including the world
+	/// settings of that step, then return the step parameters. The caller
+	/// steps the world, so it can time the step on its own.
+	/// @return false at the end of the log, or if the log does not match
+	/// the world. Records after the last step are applied first.
+	bool ReadStep(b2World* world, b2ReplayStep* step);
+
+	/// Was the whole log applied without errors?
+	bool IsComplete() const { return m_ok && m_reader.IsOk() && m_reader.GetRemaining() == 0; }
+
+	/// Get the reason the replay stopped, or NULL if there was no error.
+	const char* GetError() const { return m_error; }
+
+private:
+
+	bool ReadRecord(b2World* world, int32 type);
+	bool ReadBodyRecord(b2Body* body, int32 type);
+	void ReadJointDef(b2JointDef* def);
+	b2Body* ReadBody(b2World* world);
+	b2Fixture* ReadFixture(b2World* world);
+	b2Joint* ReadJoint(int32* id);
+	void AddJoint(b2Joint* joint);
+	void ResetJoints(b2World* world);
+	void Fail(const char* error);
+
+	b2StreamReader m_reader;
+	bool m_started;
+	bool m_ok;
+	const char* m_error;
+
+	b2Joint** m_joints;
+	int32 m_jointCount;
+	int32 m_jointCapacity;
+};
+
+#endif
@@ -0,0 +1,183 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2TOIQueue.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <string.h>
+
+b2TOIQueue::b2TOIQueue(b2Allocator* allocator)
+{
+	m_allocator = allocator;
+	m_entries = NULL;
+	m_count = 0;
+	m_capacity = 0;
+	m_sequence = 0;
+
+	m_wokenBodies = NULL;
+	m_wokenCount = 0;
+	m_wokenCapacity = 0;
+	m_recording = false;
+}
+
+b2TOIQueue::~b2TOIQueue()
+{
+	b2Free(m_allocator, m_entries);
+	b2Free(m_allocator, m_wokenBodies);
+}
+
+void b2TOIQueue::Begin()
+{
+	m_count = 0;
+	m_sequence = 0;
+	m_wokenCount = 0;
+	m_recording = true;
+}
+
+void b2TOIQueue::End()
+{
+	m_count = 0;
+	m_wokenCount = 0;
+	m_recording = false;
+}
+
+inline bool b2TOIQueue::Less(const b2TOIEntry& a, const b2TOIEntry& b)
+{
+	if (a.alpha != b.alpha)
+	{
+		return a.alpha < b.alpha;
+	}
+
+	return a.sequence < b.sequence;
+}
+
+void b2TOIQueue::Push(b2Contact* contact)
+{
+	b2Assert(contact->m_flags & b2Contact::e_toiFlag);
+
+	if (m_count == m_capacity)
+	{
+		b2TOIEntry* old = m_entries;
+		m_capacity = m_capacity > 0 ? 2 * m_capacity : 64;
+		m_entries = (b2TOIEntry*)b2Alloc(m_allocator, m_capacity * sizeof(b2TOIEntry), b2_allocTOIQueue);
+		if (old != NULL)
+		{
+			memcpy(m_entries, old, m_count * sizeof(b2TOIEntry));
+			b2Free(m_allocator, old);
+		}
+	}
+
+	// A new entry supersedes any older entry of this contact.
+	++m_sequence;
+	contact->m_toiSequence = m_sequence;
+
+	b2TOIEntry entry;
+	entry.alpha = contact->m_toi;
+	entry.sequence = m_sequence;
+	entry.contact = contact;
+
+	// Sift up.
+	int32 index = m_count++;
+	while (index > 0)
+	{
+		int32 parent = (index - 1) >> 1;
+		if (Less(entry, m_entries[parent]) == false)
+		{
+			break;
+		}
+
+		m_entries[index] = m_entries[parent];
+		index = parent;
+	}
+
+	m_entries[index] = entry;
+}
+
+b2Contact* b2TOIQueue::Pop()
+{
+	while (m_count > 0)
+	{
+		b2TOIEntry top = m_entries[0];
+
+		// Move the last entry to the root and sift down.
+		b2TOIEntry last = m_entries[--m_count];
+		int32 index = 0;
+		for (;;)
+		{
+			int32 child = 2 * index + 1;
+			if (child >= m_count)
+			{
+				break;
+			}
+
+			if (child + 1 < m_count && Less(m_entries[child + 1], m_entries[child]))
+			{
+				++child;
+			}
+
+			if (Less(m_entries[child], last) == false)
+			{
+				break;
+			}
+
+			m_entries[index] = m_entries[child];
+			index = child;
+		}
+
+		if (m_count > 0)
+		{
+			m_entries[index] = last;
+		}
+
+		b2Contact* contact = top.contact;
+		if ((contact->m_flags & b2Contact::e_toiFlag) && contact->m_toiSequence == top.sequence)
+		{
+			return contact;
+		}
+	}
+
+	return NULL;
+}
+
+void b2TOIQueue::AddWokenBody(b2Body* body)
+{
+	if (m_recording == false)
+	{
+		return;
+	}
+
+	if (m_wokenCount == m_wokenCapacity)
+	{
+		b2Body** old = m_wokenBodies;
+		m_wokenCapacity = m_wokenCapacity > 0 ? 2 * m_wokenCapacity : 16;
+		m_wokenBodies = (b2Body**)b2Alloc(m_allocator, m_wokenCapacity * sizeof(b2Body*), b2_allocTOIQueue);
+		memcpy(m_wokenBodies, old, m_wokenCount * sizeof(b2Body*));
+		b2Free(m_allocator, old);
+	}
+
+	m_wokenBodies[m_wokenCount++] = body;
+}
+
+b2Body* b2TOIQueue::PopWokenBody()
+{
+	if (m_wokenCount == 0)
+	{
+		return NULL;
+	}
+
+	return m_wokenBodies[--m_wokenCount];
+}
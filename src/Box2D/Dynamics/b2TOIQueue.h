@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TOI_QUEUE_H
+#define B2_TOI_QUEUE_H
+
+#include <Box2D/Common/b2Settings.h>
+
+class b2Body;
+class b2Contact;
+
+/// This is an internal class. A min-heap of contact TOIs used by b2World::SolveTOI.
+/// Entries are invalidated lazily: an entry is stale once its contact loses
+/// its TOI flag or is pushed again. The storage is kept between steps.
+class b2TOIQueue
+{
+public:
+	b2TOIQueue(b2Allocator* allocator = NULL);
+	~b2TOIQueue();
+
+	/// Start a TOI phase. This empties the queue and starts recording woken bodies.
+	void Begin();
+
+	/// End the TOI phase. This drops all entries.
+	void End();
+
+	/// Push a contact with a valid TOI in m_toi.
+	void Push(b2Contact* contact);
+
+	/// Remove the contact with the smallest TOI, skipping stale entries.
+	/// Ties go to the contact pushed first. Returns NULL when empty.
+	b2Contact* Pop();
+
+	/// Record a body that was woken during the TOI phase.
+	void AddWokenBody(b2Body* body);
+
+	/// Take a body recorded by AddWokenBody, or NULL when there are none.
+	b2Body* PopWokenBody();
+
+	/// Get the number of entries, including stale ones.
+	int32 GetCount() const;
+
+private:
+
+	struct b2TOIEntry
+	{
+		float32 alpha;
+		int32 sequence;
+		b2Contact* contact;
+	};
+
+	static bool Less(const b2TOIEntry& a, const b2TOIEntry& b);
+
+	b2TOIEntry* m_entries;
+	int32 m_count;
+	int32 m_capacity;
+	int32 m_sequence;
+
+	b2Body** m_wokenBodies;
+	int32 m_wokenCount;
+	int32 m_wokenCapacity;
+	bool m_recording;
+
+	b2Allocator* m_allocator;
+};
+
+inline int32 b2TOIQueue::GetCount() const
+{
+	return m_count;
+}
+
+#endif
@@ -21,7 +21,7 @@
 
 #include <Box2D/Common/b2Math.h>
 
-/// Profiling data. Times are in milliseconds.
+/// Profiling data. Times are in milliseconds. Counters are for one step.
 struct b2Profile
 {
 	float32 step;
@@ -32,6 +32,21 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+
+	int32 proxiesMoved;			///< fixture proxies synchronized with the broad-phase
+	int32 treeReinsertions;		///< proxies that left their fat AABB
+	int32 pairsFound;			///< unique pairs found by the broad-phase
+	int32 contactsCreated;
+	int32 contactsDestroyed;
+	int32 manifoldsUpdated;		///< narrow phase updates, including TOI
+	int32 islandCount;
+	int32 islandBodies;			///< bodies in all islands
+	int32 maxIslandBodies;		///< bodies in the largest island
+	int32 toiEvents;
+	int32 velocityIterations;	///< velocity iterations summed over islands
+	int32 positionIterations;	///< position iterations summed over islands
+	int32 allocCount;			///< heap allocations, see b2World::GetStepAllocations
+	int32 allocBytes;			///< bytes in heap allocations
 };
 
 /// This is an internal structure.
@@ -67,4 +82,12 @@ struct b2SolverData
 	b2Velocity* velocities;
 };
 
+/// Lanes of the wide contact solver compared with the scalar solver.
+/// See b2World::SetWideSolverCheck.
+struct b2WideSolverStats
+{
+	volatile int32 laneCount;
+	volatile int32 mismatchCount;	///< lanes that differ by more than a relative 1e-5
+};
+
 #endif
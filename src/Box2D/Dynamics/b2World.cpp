@@ -19,7 +19,9 @@
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2FixtureBatch.h>
 #include <Box2D/Dynamics/b2Island.h>
+#include <Box2D/Dynamics/b2Recorder.h>
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
@@ -31,23 +33,52 @@
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2ThreadPool.h>
 #include <Box2D/Common/b2Timer.h>
+#include <Box2D/Common/b2Trace.h>
 #include <new>
 
-b2World::b2World(const b2Vec2& gravity)
+// Add the solver times and counters of one or more islands to a step profile.
+static void b2AddIslandProfile(b2Profile* profile, const b2Profile& island)
+{
+	profile->solveInit += island.solveInit;
+	profile->solveVelocity += island.solveVelocity;
+	profile->solvePosition += island.solvePosition;
+	profile->islandCount += island.islandCount;
+	profile->islandBodies += island.islandBodies;
+	profile->maxIslandBodies = b2Max(profile->maxIslandBodies, island.maxIslandBodies);
+	profile->velocityIterations += island.velocityIterations;
+	profile->positionIterations += island.positionIterations;
+}
+
+b2World::b2World(const b2Vec2& gravity, b2Allocator* allocator)
+	: m_allocator(allocator),
+	m_allocCounter(allocator),
+	m_blockAllocator(&m_allocCounter),
+	m_stackAllocator(b2_stackSize, &m_allocCounter),
+	m_contactManager(&m_allocCounter),
+	m_toiQueue(&m_allocCounter),
+	m_bodyStore(&m_allocCounter)
 {
 	m_destructionListener = NULL;
 	m_debugDraw = NULL;
+	m_recorder = NULL;
 
 	m_bodyList = NULL;
 	m_jointList = NULL;
+	m_awakeBodyList = NULL;
 
 	m_bodyCount = 0;
 	m_jointCount = 0;
 
 	m_warmStarting = true;
 	m_continuousPhysics = true;
+	m_speculativeContacts = false;
 	m_subStepping = false;
+	m_coloredSolver = false;
+	m_wideSolverCheck = false;
+	m_wideSolverStats.laneCount = 0;
+	m_wideSolverStats.mismatchCount = 0;
 
 	m_stepComplete = true;
 
@@ -60,11 +91,28 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_contactManager.m_allocator = &m_blockAllocator;
 
+	m_threadPool = NULL;
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+	m_stackCapacity = b2_stackSize;
+
 	memset(&m_profile, 0, sizeof(b2Profile));
+	ResetProfileHistory();
+
+	m_forkBuffer = NULL;
+	m_forkCapacity = 0;
+
+	memset(&m_stepAllocations, 0, sizeof(b2AllocStats));
+	m_allocGuardSteps = -1;
 }
 
 b2World::~b2World()
 {
+	if (m_recorder)
+	{
+		m_recorder->End();
+	}
+
 	// Some shapes allocate using b2Alloc.
 	b2Body* b = m_bodyList;
 	while (b)
@@ -82,6 +130,67 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	SetThreadPool(NULL);
+
+	b2Free(&m_allocCounter, m_forkBuffer);
+}
+
+void b2World::SetThreadPool(b2ThreadPool* threadPool)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].~b2StackAllocator();
+	}
+	b2Free(&m_allocCounter, m_threadAllocators);
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+
+	m_threadPool = threadPool;
+
+	// The calling thread keeps using the world's stack allocator.
+	if (m_threadPool != NULL && m_threadPool->GetThreadCount() > 1)
+	{
+		m_threadAllocatorCount = m_threadPool->GetThreadCount() - 1;
+		m_threadAllocators = (b2StackAllocator*)b2Alloc(&m_allocCounter, m_threadAllocatorCount * sizeof(b2StackAllocator), b2_allocWorld);
+		for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+		{
+			new (m_threadAllocators + i) b2StackAllocator(m_stackCapacity, &m_allocCounter);
+		}
+	}
+}
+
+void b2World::SetWideSolverCheck(bool flag)
+{
+	if (flag && m_wideSolverCheck == false)
+	{
+		m_wideSolverStats.laneCount = 0;
+		m_wideSolverStats.mismatchCount = 0;
+	}
+
+	m_wideSolverCheck = flag;
+}
+
+void b2World::SetStackCapacity(int32 capacity)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_stackCapacity = capacity;
+	m_stackAllocator.SetCapacity(capacity);
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].SetCapacity(capacity);
+	}
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -125,6 +234,16 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	m_bodyList = b;
 	++m_bodyCount;
 
+	if (b->IsAwake() && b->m_type != b2_staticBody)
+	{
+		b->AddToAwakeList();
+	}
+
+	if (m_recorder)
+	{
+		m_recorder->RecordCreateBody(b, def);
+	}
+
 	return b;
 }
 
@@ -155,6 +274,12 @@ void b2World::DestroyBody(b2Body* b)
 	}
 	b->m_jointList = NULL;
 
+	// The joints were recorded on their own.
+	if (m_recorder)
+	{
+		m_recorder->RecordDestroyBody(b);
+	}
+
 	// Delete the attached contacts.
 	b2ContactEdge* ce = b->m_contactList;
 	while (ce)
@@ -165,6 +290,16 @@ void b2World::DestroyBody(b2Body* b)
 	}
 	b->m_contactList = NULL;
 
+	// Delete the attached sensor pairs.
+	b2SensorEdge* se = b->m_sensorList;
+	while (se)
+	{
+		b2SensorEdge* se0 = se;
+		se = se->next;
+		m_contactManager.Destroy(se0->pair);
+	}
+	b->m_sensorList = NULL;
+
 	// Delete the attached fixtures. This destroys broad-phase proxies.
 	b2Fixture* f = b->m_fixtureList;
 	while (f)
@@ -204,7 +339,14 @@ void b2World::DestroyBody(b2Body* b)
 		m_bodyList = b->m_next;
 	}
 
+	// Destroying joints and contacts may have woken the body.
+	if (b->m_flags & b2Body::e_awakeListFlag)
+	{
+		RemoveAwakeBody(b);
+	}
+
 	--m_bodyCount;
+	m_bodyStore.Destroy(b->m_handle);
 	b->~b2Body();
 	m_blockAllocator.Free(b, sizeof(b2Body));
 }
@@ -255,9 +397,10 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 		{
 			if (edge->other == bodyA)
 			{
-				// Flag the contact for filtering at the next time step (where either
-				// body is awake).
+				// Flag the contact for filtering at the next time step. Filtering
+				// happens on the awake list, even if both bodies sleep.
 				edge->contact->FlagForFiltering();
+				m_contactManager.AddAwakeContact(edge->contact);
 			}
 
 			edge = edge->next;
@@ -266,6 +409,11 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 
 	// Note: creating a joint doesn't wake the bodies.
 
+	if (m_recorder)
+	{
+		m_recorder->RecordCreateJoint(j, def);
+	}
+
 	return j;
 }
 
@@ -277,6 +425,11 @@ void b2World::DestroyJoint(b2Joint* j)
 		return;
 	}
 
+	if (m_recorder)
+	{
+		m_recorder->RecordDestroyJoint(j);
+	}
+
 	bool collideConnected = j->m_collideConnected;
 
 	// Remove from the doubly linked list.
@@ -354,9 +507,10 @@ void b2World::DestroyJoint(b2Joint* j)
 		{
 			if (edge->other == bodyA)
 			{
-				// Flag the contact for filtering at the next time step (where either
-				// body is awake).
+				// Flag the contact for filtering at the next time step. Filtering
+				// happens on the awake list, even if both bodies sleep.
 				edge->contact->FlagForFiltering();
+				m_contactManager.AddAwakeContact(edge->contact);
 			}
 
 			edge = edge->next;
@@ -364,6 +518,44 @@ void b2World::DestroyJoint(b2Joint* j)
 	}
 }
 
+void b2World::AddAwakeBody(b2Body* b)
+{
+	b2Assert((b->m_flags & b2Body::e_awakeListFlag) == 0);
+	b->m_flags |= b2Body::e_awakeListFlag;
+
+	b->m_awakePrev = NULL;
+	b->m_awakeNext = m_awakeBodyList;
+	if (m_awakeBodyList)
+	{
+		m_awakeBodyList->m_awakePrev = b;
+	}
+	m_awakeBodyList = b;
+}
+
+void b2World::RemoveAwakeBody(b2Body* b)
+{
+	b2Assert(b->m_flags & b2Body::e_awakeListFlag);
+
+	if (b->m_awakePrev)
+	{
+		b->m_awakePrev->m_awakeNext = b->m_awakeNext;
+	}
+
+	if (b->m_awakeNext)
+	{
+		b->m_awakeNext->m_awakePrev = b->m_awakePrev;
+	}
+
+	if (b == m_awakeBodyList)
+	{
+		m_awakeBodyList = b->m_awakeNext;
+	}
+
+	b->m_awakePrev = NULL;
+	b->m_awakeNext = NULL;
+	b->m_flags &= ~(b2Body::e_awakeListFlag | b2Body::e_islandFlag);
+}
+
 //
 void b2World::SetAllowSleeping(bool flag)
 {
@@ -382,162 +574,367 @@ void b2World::SetAllowSleeping(bool flag)
 	}
 }
 
-// Find islands, integrate and solve constraints, solve position constraints
-void b2World::Solve(const b2TimeStep& step)
+// Perform a depth first search (DFS) on the constraint graph starting at
+// the seed and add everything reached to the island.
+void b2World::BuildIsland(b2Body* seed, b2Body** stack, int32 stackSize, b2Island* island)
 {
-	m_profile.solveInit = 0.0f;
-	m_profile.solveVelocity = 0.0f;
-	m_profile.solvePosition = 0.0f;
+	B2_NOT_USED(stackSize);
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount,
-					m_contactManager.m_contactCount,
-					m_jointCount,
-					&m_stackAllocator,
-					m_contactManager.m_contactListener);
+	int32 stackCount = 0;
+	stack[stackCount++] = seed;
+	seed->m_flags |= b2Body::e_islandFlag;
 
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
-	{
-		b->m_flags &= ~b2Body::e_islandFlag;
-	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
-	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
-	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	while (stackCount > 0)
 	{
-		j->m_islandFlag = false;
-	}
+		// Grab the next body off the stack and add it to the island.
+		b2Body* b = stack[--stackCount];
+		b2Assert(b->IsActive() == true);
+		island->Add(b);
 
-	// Build and simulate all awake islands.
-	int32 stackSize = m_bodyCount;
-	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
-	{
-		if (seed->m_flags & b2Body::e_islandFlag)
+		// Make sure the body is awake.
+		b->SetAwake(true);
+
+		// To keep islands as small as possible, we don't
+		// propagate islands across static bodies.
+		if (b->GetType() == b2_staticBody)
 		{
 			continue;
 		}
 
-		if (seed->IsAwake() == false || seed->IsActive() == false)
+		// Search all contacts connected to this body.
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
 		{
-			continue;
+			b2Contact* contact = ce->contact;
+
+			// Has this contact already been added to an island?
+			if (contact->m_flags & b2Contact::e_islandFlag)
+			{
+				continue;
+			}
+
+			// Is this contact solid and touching or speculative?
+			if (contact->IsEnabled() == false ||
+				(contact->m_flags & (b2Contact::e_touchingFlag | b2Contact::e_speculativeFlag)) == 0)
+			{
+				continue;
+			}
+
+			// Sensors never create contacts.
+			b2Assert(contact->m_fixtureA->m_isSensor == false && contact->m_fixtureB->m_isSensor == false);
+
+			island->Add(contact);
+			contact->m_flags |= b2Contact::e_islandFlag;
+
+			b2Body* other = ce->other;
+
+			// Was the other body already added to this island?
+			if (other->m_flags & b2Body::e_islandFlag)
+			{
+				continue;
+			}
+
+			b2Assert(stackCount < stackSize);
+			stack[stackCount++] = other;
+			other->m_flags |= b2Body::e_islandFlag;
 		}
 
-		// The seed can be dynamic or kinematic.
-		if (seed->GetType() == b2_staticBody)
+		// Search all joints connect to this body.
+		for (b2JointEdge* je = b->m_jointList; je; je = je->next)
 		{
-			continue;
+			if (je->joint->m_islandFlag == true)
+			{
+				continue;
+			}
+
+			b2Body* other = je->other;
+
+			// Don't simulate joints connected to inactive bodies.
+			if (other->IsActive() == false)
+			{
+				continue;
+			}
+
+			island->Add(je->joint);
+			je->joint->m_islandFlag = true;
+
+			if (other->m_flags & b2Body::e_islandFlag)
+			{
+				continue;
+			}
+
+			b2Assert(stackCount < stackSize);
+			stack[stackCount++] = other;
+			other->m_flags |= b2Body::e_islandFlag;
 		}
+	}
+}
 
-		// Reset island and stack.
-		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
+// Find islands, integrate and solve constraints, solve position constraints
+void b2World::Solve(const b2TimeStep& step)
+{
+	m_profile.solveInit = 0.0f;
+	m_profile.solveVelocity = 0.0f;
+	m_profile.solvePosition = 0.0f;
 
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
+	// Clear the island flags. Only awake bodies and contacts can have them
+	// set, and every flagged joint is attached to an awake body.
+	for (b2Body* b = m_awakeBodyList; b; b = b->m_awakeNext)
+	{
+		b->m_flags &= ~b2Body::e_islandFlag;
+		for (b2JointEdge* je = b->m_jointList; je; je = je->next)
 		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
-			b2Assert(b->IsActive() == true);
-			island.Add(b);
+			je->joint->m_islandFlag = false;
+		}
+	}
+	for (b2Contact* c = m_contactManager.m_awakeContactList; c; c = c->m_awakeNext)
+	{
+		c->m_flags &= ~b2Contact::e_islandFlag;
+	}
 
-			// Make sure the body is awake.
-			b->SetAwake(true);
+	if (m_threadPool != NULL && m_threadPool->GetThreadCount() > 1)
+	{
+		SolveParallel(step);
+	}
+	else
+	{
+		// Size the island for the worst case.
+		b2Island island(&m_bodyStore,
+						m_bodyCount,
+						m_contactManager.m_contactCount,
+						m_jointCount,
+						&m_stackAllocator,
+						m_contactManager.m_contactListener);
+		island.m_colored = m_coloredSolver;
+		island.m_wideSolverStats = m_wideSolverCheck ? &m_wideSolverStats : NULL;
+
+		// Build and simulate all awake islands.
+		int32 stackSize = m_bodyCount;
+		b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+
+		// Bodies woken while building an island are pushed on the front of the
+		// awake list and are not visited here. They are in an island already.
+		b2Body* next = NULL;
+		for (b2Body* seed = m_awakeBodyList; seed; seed = next)
+		{
+			next = seed->m_awakeNext;
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
-			if (b->GetType() == b2_staticBody)
+			// Bodies that fell asleep in this step still need their fixtures
+			// synchronized, so they are only dropped in the next step.
+			if (seed->m_flags & b2Body::e_islandFlag)
 			{
 				continue;
 			}
 
-			// Search all contacts connected to this body.
-			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			// Drop bodies that fell asleep or became static.
+			if (seed->IsAwake() == false || seed->GetType() == b2_staticBody)
 			{
-				b2Contact* contact = ce->contact;
+				RemoveAwakeBody(seed);
+				continue;
+			}
 
-				// Has this contact already been added to an island?
-				if (contact->m_flags & b2Contact::e_islandFlag)
-				{
-					continue;
-				}
+			if (seed->IsActive() == false)
+			{
+				continue;
+			}
 
-				// Is this contact solid and touching?
-				if (contact->IsEnabled() == false ||
-					contact->IsTouching() == false)
-				{
-					continue;
-				}
+			// Reset island and search the constraint graph.
+			island.Clear();
+			BuildIsland(seed, stack, stackSize, &island);
 
-				// Skip sensors.
-				bool sensorA = contact->m_fixtureA->m_isSensor;
-				bool sensorB = contact->m_fixtureB->m_isSensor;
-				if (sensorA || sensorB)
+			b2Profile profile;
+			{
+				B2_TRACE_SCOPE_ARG("Island", island.m_bodyCount);
+				island.Solve(&profile, step, m_gravity, m_allowSleep);
+			}
+			b2AddIslandProfile(&m_profile, profile);
+
+			// Post solve cleanup.
+			for (int32 i = 0; i < island.m_bodyCount; ++i)
+			{
+				// Allow static bodies to participate in other islands.
+				b2Body* b = island.m_bodies[i];
+				if (b->GetType() == b2_staticBody)
 				{
-					continue;
+					b->m_flags &= ~b2Body::e_islandFlag;
 				}
+			}
+		}
 
-				island.Add(contact);
-				contact->m_flags |= b2Contact::e_islandFlag;
+		m_stackAllocator.Free(stack);
+	}
 
-				b2Body* other = ce->other;
+	{
+		B2_TRACE_SCOPE("Broadphase");
+		b2Timer timer;
+		bool speculative = m_continuousPhysics && m_speculativeContacts;
+
+		// Synchronize fixtures of the bodies that moved as one batch.
+		{
+			b2FixtureBatch batch(&m_stackAllocator);
 
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
+			for (b2Body* b = m_awakeBodyList; b; b = b->m_awakeNext)
+			{
+				// If a body was not in an island then it did not move.
+				if ((b->m_flags & b2Body::e_islandFlag) == 0 || b->GetType() == b2_staticBody)
 				{
 					continue;
 				}
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
+				batch.Count(b);
 			}
 
-			// Search all joints connect to this body.
-			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			batch.Allocate();
+
+			for (b2Body* b = m_awakeBodyList; b; b = b->m_awakeNext)
 			{
-				if (je->joint->m_islandFlag == true)
+				if ((b->m_flags & b2Body::e_islandFlag) == 0 || b->GetType() == b2_staticBody)
 				{
 					continue;
 				}
 
-				b2Body* other = je->other;
+				m_bodyStore.MarkMoved(b->m_handle);
 
-				// Don't simulate joints connected to inactive bodies.
-				if (other->IsActive() == false)
+				b2Transform xf1, xf2;
+				if (speculative)
 				{
-					continue;
+					b->GetPredictedTransforms(step.dt, &xf1, &xf2);
 				}
-
-				island.Add(je->joint);
-				je->joint->m_islandFlag = true;
-
-				if (other->m_flags & b2Body::e_islandFlag)
+				else
 				{
-					continue;
+					b->GetSweepTransforms(&xf1, &xf2);
 				}
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
+				batch.Add(b, xf1, xf2);
 			}
+
+			batch.Synchronize(&m_contactManager.m_broadPhase);
 		}
 
+		// Look for new contacts.
+		m_contactManager.FindNewContacts();
+		m_profile.broadphase = timer.GetMilliseconds();
+	}
+}
+
+/// A range of the island arrays gathered by b2World::SolveParallel.
+struct b2IslandRange
+{
+	int32 bodyStart, bodyCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+};
+
+/// Solves one gathered island per item. Each thread owns a stack allocator,
+/// a profile, and a set of position/velocity buffers.
+class b2SolveIslandsTask : public b2Task
+{
+public:
+	void Execute(int32 index, int32 threadIndex)
+	{
+		const b2IslandRange* r = ranges + islands[index];
+		b2Island island(store,
+						bodies + r->bodyStart, handles + r->bodyStart, indices + r->bodyStart, r->bodyCount,
+						contacts + r->contactStart, r->contactCount,
+						joints + r->jointStart, r->jointCount,
+						positions + threadIndex * slotCount,
+						velocities + threadIndex * slotCount,
+						allocators[threadIndex], NULL);
+
+		B2_TRACE_SCOPE_ARG("Island", r->bodyCount);
 		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
+		island.Solve(&profile, *step, gravity, allowSleep);
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		b2AddIslandProfile(profiles + threadIndex, profile);
+	}
+
+	const b2TimeStep* step;
+	b2Vec2 gravity;
+	bool allowSleep;
+
+	const b2IslandRange* ranges;
+	const int32* islands;
+	b2BodyStore* store;
+	b2Body** bodies;
+	int32* handles;
+	int32* indices;
+	b2Contact** contacts;
+	b2Joint** joints;
+
+	b2Position* positions;
+	b2Velocity* velocities;
+	int32 slotCount;
+
+	b2StackAllocator* allocators[b2_maxThreads];
+	b2Profile profiles[b2_maxThreads];
+};
+
+// Gather all awake islands up front, then solve them on the thread pool.
+// Dynamic and kinematic bodies belong to exactly one island, so their island
+// index is local to that island. Static bodies may be shared, so each gets a
+// slot past the largest island that every thread initializes on its own.
+// Contact reporting happens afterwards on this thread, in island order, so the
+// results do not depend on the thread count. Islands that are large enough to
+// be split by graph coloring are solved one at a time using all threads.
+void b2World::SolveParallel(const b2TimeStep& step)
+{
+	int32 threadCount = m_threadPool->GetThreadCount();
+	int32 contactCount = m_contactManager.m_contactCount;
+
+	// A static body appears once in every island it touches, which takes at
+	// least one constraint per appearance.
+	b2Island gathered(&m_bodyStore,
+					  m_bodyCount + contactCount + m_jointCount,
+					  contactCount,
+					  m_jointCount,
+					  &m_stackAllocator,
+					  m_contactManager.m_contactListener);
+
+	int32 stackSize = m_bodyCount;
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+	b2IslandRange* ranges = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+	int32 islandCount = 0;
+
+	// Bodies woken while building an island are pushed on the front of the
+	// awake list and are not visited here. They are in an island already.
+	b2Body* next = NULL;
+	for (b2Body* seed = m_awakeBodyList; seed; seed = next)
+	{
+		next = seed->m_awakeNext;
+
+		// Bodies that fell asleep in this step still need their fixtures
+		// synchronized, so they are only dropped in the next step.
+		if (seed->m_flags & b2Body::e_islandFlag)
 		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
+			continue;
+		}
+
+		// Drop bodies that fell asleep or became static.
+		if (seed->IsAwake() == false || seed->GetType() == b2_staticBody)
+		{
+			RemoveAwakeBody(seed);
+			continue;
+		}
+
+		if (seed->IsActive() == false)
+		{
+			continue;
+		}
+
+		b2IslandRange* r = ranges + islandCount++;
+		r->bodyStart = gathered.m_bodyCount;
+		r->contactStart = gathered.m_contactCount;
+		r->jointStart = gathered.m_jointCount;
+
+		BuildIsland(seed, stack, stackSize, &gathered);
+
+		r->bodyCount = gathered.m_bodyCount - r->bodyStart;
+		r->contactCount = gathered.m_contactCount - r->contactStart;
+		r->jointCount = gathered.m_jointCount - r->jointStart;
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = r->bodyStart; i < gathered.m_bodyCount; ++i)
+		{
+			b2Body* b = gathered.m_bodies[i];
 			if (b->GetType() == b2_staticBody)
 			{
 				b->m_flags &= ~b2Body::e_islandFlag;
@@ -545,48 +942,345 @@ void b2World::Solve(const b2TimeStep& step)
 		}
 	}
 
+	// Assign island indices.
+	int32 maxIslandSize = 0;
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		const b2IslandRange* r = ranges + i;
+		int32 localCount = 0;
+		for (int32 j = r->bodyStart; j < r->bodyStart + r->bodyCount; ++j)
+		{
+			b2Body* b = gathered.m_bodies[j];
+			if (b->GetType() != b2_staticBody)
+			{
+				b->m_islandIndex = localCount++;
+				gathered.m_indices[j] = b->m_islandIndex;
+			}
+		}
+		maxIslandSize = b2Max(maxIslandSize, localCount);
+	}
+
+	int32 slotCount = maxIslandSize;
+	for (int32 i = 0; i < gathered.m_bodyCount; ++i)
+	{
+		b2Body* b = gathered.m_bodies[i];
+		if (b->GetType() == b2_staticBody && (b->m_flags & b2Body::e_islandFlag) == 0)
+		{
+			b->m_islandIndex = slotCount++;
+			b->m_flags |= b2Body::e_islandFlag;
+		}
+	}
+	for (int32 i = 0; i < gathered.m_bodyCount; ++i)
+	{
+		b2Body* b = gathered.m_bodies[i];
+		if (b->GetType() == b2_staticBody)
+		{
+			gathered.m_indices[i] = b->m_islandIndex;
+		}
+	}
+
+	b2Position* positions = (b2Position*)m_stackAllocator.Allocate(threadCount * slotCount * sizeof(b2Position));
+	b2Velocity* velocities = (b2Velocity*)m_stackAllocator.Allocate(threadCount * slotCount * sizeof(b2Velocity));
+
+	// Small islands are solved concurrently.
+	int32* smallIslands = (int32*)m_stackAllocator.Allocate(islandCount * sizeof(int32));
+	int32 smallIslandCount = 0;
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		if (ranges[i].contactCount < b2_minColoredContacts)
+		{
+			smallIslands[smallIslandCount++] = i;
+		}
+	}
+
+	b2SolveIslandsTask task;
+	task.step = &step;
+	task.gravity = m_gravity;
+	task.allowSleep = m_allowSleep;
+	task.ranges = ranges;
+	task.islands = smallIslands;
+	task.store = &m_bodyStore;
+	task.bodies = gathered.m_bodies;
+	task.handles = gathered.m_handles;
+	task.indices = gathered.m_indices;
+	task.contacts = gathered.m_contacts;
+	task.joints = gathered.m_joints;
+	task.positions = positions;
+	task.velocities = velocities;
+	task.slotCount = slotCount;
+	task.allocators[0] = &m_stackAllocator;
+	for (int32 i = 1; i < threadCount; ++i)
+	{
+		task.allocators[i] = m_threadAllocators + i - 1;
+	}
+	memset(task.profiles, 0, sizeof(task.profiles));
+
+	m_threadPool->ParallelFor(&task, smallIslandCount);
+
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		b2AddIslandProfile(&m_profile, task.profiles[i]);
+	}
+
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		const b2IslandRange* r = ranges + i;
+		if (r->contactCount < b2_minColoredContacts)
+		{
+			continue;
+		}
+
+		b2Island island(&m_bodyStore,
+						gathered.m_bodies + r->bodyStart, gathered.m_handles + r->bodyStart,
+						gathered.m_indices + r->bodyStart, r->bodyCount,
+						gathered.m_contacts + r->contactStart, r->contactCount,
+						gathered.m_joints + r->jointStart, r->jointCount,
+						positions, velocities,
+						&m_stackAllocator, NULL);
+		island.m_threadPool = m_threadPool;
+		island.m_wideSolverStats = m_wideSolverCheck ? &m_wideSolverStats : NULL;
+
+		B2_TRACE_SCOPE_ARG("Colored island", r->bodyCount);
+		b2Profile profile;
+		island.Solve(&profile, step, m_gravity, m_allowSleep);
+		b2AddIslandProfile(&m_profile, profile);
+	}
+
+	// Static bodies did not move and must not be synchronized.
+	for (int32 i = 0; i < gathered.m_bodyCount; ++i)
+	{
+		b2Body* b = gathered.m_bodies[i];
+		if (b->GetType() == b2_staticBody)
+		{
+			b->m_flags &= ~b2Body::e_islandFlag;
+		}
+	}
+
+	gathered.Report();
+
+	m_stackAllocator.Free(smallIslands);
+	m_stackAllocator.Free(velocities);
+	m_stackAllocator.Free(positions);
+	m_stackAllocator.Free(ranges);
 	m_stackAllocator.Free(stack);
+}
 
+/// Computes the TOIs gathered by b2World::SolveTOI, one block of contacts per item.
+class b2ComputeTOITask : public b2Task
+{
+public:
+	enum
 	{
-		b2Timer timer;
-		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		e_blockSize = 16
+	};
+
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		int32 begin = index * e_blockSize;
+		int32 end = b2Min(begin + e_blockSize, count);
+		for (int32 i = begin; i < end; ++i)
+		{
+			alphas[i] = b2World::ComputeTOI(contacts[i]);
+		}
+	}
+
+	b2Contact** contacts;
+	float32* alphas;
+	int32 count;
+};
+
+// Is this contact a TOI candidate? If so, put the sweeps of its bodies onto
+// the same time interval.
+bool b2World::PrepareTOI(b2Contact* c)
+{
+	b2Assert((c->m_flags & b2Contact::e_toiFlag) == 0);
+
+	// Is this contact disabled?
+	if (c->IsEnabled() == false)
+	{
+		return false;
+	}
+
+	// Prevent excessive sub-stepping.
+	if (c->m_toiCount > b2_maxSubSteps)
+	{
+		return false;
+	}
+
+	b2Fixture* fA = c->GetFixtureA();
+	b2Fixture* fB = c->GetFixtureB();
+
+	b2Body* bA = fA->GetBody();
+	b2Body* bB = fB->GetBody();
+
+	b2BodyType typeA = bA->m_type;
+	b2BodyType typeB = bB->m_type;
+	b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
+
+	bool activeA = bA->IsAwake() && typeA != b2_staticBody;
+	bool activeB = bB->IsAwake() && typeB != b2_staticBody;
+
+	// Is at least one body active (awake and dynamic or kinematic)?
+	if (activeA == false && activeB == false)
+	{
+		return false;
+	}
+
+	bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
+	bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
+
+	// Are these two non-bullet dynamic bodies?
+	if (collideA == false && collideB == false)
+	{
+		return false;
+	}
+
+	// Put the sweeps onto the same time interval.
+	float32 alpha0 = bA->m_sim->sweep.alpha0;
+
+	if (bA->m_sim->sweep.alpha0 < bB->m_sim->sweep.alpha0)
+	{
+		alpha0 = bB->m_sim->sweep.alpha0;
+		bA->m_sim->sweep.Advance(alpha0);
+	}
+	else if (bB->m_sim->sweep.alpha0 < bA->m_sim->sweep.alpha0)
+	{
+		alpha0 = bA->m_sim->sweep.alpha0;
+		bB->m_sim->sweep.Advance(alpha0);
+	}
+
+	b2Assert(alpha0 < 1.0f);
+
+	return true;
+}
+
+// Compute the TOI of a contact prepared by PrepareTOI. This only reads the
+// sweeps and shapes, so it may run on any thread.
+float32 b2World::ComputeTOI(const b2Contact* c)
+{
+	const b2Fixture* fA = c->GetFixtureA();
+	const b2Fixture* fB = c->GetFixtureB();
+	const b2Body* bA = fA->GetBody();
+	const b2Body* bB = fB->GetBody();
+	float32 alpha0 = bA->m_sim->sweep.alpha0;
+
+	// PrepareTOI put the sweeps onto the same interval and nothing may have
+	// advanced either body since.
+	b2Assert(bB->m_sim->sweep.alpha0 == alpha0);
+
+	int32 indexA = c->GetChildIndexA();
+	int32 indexB = c->GetChildIndexB();
+
+	// Compute the time of impact in interval [0, minTOI]
+	b2TOIInput input;
+	input.proxyA.Set(fA->GetShape(), indexA);
+	input.proxyB.Set(fB->GetShape(), indexB);
+	input.sweepA = bA->m_sim->sweep;
+	input.sweepB = bB->m_sim->sweep;
+	input.tMax = 1.0f;
+
+	b2TOIOutput output;
+	b2TimeOfImpact(&output, &input);
+
+	// Beta is the fraction of the remaining portion of the .
+	float32 beta = output.t;
+	if (output.state == b2TOIOutput::e_touching)
+	{
+		return b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
+	}
+
+	return 1.0f;
+}
+
+// Cache the TOI of a contact and queue it.
+void b2World::SetTOI(b2Contact* c, float32 alpha)
+{
+	c->m_toi = alpha;
+	c->m_flags |= b2Contact::e_toiFlag;
+
+	if (alpha < 1.0f)
+	{
+		m_toiQueue.Push(c);
+	}
+	else
+	{
+		// Drop any older queue entry.
+		c->m_toiSequence = 0;
+	}
+}
+
+// Compute the TOI of a contact without a valid TOI and queue it when it is a candidate.
+void b2World::UpdateTOI(b2Contact* c)
+{
+	if (PrepareTOI(c))
+	{
+		SetTOI(c, ComputeTOI(c));
+	}
+}
+
+// Queue the contacts whose TOI may have changed during a TOI event.
+void b2World::RequeueTOI(const b2Island* island, b2Contact* tail)
+{
+	// Contacts of displaced bodies were invalidated.
+	if (island != NULL)
+	{
+		for (int32 i = 0; i < island->m_bodyCount; ++i)
 		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			b2Body* body = island->m_bodies[i];
+			if (body->m_type == b2_staticBody)
 			{
 				continue;
 			}
 
-			if (b->GetType() == b2_staticBody)
+			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 			{
-				continue;
+				if ((ce->contact->m_flags & b2Contact::e_toiFlag) == 0)
+				{
+					UpdateTOI(ce->contact);
+				}
 			}
+		}
+	}
 
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
+	// Contacts of woken bodies may have become active.
+	for (b2Body* body = m_toiQueue.PopWokenBody(); body; body = m_toiQueue.PopWokenBody())
+	{
+		for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+		{
+			if ((ce->contact->m_flags & b2Contact::e_toiFlag) == 0)
+			{
+				UpdateTOI(ce->contact);
+			}
 		}
+	}
 
-		// Look for new contacts.
-		m_contactManager.FindNewContacts();
-		m_profile.broadphase = timer.GetMilliseconds();
+	// New contacts are appended to the awake list.
+	b2Contact* c = tail ? tail->m_awakeNext : m_contactManager.m_awakeContactList;
+	for (; c; c = c->m_awakeNext)
+	{
+		if ((c->m_flags & b2Contact::e_toiFlag) == 0)
+		{
+			UpdateTOI(c);
+		}
 	}
 }
 
 // Find TOI contacts and solve them.
 void b2World::SolveTOI(const b2TimeStep& step)
 {
-	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
+	b2Island island(&m_bodyStore, 2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
 
 	if (m_stepComplete)
 	{
-		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		for (b2Body* b = m_awakeBodyList; b; b = b->m_awakeNext)
 		{
 			b->m_flags &= ~b2Body::e_islandFlag;
-			b->m_sweep.alpha0 = 0.0f;
+			b->m_sim->sweep.alpha0 = 0.0f;
 		}
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		for (b2Contact* c = m_contactManager.m_awakeContactList; c; c = c->m_awakeNext)
 		{
 			// Invalidate TOI
 			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
@@ -595,144 +1289,116 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		}
 	}
 
-	// Find TOI events and solve them.
-	for (;;)
+	// Gather the TOI candidates and compute their TOIs up front, on the thread
+	// pool when there are enough of them. Cached TOIs survive an interrupted
+	// sub-step and are queued right away. After an interrupted sub-step the
+	// bodies are on different intervals, so preparing a later candidate may
+	// advance a body of an earlier one. Those TOIs are computed one by one.
+	m_toiQueue.Begin();
 	{
-		// Find the first TOI.
-		b2Contact* minContact = NULL;
-		float32 minAlpha = 1.0f;
+		B2_TRACE_SCOPE("TOI candidates");
+		b2ComputeTOITask task;
+		task.contacts = (b2Contact**)m_stackAllocator.Allocate(m_contactManager.m_contactCount * sizeof(b2Contact*));
+		task.count = 0;
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		for (b2Contact* c = m_contactManager.m_awakeContactList; c; c = c->m_awakeNext)
 		{
-			// Is this contact disabled?
-			if (c->IsEnabled() == false)
+			if (c->m_flags & b2Contact::e_toiFlag)
 			{
-				continue;
+				if (c->m_toi < 1.0f)
+				{
+					m_toiQueue.Push(c);
+				}
 			}
-
-			// Prevent excessive sub-stepping.
-			if (c->m_toiCount > b2_maxSubSteps)
+			else if (m_stepComplete == false)
 			{
-				continue;
+				UpdateTOI(c);
 			}
-
-			float32 alpha = 1.0f;
-			if (c->m_flags & b2Contact::e_toiFlag)
+			else if (PrepareTOI(c))
 			{
-				// This contact has a valid cached TOI.
-				alpha = c->m_toi;
+				task.contacts[task.count++] = c;
 			}
-			else
-			{
-				b2Fixture* fA = c->GetFixtureA();
-				b2Fixture* fB = c->GetFixtureB();
-
-				// Is there a sensor?
-				if (fA->IsSensor() || fB->IsSensor())
-				{
-					continue;
-				}
-
-				b2Body* bA = fA->GetBody();
-				b2Body* bB = fB->GetBody();
-
-				b2BodyType typeA = bA->m_type;
-				b2BodyType typeB = bB->m_type;
-				b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
-
-				bool activeA = bA->IsAwake() && typeA != b2_staticBody;
-				bool activeB = bB->IsAwake() && typeB != b2_staticBody;
-
-				// Is at least one body active (awake and dynamic or kinematic)?
-				if (activeA == false && activeB == false)
-				{
-					continue;
-				}
-
-				bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
-				bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
-
-				// Are these two non-bullet dynamic bodies?
-				if (collideA == false && collideB == false)
-				{
-					continue;
-				}
-
-				// Compute the TOI for this contact.
-				// Put the sweeps onto the same time interval.
-				float32 alpha0 = bA->m_sweep.alpha0;
-
-				if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
-				{
-					alpha0 = bB->m_sweep.alpha0;
-					bA->m_sweep.Advance(alpha0);
-				}
-				else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
-				{
-					alpha0 = bA->m_sweep.alpha0;
-					bB->m_sweep.Advance(alpha0);
-				}
-
-				b2Assert(alpha0 < 1.0f);
-
-				int32 indexA = c->GetChildIndexA();
-				int32 indexB = c->GetChildIndexB();
+		}
 
-				// Compute the time of impact in interval [0, minTOI]
-				b2TOIInput input;
-				input.proxyA.Set(fA->GetShape(), indexA);
-				input.proxyB.Set(fB->GetShape(), indexB);
-				input.sweepA = bA->m_sweep;
-				input.sweepB = bB->m_sweep;
-				input.tMax = 1.0f;
+		task.alphas = (float32*)m_stackAllocator.Allocate(task.count * sizeof(float32));
 
-				b2TOIOutput output;
-				b2TimeOfImpact(&output, &input);
+		int32 blockCount = (task.count + b2ComputeTOITask::e_blockSize - 1) / b2ComputeTOITask::e_blockSize;
+		if (m_threadPool != NULL && m_threadPool->GetThreadCount() > 1 && task.count >= b2_minParallelTOIContacts)
+		{
+			m_threadPool->ParallelFor(&task, blockCount);
+		}
+		else
+		{
+			for (int32 i = 0; i < blockCount; ++i)
+			{
+				task.Execute(i, 0);
+			}
+		}
 
-				// Beta is the fraction of the remaining portion of the .
-				float32 beta = output.t;
-				if (output.state == b2TOIOutput::e_touching)
-				{
-					alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
-				}
-				else
-				{
-					alpha = 1.0f;
-				}
+		for (int32 i = 0; i < task.count; ++i)
+		{
+			SetTOI(task.contacts[i], task.alphas[i]);
+		}
 
-				c->m_toi = alpha;
-				c->m_flags |= b2Contact::e_toiFlag;
-			}
+		m_stackAllocator.Free(task.alphas);
+		m_stackAllocator.Free(task.contacts);
+	}
 
-			if (alpha < minAlpha)
+	// Find TOI events and solve them. Each event only updates the TOIs of
+	// the contacts it touched.
+	for (;;)
+	{
+		// Find the first TOI.
+		b2Contact* minContact = m_toiQueue.Pop();
+		while (minContact != NULL)
+		{
+			// The contact may have been disabled or sub-stepped since it was queued.
+			if (minContact->IsEnabled() && minContact->m_toiCount <= b2_maxSubSteps)
 			{
-				// This is the minimum TOI found so far.
-				minContact = c;
-				minAlpha = alpha;
+				break;
 			}
+
+			minContact = m_toiQueue.Pop();
 		}
 
+		float32 minAlpha = minContact != NULL ? minContact->m_toi : 1.0f;
+
 		if (minContact == NULL || 1.0f - 10.0f * b2_epsilon < minAlpha)
 		{
 			// No more TOI events. Done!
 			m_stepComplete = true;
+
+			// Sleeping bodies may have been advanced as the partner of an awake
+			// body. Rewind them now, since they can drop off the awake lists
+			// before the next TOI pass.
+			for (b2Contact* c = m_contactManager.m_awakeContactList; c; c = c->m_awakeNext)
+			{
+				c->m_fixtureA->m_body->m_sim->sweep.alpha0 = 0.0f;
+				c->m_fixtureB->m_body->m_sim->sweep.alpha0 = 0.0f;
+			}
 			break;
 		}
 
+		B2_TRACE_SCOPE("TOI event");
+
+		// Contacts created by this event are appended after the current tail.
+		b2Contact* tail = m_contactManager.m_awakeContactTail;
+
 		// Advance the bodies to the TOI.
 		b2Fixture* fA = minContact->GetFixtureA();
 		b2Fixture* fB = minContact->GetFixtureB();
 		b2Body* bA = fA->GetBody();
 		b2Body* bB = fB->GetBody();
 
-		b2Sweep backup1 = bA->m_sweep;
-		b2Sweep backup2 = bB->m_sweep;
+		b2Sweep backup1 = bA->m_sim->sweep;
+		b2Sweep backup2 = bB->m_sim->sweep;
 
 		bA->Advance(minAlpha);
 		bB->Advance(minAlpha);
 
 		// The TOI contact likely has some new contact points.
 		minContact->Update(m_contactManager.m_contactListener);
+		++m_contactManager.m_updateCount;
 		minContact->m_flags &= ~b2Contact::e_toiFlag;
 		++minContact->m_toiCount;
 
@@ -741,10 +1407,11 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		{
 			// Restore the sweeps.
 			minContact->SetEnabled(false);
-			bA->m_sweep = backup1;
-			bB->m_sweep = backup2;
+			bA->m_sim->sweep = backup1;
+			bB->m_sim->sweep = backup2;
 			bA->SynchronizeTransform();
 			bB->SynchronizeTransform();
+			RequeueTOI(NULL, tail);
 			continue;
 		}
 
@@ -796,16 +1463,8 @@ void b2World::SolveTOI(const b2TimeStep& step)
 						continue;
 					}
 
-					// Skip sensors.
-					bool sensorA = contact->m_fixtureA->m_isSensor;
-					bool sensorB = contact->m_fixtureB->m_isSensor;
-					if (sensorA || sensorB)
-					{
-						continue;
-					}
-
 					// Tentatively advance the body to the TOI.
-					b2Sweep backup = other->m_sweep;
+					b2Sweep backup = other->m_sim->sweep;
 					if ((other->m_flags & b2Body::e_islandFlag) == 0)
 					{
 						other->Advance(minAlpha);
@@ -813,11 +1472,12 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 					// Update the contact points
 					contact->Update(m_contactManager.m_contactListener);
+					++m_contactManager.m_updateCount;
 
 					// Was the contact disabled by the user?
 					if (contact->IsEnabled() == false)
 					{
-						other->m_sweep = backup;
+						other->m_sim->sweep = backup;
 						other->SynchronizeTransform();
 						continue;
 					}
@@ -825,7 +1485,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					// Are there contact points?
 					if (contact->IsTouching() == false)
 					{
-						other->m_sweep = backup;
+						other->m_sim->sweep = backup;
 						other->SynchronizeTransform();
 						continue;
 					}
@@ -861,6 +1521,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
+		++m_profile.toiEvents;
 
 		// Reset island flags and synchronize broad-phase proxies.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -874,6 +1535,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			}
 
 			body->SynchronizeFixtures();
+			m_bodyStore.MarkMoved(body->m_handle);
 
 			// Invalidate all contact TOIs on this displaced body.
 			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
@@ -891,13 +1553,42 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			m_stepComplete = false;
 			break;
 		}
+
+		RequeueTOI(&island, tail);
 	}
+
+	m_toiQueue.End();
 }
 
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
+	B2_TRACE_SCOPE("Step");
 	b2Timer stepTimer;
 
+	m_allocCounter.Reset();
+	m_allocCounter.SetGuarded(m_allocGuardSteps == 0);
+	if (m_allocGuardSteps > 0)
+	{
+		--m_allocGuardSteps;
+	}
+
+	if (m_recorder)
+	{
+		m_recorder->RecordStep(dt, velocityIterations, positionIterations);
+	}
+
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	broadPhase->ResetCounters();
+	m_contactManager.m_createCount = 0;
+	m_contactManager.m_destroyCount = 0;
+	m_contactManager.m_updateCount = 0;
+	m_profile.islandCount = 0;
+	m_profile.islandBodies = 0;
+	m_profile.maxIslandBodies = 0;
+	m_profile.toiEvents = 0;
+	m_profile.velocityIterations = 0;
+	m_profile.positionIterations = 0;
+
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_flags & e_newFixture)
 	{
@@ -926,22 +1617,26 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
+		B2_TRACE_SCOPE("Collide");
 		b2Timer timer;
-		m_contactManager.Collide();
+		float32 speculativeDt = m_continuousPhysics && m_speculativeContacts ? step.dt : 0.0f;
+		m_contactManager.Collide(speculativeDt);
 		m_profile.collide = timer.GetMilliseconds();
 	}
 
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	if (m_stepComplete && step.dt > 0.0f)
 	{
+		B2_TRACE_SCOPE("Solve");
 		b2Timer timer;
 		Solve(step);
 		m_profile.solve = timer.GetMilliseconds();
 	}
 
-	// Handle TOI events.
-	if (m_continuousPhysics && step.dt > 0.0f)
+	// Handle TOI events. Speculative contacts were solved with the rest.
+	if (m_continuousPhysics && m_speculativeContacts == false && step.dt > 0.0f)
 	{
+		B2_TRACE_SCOPE("SolveTOI");
 		b2Timer timer;
 		SolveTOI(step);
 		m_profile.solveTOI = timer.GetMilliseconds();
@@ -959,16 +1654,158 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 
 	m_flags &= ~e_locked;
 
+	if (m_recorder)
+	{
+		m_recorder->RecordStepEnd();
+	}
+
+	const b2BroadPhaseCounters& counters = broadPhase->GetCounters();
+	m_profile.proxiesMoved = counters.proxiesMoved;
+	m_profile.treeReinsertions = counters.treeReinsertions;
+	m_profile.pairsFound = counters.pairsFound;
+	m_profile.contactsCreated = m_contactManager.m_createCount;
+	m_profile.contactsDestroyed = m_contactManager.m_destroyCount;
+	m_profile.manifoldsUpdated = m_contactManager.m_updateCount;
+
+	m_allocCounter.SetGuarded(false);
+	m_stepAllocations = m_allocCounter.GetStats();
+	m_profile.allocCount = m_stepAllocations.count;
+	m_profile.allocBytes = m_stepAllocations.bytes;
+
 	m_profile.step = stepTimer.GetMilliseconds();
+
+	m_profileHistory[m_profileHistoryIndex] = m_profile;
+	m_profileHistoryIndex = (m_profileHistoryIndex + 1) % b2_profileHistory;
+	m_profileHistoryCount = b2Min(m_profileHistoryCount + 1, b2_profileHistory);
+}
+
+// Apply an operation to every field of a profile.
+template <typename T>
+static void b2ForEachProfileField(b2Profile* a, const b2Profile& b, const T& op)
+{
+	op(a->step, b.step);
+	op(a->collide, b.collide);
+	op(a->solve, b.solve);
+	op(a->solveInit, b.solveInit);
+	op(a->solveVelocity, b.solveVelocity);
+	op(a->solvePosition, b.solvePosition);
+	op(a->broadphase, b.broadphase);
+	op(a->solveTOI, b.solveTOI);
+	op(a->proxiesMoved, b.proxiesMoved);
+	op(a->treeReinsertions, b.treeReinsertions);
+	op(a->pairsFound, b.pairsFound);
+	op(a->contactsCreated, b.contactsCreated);
+	op(a->contactsDestroyed, b.contactsDestroyed);
+	op(a->manifoldsUpdated, b.manifoldsUpdated);
+	op(a->islandCount, b.islandCount);
+	op(a->islandBodies, b.islandBodies);
+	op(a->maxIslandBodies, b.maxIslandBodies);
+	op(a->toiEvents, b.toiEvents);
+	op(a->velocityIterations, b.velocityIterations);
+	op(a->positionIterations, b.positionIterations);
+	op(a->allocCount, b.allocCount);
+	op(a->allocBytes, b.allocBytes);
+}
+
+struct b2ProfileMin
+{
+	template <typename T>
+	void operator()(T& a, T b) const { a = b2Min(a, b); }
+};
+
+struct b2ProfileMax
+{
+	template <typename T>
+	void operator()(T& a, T b) const { a = b2Max(a, b); }
+};
+
+struct b2ProfileAdd
+{
+	template <typename T>
+	void operator()(T& a, T b) const { a += b; }
+};
+
+struct b2ProfileDivide
+{
+	template <typename T>
+	void operator()(T& a, T) const { a = T(a / count); }
+
+	int32 count;
+};
+
+int32 b2World::GetProfileHistory(b2Profile* minimum, b2Profile* average, b2Profile* maximum) const
+{
+	b2Profile minProfile, sumProfile, maxProfile;
+	memset(&sumProfile, 0, sizeof(b2Profile));
+	memset(&minProfile, 0, sizeof(b2Profile));
+	memset(&maxProfile, 0, sizeof(b2Profile));
+
+	if (m_profileHistoryCount > 0)
+	{
+		minProfile = m_profileHistory[0];
+		maxProfile = m_profileHistory[0];
+	}
+
+	for (int32 i = 0; i < m_profileHistoryCount; ++i)
+	{
+		const b2Profile& p = m_profileHistory[i];
+		b2ForEachProfileField(&minProfile, p, b2ProfileMin());
+		b2ForEachProfileField(&maxProfile, p, b2ProfileMax());
+		b2ForEachProfileField(&sumProfile, p, b2ProfileAdd());
+	}
+
+	if (m_profileHistoryCount > 0)
+	{
+		b2ProfileDivide divide;
+		divide.count = m_profileHistoryCount;
+		b2ForEachProfileField(&sumProfile, sumProfile, divide);
+	}
+
+	if (minimum)
+	{
+		*minimum = minProfile;
+	}
+
+	if (average)
+	{
+		*average = sumProfile;
+	}
+
+	if (maximum)
+	{
+		*maximum = maxProfile;
+	}
+
+	return m_profileHistoryCount;
+}
+
+void b2World::ResetProfileHistory()
+{
+	m_profileHistoryCount = 0;
+	m_profileHistoryIndex = 0;
+}
+
+int32 b2World::ExportTransforms(b2BodyPose* poses, int32 capacity, bool movedOnly)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return 0;
+	}
+
+	return m_bodyStore.Export(poses, capacity, movedOnly);
 }
 
 void b2World::ClearForces()
 {
-	for (b2Body* body = m_bodyList; body; body = body->GetNext())
+	if (m_recorder)
 	{
-		body->m_force.SetZero();
-		body->m_torque = 0.0f;
+		m_recorder->RecordClearForces();
 	}
+
+	// The forces are packed, so one pass over the store is cheaper than
+	// walking the awake list.
+	m_bodyStore.ClearForces();
 }
 
 struct b2WorldQueryWrapper
@@ -1256,6 +2093,16 @@ float32 b2World::GetTreeQuality() const
 	return m_contactManager.m_broadPhase.GetTreeQuality();
 }
 
+void b2World::SetBlockChunkSize(int32 size)
+{
+	m_blockAllocator.SetChunkSize(size);
+}
+
+void b2World::GetBlockAllocatorStats(b2BlockAllocatorStats* stats) const
+{
+	m_blockAllocator.GetStats(stats);
+}
+
 void b2World::Dump()
 {
 	if ((m_flags & e_locked) == e_locked)
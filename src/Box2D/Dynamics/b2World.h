@@ -20,9 +20,12 @@
 #define B2_WORLD_H
 
 #include <Box2D/Common/b2Math.h>
+#include <Box2D/Common/b2AllocCounter.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
+#include <Box2D/Dynamics/b2TOIQueue.h>
+#include <Box2D/Dynamics/b2BodyStore.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -33,7 +36,12 @@ struct b2JointDef;
 class b2Body;
 class b2Draw;
 class b2Fixture;
+class b2Island;
 class b2Joint;
+class b2ThreadPool;
+class b2Recorder;
+class b2StreamReader;
+struct b2SnapshotObjects;
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -43,7 +51,11 @@ class b2World
 public:
 	/// Construct a world object.
 	/// @param gravity the world gravity vector.
-	b2World(const b2Vec2& gravity);
+	/// @param allocator the heap for all memory of the world, or NULL for b2Alloc.
+	/// It must outlive the world. Chain shape vertices still come from b2Alloc.
+	/// If the allocator can release everything at once, such as an arena, a
+	/// world without chain shapes can be dropped without running its destructor.
+	b2World(const b2Vec2& gravity, b2Allocator* allocator = NULL);
 
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
@@ -61,11 +73,38 @@ public:
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
 
+	/// Solve islands in parallel on a thread pool. Islands with many contacts
+	/// are also split across threads by graph coloring. The pool is owned by you
+	/// and must remain in scope. Pass NULL to solve on the calling thread, which
+	/// is the default. Results are identical for any pool with two or more
+	/// threads. Contact PostSolve callbacks are reported after all islands
+	/// are solved.
+	/// @warning This function is locked during callbacks.
+	void SetThreadPool(b2ThreadPool* threadPool);
+
+	/// Get the thread pool used for solving, or NULL.
+	b2ThreadPool* GetThreadPool() const { return m_threadPool; }
+
+	/// Set the initial size in bytes of the per-step stack allocators. There
+	/// is one for each solver thread. They grow when a step needs more and
+	/// keep their high-water size, so the heap is only used while growing.
+	/// The default is b2_stackSize.
+	/// @warning This function is locked during callbacks.
+	void SetStackCapacity(int32 capacity);
+
+	/// Get the stack allocator of the thread that calls Step, for its peak
+	/// usage and fallback count. The other pool threads have their own stack
+	/// allocators, which are not exposed.
+	const b2StackAllocator& GetStackAllocator() const;
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside with b2World::DrawDebugData method. The debug draw object is owned
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2Draw* debugDraw);
 
+	/// Get the recorder of this world, or NULL. See b2Recorder::Begin.
+	b2Recorder* GetRecorder() const { return m_recorder; }
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
@@ -153,16 +192,63 @@ public:
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 	bool GetContinuousPhysics() const { return m_continuousPhysics; }
 
+	/// Use speculative contacts instead of time of impact sub-stepping for
+	/// continuous physics. Contacts get a predicted point before the shapes
+	/// touch and are solved in the regular solver pass, so there are no TOI
+	/// events. This is cheaper with many fast bodies, but a body can stop
+	/// slightly short of a surface and bodies are only predicted to move in a
+	/// straight line. Only applies when continuous physics is enabled.
+	void SetSpeculativeContacts(bool flag) { m_speculativeContacts = flag; }
+	bool GetSpeculativeContacts() const { return m_speculativeContacts; }
+
 	/// Enable/disable single stepped continuous physics. For testing.
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Solve every lane of the wide contact solver with the scalar solver as
+	/// well and count the lanes that differ. This is slow and does nothing when
+	/// B2_SIMD_WIDTH is 0. Enabling it resets the counts. For testing.
+	void SetWideSolverCheck(bool flag);
+	const b2WideSolverStats& GetWideSolverStats() const { return m_wideSolverStats; }
+
+	/// Solve the contacts of large islands by graph color, which lets the wide
+	/// SIMD solver batch them. The solve order differs from the sequential
+	/// solver, so results change slightly. Islands are always colored when a
+	/// thread pool with more than one thread is attached. Off by default.
+	void SetColoredSolver(bool flag) { m_coloredSolver = flag; }
+	bool GetColoredSolver() const { return m_coloredSolver; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
 	/// Get the number of bodies.
 	int32 GetBodyCount() const;
 
+	/// Get the body with a handle from b2Body::GetHandle, or NULL if no body has it.
+	b2Body* GetBody(int32 handle);
+
+	/// Get an upper bound on body handles. Use this to size arrays indexed by handle.
+	int32 GetBodyHandleCount() const;
+
+	/// Get the number of bodies whose transform changed since the last export.
+	/// This may overcount destroyed bodies.
+	int32 GetMovedBodyCount() const;
+
+	/// Write the poses of bodies into a caller array for render sync. The solver
+	/// flags a body when its transform changes: in a step, in SetTransform and
+	/// on creation. With movedOnly set, only flagged bodies are written, so the
+	/// cost follows the number of moving bodies rather than the body count.
+	/// Otherwise all bodies are written in handle order.
+	/// With movedOnly, the flags of the bodies written are cleared and flagged
+	/// bodies that do not fit are kept for the next call. Without it, all flags
+	/// are cleared when every body fits and none are cleared otherwise.
+	/// @param poses the caller array.
+	/// @param capacity the length of the caller array.
+	/// @param movedOnly write only the bodies that moved since the last export.
+	/// @return the number of poses written.
+	/// @warning This function is locked during callbacks.
+	int32 ExportTransforms(b2BodyPose* poses, int32 capacity, bool movedOnly = true);
+
 	/// Get the number of joints.
 	int32 GetJointCount() const;
 
@@ -179,6 +265,14 @@ public:
 	/// The minimum is 1.
 	float32 GetTreeQuality() const;
 
+	/// Set the size of the chunks that the block allocator for bodies, fixtures,
+	/// joints and contacts takes from b2Alloc. Smaller chunks waste less memory
+	/// in small worlds. Existing chunks keep their size.
+	void SetBlockChunkSize(int32 size);
+
+	/// Get memory statistics of that block allocator.
+	void GetBlockAllocatorStats(b2BlockAllocatorStats* stats) const;
+
 	/// Change the global gravity vector.
 	void SetGravity(const b2Vec2& gravity);
 	
@@ -200,10 +294,67 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Get the minimum, average and maximum of every profile field over the
+	/// last b2_profileHistory steps. Any of the outputs may be NULL.
+	/// @return the number of steps in the history.
+	int32 GetProfileHistory(b2Profile* minimum, b2Profile* average, b2Profile* maximum) const;
+
+	/// Forget the profile history, for example after loading a level.
+	void ResetProfileHistory();
+
+	/// Get the allocator passed to the constructor.
+	b2Allocator* GetAllocator() const { return m_allocator; }
+
+	/// Get the heap allocations made during the last step, by call site.
+	/// Once the allocators have grown to fit the scene this should be empty.
+	const b2AllocStats& GetStepAllocations() const { return m_stepAllocations; }
+
+	/// Assert on any heap allocation during a step after this many more
+	/// steps, to catch allocations that cause latency spikes. The allocation
+	/// is logged with its call site first. Use -1, the default, to turn the
+	/// check off.
+	void SetAllocationGuard(int32 warmUpSteps) { m_allocGuardSteps = warmUpSteps; }
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
 
+	/// Write a binary snapshot of the world: bodies, fixtures, shapes, joints,
+	/// contacts with their warm starting impulses, sensor pairs and the broad-phase
+	/// tree. Stepping a loaded snapshot in the same program gives the same results
+	/// as stepping this world. The format does not depend on the pointer size or
+	/// the structure padding, so a snapshot also loads in a build for another
+	/// little endian target. User data pointers are not written.
+	/// @param buffer the destination, or NULL to measure the snapshot.
+	/// @param capacity the size of the destination in bytes.
+	/// @return the size of the snapshot in bytes. If this is larger than the
+	/// capacity, the buffer does not hold a usable snapshot.
+	/// @warning This function is locked during callbacks.
+	int32 SaveSnapshot(void* buffer, int32 capacity);
+
+	/// Replace the contents of the world with a snapshot written by SaveSnapshot.
+	/// Existing bodies and joints are destroyed without calling listeners. Body
+	/// handles, body order and fixture order are restored, so user data can be
+	/// set again by handle. Listeners, the debug draw and the thread pool are kept.
+	/// @return false if the snapshot is malformed or has another version. The
+	/// world is then empty.
+	/// @warning This function is locked during callbacks.
+	bool LoadSnapshot(const void* buffer, int32 size);
+
+	/// Make another world an independent copy of this one, for example to
+	/// step ahead and look at the outcome of an action. The copy keeps its own
+	/// listeners and allocator. It goes through a snapshot kept in a scratch
+	/// buffer that this world reuses, so repeated forks do not allocate once
+	/// the buffer has grown. Body handles are the same in both worlds.
+	/// @return false if the copy failed. The other world is then empty.
+	/// @warning This function is locked during callbacks.
+	bool Fork(b2World* world);
+
+	/// Destroy all bodies, fixtures and joints without calling listeners. The
+	/// settings, listeners and thread pool are kept.
+	/// @warning This function is locked during callbacks.
+	void Clear();
+
 private:
 
 	// m_flags
@@ -218,22 +369,64 @@ private:
 	friend class b2Fixture;
 	friend class b2ContactManager;
 	friend class b2Controller;
+	friend class b2ComputeTOITask;
+	friend class b2Recorder;
+
+	// Create the objects of a snapshot after the header and the bulk state.
+	bool ReadSnapshot(b2StreamReader* reader, b2SnapshotObjects* objects);
 
 	void Solve(const b2TimeStep& step);
+	void SolveParallel(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
+	// TOI computation is split so that SolveTOI can compute the TOIs of many
+	// candidates on the thread pool. PrepareTOI and SetTOI run serially. This
+	// is only done at the start of a step, while all sweeps begin at zero.
+	bool PrepareTOI(b2Contact* c);
+	static float32 ComputeTOI(const b2Contact* c);
+	void SetTOI(b2Contact* c, float32 alpha);
+
+	// Compute the TOI of a contact without a valid TOI and queue it when it is a candidate.
+	void UpdateTOI(b2Contact* c);
+
+	// After a TOI event, queue the contacts it may have changed: those of the
+	// island bodies, of bodies woken by the event, and contacts created after tail.
+	void RequeueTOI(const b2Island* island, b2Contact* tail);
+
+	void BuildIsland(b2Body* seed, b2Body** stack, int32 stackSize, b2Island* island);
+
+	// Awake, non-static bodies are kept on the awake list so that a step
+	// only visits them. Removal is lazy: Solve drops bodies that fell asleep.
+	void AddAwakeBody(b2Body* b);
+	void RemoveAwakeBody(b2Body* b);
+
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
+	b2Allocator* m_allocator;
+
+	// Everything below allocates through this, so steps can be audited.
+	b2AllocCounter m_allocCounter;
+	b2AllocStats m_stepAllocations;
+	int32 m_allocGuardSteps;
+
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
+	b2ThreadPool* m_threadPool;
+	b2StackAllocator* m_threadAllocators;
+	int32 m_threadAllocatorCount;
+	int32 m_stackCapacity;
+
 	int32 m_flags;
 
 	b2ContactManager m_contactManager;
+	b2TOIQueue m_toiQueue;
+	b2BodyStore m_bodyStore;
 
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
+	b2Body* m_awakeBodyList;
 
 	int32 m_bodyCount;
 	int32 m_jointCount;
@@ -243,6 +436,7 @@ private:
 
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
+	b2Recorder* m_recorder;
 
 	// This is used to compute the time step ratio to
 	// support a variable time step.
@@ -251,11 +445,22 @@ private:
 	// These are for debugging the solver.
 	bool m_warmStarting;
 	bool m_continuousPhysics;
+	bool m_speculativeContacts;
 	bool m_subStepping;
+	bool m_coloredSolver;
+	bool m_wideSolverCheck;
+	b2WideSolverStats m_wideSolverStats;
 
 	bool m_stepComplete;
 
 	b2Profile m_profile;
+	b2Profile m_profileHistory[b2_profileHistory];
+	int32 m_profileHistoryCount;
+	int32 m_profileHistoryIndex;
+
+	// Snapshot scratch space for Fork.
+	void* m_forkBuffer;
+	int32 m_forkCapacity;
 };
 
 inline b2Body* b2World::GetBodyList()
@@ -293,6 +498,25 @@ inline int32 b2World::GetBodyCount() const
 	return m_bodyCount;
 }
 
+inline b2Body* b2World::GetBody(int32 handle)
+{
+	if (handle < 0 || handle >= m_bodyStore.GetCount())
+	{
+		return NULL;
+	}
+	return m_bodyStore.GetBody(handle);
+}
+
+inline int32 b2World::GetBodyHandleCount() const
+{
+	return m_bodyStore.GetCount();
+}
+
+inline int32 b2World::GetMovedBodyCount() const
+{
+	return m_bodyStore.GetMovedCount();
+}
+
 inline int32 b2World::GetJointCount() const
 {
 	return m_jointCount;
@@ -341,6 +565,11 @@ inline const b2ContactManager& b2World::GetContactManager() const
 	return m_contactManager;
 }
 
+inline const b2StackAllocator& b2World::GetStackAllocator() const
+{
+	return m_stackAllocator;
+}
+
 inline const b2Profile& b2World::GetProfile() const
 {
 	return m_profile;
@@ -89,6 +89,24 @@ public:
 	/// Called when two fixtures cease to touch.
 	virtual void EndContact(b2Contact* contact) { B2_NOT_USED(contact); }
 
+	/// Called when a sensor fixture begins to overlap another fixture.
+	/// Sensors do not create contacts, so they report through this instead
+	/// of BeginContact.
+	/// @param sensor the sensor fixture
+	/// @param other the overlapping fixture, which may also be a sensor
+	virtual void BeginOverlap(b2Fixture* sensor, b2Fixture* other)
+	{
+		B2_NOT_USED(sensor);
+		B2_NOT_USED(other);
+	}
+
+	/// Called when a sensor fixture ceases to overlap another fixture.
+	virtual void EndOverlap(b2Fixture* sensor, b2Fixture* other)
+	{
+		B2_NOT_USED(sensor);
+		B2_NOT_USED(other);
+	}
+
 	/// This is called after a contact is updated. This allows you to inspect a
 	/// contact before it goes to the solver. If you are careful, you can modify the
 	/// contact manifold (e.g. disable contact).
@@ -0,0 +1,253 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2WorldGroup.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Common/b2Timer.h>
+#include <Box2D/Common/b2Trace.h>
+#include <algorithm>
+#include <cstring>
+
+const int32 b2_nullWorld = -1;
+
+// Runs the queue of each item and then steals.
+class b2StepWorldsTask : public b2Task
+{
+public:
+	b2StepWorldsTask(b2WorldGroup* group) : m_group(group) {}
+
+	void Execute(int32 index, int32 threadIndex)
+	{
+		m_group->StepWorlds(index, threadIndex);
+	}
+
+	b2WorldGroup* m_group;
+};
+
+// Orders world indices by the time of their last step, longest first.
+struct b2StepTimeGreater
+{
+	b2StepTimeGreater(const b2WorldGroup::b2WorldEntry* entries) : m_entries(entries) {}
+
+	bool operator()(int32 a, int32 b) const
+	{
+		float32 timeA = m_entries[a].stepTime;
+		float32 timeB = m_entries[b].stepTime;
+		if (timeA != timeB)
+		{
+			return timeA > timeB;
+		}
+
+		return a < b;
+	}
+
+	const b2WorldGroup::b2WorldEntry* m_entries;
+};
+
+b2WorldGroup::b2WorldGroup(b2ThreadPool* threadPool)
+{
+	m_threadPool = threadPool;
+
+	m_entries = NULL;
+	m_count = 0;
+	m_capacity = 0;
+
+	m_queueCount = 0;
+	m_items = NULL;
+	m_order = NULL;
+
+	m_timeStep = 0.0f;
+	m_velocityIterations = 0;
+	m_positionIterations = 0;
+	m_stealCount = 0;
+}
+
+b2WorldGroup::~b2WorldGroup()
+{
+	b2Free(m_entries);
+	b2Free(m_items);
+	b2Free(m_order);
+}
+
+int32 b2WorldGroup::AddWorld(b2World* world)
+{
+	b2Assert(world != NULL);
+
+	if (m_count == m_capacity)
+	{
+		int32 capacity = b2Max(2 * m_capacity, 16);
+
+		b2WorldEntry* entries = (b2WorldEntry*)b2Alloc(capacity * sizeof(b2WorldEntry));
+		if (m_entries)
+		{
+			memcpy(entries, m_entries, m_count * sizeof(b2WorldEntry));
+		}
+
+		b2Free(m_entries);
+		b2Free(m_items);
+		b2Free(m_order);
+
+		m_entries = entries;
+		m_items = (int32*)b2Alloc(capacity * sizeof(int32));
+		m_order = (int32*)b2Alloc(capacity * sizeof(int32));
+		m_capacity = capacity;
+	}
+
+	b2WorldEntry* entry = m_entries + m_count;
+	entry->world = world;
+	entry->stepTime = 0.0f;
+	entry->threadIndex = 0;
+	return m_count++;
+}
+
+void b2WorldGroup::RemoveWorld(b2World* world)
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		if (m_entries[i].world == world)
+		{
+			m_entries[i] = m_entries[m_count - 1];
+			--m_count;
+			return;
+		}
+	}
+
+	b2Assert(false);
+}
+
+void b2WorldGroup::Step(float32 timeStep, int32 velocityIterations, int32 positionIterations)
+{
+	B2_TRACE_SCOPE("WorldGroup");
+
+	m_timeStep = timeStep;
+	m_velocityIterations = velocityIterations;
+	m_positionIterations = positionIterations;
+	m_stealCount = 0;
+
+	if (m_count == 0)
+	{
+		return;
+	}
+
+	int32 threadCount = m_threadPool != NULL ? m_threadPool->GetThreadCount() : 1;
+	m_queueCount = b2Min(threadCount, m_count);
+
+	// Longest first, using the times of the last step.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_order[i] = i;
+	}
+	std::sort(m_order, m_order + m_count, b2StepTimeGreater(m_entries));
+
+	// Deal the worlds out in turn, so each queue starts with a long one.
+	int32 start = 0;
+	for (int32 q = 0; q < m_queueCount; ++q)
+	{
+		b2WorldQueue* queue = m_queues + q;
+		queue->items = m_items + start;
+		queue->head = 0;
+		queue->tail = 0;
+		queue->stealCount = 0;
+
+		for (int32 i = q; i < m_count; i += m_queueCount)
+		{
+			queue->items[queue->tail++] = m_order[i];
+		}
+
+		start += queue->tail;
+	}
+
+	if (m_queueCount == 1)
+	{
+		StepWorlds(0, 0);
+		return;
+	}
+
+	b2StepWorldsTask task(this);
+	m_threadPool->ParallelFor(&task, m_queueCount);
+
+	for (int32 q = 0; q < m_queueCount; ++q)
+	{
+		m_stealCount += m_queues[q].stealCount;
+	}
+}
+
+int32 b2WorldGroup::Pop(int32 queueIndex)
+{
+	b2WorldQueue* queue = m_queues + queueIndex;
+	int32 index = b2_nullWorld;
+
+	queue->lock.Lock();
+	if (queue->head < queue->tail)
+	{
+		index = queue->items[queue->head++];
+	}
+	queue->lock.Unlock();
+
+	return index;
+}
+
+int32 b2WorldGroup::Steal(int32 queueIndex)
+{
+	// Visit the other queues in turn so thieves spread out.
+	for (int32 i = 1; i < m_queueCount; ++i)
+	{
+		b2WorldQueue* queue = m_queues + (queueIndex + i) % m_queueCount;
+		int32 index = b2_nullWorld;
+
+		queue->lock.Lock();
+		if (queue->head < queue->tail)
+		{
+			index = queue->items[--queue->tail];
+		}
+		queue->lock.Unlock();
+
+		if (index != b2_nullWorld)
+		{
+			++m_queues[queueIndex].stealCount;
+			return index;
+		}
+	}
+
+	return b2_nullWorld;
+}
+
+void b2WorldGroup::StepWorlds(int32 queueIndex, int32 threadIndex)
+{
+	for (;;)
+	{
+		int32 index = Pop(queueIndex);
+		if (index == b2_nullWorld)
+		{
+			index = Steal(queueIndex);
+		}
+
+		if (index == b2_nullWorld)
+		{
+			break;
+		}
+
+		b2WorldEntry* entry = m_entries + index;
+		b2Assert(m_threadPool == NULL || entry->world->GetThreadPool() != m_threadPool);
+
+		b2Timer timer;
+		entry->world->Step(m_timeStep, m_velocityIterations, m_positionIterations);
+		entry->stepTime = timer.GetMilliseconds();
+		entry->threadIndex = threadIndex;
+	}
+}
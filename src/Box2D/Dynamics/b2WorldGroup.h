@@ -0,0 +1,142 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WORLD_GROUP_H
+#define B2_WORLD_GROUP_H
+
+#include <Box2D/Common/b2Settings.h>
+#include <Box2D/Common/b2ThreadPool.h>
+
+class b2World;
+
+/// Steps many independent worlds on one thread pool. Each pool thread has a
+/// queue of worlds and takes worlds from the other queues when its own is
+/// empty. Worlds are dealt out by the time of their last step, longest
+/// first, so a large world starts early instead of holding up the step at
+/// the end. A world is stepped by one thread at a time and uses its own
+/// allocators, so worlds share no memory. Callbacks of a world run on the
+/// thread that steps it.
+class b2WorldGroup
+{
+public:
+	/// @param threadPool the pool that steps the worlds, or NULL to step them
+	/// on the calling thread. The pool is owned by you and must remain in scope.
+	b2WorldGroup(b2ThreadPool* threadPool);
+	~b2WorldGroup();
+
+	/// Add a world. The world is owned by you and must remain in scope until
+	/// it is removed. A world can be in one group only. Its own thread pool, if
+	/// any, must not be the pool of the group.
+	/// @return the index of the world.
+	int32 AddWorld(b2World* world);
+
+	/// Remove a world. The last world takes its index.
+	void RemoveWorld(b2World* world);
+
+	/// Get the number of worlds.
+	int32 GetWorldCount() const;
+
+	/// Get a world by index.
+	b2World* GetWorld(int32 index) const;
+
+	/// Step every world once and wait for all of them.
+	/// @see b2World::Step
+	void Step(float32 timeStep, int32 velocityIterations, int32 positionIterations);
+
+	/// Get the time in milliseconds the last Step spent in a world.
+	float32 GetStepTime(int32 index) const;
+
+	/// Get the pool thread that stepped a world in the last Step.
+	int32 GetStepThread(int32 index) const;
+
+	/// Get the number of worlds the last Step took from the queue of another thread.
+	int32 GetStealCount() const;
+
+	/// This is an internal function.
+	void StepWorlds(int32 queueIndex, int32 threadIndex);
+
+	/// A world and the results of its last step.
+	struct b2WorldEntry
+	{
+		b2World* world;
+		float32 stepTime;
+		int32 threadIndex;
+	};
+
+private:
+
+	// Worlds waiting for a thread. The owner pops from the front and other
+	// threads steal from the back.
+	struct b2WorldQueue
+	{
+		int32* items;
+		int32 head;
+		int32 tail;
+		int32 stealCount;
+		b2SpinLock lock;
+	};
+
+	int32 Pop(int32 queueIndex);
+	int32 Steal(int32 queueIndex);
+
+	b2ThreadPool* m_threadPool;
+
+	b2WorldEntry* m_entries;
+	int32 m_count;
+	int32 m_capacity;
+
+	b2WorldQueue m_queues[b2_maxThreads];
+	int32 m_queueCount;
+	int32* m_items;
+	int32* m_order;
+
+	float32 m_timeStep;
+	int32 m_velocityIterations;
+	int32 m_positionIterations;
+	int32 m_stealCount;
+};
+
+inline int32 b2WorldGroup::GetWorldCount() const
+{
+	return m_count;
+}
+
+inline b2World* b2WorldGroup::GetWorld(int32 index) const
+{
+	b2Assert(0 <= index && index < m_count);
+	return m_entries[index].world;
+}
+
+inline float32 b2WorldGroup::GetStepTime(int32 index) const
+{
+	b2Assert(0 <= index && index < m_count);
+	return m_entries[index].stepTime;
+}
+
+inline int32 b2WorldGroup::GetStepThread(int32 index) const
+{
+	b2Assert(0 <= index && index < m_count);
+	return m_entries[index].threadIndex;
+}
+
+inline int32 b2WorldGroup::GetStealCount() const
+{
+	return m_stealCount;
+}
+
+#endif
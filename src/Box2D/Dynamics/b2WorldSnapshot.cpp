@@ -0,0 +1,1161 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2Recorder.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2FrictionJoint.h>
+#include <Box2D/Dynamics/Joints/b2GearJoint.h>
+#include <Box2D/Dynamics/Joints/b2MouseJoint.h>
+#include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
+#include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/Joints/b2RopeJoint.h>
+#include <Box2D/Dynamics/Joints/b2WeldJoint.h>
+#include <Box2D/Dynamics/Joints/b2WheelJoint.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Common/b2Stream.h>
+#include <new>
+
+// A snapshot holds, in order:
+// - the header: magic, version and object counts;
+// - the world settings;
+// - the body store slots and the broad-phase tree, copied in bulk;
+// - the bodies in list order, each followed by its fixtures and shapes;
+// - the joints from oldest to newest, so gear joints follow their joints;
+// - the contacts and the sensor pairs in list order;
+// - the joint, contact and sensor edge lists of each body;
+// - the awake body and contact lists, and an end marker.
+// Pointers are written as body handles or as indices in write order. Every
+// value is a fixed size integer or float, so a snapshot does not depend on the
+// pointer size or the structure padding of the build that wrote it.
+
+static const uint32 b2_snapshotMagic = 0x4E533242;	// "B2SN"
+static const uint32 b2_snapshotEnd = 0x444E4542;	// "BEND"
+static const int32 b2_snapshotVersion = 3;
+
+struct b2SnapshotIndex
+{
+	const void* pointer;
+	int32 index;
+};
+
+// Maps the objects of a world to their write order. This is an open addressing
+// hash table that is at most half full.
+class b2SnapshotMap
+{
+public:
+	b2SnapshotMap(b2StackAllocator* allocator, int32 count)
+	{
+		m_capacity = 16;
+		m_shift = 28;
+		while (m_capacity < 2 * count)
+		{
+			m_capacity *= 2;
+			--m_shift;
+		}
+
+		m_allocator = allocator;
+		m_entries = (b2SnapshotIndex*)m_allocator->Allocate(m_capacity * sizeof(b2SnapshotIndex));
+		for (int32 i = 0; i < m_capacity; ++i)
+		{
+			m_entries[i].pointer = NULL;
+		}
+		m_count = 0;
+	}
+
+	~b2SnapshotMap()
+	{
+		m_allocator->Free(m_entries);
+	}
+
+	void Add(const void* pointer)
+	{
+		b2Assert(2 * m_count < m_capacity);
+		int32 i = Hash(pointer);
+		while (m_entries[i].pointer != NULL)
+		{
+			i = (i + 1) & (m_capacity - 1);
+		}
+		m_entries[i].pointer = pointer;
+		m_entries[i].index = m_count;
+		++m_count;
+	}
+
+	int32 Find(const void* pointer) const
+	{
+		int32 i = Hash(pointer);
+		while (m_entries[i].pointer != pointer)
+		{
+			b2Assert(m_entries[i].pointer != NULL);
+			i = (i + 1) & (m_capacity - 1);
+		}
+		return m_entries[i].index;
+	}
+
+private:
+	int32 Hash(const void* pointer) const
+	{
+		// Fibonacci hashing of the block address.
+		uint32 key = uint32(size_t(pointer) >> 3);
+		return int32((key * 2654435761u) >> m_shift);
+	}
+
+	b2StackAllocator* m_allocator;
+	b2SnapshotIndex* m_entries;
+	int32 m_capacity;
+	int32 m_shift;
+	int32 m_count;
+};
+
+// The objects created so far by a load, indexed in write order.
+struct b2SnapshotObjects
+{
+	b2Body** bodies;
+	b2Fixture** fixtures;
+	b2Joint** joints;
+	b2Contact** contacts;
+	b2SensorPair** pairs;
+	int32 bodyCount;
+	int32 fixtureCount;
+	int32 jointCount;
+	int32 contactCount;
+	int32 pairCount;
+};
+
+// Manifolds are written field by field with only the points in use. The rest
+// of an empty manifold is never set.
+static void b2SaveManifold(b2StreamWriter* writer, const b2Manifold* manifold)
+{
+	writer->Write(manifold->pointCount);
+	if (manifold->pointCount == 0)
+	{
+		return;
+	}
+
+	writer->Write(int32(manifold->type));
+	writer->Write(manifold->localNormal);
+	writer->Write(manifold->localPoint);
+	for (int32 i = 0; i < manifold->pointCount; ++i)
+	{
+		const b2ManifoldPoint* mp = manifold->points + i;
+		writer->Write(mp->localPoint);
+		writer->Write(mp->normalImpulse);
+		writer->Write(mp->tangentImpulse);
+		writer->Write(mp->id.key);
+	}
+}
+
+static bool b2LoadManifold(b2StreamReader* reader, b2Manifold* manifold)
+{
+	reader->Read(&manifold->pointCount);
+	if (reader->IsOk() == false || manifold->pointCount < 0 || manifold->pointCount > b2_maxManifoldPoints)
+	{
+		return false;
+	}
+
+	if (manifold->pointCount == 0)
+	{
+		return true;
+	}
+
+	int32 type;
+	reader->Read(&type);
+	reader->Read(&manifold->localNormal);
+	reader->Read(&manifold->localPoint);
+	manifold->type = b2Manifold::Type(type);
+	for (int32 i = 0; i < manifold->pointCount; ++i)
+	{
+		b2ManifoldPoint* mp = manifold->points + i;
+		reader->Read(&mp->localPoint);
+		reader->Read(&mp->normalImpulse);
+		reader->Read(&mp->tangentImpulse);
+		reader->Read(&mp->id.key);
+	}
+
+	return reader->IsOk() && b2Manifold::e_circles <= type && type <= b2Manifold::e_faceB;
+}
+
+int32 b2World::SaveSnapshot(void* buffer, int32 capacity)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return 0;
+	}
+
+	b2StreamWriter writer(buffer, capacity);
+
+	int32 fixtureCount = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		fixtureCount += b->m_fixtureCount;
+	}
+
+	int32 contactCount = m_contactManager.m_contactCount;
+	int32 pairCount = m_contactManager.m_sensorCount;
+
+	writer.Write(b2_snapshotMagic);
+	writer.Write(b2_snapshotVersion);
+	writer.Write(m_bodyCount);
+	writer.Write(fixtureCount);
+	writer.Write(m_jointCount);
+	writer.Write(contactCount);
+	writer.Write(pairCount);
+
+	writer.Write(m_gravity);
+	writer.Write(m_flags);
+	writer.Write(m_inv_dt0);
+	writer.Write(uint8(m_allowSleep));
+	writer.Write(uint8(m_warmStarting));
+	writer.Write(uint8(m_continuousPhysics));
+	writer.Write(uint8(m_speculativeContacts));
+	writer.Write(uint8(m_subStepping));
+	writer.Write(uint8(m_coloredSolver));
+	writer.Write(uint8(m_stepComplete));
+
+	m_bodyStore.Save(&writer);
+	m_contactManager.m_broadPhase.Save(&writer);
+
+	// Bodies and fixtures. The hot body state is in the store.
+	b2SnapshotMap fixtureMap(&m_stackAllocator, fixtureCount);
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		writer.Write(b->m_handle);
+		writer.Write(int32(b->m_type));
+		writer.Write(uint16(b->m_flags & ~b2Body::e_recordFlag));
+		writer.Write(b->m_islandIndex);
+		writer.Write(b->m_prevPosition);
+		writer.Write(b->m_prevAngle);
+		writer.Write(b->m_mass);
+		writer.Write(b->m_I);
+		writer.Write(b->m_motion->linearDamping);
+		writer.Write(b->m_motion->angularDamping);
+		writer.Write(b->m_motion->gravityScale);
+		writer.Write(b->m_sleepTime);
+		writer.Write(b->m_fixtureCount);
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			fixtureMap.Add(f);
+
+			writer.Write(f->m_density);
+			writer.Write(f->m_friction);
+			writer.Write(f->m_restitution);
+			writer.Write(f->m_filter);
+			writer.Write(uint8(f->m_isSensor));
+			b2SaveShape(&writer, f->m_shape);
+
+			writer.Write(f->m_proxyCount);
+			for (int32 i = 0; i < f->m_proxyCount; ++i)
+			{
+				const b2FixtureProxy* proxy = f->m_proxies + i;
+				writer.Write(proxy->aabb);
+				writer.Write(proxy->childIndex);
+				writer.Write(proxy->proxyId);
+			}
+		}
+	}
+
+	// Joints, oldest first.
+	b2Joint* oldest = m_jointList;
+	while (oldest && oldest->m_next)
+	{
+		oldest = oldest->m_next;
+	}
+
+	b2SnapshotMap jointMap(&m_stackAllocator, m_jointCount);
+	for (b2Joint* j = oldest; j; j = j->m_prev)
+	{
+		jointMap.Add(j);
+	}
+
+	for (b2Joint* j = oldest; j; j = j->m_prev)
+	{
+		writer.Write(int32(j->m_type));
+		writer.Write(j->m_bodyA->m_handle);
+		writer.Write(j->m_bodyB->m_handle);
+		writer.Write(uint8(j->m_collideConnected));
+		writer.Write(uint8(j->m_islandFlag));
+		writer.Write(j->m_index);
+
+		if (j->m_type == e_gearJoint)
+		{
+			const b2GearJoint* gear = (const b2GearJoint*)j;
+			writer.Write(jointMap.Find(gear->m_joint1));
+			writer.Write(jointMap.Find(gear->m_joint2));
+		}
+
+		j->SaveState(&writer);
+	}
+
+	// Contacts with their manifolds and warm starting impulses.
+	b2SnapshotMap contactMap(&m_stackAllocator, contactCount);
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		contactMap.Add(c);
+
+		writer.Write(fixtureMap.Find(c->m_fixtureA));
+		writer.Write(c->m_indexA);
+		writer.Write(fixtureMap.Find(c->m_fixtureB));
+		writer.Write(c->m_indexB);
+		writer.Write(c->m_flags);
+		b2SaveManifold(&writer, &c->m_manifold);
+		writer.Write(c->m_toiCount);
+		writer.Write(c->m_toi);
+		writer.Write(c->m_toiSequence);
+		writer.Write(c->m_friction);
+		writer.Write(c->m_restitution);
+	}
+
+	b2SnapshotMap pairMap(&m_stackAllocator, pairCount);
+	for (b2SensorPair* p = m_contactManager.m_sensorList; p; p = p->next)
+	{
+		pairMap.Add(p);
+
+		writer.Write(fixtureMap.Find(p->fixtureA));
+		writer.Write(p->indexA);
+		writer.Write(fixtureMap.Find(p->fixtureB));
+		writer.Write(p->indexB);
+		writer.Write(p->flags);
+	}
+
+	// Edge lists. An edge is written as twice its object index, plus one for
+	// the edge of body B.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		int32 count = 0;
+		for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+		{
+			++count;
+		}
+		writer.Write(count);
+		for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+		{
+			int32 side = je == &je->joint->m_edgeB ? 1 : 0;
+			writer.Write(2 * jointMap.Find(je->joint) + side);
+		}
+
+		count = 0;
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			++count;
+		}
+		writer.Write(count);
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			int32 side = ce == &ce->contact->m_nodeB ? 1 : 0;
+			writer.Write(2 * contactMap.Find(ce->contact) + side);
+		}
+
+		count = 0;
+		for (b2SensorEdge* se = b->m_sensorList; se; se = se->next)
+		{
+			++count;
+		}
+		writer.Write(count);
+		for (b2SensorEdge* se = b->m_sensorList; se; se = se->next)
+		{
+			int32 side = se == &se->pair->nodeB ? 1 : 0;
+			writer.Write(2 * pairMap.Find(se->pair) + side);
+		}
+	}
+
+	// Awake lists.
+	int32 count = 0;
+	for (b2Body* b = m_awakeBodyList; b; b = b->m_awakeNext)
+	{
+		++count;
+	}
+	writer.Write(count);
+	for (b2Body* b = m_awakeBodyList; b; b = b->m_awakeNext)
+	{
+		writer.Write(b->m_handle);
+	}
+
+	count = 0;
+	for (b2Contact* c = m_contactManager.m_awakeContactList; c; c = c->m_awakeNext)
+	{
+		++count;
+	}
+	writer.Write(count);
+	for (b2Contact* c = m_contactManager.m_awakeContactList; c; c = c->m_awakeNext)
+	{
+		writer.Write(contactMap.Find(c));
+	}
+
+	writer.Write(b2_snapshotEnd);
+	return writer.GetSize();
+}
+
+bool b2World::LoadSnapshot(const void* buffer, int32 size)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return false;
+	}
+
+	// Record the loaded world rather than the calls that clear this one.
+	if (m_recorder)
+	{
+		b2Recorder* recorder = m_recorder;
+		recorder->End();
+		bool ok = LoadSnapshot(buffer, size);
+		recorder->Resume(this);
+		return ok;
+	}
+
+	Clear();
+
+	b2StreamReader reader(buffer, size);
+
+	uint32 magic;
+	int32 version;
+	reader.Read(&magic);
+	reader.Read(&version);
+	if (reader.IsOk() == false || magic != b2_snapshotMagic || version != b2_snapshotVersion)
+	{
+		return false;
+	}
+
+	b2SnapshotObjects objects;
+	reader.Read(&objects.bodyCount);
+	reader.Read(&objects.fixtureCount);
+	reader.Read(&objects.jointCount);
+	reader.Read(&objects.contactCount);
+	reader.Read(&objects.pairCount);
+
+	// Every object takes more than four bytes.
+	int32 limit = reader.GetRemaining() / 4;
+	if (reader.IsOk() == false ||
+		objects.bodyCount < 0 || objects.bodyCount > limit ||
+		objects.fixtureCount < 0 || objects.fixtureCount > limit ||
+		objects.jointCount < 0 || objects.jointCount > limit ||
+		objects.contactCount < 0 || objects.contactCount > limit ||
+		objects.pairCount < 0 || objects.pairCount > limit)
+	{
+		return false;
+	}
+
+	int32 objectCount = objects.bodyCount + objects.fixtureCount + objects.jointCount +
+		objects.contactCount + objects.pairCount;
+	void** memory = (void**)m_stackAllocator.Allocate(b2Max(objectCount, 1) * sizeof(void*));
+	objects.bodies = (b2Body**)memory;
+	objects.fixtures = (b2Fixture**)(objects.bodies + objects.bodyCount);
+	objects.joints = (b2Joint**)(objects.fixtures + objects.fixtureCount);
+	objects.contacts = (b2Contact**)(objects.joints + objects.jointCount);
+	objects.pairs = (b2SensorPair**)(objects.contacts + objects.contactCount);
+
+	bool ok = ReadSnapshot(&reader, &objects);
+
+	m_stackAllocator.Free(memory);
+
+	if (ok == false)
+	{
+		Clear();
+	}
+
+	return ok;
+}
+
+bool b2World::ReadSnapshot(b2StreamReader* reader, b2SnapshotObjects* objects)
+{
+	int32 flags;
+	uint8 allowSleep, warmStarting, continuousPhysics, speculativeContacts, subStepping, coloredSolver, stepComplete;
+	reader->Read(&m_gravity);
+	reader->Read(&flags);
+	reader->Read(&m_inv_dt0);
+	reader->Read(&allowSleep);
+	reader->Read(&warmStarting);
+	reader->Read(&continuousPhysics);
+	reader->Read(&speculativeContacts);
+	reader->Read(&subStepping);
+	reader->Read(&coloredSolver);
+	reader->Read(&stepComplete);
+	m_flags = flags & ~e_locked;
+	m_allowSleep = allowSleep != 0;
+	m_warmStarting = warmStarting != 0;
+	m_continuousPhysics = continuousPhysics != 0;
+	m_speculativeContacts = speculativeContacts != 0;
+	m_subStepping = subStepping != 0;
+	m_coloredSolver = coloredSolver != 0;
+	m_stepComplete = stepComplete != 0;
+
+	if (reader->IsOk() == false ||
+		m_bodyStore.Load(reader) == false ||
+		m_contactManager.m_broadPhase.Load(reader) == false)
+	{
+		return false;
+	}
+
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+
+	// Bodies and fixtures, appended to keep the list order.
+	b2Body* bodyTail = NULL;
+	int32 fixtureIndex = 0;
+	int32 proxyTotal = 0;
+	for (int32 i = 0; i < objects->bodyCount; ++i)
+	{
+		int32 handle, type, fixtureCount;
+		uint16 bodyFlags;
+		reader->Read(&handle);
+		reader->Read(&type);
+		reader->Read(&bodyFlags);
+		if (reader->IsOk() == false || handle < 0 || handle >= m_bodyStore.GetCount() ||
+			m_bodyStore.GetBody(handle) != NULL || type < b2_staticBody || type > b2_dynamicBody)
+		{
+			return false;
+		}
+
+		void* mem = m_blockAllocator.Allocate(sizeof(b2Body));
+		b2Body* b = new (mem) b2Body(this, handle);
+		b->m_type = b2BodyType(type);
+		b->m_motion->type = type;
+		b->m_flags = bodyFlags & ~(b2Body::e_awakeListFlag | b2Body::e_recordFlag);
+		reader->Read(&b->m_islandIndex);
+		reader->Read(&b->m_prevPosition);
+		reader->Read(&b->m_prevAngle);
+		reader->Read(&b->m_mass);
+		reader->Read(&b->m_I);
+		reader->Read(&b->m_motion->linearDamping);
+		reader->Read(&b->m_motion->angularDamping);
+		reader->Read(&b->m_motion->gravityScale);
+		reader->Read(&b->m_sleepTime);
+		reader->Read(&fixtureCount);
+
+		b->m_prev = bodyTail;
+		if (bodyTail)
+		{
+			bodyTail->m_next = b;
+		}
+		else
+		{
+			m_bodyList = b;
+		}
+		bodyTail = b;
+		++m_bodyCount;
+		objects->bodies[i] = b;
+
+		if (reader->IsOk() == false || fixtureCount < 0 || fixtureCount > objects->fixtureCount - fixtureIndex)
+		{
+			return false;
+		}
+
+		b2Fixture* fixtureTail = NULL;
+		for (int32 k = 0; k < fixtureCount; ++k)
+		{
+			b2FixtureDef def;
+			uint8 isSensor;
+			reader->Read(&def.density);
+			reader->Read(&def.friction);
+			reader->Read(&def.restitution);
+			reader->Read(&def.filter);
+			reader->Read(&isSensor);
+			def.isSensor = isSensor != 0;
+
+			b2CircleShape circle;
+			b2EdgeShape edge;
+			b2PolygonShape polygon;
+			b2ChainShape chain;
+			if (b2LoadShape(reader, &def, &circle, &edge, &polygon, &chain) == false)
+			{
+				return false;
+			}
+
+			void* fixtureMemory = m_blockAllocator.Allocate(sizeof(b2Fixture));
+			b2Fixture* f = new (fixtureMemory) b2Fixture;
+			f->Create(&m_blockAllocator, b, &def);
+
+			if (fixtureTail)
+			{
+				fixtureTail->m_next = f;
+			}
+			else
+			{
+				b->m_fixtureList = f;
+			}
+			fixtureTail = f;
+			++b->m_fixtureCount;
+			objects->fixtures[fixtureIndex++] = f;
+
+			int32 proxyCount;
+			reader->Read(&proxyCount);
+			int32 childCount = f->m_shape->GetChildCount();
+			if (reader->IsOk() == false || (proxyCount != 0 && proxyCount != childCount))
+			{
+				return false;
+			}
+
+			for (int32 p = 0; p < proxyCount; ++p)
+			{
+				b2FixtureProxy* proxy = f->m_proxies + p;
+				reader->Read(&proxy->aabb);
+				reader->Read(&proxy->childIndex);
+				reader->Read(&proxy->proxyId);
+				// Each proxy of the loaded tree belongs to one fixture child.
+				if (reader->IsOk() == false || proxy->childIndex < 0 || proxy->childIndex >= childCount ||
+					broadPhase->IsProxy(proxy->proxyId) == false || broadPhase->GetUserData(proxy->proxyId) != NULL)
+				{
+					return false;
+				}
+				proxy->fixture = f;
+				broadPhase->SetUserData(proxy->proxyId, proxy);
+			}
+			f->m_proxyCount = proxyCount;
+			proxyTotal += proxyCount;
+		}
+	}
+
+	// A proxy without a fixture would be reported to queries with no user data.
+	if (fixtureIndex != objects->fixtureCount || proxyTotal != broadPhase->GetProxyCount())
+	{
+		return false;
+	}
+
+	// Joints, prepended from oldest to newest to keep the list order.
+	for (int32 i = 0; i < objects->jointCount; ++i)
+	{
+		int32 type, handleA, handleB, index, joint1 = -1, joint2 = -1;
+		uint8 collideConnected, islandFlag;
+		reader->Read(&type);
+		reader->Read(&handleA);
+		reader->Read(&handleB);
+		reader->Read(&collideConnected);
+		reader->Read(&islandFlag);
+		reader->Read(&index);
+		if (type == e_gearJoint)
+		{
+			reader->Read(&joint1);
+			reader->Read(&joint2);
+		}
+
+		if (reader->IsOk() == false ||
+			handleA < 0 || handleA >= m_bodyStore.GetCount() ||
+			handleB < 0 || handleB >= m_bodyStore.GetCount() ||
+			type < e_revoluteJoint || type > e_ropeJoint)
+		{
+			return false;
+		}
+
+		b2Body* bodyA = m_bodyStore.GetBody(handleA);
+		b2Body* bodyB = m_bodyStore.GetBody(handleB);
+		if (bodyA == NULL || bodyB == NULL || bodyA == bodyB)
+		{
+			return false;
+		}
+
+		b2RevoluteJointDef revoluteDef;
+		b2PrismaticJointDef prismaticDef;
+		b2DistanceJointDef distanceDef;
+		b2PulleyJointDef pulleyDef;
+		b2MouseJointDef mouseDef;
+		b2GearJointDef gearDef;
+		b2WheelJointDef wheelDef;
+		b2WeldJointDef weldDef;
+		b2FrictionJointDef frictionDef;
+		b2RopeJointDef ropeDef;
+
+		b2JointDef* def = NULL;
+		switch (type)
+		{
+		case e_revoluteJoint:
+			def = &revoluteDef;
+			break;
+		case e_prismaticJoint:
+			def = &prismaticDef;
+			break;
+		case e_distanceJoint:
+			def = &distanceDef;
+			break;
+		case e_pulleyJoint:
+			def = &pulleyDef;
+			break;
+		case e_mouseJoint:
+			def = &mouseDef;
+			break;
+		case e_gearJoint:
+			{
+				if (joint1 < 0 || joint1 >= i || joint2 < 0 || joint2 >= i)
+				{
+					return false;
+				}
+
+				b2JointType typeA = objects->joints[joint1]->m_type;
+				b2JointType typeB = objects->joints[joint2]->m_type;
+				if ((typeA != e_revoluteJoint && typeA != e_prismaticJoint) ||
+					(typeB != e_revoluteJoint && typeB != e_prismaticJoint))
+				{
+					return false;
+				}
+
+				gearDef.joint1 = objects->joints[joint1];
+				gearDef.joint2 = objects->joints[joint2];
+				def = &gearDef;
+			}
+			break;
+		case e_wheelJoint:
+			def = &wheelDef;
+			break;
+		case e_weldJoint:
+			def = &weldDef;
+			break;
+		case e_frictionJoint:
+			def = &frictionDef;
+			break;
+		case e_ropeJoint:
+			def = &ropeDef;
+			break;
+		}
+
+		// The constructor sets up a valid joint, then the saved state replaces it.
+		def->bodyA = bodyA;
+		def->bodyB = bodyB;
+		b2Joint* j = b2Joint::Create(def, &m_blockAllocator);
+		j->m_bodyA = bodyA;
+		j->m_bodyB = bodyB;
+		j->m_collideConnected = collideConnected != 0;
+		j->m_islandFlag = islandFlag != 0;
+		j->m_index = index;
+		j->m_edgeA.joint = j;
+		j->m_edgeA.other = bodyB;
+		j->m_edgeB.joint = j;
+		j->m_edgeB.other = bodyA;
+
+		j->m_prev = NULL;
+		j->m_next = m_jointList;
+		if (m_jointList)
+		{
+			m_jointList->m_prev = j;
+		}
+		m_jointList = j;
+		++m_jointCount;
+		objects->joints[i] = j;
+
+		j->LoadState(reader);
+		if (reader->IsOk() == false)
+		{
+			return false;
+		}
+
+		if (type == e_gearJoint)
+		{
+			b2GearJoint* gear = (b2GearJoint*)j;
+			gear->m_joint1 = objects->joints[joint1];
+			gear->m_joint2 = objects->joints[joint2];
+			gear->m_bodyC = gear->m_joint1->m_bodyA;
+			gear->m_bodyD = gear->m_joint2->m_bodyA;
+		}
+	}
+
+	// Contacts, appended to keep the list order.
+	b2Contact* contactTail = NULL;
+	for (int32 i = 0; i < objects->contactCount; ++i)
+	{
+		int32 fixtureA, indexA, fixtureB, indexB;
+		reader->Read(&fixtureA);
+		reader->Read(&indexA);
+		reader->Read(&fixtureB);
+		reader->Read(&indexB);
+		if (reader->IsOk() == false ||
+			fixtureA < 0 || fixtureA >= objects->fixtureCount ||
+			fixtureB < 0 || fixtureB >= objects->fixtureCount)
+		{
+			return false;
+		}
+
+		b2Fixture* fA = objects->fixtures[fixtureA];
+		b2Fixture* fB = objects->fixtures[fixtureB];
+		if (indexA < 0 || indexA >= fA->m_shape->GetChildCount() ||
+			indexB < 0 || indexB >= fB->m_shape->GetChildCount() ||
+			fA->m_body == fB->m_body)
+		{
+			return false;
+		}
+
+		b2Contact* c = b2Contact::Create(fA, indexA, fB, indexB, &m_blockAllocator);
+		if (c == NULL)
+		{
+			return false;
+		}
+
+		if (c->m_fixtureA != fA)
+		{
+			b2Contact::Destroy(c, &m_blockAllocator);
+			return false;
+		}
+
+		uint32 contactFlags;
+		reader->Read(&contactFlags);
+		bool validManifold = b2LoadManifold(reader, &c->m_manifold);
+		reader->Read(&c->m_toiCount);
+		reader->Read(&c->m_toi);
+		reader->Read(&c->m_toiSequence);
+		reader->Read(&c->m_friction);
+		reader->Read(&c->m_restitution);
+		c->m_flags = contactFlags & ~b2Contact::e_awakeListFlag;
+
+		b2Body* bodyA = fA->m_body;
+		b2Body* bodyB = fB->m_body;
+		c->m_nodeA.contact = c;
+		c->m_nodeA.other = bodyB;
+		c->m_nodeB.contact = c;
+		c->m_nodeB.other = bodyA;
+
+		c->m_prev = contactTail;
+		if (contactTail)
+		{
+			contactTail->m_next = c;
+		}
+		else
+		{
+			m_contactManager.m_contactList = c;
+		}
+		contactTail = c;
+		++m_contactManager.m_contactCount;
+		objects->contacts[i] = c;
+
+		if (reader->IsOk() == false || validManifold == false)
+		{
+			return false;
+		}
+	}
+
+	// Sensor pairs, appended to keep the list order.
+	b2SensorPair* pairTail = NULL;
+	for (int32 i = 0; i < objects->pairCount; ++i)
+	{
+		int32 fixtureA, indexA, fixtureB, indexB;
+		uint32 pairFlags;
+		reader->Read(&fixtureA);
+		reader->Read(&indexA);
+		reader->Read(&fixtureB);
+		reader->Read(&indexB);
+		reader->Read(&pairFlags);
+		if (reader->IsOk() == false ||
+			fixtureA < 0 || fixtureA >= objects->fixtureCount ||
+			fixtureB < 0 || fixtureB >= objects->fixtureCount)
+		{
+			return false;
+		}
+
+		b2Fixture* fA = objects->fixtures[fixtureA];
+		b2Fixture* fB = objects->fixtures[fixtureB];
+		if (indexA < 0 || indexA >= fA->m_shape->GetChildCount() ||
+			indexB < 0 || indexB >= fB->m_shape->GetChildCount() ||
+			fA->m_body == fB->m_body)
+		{
+			return false;
+		}
+
+		void* mem = m_contactManager.m_allocator->Allocate(sizeof(b2SensorPair));
+		b2SensorPair* p = new (mem) b2SensorPair;
+		p->flags = pairFlags;
+		p->fixtureA = fA;
+		p->fixtureB = fB;
+		p->indexA = indexA;
+		p->indexB = indexB;
+		p->nodeA.pair = p;
+		p->nodeA.other = fB->m_body;
+		p->nodeA.prev = NULL;
+		p->nodeA.next = NULL;
+		p->nodeB.pair = p;
+		p->nodeB.other = fA->m_body;
+		p->nodeB.prev = NULL;
+		p->nodeB.next = NULL;
+
+		p->prev = pairTail;
+		p->next = NULL;
+		if (pairTail)
+		{
+			pairTail->next = p;
+		}
+		else
+		{
+			m_contactManager.m_sensorList = p;
+		}
+		pairTail = p;
+		++m_contactManager.m_sensorCount;
+		objects->pairs[i] = p;
+	}
+
+	// Edge lists. An edge is only linked to its own body and only once.
+	for (int32 i = 0; i < objects->bodyCount; ++i)
+	{
+		b2Body* b = objects->bodies[i];
+
+		int32 count;
+		reader->Read(&count);
+		if (reader->IsOk() == false || count < 0 || count > 2 * objects->jointCount)
+		{
+			return false;
+		}
+
+		b2JointEdge* jointTail = NULL;
+		for (int32 k = 0; k < count; ++k)
+		{
+			int32 code;
+			reader->Read(&code);
+			if (reader->IsOk() == false || code < 0 || code >= 2 * objects->jointCount)
+			{
+				return false;
+			}
+
+			b2Joint* j = objects->joints[code / 2];
+			b2JointEdge* je = (code & 1) ? &j->m_edgeB : &j->m_edgeA;
+			b2Body* owner = (code & 1) ? j->m_bodyB : j->m_bodyA;
+			if (owner != b || je->prev != NULL || je == b->m_jointList)
+			{
+				return false;
+			}
+
+			je->prev = jointTail;
+			je->next = NULL;
+			if (jointTail)
+			{
+				jointTail->next = je;
+			}
+			else
+			{
+				b->m_jointList = je;
+			}
+			jointTail = je;
+		}
+
+		reader->Read(&count);
+		if (reader->IsOk() == false || count < 0 || count > 2 * objects->contactCount)
+		{
+			return false;
+		}
+
+		b2ContactEdge* contactTail = NULL;
+		for (int32 k = 0; k < count; ++k)
+		{
+			int32 code;
+			reader->Read(&code);
+			if (reader->IsOk() == false || code < 0 || code >= 2 * objects->contactCount)
+			{
+				return false;
+			}
+
+			b2Contact* c = objects->contacts[code / 2];
+			b2ContactEdge* ce = (code & 1) ? &c->m_nodeB : &c->m_nodeA;
+			b2Body* owner = (code & 1) ? c->m_fixtureB->m_body : c->m_fixtureA->m_body;
+			if (owner != b || ce->prev != NULL || ce == b->m_contactList)
+			{
+				return false;
+			}
+
+			ce->prev = contactTail;
+			ce->next = NULL;
+			if (contactTail)
+			{
+				contactTail->next = ce;
+			}
+			else
+			{
+				b->m_contactList = ce;
+			}
+			contactTail = ce;
+		}
+
+		reader->Read(&count);
+		if (reader->IsOk() == false || count < 0 || count > 2 * objects->pairCount)
+		{
+			return false;
+		}
+
+		b2SensorEdge* sensorTail = NULL;
+		for (int32 k = 0; k < count; ++k)
+		{
+			int32 code;
+			reader->Read(&code);
+			if (reader->IsOk() == false || code < 0 || code >= 2 * objects->pairCount)
+			{
+				return false;
+			}
+
+			b2SensorPair* p = objects->pairs[code / 2];
+			b2SensorEdge* se = (code & 1) ? &p->nodeB : &p->nodeA;
+			b2Body* owner = (code & 1) ? p->fixtureB->m_body : p->fixtureA->m_body;
+			if (owner != b || se->prev != NULL || se == b->m_sensorList)
+			{
+				return false;
+			}
+
+			se->prev = sensorTail;
+			se->next = NULL;
+			if (sensorTail)
+			{
+				sensorTail->next = se;
+			}
+			else
+			{
+				b->m_sensorList = se;
+			}
+			sensorTail = se;
+		}
+	}
+
+	// Awake lists.
+	int32 count;
+	reader->Read(&count);
+	if (reader->IsOk() == false || count < 0 || count > objects->bodyCount)
+	{
+		return false;
+	}
+
+	b2Body* awakeTail = NULL;
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 handle;
+		reader->Read(&handle);
+		if (reader->IsOk() == false || handle < 0 || handle >= m_bodyStore.GetCount())
+		{
+			return false;
+		}
+
+		b2Body* b = m_bodyStore.GetBody(handle);
+		if (b == NULL || (b->m_flags & b2Body::e_awakeListFlag))
+		{
+			return false;
+		}
+
+		b->m_flags |= b2Body::e_awakeListFlag;
+		b->m_awakePrev = awakeTail;
+		b->m_awakeNext = NULL;
+		if (awakeTail)
+		{
+			awakeTail->m_awakeNext = b;
+		}
+		else
+		{
+			m_awakeBodyList = b;
+		}
+		awakeTail = b;
+	}
+
+	reader->Read(&count);
+	if (reader->IsOk() == false || count < 0 || count > objects->contactCount)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 index;
+		reader->Read(&index);
+		if (reader->IsOk() == false || index < 0 || index >= objects->contactCount)
+		{
+			return false;
+		}
+
+		b2Contact* c = objects->contacts[index];
+		if (c->m_flags & b2Contact::e_awakeListFlag)
+		{
+			return false;
+		}
+
+		c->m_flags |= b2Contact::e_awakeListFlag;
+		c->m_awakePrev = m_contactManager.m_awakeContactTail;
+		c->m_awakeNext = NULL;
+		if (m_contactManager.m_awakeContactTail)
+		{
+			m_contactManager.m_awakeContactTail->m_awakeNext = c;
+		}
+		else
+		{
+			m_contactManager.m_awakeContactList = c;
+		}
+		m_contactManager.m_awakeContactTail = c;
+	}
+
+	uint32 end;
+	reader->Read(&end);
+	return reader->IsOk() && end == b2_snapshotEnd;
+}
+
+bool b2World::Fork(b2World* world)
+{
+	b2Assert(world != this);
+	b2Assert(IsLocked() == false && world->IsLocked() == false);
+	if (world == this || IsLocked() || world->IsLocked())
+	{
+		return false;
+	}
+
+	int32 size = SaveSnapshot(m_forkBuffer, m_forkCapacity);
+	if (size > m_forkCapacity)
+	{
+		// Leave room for the world to grow a little.
+		b2Free(&m_allocCounter, m_forkBuffer);
+		m_forkCapacity = size + size / 4;
+		m_forkBuffer = b2Alloc(&m_allocCounter, m_forkCapacity, b2_allocWorld);
+		SaveSnapshot(m_forkBuffer, m_forkCapacity);
+	}
+
+	return world->LoadSnapshot(m_forkBuffer, size);
+}
+
+void b2World::Clear()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	b2DestructionListener* destructionListener = m_destructionListener;
+	b2ContactListener* contactListener = m_contactManager.m_contactListener;
+	m_destructionListener = NULL;
+	m_contactManager.m_contactListener = NULL;
+
+	// A failed load may leave objects that are not linked to their bodies.
+	while (m_contactManager.m_contactList)
+	{
+		m_contactManager.Destroy(m_contactManager.m_contactList);
+	}
+
+	while (m_contactManager.m_sensorList)
+	{
+		m_contactManager.Destroy(m_contactManager.m_sensorList);
+	}
+
+	while (m_jointList)
+	{
+		DestroyJoint(m_jointList);
+	}
+
+	while (m_bodyList)
+	{
+		DestroyBody(m_bodyList);
+	}
+
+	m_destructionListener = destructionListener;
+	m_contactManager.m_contactListener = contactListener;
+
+	// This also drops any proxies and slots a failed load left without an owner.
+	m_bodyStore.Reset();
+	m_contactManager.m_broadPhase.Reset();
+}
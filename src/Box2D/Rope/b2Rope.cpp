@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Rope/b2Rope.h>
+#include <Box2D/Rope/b2RopeSystem.h>
 #include <Box2D/Common/b2Draw.h>
 
 b2Rope::b2Rope()
@@ -31,11 +32,17 @@ b2Rope::b2Rope()
 	m_gravity.SetZero();
 	m_k2 = 1.0f;
 	m_k3 = 0.1f;
+	m_system = NULL;
+	m_batch = -1;
+	m_lane = 0;
 }
 
 b2Rope::~b2Rope()
 {
-	b2Free(m_ps);
+	if (m_system == NULL)
+	{
+		b2Free(m_ps);
+	}
 	b2Free(m_p0s);
 	b2Free(m_vs);
 	b2Free(m_ims);
@@ -104,7 +111,8 @@ void b2Rope::Initialize(const b2RopeDef* def)
 
 void b2Rope::Step(float32 h, int32 iterations)
 {
-	if (h == 0.0)
+	b2Assert(m_system == NULL);
+	if (h == 0.0 || m_system != NULL)
 	{
 		return;
 	}
@@ -170,6 +178,12 @@ void b2Rope::SolveC2()
 
 void b2Rope::SetAngle(float32 angle)
 {
+	if (m_system != NULL)
+	{
+		m_system->SetAngle(this, angle);
+		return;
+	}
+
 	int32 count3 = m_count - 2;
 	for (int32 i = 0; i < count3; ++i)
 	{
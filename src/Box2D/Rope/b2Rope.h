@@ -22,6 +22,7 @@
 #include <Box2D/Common/b2Math.h>
 
 class b2Draw;
+class b2RopeSystem;
 
 /// 
 struct b2RopeDef
@@ -69,7 +70,7 @@ public:
 	///
 	void Initialize(const b2RopeDef* def);
 
-	///
+	/// Ropes created by a b2RopeSystem are stepped by the system instead.
 	void Step(float32 timeStep, int32 iterations);
 
 	///
@@ -92,6 +93,8 @@ public:
 
 private:
 
+	friend class b2RopeSystem;
+
 	void SolveC2();
 	void SolveC3();
 
@@ -110,6 +113,11 @@ private:
 
 	float32 m_k2;
 	float32 m_k3;
+
+	// Views into a b2RopeSystem only keep m_ps, which points into the system.
+	b2RopeSystem* m_system;
+	int32 m_batch;
+	int32 m_lane;
 };
 
 #endif
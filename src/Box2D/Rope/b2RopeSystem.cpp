@@ -0,0 +1,769 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Rope/b2RopeSystem.h>
+#include <Box2D/Common/b2Simd.h>
+#include <Box2D/Common/b2ThreadPool.h>
+#include <new>
+#include <string.h>
+
+#if B2_SIMD_WIDTH > 0
+#define b2_ropeLaneCount B2_SIMD_WIDTH
+#else
+#define b2_ropeLaneCount 1
+#endif
+
+// Up to b2_ropeLaneCount ropes solved side by side. The ropes are sorted by
+// length, so the first lane holds the longest rope and sets the slot count.
+// Slots past the end of a shorter rope are padding: their particles are static
+// and their constraints have zero stiffness.
+struct b2RopeBatch
+{
+	int32 count;
+	int32 start;
+	int32 slotCount;
+	int32 vertexCount[b2_ropeLaneCount];
+	int32 vertexOffset[b2_ropeLaneCount];
+	float32 gravityX[b2_ropeLaneCount];
+	float32 gravityY[b2_ropeLaneCount];
+	float32 damping[b2_ropeLaneCount];
+};
+
+class b2RopeStepTask : public b2Task
+{
+public:
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+		system->StepBatch(index, timeStep, iterations);
+	}
+
+	b2RopeSystem* system;
+	float32 timeStep;
+	int32 iterations;
+};
+
+// Wrap an angle into [-pi, pi] so that the solver needs a single correction.
+static float32 b2WrapAngle(float32 angle)
+{
+	while (angle > b2_pi)
+	{
+		angle -= 2.0f * b2_pi;
+	}
+
+	while (angle < -b2_pi)
+	{
+		angle += 2.0f * b2_pi;
+	}
+
+	return angle;
+}
+
+b2RopeSystem::b2RopeSystem()
+{
+	m_ropes = NULL;
+	m_ropeCount = 0;
+	m_ropeCapacity = 0;
+
+	m_batches = NULL;
+	m_batchCount = 0;
+	m_slotCount = 0;
+
+	m_px = NULL;
+	m_py = NULL;
+	m_p0x = NULL;
+	m_p0y = NULL;
+	m_vx = NULL;
+	m_vy = NULL;
+	m_ims = NULL;
+	m_Ls = NULL;
+	m_s1s = NULL;
+	m_s2s = NULL;
+	m_as = NULL;
+	m_k3s = NULL;
+	m_vertices = NULL;
+
+	m_threadPool = NULL;
+}
+
+b2RopeSystem::~b2RopeSystem()
+{
+	for (int32 i = 0; i < m_ropeCount; ++i)
+	{
+		m_ropes[i]->~b2Rope();
+		b2Free(m_ropes[i]);
+	}
+
+	b2Free(m_ropes);
+	b2Free(m_batches);
+	b2Free(m_px);
+	b2Free(m_py);
+	b2Free(m_p0x);
+	b2Free(m_p0y);
+	b2Free(m_vx);
+	b2Free(m_vy);
+	b2Free(m_ims);
+	b2Free(m_Ls);
+	b2Free(m_s1s);
+	b2Free(m_s2s);
+	b2Free(m_as);
+	b2Free(m_k3s);
+	b2Free(m_vertices);
+}
+
+b2Rope* b2RopeSystem::CreateRope(const b2RopeDef* def)
+{
+	if (m_ropeCount == m_ropeCapacity)
+	{
+		b2Rope** oldRopes = m_ropes;
+		m_ropeCapacity = m_ropeCapacity > 0 ? 2 * m_ropeCapacity : 16;
+		m_ropes = (b2Rope**)b2Alloc(m_ropeCapacity * sizeof(b2Rope*));
+		if (oldRopes != NULL)
+		{
+			memcpy(m_ropes, oldRopes, m_ropeCount * sizeof(b2Rope*));
+			b2Free(oldRopes);
+		}
+	}
+
+	// Build a standalone rope first, then move it into the buffers.
+	void* mem = b2Alloc(sizeof(b2Rope));
+	b2Rope* rope = new (mem) b2Rope;
+	rope->Initialize(def);
+
+	m_ropes[m_ropeCount] = rope;
+	++m_ropeCount;
+
+	Pack();
+
+	return rope;
+}
+
+void b2RopeSystem::DestroyRope(b2Rope* rope)
+{
+	b2Assert(rope->m_system == this);
+
+	int32 index = 0;
+	while (index < m_ropeCount && m_ropes[index] != rope)
+	{
+		++index;
+	}
+
+	b2Assert(index < m_ropeCount);
+	if (index == m_ropeCount)
+	{
+		return;
+	}
+
+	for (int32 i = index + 1; i < m_ropeCount; ++i)
+	{
+		m_ropes[i - 1] = m_ropes[i];
+	}
+	--m_ropeCount;
+
+	Pack();
+
+	rope->~b2Rope();
+	b2Free(rope);
+}
+
+void b2RopeSystem::SetThreadPool(b2ThreadPool* threadPool)
+{
+	m_threadPool = threadPool;
+}
+
+// Rebuild the buffers for the current rope list. Ropes already in the system
+// are copied from the old buffers, new ropes from their own arrays.
+void b2RopeSystem::Pack()
+{
+	const int32 width = b2_ropeLaneCount;
+
+	// Sort longest first so ropes of similar length share a batch.
+	int32* order = (int32*)b2Alloc(b2Max(m_ropeCount, 1) * sizeof(int32));
+	for (int32 i = 0; i < m_ropeCount; ++i)
+	{
+		int32 j = i;
+		while (j > 0 && m_ropes[order[j - 1]]->m_count < m_ropes[i]->m_count)
+		{
+			order[j] = order[j - 1];
+			--j;
+		}
+		order[j] = i;
+	}
+
+	int32* vertexOffsets = (int32*)b2Alloc(b2Max(m_ropeCount, 1) * sizeof(int32));
+	int32 vertexCount = 0;
+	for (int32 i = 0; i < m_ropeCount; ++i)
+	{
+		vertexOffsets[i] = vertexCount;
+		vertexCount += m_ropes[i]->m_count;
+	}
+
+	int32 batchCount = (m_ropeCount + width - 1) / width;
+	b2RopeBatch* batches = (b2RopeBatch*)b2Alloc(b2Max(batchCount, 1) * sizeof(b2RopeBatch));
+	memset(batches, 0, b2Max(batchCount, 1) * sizeof(b2RopeBatch));
+
+	int32 slotCount = 0;
+	for (int32 i = 0; i < batchCount; ++i)
+	{
+		b2RopeBatch* batch = batches + i;
+		batch->count = b2Min(width, m_ropeCount - i * width);
+		batch->start = slotCount;
+		batch->slotCount = m_ropes[order[i * width]]->m_count;
+		slotCount += batch->slotCount;
+
+		for (int32 lane = 0; lane < batch->count; ++lane)
+		{
+			int32 index = order[i * width + lane];
+			const b2Rope* rope = m_ropes[index];
+			batch->vertexCount[lane] = rope->m_count;
+			batch->vertexOffset[lane] = vertexOffsets[index];
+			batch->gravityX[lane] = rope->m_gravity.x;
+			batch->gravityY[lane] = rope->m_gravity.y;
+			batch->damping[lane] = rope->m_damping;
+		}
+	}
+
+	int32 size = b2Max(slotCount * width, 1) * sizeof(float32);
+	float32* px = (float32*)b2Alloc(size);
+	float32* py = (float32*)b2Alloc(size);
+	float32* p0x = (float32*)b2Alloc(size);
+	float32* p0y = (float32*)b2Alloc(size);
+	float32* vx = (float32*)b2Alloc(size);
+	float32* vy = (float32*)b2Alloc(size);
+	float32* ims = (float32*)b2Alloc(size);
+	float32* Ls = (float32*)b2Alloc(size);
+	float32* s1s = (float32*)b2Alloc(size);
+	float32* s2s = (float32*)b2Alloc(size);
+	float32* as = (float32*)b2Alloc(size);
+	float32* k3s = (float32*)b2Alloc(size);
+	memset(px, 0, size);
+	memset(py, 0, size);
+	memset(p0x, 0, size);
+	memset(p0y, 0, size);
+	memset(vx, 0, size);
+	memset(vy, 0, size);
+	memset(ims, 0, size);
+	memset(Ls, 0, size);
+	memset(s1s, 0, size);
+	memset(s2s, 0, size);
+	memset(as, 0, size);
+	memset(k3s, 0, size);
+
+	b2Vec2* vertices = (b2Vec2*)b2Alloc(b2Max(vertexCount, 1) * sizeof(b2Vec2));
+
+	for (int32 i = 0; i < batchCount; ++i)
+	{
+		const b2RopeBatch* batch = batches + i;
+		for (int32 lane = 0; lane < batch->count; ++lane)
+		{
+			b2Rope* rope = m_ropes[order[i * width + lane]];
+			int32 count = rope->m_count;
+
+			for (int32 j = 0; j < count; ++j)
+			{
+				int32 k = (batch->start + j) * width + lane;
+
+				if (rope->m_system == this)
+				{
+					int32 ok = (m_batches[rope->m_batch].start + j) * width + rope->m_lane;
+					px[k] = m_px[ok];
+					py[k] = m_py[ok];
+					p0x[k] = m_p0x[ok];
+					p0y[k] = m_p0y[ok];
+					vx[k] = m_vx[ok];
+					vy[k] = m_vy[ok];
+					ims[k] = m_ims[ok];
+					Ls[k] = m_Ls[ok];
+					as[k] = m_as[ok];
+				}
+				else
+				{
+					px[k] = rope->m_ps[j].x;
+					py[k] = rope->m_ps[j].y;
+					p0x[k] = rope->m_p0s[j].x;
+					p0y[k] = rope->m_p0s[j].y;
+					vx[k] = rope->m_vs[j].x;
+					vy[k] = rope->m_vs[j].y;
+					ims[k] = rope->m_ims[j];
+					if (j < count - 1)
+					{
+						Ls[k] = rope->m_Ls[j];
+					}
+					if (j < count - 2)
+					{
+						as[k] = b2WrapAngle(rope->m_as[j]);
+					}
+				}
+
+				vertices[batch->vertexOffset[lane] + j].Set(px[k], py[k]);
+			}
+
+			// Fold the stiffness into the mass ratios like b2Rope::SolveC2.
+			for (int32 j = 0; j < count - 1; ++j)
+			{
+				int32 k = (batch->start + j) * width + lane;
+				float32 im1 = ims[k];
+				float32 im2 = ims[k + width];
+				if (im1 + im2 > 0.0f)
+				{
+					s1s[k] = rope->m_k2 * (im1 / (im1 + im2));
+					s2s[k] = rope->m_k2 * (im2 / (im1 + im2));
+				}
+			}
+
+			for (int32 j = 0; j < count - 2; ++j)
+			{
+				k3s[(batch->start + j) * width + lane] = rope->m_k3;
+			}
+
+			if (rope->m_system == NULL)
+			{
+				b2Free(rope->m_ps);
+				b2Free(rope->m_p0s);
+				b2Free(rope->m_vs);
+				b2Free(rope->m_ims);
+				b2Free(rope->m_Ls);
+				b2Free(rope->m_as);
+				rope->m_p0s = NULL;
+				rope->m_vs = NULL;
+				rope->m_ims = NULL;
+				rope->m_Ls = NULL;
+				rope->m_as = NULL;
+			}
+
+			rope->m_system = this;
+			rope->m_batch = i;
+			rope->m_lane = lane;
+			rope->m_ps = vertices + batch->vertexOffset[lane];
+		}
+	}
+
+	b2Free(order);
+	b2Free(vertexOffsets);
+
+	b2Free(m_batches);
+	b2Free(m_px);
+	b2Free(m_py);
+	b2Free(m_p0x);
+	b2Free(m_p0y);
+	b2Free(m_vx);
+	b2Free(m_vy);
+	b2Free(m_ims);
+	b2Free(m_Ls);
+	b2Free(m_s1s);
+	b2Free(m_s2s);
+	b2Free(m_as);
+	b2Free(m_k3s);
+	b2Free(m_vertices);
+
+	m_batches = batches;
+	m_batchCount = batchCount;
+	m_slotCount = slotCount;
+	m_px = px;
+	m_py = py;
+	m_p0x = p0x;
+	m_p0y = p0y;
+	m_vx = vx;
+	m_vy = vy;
+	m_ims = ims;
+	m_Ls = Ls;
+	m_s1s = s1s;
+	m_s2s = s2s;
+	m_as = as;
+	m_k3s = k3s;
+	m_vertices = vertices;
+}
+
+void b2RopeSystem::SetAngle(b2Rope* rope, float32 angle)
+{
+	b2Assert(rope->m_system == this);
+
+	const int32 width = b2_ropeLaneCount;
+	const b2RopeBatch* batch = m_batches + rope->m_batch;
+	angle = b2WrapAngle(angle);
+
+	for (int32 i = 0; i < rope->m_count - 2; ++i)
+	{
+		m_as[(batch->start + i) * width + rope->m_lane] = angle;
+	}
+}
+
+void b2RopeSystem::Step(float32 h, int32 iterations)
+{
+	if (h == 0.0f)
+	{
+		return;
+	}
+
+	b2RopeStepTask task;
+	task.system = this;
+	task.timeStep = h;
+	task.iterations = iterations;
+
+	if (m_threadPool != NULL && m_threadPool->GetThreadCount() > 1 && m_batchCount > 1)
+	{
+		m_threadPool->ParallelFor(&task, m_batchCount);
+	}
+	else
+	{
+		for (int32 i = 0; i < m_batchCount; ++i)
+		{
+			task.Execute(i, 0);
+		}
+	}
+}
+
+#if B2_SIMD_WIDTH > 0
+
+// atan2 for the bending constraint. Cephes atanf on [0, 1] after reducing
+// by octant, accurate to a few float ulps. b2Rope uses the library atan2.
+static b2FloatW b2Atan2W(b2FloatW y, b2FloatW x)
+{
+	const b2FloatW zero = b2ZeroW();
+	const b2FloatW one = b2SplatW(1.0f);
+
+	b2FloatW ax = b2MaxW(x, b2SubW(zero, x));
+	b2FloatW ay = b2MaxW(y, b2SubW(zero, y));
+	b2FloatW hi = b2MaxW(ax, ay);
+	b2FloatW lo = b2MinW(ax, ay);
+
+	// r in [0, 1]
+	b2FloatW r = b2DivW(lo, b2SelectW(b2GreaterEqualW(zero, hi), hi, one));
+
+	// Reduce to |t| <= tan(pi/8).
+	b2FloatW reduce = b2GreaterEqualW(r, b2SplatW(0.414213562373095f));
+	b2FloatW t = b2SelectW(reduce, r, b2DivW(b2SubW(r, one), b2AddW(r, one)));
+	b2FloatW base = b2SelectW(reduce, zero, b2SplatW(0.25f * b2_pi));
+
+	b2FloatW z = b2MulW(t, t);
+	b2FloatW p = b2SplatW(8.05374449538e-2f);
+	p = b2SubW(b2MulW(p, z), b2SplatW(1.38776856032e-1f));
+	p = b2AddW(b2MulW(p, z), b2SplatW(1.99777106478e-1f));
+	p = b2SubW(b2MulW(p, z), b2SplatW(3.33329491539e-1f));
+	b2FloatW angle = b2AddW(base, b2AddW(b2MulW(b2MulW(p, z), t), t));
+
+	// Undo the octant reduction.
+	angle = b2SelectW(b2GreaterEqualW(ax, ay), b2SubW(b2SplatW(0.5f * b2_pi), angle), angle);
+	angle = b2SelectW(b2GreaterEqualW(x, zero), b2SubW(b2SplatW(b2_pi), angle), angle);
+	angle = b2SelectW(b2GreaterEqualW(y, zero), b2SubW(zero, angle), angle);
+	return angle;
+}
+
+// The math of b2Rope::Step, one rope per lane.
+void b2RopeSystem::StepBatch(int32 index, float32 h, int32 iterations)
+{
+	const int32 width = B2_SIMD_WIDTH;
+	const b2FloatW zero = b2ZeroW();
+	const b2FloatW one = b2SplatW(1.0f);
+	const b2RopeBatch* batch = m_batches + index;
+	const int32 start = batch->start * width;
+	const int32 count = batch->slotCount;
+
+	float32 buffer[B2_SIMD_WIDTH];
+	for (int32 lane = 0; lane < width; ++lane)
+	{
+		buffer[lane] = expf(- h * batch->damping[lane]);
+	}
+
+	b2FloatW hW = b2SplatW(h);
+	b2FloatW d = b2LoadW(buffer);
+	b2FloatW gx = b2MulW(hW, b2LoadW(batch->gravityX));
+	b2FloatW gy = b2MulW(hW, b2LoadW(batch->gravityY));
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 k = start + i * width;
+		b2FloatW px = b2LoadW(m_px + k);
+		b2FloatW py = b2LoadW(m_py + k);
+		b2FloatW vx = b2LoadW(m_vx + k);
+		b2FloatW vy = b2LoadW(m_vy + k);
+
+		// Static particles get no gravity.
+		b2FloatW isStatic = b2GreaterEqualW(zero, b2LoadW(m_ims + k));
+		vx = b2AddW(vx, b2SelectW(isStatic, gx, zero));
+		vy = b2AddW(vy, b2SelectW(isStatic, gy, zero));
+		vx = b2MulW(vx, d);
+		vy = b2MulW(vy, d);
+
+		b2StoreW(m_p0x + k, px);
+		b2StoreW(m_p0y + k, py);
+		b2StoreW(m_px + k, b2AddW(px, b2MulW(hW, vx)));
+		b2StoreW(m_py + k, b2AddW(py, b2MulW(hW, vy)));
+	}
+
+	const b2FloatW epsilon = b2SplatW(b2_epsilon);
+	const b2FloatW pi = b2SplatW(b2_pi);
+	const b2FloatW twoPi = b2SplatW(2.0f * b2_pi);
+
+	for (int32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		for (int32 pass = 0; pass < 3; ++pass)
+		{
+			if (pass == 1)
+			{
+				// Bending, as b2Rope::SolveC3.
+				for (int32 i = 0; i < count - 2; ++i)
+				{
+					int32 k1 = start + i * width;
+					int32 k2 = k1 + width;
+					int32 k3 = k2 + width;
+
+					b2FloatW p1x = b2LoadW(m_px + k1);
+					b2FloatW p1y = b2LoadW(m_py + k1);
+					b2FloatW p2x = b2LoadW(m_px + k2);
+					b2FloatW p2y = b2LoadW(m_py + k2);
+					b2FloatW p3x = b2LoadW(m_px + k3);
+					b2FloatW p3y = b2LoadW(m_py + k3);
+
+					b2FloatW m1 = b2LoadW(m_ims + k1);
+					b2FloatW m2 = b2LoadW(m_ims + k2);
+					b2FloatW m3 = b2LoadW(m_ims + k3);
+
+					b2FloatW d1x = b2SubW(p2x, p1x);
+					b2FloatW d1y = b2SubW(p2y, p1y);
+					b2FloatW d2x = b2SubW(p3x, p2x);
+					b2FloatW d2y = b2SubW(p3y, p2y);
+
+					b2FloatW L1sqr = b2AddW(b2MulW(d1x, d1x), b2MulW(d1y, d1y));
+					b2FloatW L2sqr = b2AddW(b2MulW(d2x, d2x), b2MulW(d2y, d2y));
+					b2FloatW invalid = b2GreaterEqualW(zero, b2MulW(L1sqr, L2sqr));
+
+					b2FloatW a = b2SubW(b2MulW(d1x, d2y), b2MulW(d1y, d2x));
+					b2FloatW b = b2AddW(b2MulW(d1x, d2x), b2MulW(d1y, d2y));
+					b2FloatW angle = b2Atan2W(a, b);
+
+					// Jd1 = -skew(d1) / L1sqr, Jd2 = skew(d2) / L2sqr with skew(v) = (-v.y, v.x)
+					b2FloatW s1 = b2DivW(one, b2SelectW(invalid, L1sqr, one));
+					b2FloatW s2 = b2DivW(one, b2SelectW(invalid, L2sqr, one));
+					b2FloatW Jd1x = b2MulW(s1, d1y);
+					b2FloatW Jd1y = b2SubW(zero, b2MulW(s1, d1x));
+					b2FloatW Jd2x = b2SubW(zero, b2MulW(s2, d2y));
+					b2FloatW Jd2y = b2MulW(s2, d2x);
+
+					b2FloatW J1x = b2SubW(zero, Jd1x);
+					b2FloatW J1y = b2SubW(zero, Jd1y);
+					b2FloatW J2x = b2SubW(Jd1x, Jd2x);
+					b2FloatW J2y = b2SubW(Jd1y, Jd2y);
+					b2FloatW J3x = Jd2x;
+					b2FloatW J3y = Jd2y;
+
+					b2FloatW mass = b2MulW(m1, b2AddW(b2MulW(J1x, J1x), b2MulW(J1y, J1y)));
+					mass = b2AddW(mass, b2MulW(m2, b2AddW(b2MulW(J2x, J2x), b2MulW(J2y, J2y))));
+					mass = b2AddW(mass, b2MulW(m3, b2AddW(b2MulW(J3x, J3x), b2MulW(J3y, J3y))));
+					invalid = b2SelectW(b2GreaterEqualW(zero, mass), invalid, b2GreaterEqualW(zero, zero));
+					mass = b2DivW(one, b2SelectW(invalid, mass, one));
+
+					// Both angles are in [-pi, pi], so one wrap is enough.
+					b2FloatW C = b2SubW(angle, b2LoadW(m_as + k1));
+					C = b2SelectW(b2GreaterEqualW(pi, C), b2SubW(C, twoPi), C);
+					C = b2SelectW(b2GreaterEqualW(C, b2SubW(zero, pi)), b2AddW(C, twoPi), C);
+
+					b2FloatW impulse = b2SubW(zero, b2MulW(b2MulW(b2LoadW(m_k3s + k1), mass), C));
+					impulse = b2SelectW(invalid, impulse, zero);
+
+					b2FloatW i1 = b2MulW(m1, impulse);
+					b2FloatW i2 = b2MulW(m2, impulse);
+					b2FloatW i3 = b2MulW(m3, impulse);
+
+					b2StoreW(m_px + k1, b2AddW(p1x, b2MulW(i1, J1x)));
+					b2StoreW(m_py + k1, b2AddW(p1y, b2MulW(i1, J1y)));
+					b2StoreW(m_px + k2, b2AddW(p2x, b2MulW(i2, J2x)));
+					b2StoreW(m_py + k2, b2AddW(p2y, b2MulW(i2, J2y)));
+					b2StoreW(m_px + k3, b2AddW(p3x, b2MulW(i3, J3x)));
+					b2StoreW(m_py + k3, b2AddW(p3y, b2MulW(i3, J3y)));
+				}
+
+				continue;
+			}
+
+			// Stretching, as b2Rope::SolveC2. Padding has zero mass ratios.
+			for (int32 i = 0; i < count - 1; ++i)
+			{
+				int32 k1 = start + i * width;
+				int32 k2 = k1 + width;
+
+				b2FloatW p1x = b2LoadW(m_px + k1);
+				b2FloatW p1y = b2LoadW(m_py + k1);
+				b2FloatW p2x = b2LoadW(m_px + k2);
+				b2FloatW p2y = b2LoadW(m_py + k2);
+
+				b2FloatW dx = b2SubW(p2x, p1x);
+				b2FloatW dy = b2SubW(p2y, p1y);
+				b2FloatW L = b2SqrtW(b2AddW(b2MulW(dx, dx), b2MulW(dy, dy)));
+
+				// Like b2Vec2::Normalize, leave tiny offsets as they are and use zero length.
+				b2FloatW valid = b2GreaterEqualW(L, epsilon);
+				b2FloatW invL = b2DivW(one, b2SelectW(valid, one, L));
+				dx = b2MulW(dx, invL);
+				dy = b2MulW(dy, invL);
+				L = b2SelectW(valid, zero, L);
+
+				b2FloatW C = b2SubW(b2LoadW(m_Ls + k1), L);
+				b2FloatW c1 = b2MulW(b2LoadW(m_s1s + k1), C);
+				b2FloatW c2 = b2MulW(b2LoadW(m_s2s + k1), C);
+
+				b2StoreW(m_px + k1, b2SubW(p1x, b2MulW(c1, dx)));
+				b2StoreW(m_py + k1, b2SubW(p1y, b2MulW(c1, dy)));
+				b2StoreW(m_px + k2, b2AddW(p2x, b2MulW(c2, dx)));
+				b2StoreW(m_py + k2, b2AddW(p2y, b2MulW(c2, dy)));
+			}
+		}
+	}
+
+	b2FloatW inv_h = b2SplatW(1.0f / h);
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 k = start + i * width;
+		b2StoreW(m_vx + k, b2MulW(inv_h, b2SubW(b2LoadW(m_px + k), b2LoadW(m_p0x + k))));
+		b2StoreW(m_vy + k, b2MulW(inv_h, b2SubW(b2LoadW(m_py + k), b2LoadW(m_p0y + k))));
+	}
+
+	for (int32 lane = 0; lane < batch->count; ++lane)
+	{
+		b2Vec2* vertices = m_vertices + batch->vertexOffset[lane];
+		for (int32 i = 0; i < batch->vertexCount[lane]; ++i)
+		{
+			int32 k = start + i * width + lane;
+			vertices[i].Set(m_px[k], m_py[k]);
+		}
+	}
+}
+
+#else
+
+// Without SIMD every batch holds one rope and this is b2Rope::Step on the buffers.
+void b2RopeSystem::StepBatch(int32 index, float32 h, int32 iterations)
+{
+	const b2RopeBatch* batch = m_batches + index;
+	b2Vec2 gravity(batch->gravityX[0], batch->gravityY[0]);
+	float32 d = expf(- h * batch->damping[0]);
+
+	const int32 start = batch->start;
+	const int32 count = batch->slotCount;
+	float32* ims = m_ims + start;
+	float32* Ls = m_Ls + start;
+	float32* s1s = m_s1s + start;
+	float32* s2s = m_s2s + start;
+	float32* as = m_as + start;
+	float32* k3s = m_k3s + start;
+	b2Vec2* ps = m_vertices + batch->vertexOffset[0];
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 k = start + i;
+		b2Vec2 v(m_vx[k], m_vy[k]);
+		ps[i].Set(m_px[k], m_py[k]);
+		m_p0x[k] = m_px[k];
+		m_p0y[k] = m_py[k];
+		if (ims[i] > 0.0f)
+		{
+			v += h * gravity;
+		}
+		v *= d;
+		ps[i] += h * v;
+	}
+
+	for (int32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		for (int32 pass = 0; pass < 3; ++pass)
+		{
+			if (pass == 1)
+			{
+				for (int32 i = 0; i < count - 2; ++i)
+				{
+					b2Vec2 p1 = ps[i];
+					b2Vec2 p2 = ps[i + 1];
+					b2Vec2 p3 = ps[i + 2];
+
+					float32 m1 = ims[i];
+					float32 m2 = ims[i + 1];
+					float32 m3 = ims[i + 2];
+
+					b2Vec2 d1 = p2 - p1;
+					b2Vec2 d2 = p3 - p2;
+
+					float32 L1sqr = d1.LengthSquared();
+					float32 L2sqr = d2.LengthSquared();
+
+					if (L1sqr * L2sqr == 0.0f)
+					{
+						continue;
+					}
+
+					float32 angle = b2Atan2(b2Cross(d1, d2), b2Dot(d1, d2));
+
+					b2Vec2 Jd1 = (-1.0f / L1sqr) * d1.Skew();
+					b2Vec2 Jd2 = (1.0f / L2sqr) * d2.Skew();
+
+					b2Vec2 J1 = -Jd1;
+					b2Vec2 J2 = Jd1 - Jd2;
+					b2Vec2 J3 = Jd2;
+
+					float32 mass = m1 * b2Dot(J1, J1) + m2 * b2Dot(J2, J2) + m3 * b2Dot(J3, J3);
+					if (mass == 0.0f)
+					{
+						continue;
+					}
+
+					mass = 1.0f / mass;
+
+					float32 C = b2WrapAngle(angle - as[i]);
+					float32 impulse = - k3s[i] * mass * C;
+
+					ps[i] = p1 + (m1 * impulse) * J1;
+					ps[i + 1] = p2 + (m2 * impulse) * J2;
+					ps[i + 2] = p3 + (m3 * impulse) * J3;
+				}
+
+				continue;
+			}
+
+			for (int32 i = 0; i < count - 1; ++i)
+			{
+				b2Vec2 p1 = ps[i];
+				b2Vec2 p2 = ps[i + 1];
+
+				b2Vec2 dp = p2 - p1;
+				float32 L = dp.Normalize();
+
+				ps[i] = p1 - s1s[i] * (Ls[i] - L) * dp;
+				ps[i + 1] = p2 + s2s[i] * (Ls[i] - L) * dp;
+			}
+		}
+	}
+
+	float32 inv_h = 1.0f / h;
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 k = start + i;
+		m_px[k] = ps[i].x;
+		m_py[k] = ps[i].y;
+		m_vx[k] = inv_h * (m_px[k] - m_p0x[k]);
+		m_vy[k] = inv_h * (m_py[k] - m_p0y[k]);
+	}
+}
+
+#endif
+
+void b2RopeSystem::Draw(b2Draw* draw) const
+{
+	for (int32 i = 0; i < m_ropeCount; ++i)
+	{
+		m_ropes[i]->Draw(draw);
+	}
+}
@@ -0,0 +1,114 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ROPE_SYSTEM_H
+#define B2_ROPE_SYSTEM_H
+
+#include <Box2D/Rope/b2Rope.h>
+
+class b2Draw;
+class b2ThreadPool;
+struct b2RopeBatch;
+
+/// Simulates many ropes together. The particles and constraints of all ropes
+/// are packed into shared structure of arrays buffers, with one rope per SIMD
+/// lane, so the distance and bending constraints of several ropes are solved
+/// at once. Each rope is still solved in order along its length, like b2Rope.
+/// Groups of ropes can be spread over a thread pool.
+/// The ropes returned by CreateRope are views into the system: the vertex,
+/// angle and draw functions of b2Rope work on them, but the system steps them.
+class b2RopeSystem
+{
+public:
+	b2RopeSystem();
+	~b2RopeSystem();
+
+	/// Create a rope. This repacks the buffers, so create ropes up front.
+	b2Rope* CreateRope(const b2RopeDef* def);
+
+	/// Destroy a rope created by this system.
+	void DestroyRope(b2Rope* rope);
+
+	/// Step all ropes.
+	void Step(float32 timeStep, int32 iterations);
+
+	/// Set a thread pool to step groups of ropes in parallel, or NULL.
+	/// The pool must outlive the system or be removed first.
+	void SetThreadPool(b2ThreadPool* threadPool);
+
+	/// Get the number of ropes.
+	int32 GetRopeCount() const;
+
+	/// Get a rope by index in [0, GetRopeCount()).
+	b2Rope* GetRope(int32 index);
+
+	/// Draw all ropes.
+	void Draw(b2Draw* draw) const;
+
+private:
+
+	friend class b2Rope;
+	friend class b2RopeStepTask;
+
+	void Pack();
+	void StepBatch(int32 index, float32 timeStep, int32 iterations);
+	void SetAngle(b2Rope* rope, float32 angle);
+
+	b2Rope** m_ropes;
+	int32 m_ropeCount;
+	int32 m_ropeCapacity;
+
+	// The lanes of particle slot i of a batch start at (batch.start + i) * lane width.
+	// Constraint i of either kind uses the slot of its first particle.
+	b2RopeBatch* m_batches;
+	int32 m_batchCount;
+	int32 m_slotCount;
+
+	float32* m_px;
+	float32* m_py;
+	float32* m_p0x;
+	float32* m_p0y;
+	float32* m_vx;
+	float32* m_vy;
+	float32* m_ims;
+
+	float32* m_Ls;
+	float32* m_s1s;
+	float32* m_s2s;
+
+	float32* m_as;
+	float32* m_k3s;
+
+	// Positions of every rope, one after the other. b2Rope::GetVertices points here.
+	b2Vec2* m_vertices;
+
+	b2ThreadPool* m_threadPool;
+};
+
+inline int32 b2RopeSystem::GetRopeCount() const
+{
+	return m_ropeCount;
+}
+
+inline b2Rope* b2RopeSystem::GetRope(int32 index)
+{
+	b2Assert(0 <= index && index < m_ropeCount);
+	return m_ropes[index];
+}
+
+#endif
@@ -31,6 +31,7 @@
 #include <memory>
 #include <cstdlib>
 #include <math.h>
+#include <time.h>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -44,6 +45,11 @@
 #define  LOGI(...)  __android_log_print(ANDROID_LOG_INFO,LOG_TAG,__VA_ARGS__)
 #define  LOGE(...)  __android_log_print(ANDROID_LOG_ERROR,LOG_TAG,__VA_ARGS__)
 
+// record the world input of a session, to replay it with box2d_replay
+#ifndef RECORD_PHYSICS
+#define RECORD_PHYSICS 0
+#endif
+
 AAssetManager *g_asset_mgr = 0;
 
 
@@ -583,12 +589,27 @@ static const char *command_to_string( int32_t cmd ) {
     }
 }
 
+// bump when engine_state or the saved layout changes, so that state saved by
+// another build is dropped instead of misread
+const static int32_t engine_state_version = 1;
+
 struct engine_state {
+    int32_t version;
+    int32_t state_size; // sizeof( engine_state ) of the build that saved it
     float grey;
+    int32_t body_handle;
+    int32_t world_size; // size of the b2World snapshot that follows the state
 };
 
 
 const static size_t hd_size = 1024 * 1024 * 1;
+
+static double monotonic_seconds() {
+    timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
 class engine {
 public:
     
@@ -637,16 +658,31 @@ public:
         body_->CreateFixture(&fixtureDef);
     
     }
-    engine() : grey(0), hue_(0.0), huge_data_(hd_size, 1), world_(b2Vec2(0.0f, -10.0f))
+    engine() : grey(0), hue_(0.0), huge_data_(hd_size, 1), world_(b2Vec2(0.0f, -10.0f)), stepper_(&world_, 1.0f / 60.0f, 6, 2, 5), last_frame_time_(-1.0)
     {
         create_phys();
+#if RECORD_PHYSICS
+        recorder_.Begin( &world_ );
+#endif
         test_assets();
     }
-    engine( const engine_state &state ):  huge_data_(hd_size, 1), world_(b2Vec2(0.0f, -10.0f)) {
+    engine( const engine_state &state, const void *world_data ):  huge_data_(hd_size, 1), world_(b2Vec2(0.0f, -10.0f)), stepper_(&world_, 1.0f / 60.0f, 6, 2, 5), last_frame_time_(-1.0) {
      
         grey = std::min( 1.0f, std::max( 0.0f, state.grey ));   
         
-        create_phys();
+        body_ = 0;
+        if( state.world_size > 0 && world_.LoadSnapshot( world_data, state.world_size ) ) {
+            body_ = world_.GetBody( state.body_handle );
+        }
+        
+        if( body_ == 0 ) {
+            LOGI( "world snapshot rejected, rebuilding\n" );
+            world_.Clear();
+            create_phys();
+        }
+#if RECORD_PHYSICS
+        recorder_.Begin( &world_ );
+#endif
         test_assets();
     }
     void test_assets() {
@@ -681,16 +717,59 @@ public:
     
     engine_state serialize() {
         engine_state state;
+        state.version = engine_state_version;
+        state.state_size = sizeof( engine_state );
         state.grey = grey;
+        state.body_handle = body_->GetHandle();
+        state.world_size = 0;
         
         return state;
     }
+    
+    // the engine state followed by a snapshot of the world
+    size_t saved_state_size() {
+        return sizeof( engine_state ) + world_.SaveSnapshot( 0, 0 );
+    }
+    
+#if RECORD_PHYSICS
+    bool write_recording( const char *path ) {
+        FILE *f = fopen( path, "wb" );
+        if( f == 0 ) {
+            return false;
+        }
+        
+        bool ok = fwrite( recorder_.GetData(), 1, recorder_.GetSize(), f ) == size_t(recorder_.GetSize());
+        fclose( f );
+        return ok;
+    }
+#endif
+    
+    void save_state( char *buf, size_t size ) {
+        engine_state state = serialize();
+        state.world_size = world_.SaveSnapshot( buf + sizeof( engine_state ), size - sizeof( engine_state ));
+        
+        std::copy( (const char*)&state, (const char*)&state + sizeof( engine_state ), buf );
+    }
     void render( gl_transient_state *gts ) {
     
         if( !gts->visible() ) {
             return;
         }
-        gts->render_pre();
+        {
+            B2_TRACE_SCOPE( "render_pre" );
+            gts->render_pre();
+        }
+        
+        draw( gts );
+        
+        {
+            B2_TRACE_SCOPE( "swap" );
+            gts->render_post();
+        }
+    }
+    
+    void draw( gl_transient_state *gts ) {
+        B2_TRACE_SCOPE( "draw" );
         
         //CL_Mat4f mv_mat = CL_Mat4f::ortho(-5.0, 5.0, -5.0, 5.0, 0, 200);
         
@@ -758,19 +837,17 @@ public:
         checkGlError("glDrawArrays");
         
 #if 1
-        float32 timeStep = 1.0f / 60.0f;
-        int32 velocityIterations = 6;
-        int32 positionIterations = 2;
-        
-        
-        
-        // Instruct the world to perform a single step of simulation.
-        // It is generally best to keep the time step and iterations fixed.
-        world_.Step(timeStep, velocityIterations, positionIterations);
+        // Run the simulation in fixed 1/60s steps, however long the frame took.
+        double now = monotonic_seconds();
+        if( last_frame_time_ >= 0.0 ) {
+            B2_TRACE_SCOPE( "physics" );
+            stepper_.Advance( float32(now - last_frame_time_) );
+        }
+        last_frame_time_ = now;
         
-        // Now print the position and angle of the body.
-        b2Vec2 position = body_->GetPosition();
-        float32 angle = body_->GetAngle();
+        // Blend the position and angle of the body between the last two steps.
+        b2Vec2 position = stepper_.GetInterpolatedPosition(body_);
+        float32 angle = stepper_.GetInterpolatedAngle(body_);
         
         
         CL_Mat4f tr_mat = CL_Mat4f::translate( position.x, position.y, 0.0 );
@@ -795,10 +872,6 @@ public:
             checkGlError("glDrawArrays");
         }
 #endif   
-        
-        
-        gts->render_post();
-    
     }
     
 private:
@@ -809,7 +882,12 @@ private:
     
     
     b2World world_;
+    b2FixedStepper stepper_;
+    double last_frame_time_;
     b2Body* body_;
+#if RECORD_PHYSICS
+    b2Recorder recorder_; // declared after world_, so it detaches first
+#endif
 };
 
 std::auto_ptr<gl_transient_state> g_gl_transient_state;
@@ -859,10 +937,10 @@ static void engine_handle_cmd(struct android_app* app, int32_t cmd) {
         assert( g_engine.get() != 0 );
         
         
-        const size_t es_size = sizeof( engine_state );
+        const size_t es_size = g_engine->saved_state_size();
         
         app->savedState = malloc( es_size );
-        *((engine_state *)app->savedState) = g_engine->serialize();
+        g_engine->save_state( (char *)app->savedState, es_size );
         app->savedStateSize = es_size;
         
 //         app->savedState = malloc( 10 );
@@ -880,10 +958,27 @@ static void engine_handle_cmd(struct android_app* app, int32_t cmd) {
             if( app->savedState != 0 ) {
                 
                 LOGI( "start from saved state: %d\n", app->savedStateSize );
-                assert( app->savedStateSize == sizeof( engine_state ) );
                 
+                engine_state state;
+                const char *saved = (const char *)app->savedState;
+                bool valid = app->savedStateSize >= sizeof( engine_state );
                 
-                g_engine.reset( new engine(*((engine_state *)app->savedState)) );
+                if( valid ) {
+                    std::copy( saved, saved + sizeof( engine_state ), (char*)&state );
+                    valid = state.version == engine_state_version && state.state_size == int32_t(sizeof( engine_state ));
+                }
+                
+                if( valid ) {
+                    if( state.world_size < 0 || size_t(state.world_size) > app->savedStateSize - sizeof( engine_state ) ) {
+                        state.world_size = 0;
+                    }
+                    
+                    g_engine.reset( new engine(state, saved + sizeof( engine_state )) );
+                } else {
+                    // saved by another build: start over with create_phys()
+                    LOGI( "saved state rejected, starting fresh\n" );
+                    g_engine.reset( new engine() );
+                }
             } else {
             
                 g_engine.reset( new engine() );
@@ -895,6 +990,23 @@ static void engine_handle_cmd(struct android_app* app, int32_t cmd) {
 //         LOGI( "start:\n" );
         break;
         
+    case APP_CMD_PAUSE:
+#if B2_TRACE
+        // Leave a timeline of the last frames, to pull with adb.
+        {
+            std::string path = std::string( app->activity->internalDataPath ) + "/trace.json";
+            LOGI( "write trace %s: %d\n", path.c_str(), b2TraceWrite( path.c_str() ) );
+        }
+#endif
+#if RECORD_PHYSICS
+        // The whole session so far, to pull with adb and replay on a desktop.
+        if( g_engine.get() != 0 ) {
+            std::string path = std::string( app->activity->internalDataPath ) + "/physics.rec";
+            LOGI( "write recording %s: %d\n", path.c_str(), g_engine->write_recording( path.c_str() ) );
+        }
+#endif
+        break;
+        
     case APP_CMD_RESUME:
         
         
@@ -979,34 +1091,37 @@ void android_main(struct android_app* state) {
         
         
         
-        while ((ident=ALooper_pollAll( poll_timeout, NULL, &events, (void**)&source)) >= 0 ) {
+        {
+            // A blocking poll shows up as one long event while the app is hidden.
+            B2_TRACE_SCOPE( "event poll" );
+            while ((ident=ALooper_pollAll( poll_timeout, NULL, &events, (void**)&source)) >= 0 ) {
             
           
             
-            // Process this event.
-            if (source != NULL) {
-                source->process(state, source);
-            }
+                // Process this event.
+                if (source != NULL) {
+                    source->process(state, source);
+                }
 //             LOGI( "destroyed: %d\n", g_destroyed );
-            if (state->destroyRequested != 0) {
+                if (state->destroyRequested != 0) {
 //                 if( g_ctx.initialized() ) {
 //                     g_ctx.uninit_display();
 //                     
 //                     
 //                 }
                 
-                g_gl_transient_state.reset(0);
-                LOGI( "destroy: returning\n" );
-                return;
-            }
+                    g_gl_transient_state.reset(0);
+                    LOGI( "destroy: returning\n" );
+                    return;
+                }
             
-            blocking = true;
-            if( g_gl_transient_state.get() != 0 ) {
-                blocking = !g_gl_transient_state->visible();
-            }
-            poll_timeout = blocking ? -1 : 0;
+                blocking = true;
+                if( g_gl_transient_state.get() != 0 ) {
+                    blocking = !g_gl_transient_state->visible();
+                }
+                poll_timeout = blocking ? -1 : 0;
         
-            LOGI( "timeout: %d\n", poll_timeout );
+                LOGI( "timeout: %d\n", poll_timeout );
             
 //             // If a sensor has data, process it now.
 //             if (ident == LOOPER_ID_USER) {
@@ -1028,6 +1143,7 @@ void android_main(struct android_app* state) {
     //             }
     
     
+            }
         }
         
        